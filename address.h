@@ -20,8 +20,8 @@
 #ifndef HAVE_ADDRESS_H
 #define HAVE_ADDRESS_H
 
+#include <linux/if_packet.h>
 #include <netinet/in.h>
-#include <netpacket/packet.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <net/if_arp.h>
@@ -0,0 +1,988 @@
+/**
+ * @file bench.c
+ * @brief Micro benchmarks for the message, TLV, BMC and servo hot paths.
+ * @note Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "bmc.h"
+#include "clock.h"
+#include "config.h"
+#include "ds.h"
+#include "filter.h"
+#include "foreign.h"
+#include "hash.h"
+#include "msg.h"
+#include "port.h"
+#include "port_private.h"
+#include "print.h"
+#include "servo.h"
+#include "tlv.h"
+#include "tmv.h"
+#include "util.h"
+#include "version.h"
+
+#define NS_PER_SEC	1000000000LL
+#define ROUND_NS	20000000LL
+#define HASH_KEYS	256
+#define MAX_FOREIGN	256
+#define OFFSET_SAMPLES	64
+
+enum cycle_source {
+	CYCLES_NONE,
+	CYCLES_PERF,
+	CYCLES_TSC,
+};
+
+static const char *cycle_source_str[] = {
+	"none", "perf", "tsc",
+};
+
+struct bench_opts {
+	char **names;
+	int num_names;
+	int json;
+	int rounds;
+	long ops;
+	int perf_fd;
+	enum cycle_source cycles;
+};
+
+static struct bench_opts opts = {
+	.rounds = 5,
+	.perf_fd = -1,
+};
+
+typedef void (*bench_fn)(void *arg, long n);
+
+/* Message templates. */
+
+struct msg_bench {
+	struct ptp_message *msg;
+	uint8_t host[sizeof(struct message_data)];
+	uint8_t wire[sizeof(struct message_data)];
+	int len;
+};
+
+struct msg_type {
+	const char *name;
+	int type;
+	int size;
+};
+
+static struct msg_type msg_types[] = {
+	{ "sync", SYNC, sizeof(struct sync_msg) },
+	{ "delay_req", DELAY_REQ, sizeof(struct delay_req_msg) },
+	{ "pdelay_req", PDELAY_REQ, sizeof(struct pdelay_req_msg) },
+	{ "pdelay_resp", PDELAY_RESP, sizeof(struct pdelay_resp_msg) },
+	{ "follow_up", FOLLOW_UP, sizeof(struct follow_up_msg) },
+	{ "delay_resp", DELAY_RESP, sizeof(struct delay_resp_msg) },
+	{ "pdelay_resp_fup", PDELAY_RESP_FOLLOW_UP,
+	  sizeof(struct pdelay_resp_fup_msg) },
+	{ "announce", ANNOUNCE, sizeof(struct announce_msg) },
+	{ "signaling", SIGNALING, sizeof(struct signaling_msg) },
+	{ "management", MANAGEMENT, sizeof(struct management_msg) },
+};
+
+/* TLV templates. */
+
+struct tlv_bench {
+	struct tlv_extra *extra;
+	uint8_t buf[sizeof(struct message_data)];
+	uint8_t wire[sizeof(struct message_data)];
+	int len;
+};
+
+/* Servo and filter state. */
+
+struct servo_bench {
+	struct servo *servo;
+	int64_t offset[OFFSET_SAMPLES];
+	uint64_t ts;
+	long count;
+};
+
+struct filter_bench {
+	struct filter *filter;
+	tmv_t sample[OFFSET_SAMPLES];
+	long count;
+};
+
+struct dscmp_bench {
+	struct dataset a;
+	struct dataset b;
+};
+
+struct hash_bench {
+	struct hash *hash;
+	char keys[HASH_KEYS][64];
+	int num_keys;
+};
+
+static int bench_selected(const char *name)
+{
+	int i;
+
+	if (!opts.num_names) {
+		return 1;
+	}
+	for (i = 0; i < opts.num_names; i++) {
+		if (!strncmp(name, opts.names[i], strlen(opts.names[i]))) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static int perf_cycles_open(void)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.disabled = 1;
+	attr.exclude_hv = 1;
+
+	return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64_t cycles_read(void)
+{
+	uint64_t val = 0;
+
+	switch (opts.cycles) {
+	case CYCLES_PERF:
+		if (read(opts.perf_fd, &val, sizeof(val)) != sizeof(val)) {
+			val = 0;
+		}
+		break;
+	case CYCLES_TSC:
+#if defined(__x86_64__) || defined(__i386__)
+		val = __rdtsc();
+#endif
+		break;
+	case CYCLES_NONE:
+		break;
+	}
+	return val;
+}
+
+static void cycles_init(void)
+{
+	opts.perf_fd = perf_cycles_open();
+	if (opts.perf_fd >= 0) {
+		ioctl(opts.perf_fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(opts.perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+		opts.cycles = CYCLES_PERF;
+		return;
+	}
+#if defined(__x86_64__) || defined(__i386__)
+	opts.cycles = CYCLES_TSC;
+#else
+	opts.cycles = CYCLES_NONE;
+#endif
+}
+
+/*
+ * Runs the benchmark for a number of rounds and reports the fastest
+ * one, which is the least disturbed by interrupts and preemption.
+ */
+static void bench_run(const char *name, bench_fn fn, void *arg)
+{
+	double best_ns = 0.0, best_cycles = 0.0, ns, cycles;
+	uint64_t c0, c1;
+	int64_t t0, t1;
+	long ops;
+	int i;
+
+	if (!bench_selected(name)) {
+		return;
+	}
+
+	/* Warm up the caches and calibrate the number of operations. */
+	ops = opts.ops;
+	if (!ops) {
+		for (ops = 16; ops < (1L << 30); ops *= 2) {
+			t0 = now_ns();
+			fn(arg, ops);
+			t1 = now_ns();
+			if (t1 - t0 > ROUND_NS / 4) {
+				break;
+			}
+		}
+		ops = ops * ROUND_NS / (t1 - t0 + 1) + 1;
+	} else {
+		fn(arg, ops);
+	}
+
+	for (i = 0; i < opts.rounds; i++) {
+		c0 = cycles_read();
+		t0 = now_ns();
+		fn(arg, ops);
+		t1 = now_ns();
+		c1 = cycles_read();
+
+		ns = (double) (t1 - t0) / ops;
+		cycles = (double) (c1 - c0) / ops;
+		if (!i || ns < best_ns) {
+			best_ns = ns;
+			best_cycles = cycles;
+		}
+	}
+
+	if (opts.json) {
+		printf("{\"name\":\"%s\",\"ops\":%ld,\"rounds\":%d,"
+		       "\"ns_per_op\":%.2f,\"cycles_per_op\":%.1f,"
+		       "\"cycles\":\"%s\"}\n",
+		       name, ops, opts.rounds, best_ns, best_cycles,
+		       cycle_source_str[opts.cycles]);
+	} else if (opts.cycles == CYCLES_NONE) {
+		printf("%-32s %10.1f ns/op\n", name, best_ns);
+	} else {
+		printf("%-32s %10.1f ns/op %10.1f cycles/op\n",
+		       name, best_ns, best_cycles);
+	}
+	fflush(stdout);
+}
+
+/* msg_post_recv() and msg_pre_send() */
+
+static void msg_post_recv_fn(void *arg, long n)
+{
+	struct msg_bench *mb = arg;
+	struct ptp_message *m;
+
+	while (n--) {
+		m = msg_allocate();
+		memcpy(&m->header, mb->wire, mb->len);
+		if (msg_post_recv(m, mb->len)) {
+			pr_err("msg_post_recv failed");
+			exit(1);
+		}
+		msg_put(m);
+	}
+}
+
+static void msg_pre_send_fn(void *arg, long n)
+{
+	struct msg_bench *mb = arg;
+
+	while (n--) {
+		memcpy(&mb->msg->header, mb->host, mb->len);
+		msg_pre_send(mb->msg);
+	}
+}
+
+static int msg_bench_init(struct msg_bench *mb, struct msg_type *mt)
+{
+	struct management_tlv *mgt;
+	struct tlv_extra *extra;
+	struct ptp_message *m;
+
+	memset(mb, 0, sizeof(*mb));
+	m = msg_allocate();
+	if (!m) {
+		return -1;
+	}
+	m->header.tsmt = mt->type;
+	m->header.ver = PTP_VERSION;
+	m->header.messageLength = mt->size;
+	m->header.sequenceId = 1;
+	m->header.sourcePortIdentity.portNumber = 1;
+
+	switch (mt->type) {
+	case ANNOUNCE:
+		m->announce.grandmasterPriority1 = 128;
+		m->announce.grandmasterPriority2 = 128;
+		m->announce.grandmasterClockQuality.clockClass = 248;
+		break;
+	case SIGNALING:
+		extra = msg_tlv_append(m, sizeof(struct request_unicast_xmit_tlv));
+		if (!extra) {
+			return -1;
+		}
+		extra->tlv->type = TLV_REQUEST_UNICAST_TRANSMISSION;
+		extra->tlv->length = sizeof(struct request_unicast_xmit_tlv) -
+			sizeof(struct TLV);
+		break;
+	case MANAGEMENT:
+		m->management.flags = GET;
+		extra = msg_tlv_append(m, sizeof(struct management_tlv) +
+				       sizeof(struct defaultDS));
+		if (!extra) {
+			return -1;
+		}
+		mgt = (struct management_tlv *) extra->tlv;
+		mgt->type = TLV_MANAGEMENT;
+		mgt->length = sizeof(mgt->id) + sizeof(struct defaultDS);
+		mgt->id = TLV_DEFAULT_DATA_SET;
+		break;
+	}
+
+	mb->msg = m;
+	mb->len = m->header.messageLength;
+	memcpy(mb->host, &m->header, mb->len);
+	if (msg_pre_send(m)) {
+		return -1;
+	}
+	memcpy(mb->wire, &m->header, mb->len);
+	return 0;
+}
+
+static void bench_msg(void)
+{
+	struct msg_bench mb;
+	char name[64];
+	int i;
+
+	for (i = 0; i < sizeof(msg_types) / sizeof(msg_types[0]); i++) {
+		if (msg_bench_init(&mb, &msg_types[i])) {
+			pr_err("failed to prepare %s message", msg_types[i].name);
+			continue;
+		}
+		snprintf(name, sizeof(name), "msg_post_recv.%s",
+			 msg_types[i].name);
+		bench_run(name, msg_post_recv_fn, &mb);
+		snprintf(name, sizeof(name), "msg_pre_send.%s",
+			 msg_types[i].name);
+		bench_run(name, msg_pre_send_fn, &mb);
+		msg_put(mb.msg);
+	}
+}
+
+/* tlv_post_recv() */
+
+static void tlv_post_recv_fn(void *arg, long n)
+{
+	struct tlv_bench *tb = arg;
+
+	while (n--) {
+		memcpy(tb->buf, tb->wire, tb->len);
+		tb->extra->tlv = (struct TLV *) tb->buf;
+		if (tlv_post_recv(tb->extra)) {
+			pr_err("tlv_post_recv failed");
+			exit(1);
+		}
+	}
+}
+
+static int tlv_bench_init(struct tlv_bench *tb, int type, int id, int len)
+{
+	struct management_tlv *mgt;
+	struct organization_tlv *org;
+
+	memset(tb, 0, sizeof(*tb));
+	tb->extra = tlv_extra_alloc();
+	if (!tb->extra) {
+		return -1;
+	}
+	tb->extra->tlv = (struct TLV *) tb->buf;
+	tb->extra->tlv->type = type;
+	tb->extra->tlv->length = len;
+	tb->len = sizeof(struct TLV) + len;
+
+	switch (type) {
+	case TLV_MANAGEMENT:
+		mgt = (struct management_tlv *) tb->buf;
+		mgt->id = id;
+		break;
+	case TLV_ORGANIZATION_EXTENSION:
+		org = (struct organization_tlv *) tb->buf;
+		memcpy(org->id, ieee8021_id, sizeof(ieee8021_id));
+		org->subtype[2] = 1;
+		break;
+	}
+
+	tlv_pre_send(tb->extra->tlv, tb->extra);
+	memcpy(tb->wire, tb->buf, tb->len);
+	return 0;
+}
+
+static void bench_tlv(void)
+{
+	struct {
+		const char *name;
+		int type;
+		int id;
+		int len;
+	} tlvs[] = {
+		{ "tlv_post_recv.default_data_set", TLV_MANAGEMENT,
+		  TLV_DEFAULT_DATA_SET, sizeof(Enumeration16) +
+		  sizeof(struct defaultDS) },
+		{ "tlv_post_recv.port_data_set", TLV_MANAGEMENT,
+		  TLV_PORT_DATA_SET, sizeof(Enumeration16) +
+		  sizeof(struct portDS) },
+		{ "tlv_post_recv.time_status_np", TLV_MANAGEMENT,
+		  TLV_TIME_STATUS_NP, sizeof(Enumeration16) +
+		  sizeof(struct time_status_np) },
+		{ "tlv_post_recv.follow_up_info", TLV_ORGANIZATION_EXTENSION,
+		  0, sizeof(struct follow_up_info_tlv) - sizeof(struct TLV) },
+		{ "tlv_post_recv.request_unicast", TLV_REQUEST_UNICAST_TRANSMISSION,
+		  0, sizeof(struct request_unicast_xmit_tlv) -
+		  sizeof(struct TLV) },
+		{ "tlv_post_recv.path_trace", TLV_PATH_TRACE,
+		  0, 8 * sizeof(struct ClockIdentity) },
+	};
+	struct tlv_bench tb;
+	int i;
+
+	for (i = 0; i < sizeof(tlvs) / sizeof(tlvs[0]); i++) {
+		if (tlv_bench_init(&tb, tlvs[i].type, tlvs[i].id, tlvs[i].len)) {
+			pr_err("failed to prepare %s", tlvs[i].name);
+			continue;
+		}
+		bench_run(tlvs[i].name, tlv_post_recv_fn, &tb);
+		tlv_extra_recycle(tb.extra);
+	}
+}
+
+/* dscmp() and dscmp2() */
+
+static void dscmp_fn(void *arg, long n)
+{
+	struct dscmp_bench *db = arg;
+	volatile int result;
+
+	while (n--) {
+		result = dscmp(&db->a, &db->b);
+	}
+	(void) result;
+}
+
+static void dscmp2_fn(void *arg, long n)
+{
+	struct dscmp_bench *db = arg;
+	volatile int result;
+
+	while (n--) {
+		result = dscmp2(&db->a, &db->b);
+	}
+	(void) result;
+}
+
+static void bench_dscmp(void)
+{
+	struct dscmp_bench db;
+
+	memset(&db, 0, sizeof(db));
+	db.a.priority1 = 128;
+	db.a.priority2 = 128;
+	db.a.quality.clockClass = 248;
+	db.a.quality.offsetScaledLogVariance = 0xffff;
+	db.a.identity.id[7] = 1;
+	db.a.sender.clockIdentity.id[7] = 1;
+	db.a.receiver.clockIdentity.id[7] = 3;
+	db.a.stepsRemoved = 1;
+	db.b = db.a;
+
+	/* Different grand masters, decided by the identity. */
+	db.b.identity.id[7] = 2;
+	db.b.sender.clockIdentity.id[7] = 2;
+	bench_run("dscmp.other_gm", dscmp_fn, &db);
+
+	/* The same grand master, decided by the topology. */
+	db.b.identity = db.a.identity;
+	db.b.stepsRemoved = 2;
+	bench_run("dscmp.same_gm", dscmp_fn, &db);
+	bench_run("dscmp2", dscmp2_fn, &db);
+}
+
+/* port_compute_best() */
+
+static void port_compute_best_fn(void *arg, long n)
+{
+	struct port *p = arg;
+
+	while (n--) {
+		port_compute_best(p);
+	}
+}
+
+static struct port *fake_port_create(struct clock *c, int num)
+{
+	struct foreign_clock *fc;
+	struct ptp_message *m;
+	struct port *p;
+	int i, j;
+
+	p = calloc(1, sizeof(*p));
+	if (!p) {
+		return NULL;
+	}
+	p->clock = c;
+	p->portIdentity.portNumber = 1;
+	LIST_INIT(&p->foreign_masters);
+
+	/*
+	 * The list is traversed from the most recently inserted entry,
+	 * and every entry is better than the previous ones, so that none
+	 * of them is cleared during the comparison.
+	 */
+	for (i = 0; i < num; i++) {
+		fc = calloc(1, sizeof(*fc));
+		if (!fc) {
+			return NULL;
+		}
+		fc->port = p;
+		TAILQ_INIT(&fc->messages);
+		for (j = 0; j < FOREIGN_MASTER_THRESHOLD; j++) {
+			m = msg_allocate();
+			if (!m) {
+				return NULL;
+			}
+			m->header.tsmt = ANNOUNCE;
+			m->header.logMessageInterval = 31;
+			m->header.sourcePortIdentity.clockIdentity.id[6] = i >> 8;
+			m->header.sourcePortIdentity.clockIdentity.id[7] = i;
+			m->announce.grandmasterPriority1 = 128;
+			m->announce.grandmasterPriority2 = 128;
+			m->announce.grandmasterClockQuality.clockClass = 248;
+			m->announce.grandmasterIdentity.id[6] = (i + 1) >> 8;
+			m->announce.grandmasterIdentity.id[7] = i + 1;
+			TAILQ_INSERT_HEAD(&fc->messages, m, list);
+			fc->n_messages++;
+		}
+		LIST_INSERT_HEAD(&p->foreign_masters, fc, list);
+	}
+	return p;
+}
+
+static void fake_port_destroy(struct port *p)
+{
+	struct foreign_clock *fc;
+
+	while ((fc = LIST_FIRST(&p->foreign_masters)) != NULL) {
+		LIST_REMOVE(fc, list);
+		fc_clear(fc);
+		free(fc);
+	}
+	free(p);
+}
+
+static void bench_port_compute_best(struct config *cfg)
+{
+	int i, num[] = { 1, 4, 16, 64, MAX_FOREIGN };
+	struct clock *c;
+	struct port *p;
+	char name[64], uds[64];
+
+	if (!bench_selected("port_compute_best")) {
+		return;
+	}
+
+	/* A free running clock with only the UDS port. */
+	snprintf(uds, sizeof(uds), "/tmp/bench.%d", getpid());
+	if (config_set_int(cfg, "free_running", 1) ||
+	    config_set_int(cfg, "time_stamping", TS_SOFTWARE) ||
+	    config_set_string(cfg, "clockIdentity", "000000.fffe.000001") ||
+	    config_set_string(cfg, "uds_address", uds)) {
+		return;
+	}
+	c = clock_create(CLOCK_TYPE_ORDINARY, cfg, NULL);
+	if (!c) {
+		pr_err("failed to create a clock");
+		return;
+	}
+
+	for (i = 0; i < sizeof(num) / sizeof(num[0]); i++) {
+		p = fake_port_create(c, num[i]);
+		if (!p) {
+			pr_err("failed to create %d foreign masters", num[i]);
+			break;
+		}
+		snprintf(name, sizeof(name), "port_compute_best.%d", num[i]);
+		bench_run(name, port_compute_best_fn, p);
+		fake_port_destroy(p);
+	}
+	clock_destroy(c);
+}
+
+/* servo_sample() */
+
+static void servo_sample_fn(void *arg, long n)
+{
+	struct servo_bench *sb = arg;
+	enum servo_state state;
+
+	while (n--) {
+		sb->ts += NS_PER_SEC;
+		servo_sample(sb->servo, sb->offset[sb->count++ % OFFSET_SAMPLES],
+			     sb->ts, 1.0, &state);
+	}
+}
+
+static void bench_servo(struct config *cfg)
+{
+	struct {
+		const char *name;
+		enum servo_type type;
+	} servos[] = {
+		{ "servo_sample.pi", CLOCK_SERVO_PI },
+		{ "servo_sample.linreg", CLOCK_SERVO_LINREG },
+		{ "servo_sample.nullf", CLOCK_SERVO_NULLF },
+	};
+	struct servo_bench sb;
+	int i, j;
+
+	for (i = 0; i < sizeof(servos) / sizeof(servos[0]); i++) {
+		if (!bench_selected(servos[i].name)) {
+			continue;
+		}
+		memset(&sb, 0, sizeof(sb));
+		sb.servo = servo_create(cfg, servos[i].type, 0, 500000, 0);
+		if (!sb.servo) {
+			pr_err("failed to create %s", servos[i].name);
+			continue;
+		}
+		srandom(1);
+		for (j = 0; j < OFFSET_SAMPLES; j++) {
+			sb.offset[j] = random() % 201 - 100;
+		}
+		sb.ts = NS_PER_SEC;
+		bench_run(servos[i].name, servo_sample_fn, &sb);
+		servo_destroy(sb.servo);
+	}
+}
+
+/* filter_sample() */
+
+static void filter_sample_fn(void *arg, long n)
+{
+	struct filter_bench *fb = arg;
+
+	while (n--) {
+		filter_sample(fb->filter, fb->sample[fb->count++ % OFFSET_SAMPLES]);
+	}
+}
+
+static void bench_filter(struct config *cfg)
+{
+	struct {
+		const char *name;
+		enum filter_type type;
+	} filters[] = {
+		{ "filter_sample.mave", FILTER_MOVING_AVERAGE },
+		{ "filter_sample.mmedian", FILTER_MOVING_MEDIAN },
+	};
+	int i, j, length = config_get_int(cfg, NULL, "delay_filter_length");
+	struct filter_bench fb;
+
+	for (i = 0; i < sizeof(filters) / sizeof(filters[0]); i++) {
+		if (!bench_selected(filters[i].name)) {
+			continue;
+		}
+		memset(&fb, 0, sizeof(fb));
+		fb.filter = filter_create(filters[i].type, length);
+		if (!fb.filter) {
+			pr_err("failed to create %s", filters[i].name);
+			continue;
+		}
+		srandom(1);
+		for (j = 0; j < OFFSET_SAMPLES; j++) {
+			fb.sample[j] = nanoseconds_to_tmv(10000 + random() % 1000);
+		}
+		bench_run(filters[i].name, filter_sample_fn, &fb);
+		filter_destroy(fb.filter);
+	}
+}
+
+/* hash_lookup() */
+
+static void hash_lookup_fn(void *arg, long n)
+{
+	struct hash_bench *hb = arg;
+	long i;
+
+	for (i = 0; i < n; i++) {
+		if (!hash_lookup(hb->hash, hb->keys[i % hb->num_keys])) {
+			pr_err("hash_lookup failed");
+			exit(1);
+		}
+	}
+}
+
+static void bench_hash(void)
+{
+	int i, num[] = { 16, 64, HASH_KEYS };
+	struct hash_bench hb;
+	char name[64];
+
+	for (i = 0; i < sizeof(num) / sizeof(num[0]); i++) {
+		snprintf(name, sizeof(name), "hash_lookup.%d", num[i]);
+		if (!bench_selected(name)) {
+			continue;
+		}
+		memset(&hb, 0, sizeof(hb));
+		hb.hash = hash_create();
+		if (!hb.hash) {
+			return;
+		}
+		/* Keys shaped like the ones of the configuration table. */
+		for (hb.num_keys = 0; hb.num_keys < num[i]; hb.num_keys++) {
+			snprintf(hb.keys[hb.num_keys], sizeof(hb.keys[0]),
+				 "eth%d.logMinDelayReqInterval", hb.num_keys);
+			hash_insert(hb.hash, hb.keys[hb.num_keys], &hb);
+		}
+		bench_run(name, hash_lookup_fn, &hb);
+		hash_destroy(hb.hash, NULL);
+	}
+}
+
+/* config_get_int() and friends */
+
+static void config_get_label_fn(void *arg, long n)
+{
+	struct config *cfg = arg;
+	long i;
+
+	for (i = 0; i < n; i++) {
+		config_get_int(cfg, "eth0", "logSyncInterval");
+	}
+}
+
+static void config_get_id_fn(void *arg, long n)
+{
+	struct config *cfg = arg;
+	long i;
+
+	for (i = 0; i < n; i++) {
+		config_get_int_id(cfg, NULL, CFG_logSyncInterval);
+	}
+}
+
+static void config_resolve_port_fn(void *arg, long n)
+{
+	struct config_port cp;
+	struct config *cfg = arg;
+	long i;
+
+	for (i = 0; i < n; i++) {
+		config_resolve_port(cfg, "eth0", &cp);
+	}
+}
+
+struct config_bench {
+	struct config *cfg;
+	char names[HASH_KEYS][16];
+	int num;
+};
+
+static void config_lookup_fn(void *arg, long n)
+{
+	struct config_bench *cb = arg;
+	const char *name;
+	long i;
+
+	/* One option set in every port section, one falling back. */
+	for (i = 0; i < n; i++) {
+		name = cb->names[i % cb->num];
+		config_get_int(cb->cfg, name, "logSyncInterval");
+		config_get_int(cb->cfg, name, "delayAsymmetry");
+	}
+}
+
+static void bench_config_ports(void)
+{
+	int i, num[] = { 16, 64, HASH_KEYS };
+	struct config_bench cb;
+	char name[64];
+
+	for (i = 0; i < sizeof(num) / sizeof(num[0]); i++) {
+		snprintf(name, sizeof(name), "config_lookup.%d", num[i]);
+		if (!bench_selected(name)) {
+			continue;
+		}
+		memset(&cb, 0, sizeof(cb));
+		cb.cfg = config_create();
+		if (!cb.cfg) {
+			return;
+		}
+		for (cb.num = 0; cb.num < num[i]; cb.num++) {
+			snprintf(cb.names[cb.num], sizeof(cb.names[0]),
+				 "eth%d", cb.num);
+			config_set_section_int(cb.cfg, cb.names[cb.num],
+					       "logSyncInterval", -3);
+			config_set_section_int(cb.cfg, cb.names[cb.num],
+					       "announceReceiptTimeout", 4);
+		}
+		bench_run(name, config_lookup_fn, &cb);
+		config_destroy(cb.cfg);
+	}
+}
+
+static void bench_config(struct config *cfg)
+{
+	if (bench_selected("config_get.label")) {
+		bench_run("config_get.label", config_get_label_fn, cfg);
+	}
+	if (bench_selected("config_get.id")) {
+		bench_run("config_get.id", config_get_id_fn, cfg);
+	}
+	if (bench_selected("config_resolve_port")) {
+		bench_run("config_resolve_port", config_resolve_port_fn, cfg);
+	}
+	bench_config_ports();
+}
+
+static int pin_cpu(int cpu)
+{
+	cpu_set_t mask;
+
+	if (cpu < 0) {
+		cpu = sched_getcpu();
+		if (cpu < 0) {
+			return -1;
+		}
+	}
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+	if (sched_setaffinity(0, sizeof(mask), &mask)) {
+		fprintf(stderr, "failed to pin to CPU %d: %m\n", cpu);
+		return -1;
+	}
+	return 0;
+}
+
+static void usage(char *progname)
+{
+	fprintf(stderr,
+		"\n"
+		"usage: %s [options] [benchmark-prefix ...]\n\n"
+		" -c [num]  pin to CPU 'num' (the current CPU)\n"
+		" -f [file] read configuration from 'file'\n"
+		" -j        print results as JSON, one object per line\n"
+		" -n [num]  number of operations per round (calibrated)\n"
+		" -r [num]  number of rounds, the fastest is reported (5)\n"
+		" -h        prints this message and exits\n"
+		" -v        prints the software version and exits\n"
+		"\n",
+		progname);
+}
+
+int main(int argc, char *argv[])
+{
+	char *config = NULL, *progname;
+	int c, cpu = -1, err = -1, index;
+	struct option *long_opts;
+	struct config *cfg;
+
+	cfg = config_create();
+	if (!cfg) {
+		return -1;
+	}
+	long_opts = config_long_options(cfg);
+	print_set_verbose(1);
+	print_set_syslog(0);
+	print_set_level(LOG_WARNING);
+
+	progname = strrchr(argv[0], '/');
+	progname = progname ? 1+progname : argv[0];
+	while (EOF != (c = getopt_long(argc, argv, "c:f:jn:r:hv",
+				       long_opts, &index))) {
+		switch (c) {
+		case 0:
+			if (config_parse_option(cfg, long_opts[index].name,
+						optarg))
+				goto out;
+			break;
+		case 'c':
+			if (get_arg_val_i(c, optarg, &cpu, 0, CPU_SETSIZE - 1))
+				goto out;
+			break;
+		case 'f':
+			config = optarg;
+			break;
+		case 'j':
+			opts.json = 1;
+			break;
+		case 'n':
+			if (get_arg_val_i(c, optarg, &index, 1, INT_MAX))
+				goto out;
+			opts.ops = index;
+			break;
+		case 'r':
+			if (get_arg_val_i(c, optarg, &opts.rounds, 1, 1000))
+				goto out;
+			break;
+		case 'v':
+			version_show(stdout);
+			err = 0;
+			goto out;
+		case 'h':
+			usage(progname);
+			err = 0;
+			goto out;
+		case '?':
+		default:
+			usage(progname);
+			goto out;
+		}
+	}
+	opts.names = &argv[optind];
+	opts.num_names = argc - optind;
+
+	if (config && config_read(config, cfg)) {
+		fprintf(stderr, "failed to read config\n");
+		goto out;
+	}
+	print_set_progname(progname);
+
+	if (pin_cpu(cpu)) {
+		goto out;
+	}
+	cycles_init();
+
+	bench_msg();
+	bench_tlv();
+	bench_dscmp();
+	bench_port_compute_best(cfg);
+	bench_servo(cfg);
+	bench_filter(cfg);
+	bench_hash();
+	bench_config(cfg);
+	err = 0;
+out:
+	if (opts.perf_fd >= 0)
+		close(opts.perf_fd);
+	msg_cleanup();
+	tlv_extra_cleanup();
+	config_destroy(cfg);
+	return err;
+}
@@ -32,6 +32,8 @@
 #include "clockcheck.h"
 #include "foreign.h"
 #include "filter.h"
+#include "hash.h"
+#include "latency.h"
 #include "missing.h"
 #include "msg.h"
 #include "phc.h"
@@ -41,11 +43,20 @@
 #include "print.h"
 #include "rtnl.h"
 #include "tlv.h"
+#include "tmo.h"
 #include "tsproc.h"
+#include "tsrec.h"
 #include "uds.h"
 #include "util.h"
+#include "warm.h"
 
-#define N_CLOCK_PFD (N_POLLFD + 1) /* one extra per port, for the fault timer */
+#define N_CLOCK_PFD N_POLLFD
+
+/* Keep each SNAPSHOT_NP response within a single Ethernet frame. */
+#define SNAPSHOT_MAX_LEN 1400
+/* Room for the largest TLV placed into a snapshot. */
+#define SNAPSHOT_TLV_ROOM \
+	(sizeof(struct management_tlv) + sizeof(struct port_stats_np) + 2)
 
 struct interface {
 	STAILQ_ENTRY(interface) list;
@@ -97,11 +108,17 @@ struct clock {
 	struct port *uds_port;
 	struct pollfd *pollfd;
 	int pollfd_valid;
+	struct tmo_heap *timers;
+	int rtnl_fd;
+	struct hash *links; /* the ports watched via rtnl_fd, by ifname */
 	int nports; /* does not include the UDS port */
 	int last_port_number;
 	int sde;
 	int free_running;
 	int freq_est_interval;
+	int log_sync_interval;
+	int max_adj;
+	int reload_pending;
 	int local_sync_uncertain;
 	int write_phase_mode;
 	int grand_master_capable; /* for 802.1AS only */
@@ -119,6 +136,9 @@ struct clock {
 	tmv_t path_delay;
 	tmv_t ingress_ts;
 	tmv_t initial_delay;
+	char warm_clock[64];	/* name in the state file, empty if none */
+	struct warm_record warm;
+	int warm_pending;	/* until the saved parent is selected */
 	struct tsproc *tsproc;
 	struct freq_estimator fest;
 	struct time_status_np status;
@@ -132,10 +152,9 @@ struct clock {
 	struct syfu_relay_info syfu_relay;
 	LIST_HEAD(clock_subscribers_head, clock_subscriber) subscribers;
 	struct monitor *slave_event_monitor;
+	struct latency latency;
 };
 
-struct clock the_clock;
-
 static void handle_state_decision_event(struct clock *c);
 static int clock_resize_pollfd(struct clock *c, int new_nports);
 static void clock_remove_port(struct clock *c, struct port *p);
@@ -263,18 +282,113 @@ void clock_send_notification(struct clock *c, struct ptp_message *msg,
 	}
 }
 
+static void clock_warm_save(struct clock *c, double freq)
+{
+	tmv_t delay[WARM_DELAY_SAMPLES];
+	struct warm_record w;
+	int i;
+
+	memset(&w, 0, sizeof(w));
+	snprintf(w.clock, sizeof(w.clock), "%s", c->warm_clock);
+	snprintf(w.parent, sizeof(w.parent), "%s",
+		 pid2str(&c->dad.pds.parentPortIdentity));
+	w.freq = freq;
+	w.path_delay = tmv_to_nanoseconds(c->path_delay);
+	w.utc_offset = c->tds.currentUtcOffset;
+	w.utc_offset_valid = c->tds.flags & UTC_OFF_VALID ? 1 : 0;
+	w.n_delay = tsproc_get_delay_samples(c->tsproc, delay,
+					     WARM_DELAY_SAMPLES);
+	for (i = 0; i < w.n_delay; i++) {
+		w.delay[i] = tmv_to_nanoseconds(delay[i]);
+	}
+	warm_save(&w);
+}
+
+/*
+ * The saved parent is back. Start from the saved path delay and clock
+ * frequency instead of learning them again.
+ */
+static void clock_warm_start(struct clock *c)
+{
+	struct warm_record *w = &c->warm;
+	tmv_t delay[WARM_DELAY_SAMPLES];
+	struct servo *servo;
+	int i;
+
+	c->warm_pending = 0;
+
+	for (i = 0; i < w->n_delay; i++) {
+		delay[i] = nanoseconds_to_tmv(w->delay[i]);
+	}
+	tsproc_seed_delay(c->tsproc, delay, w->n_delay);
+	if (w->path_delay > 0) {
+		c->path_delay = nanoseconds_to_tmv(w->path_delay);
+		if (!w->n_delay) {
+			tsproc_set_delay(c->tsproc, c->path_delay);
+		}
+	}
+
+	if (c->clkid == CLOCK_INVALID || c->free_running ||
+	    w->freq > c->max_adj || w->freq < -c->max_adj) {
+		pr_notice("warm start from %s: path delay %" PRId64,
+			  w->parent, w->path_delay);
+		return;
+	}
+	servo = servo_create(c->config, c->servo_type, -(int) w->freq,
+			     c->max_adj, c->timestamping == TS_SOFTWARE);
+	if (!servo) {
+		pr_err("failed to create clock servo for the warm start");
+		return;
+	}
+	servo_destroy(c->servo);
+	c->servo = servo;
+	c->servo_state = SERVO_UNLOCKED;
+	clockadj_set_freq(c->clkid, w->freq);
+	if (c->sanity_check) {
+		clockcheck_set_freq(c->sanity_check, w->freq);
+	}
+	tsrec_write(TSREC_SERVO, c->clkid, c->max_adj,
+		    c->timestamping == TS_SOFTWARE, 0, w->freq);
+	clock_sync_interval(c, c->log_sync_interval);
+
+	pr_notice("warm start from %s: freq %+.0f path delay %" PRId64,
+		  w->parent, w->freq, w->path_delay);
+}
+
+int clock_warm_parent(struct clock *c, struct PortIdentity *pid)
+{
+	return c->warm_pending && !strcmp(pid2str(pid), c->warm.parent);
+}
+
 void clock_destroy(struct clock *c)
 {
+	unsigned long issued, skipped;
 	struct port *p, *tmp;
 
+	if (c->clkid != CLOCK_INVALID) {
+		clockadj_get_counts(c->clkid, &issued, &skipped);
+		pr_info("clock adjustments: %lu issued, %lu skipped",
+			issued, skipped);
+		if (c->warm_clock[0] && (c->servo_state == SERVO_LOCKED ||
+					 c->servo_state == SERVO_LOCKED_STABLE)) {
+			clock_warm_save(c, clockadj_get_freq(c->clkid));
+		}
+	}
 	interface_destroy(c->udsif);
 	clock_flush_subscriptions(c);
+	if (c->links) {
+		hash_destroy(c->links, NULL);
+	}
+	if (c->rtnl_fd >= 0) {
+		rtnl_close(c->rtnl_fd);
+	}
 	LIST_FOREACH_SAFE(p, &c->ports, list, tmp) {
 		clock_remove_port(c, p);
 	}
 	monitor_destroy(c->slave_event_monitor);
 	port_close(c->uds_port);
 	free(c->pollfd);
+	tmo_heap_destroy(c->timers);
 	if (c->clkid != CLOCK_REALTIME) {
 		phc_close(c->clkid);
 	}
@@ -286,7 +400,7 @@ void clock_destroy(struct clock *c)
 	if (c->sanity_check) {
 		clockcheck_destroy(c->sanity_check);
 	}
-	memset(c, 0, sizeof(*c));
+	free(c);
 	msg_cleanup();
 	tc_cleanup();
 }
@@ -343,6 +457,7 @@ static int clock_management_fill_response(struct clock *c, struct port *p,
 	struct subscribe_events_np *sen;
 	struct management_tlv *tlv;
 	struct time_status_np *tsn;
+	struct snapshot_np *snp;
 	struct tlv_extra *extra;
 	struct PTPText *text;
 	int datalen = 0;
@@ -352,9 +467,11 @@ static int clock_management_fill_response(struct clock *c, struct port *p,
 		pr_err("failed to allocate TLV descriptor");
 		return 0;
 	}
-	extra->tlv = (struct TLV *) rsp->management.suffix;
+	/* Append the TLV, as the response may already carry others. */
+	extra->tlv = (struct TLV *) (rsp->data.buffer +
+				     rsp->header.messageLength);
 
-	tlv = (struct management_tlv *) rsp->management.suffix;
+	tlv = (struct management_tlv *) extra->tlv;
 	tlv->type = TLV_MANAGEMENT;
 	tlv->id = id;
 
@@ -455,6 +572,21 @@ static int clock_management_fill_response(struct clock *c, struct port *p,
 		mtd->val = c->local_sync_uncertain;
 		datalen = sizeof(*mtd);
 		break;
+	case TLV_SNAPSHOT_NP:
+		snp = (struct snapshot_np *) tlv->data;
+		snp->fragment = 0;
+		snp->lastFragment = 0;
+		snp->numberPorts = c->nports;
+		snp->reserved = 0;
+		datalen = sizeof(*snp);
+		break;
+	case TLV_RELOAD_CONFIG_NP:
+		/* There is nothing to GET, only a command to acknowledge. */
+		if (!req || management_action(req) != COMMAND) {
+			tlv_extra_recycle(extra);
+			return 0;
+		}
+		break;
 	default:
 		/* The caller should *not* respond to this message. */
 		tlv_extra_recycle(extra);
@@ -472,6 +604,96 @@ static int clock_management_fill_response(struct clock *c, struct port *p,
 	return 1;
 }
 
+static struct ptp_message *clock_snapshot_begin(struct clock *c,
+						struct port *p,
+						struct ptp_message *req,
+						UInteger16 fragment)
+{
+	struct PortIdentity pid = port_identity(p);
+	struct management_tlv *tlv;
+	struct ptp_message *rsp;
+	struct snapshot_np *snp;
+
+	rsp = port_management_reply(pid, p, req);
+	if (!rsp) {
+		return NULL;
+	}
+	if (!clock_management_fill_response(c, p, req, rsp, TLV_SNAPSHOT_NP)) {
+		msg_put(rsp);
+		return NULL;
+	}
+	tlv = (struct management_tlv *) rsp->management.suffix;
+	snp = (struct snapshot_np *) tlv->data;
+	snp->fragment = fragment;
+	return rsp;
+}
+
+static int clock_snapshot_end(struct port *p, struct ptp_message *rsp,
+			      int last)
+{
+	struct management_tlv *tlv;
+	struct snapshot_np *snp;
+	int err;
+
+	tlv = (struct management_tlv *) rsp->management.suffix;
+	snp = (struct snapshot_np *) tlv->data;
+	snp->lastFragment = last ? 1 : 0;
+	err = port_prepare_and_send(p, rsp, TRANS_GENERAL);
+	msg_put(rsp);
+	return err;
+}
+
+/*
+ * Answers a SNAPSHOT_NP request with every clock data set followed by
+ * the data sets and counters of each port. Since all of the responses
+ * are built before returning to the event loop, the snapshot reflects
+ * a single point in time.
+ */
+static int clock_management_snapshot(struct clock *c, struct port *p,
+				     struct ptp_message *req)
+{
+	static const int clock_ids[] = {
+		TLV_DEFAULT_DATA_SET,
+		TLV_CURRENT_DATA_SET,
+		TLV_PARENT_DATA_SET,
+		TLV_TIME_PROPERTIES_DATA_SET,
+		TLV_TIME_STATUS_NP,
+	};
+	static const int port_ids[] = {
+		TLV_PORT_DATA_SET,
+		TLV_PORT_DATA_SET_NP,
+		TLV_PORT_PROPERTIES_NP,
+		TLV_PORT_STATS_NP,
+	};
+	UInteger16 fragment = 0;
+	struct ptp_message *rsp;
+	struct port *piter;
+	int i;
+
+	rsp = clock_snapshot_begin(c, p, req, fragment++);
+	if (!rsp) {
+		return 0;
+	}
+	for (i = 0; i < sizeof(clock_ids) / sizeof(clock_ids[0]); i++) {
+		clock_management_fill_response(c, p, req, rsp, clock_ids[i]);
+	}
+	LIST_FOREACH(piter, &c->ports, list) {
+		for (i = 0; i < sizeof(port_ids) / sizeof(port_ids[0]); i++) {
+			if (rsp->header.messageLength + SNAPSHOT_TLV_ROOM >
+			    SNAPSHOT_MAX_LEN) {
+				clock_snapshot_end(p, rsp, 0);
+				rsp = clock_snapshot_begin(c, p, req, fragment++);
+				if (!rsp) {
+					return 1;
+				}
+			}
+			port_management_append(piter, rsp, port_ids[i]);
+		}
+	}
+	clock_snapshot_end(p, rsp, 1);
+	return 1;
+}
+
 static int clock_management_get_response(struct clock *c, struct port *p,
 					 int id, struct ptp_message *req)
 {
@@ -479,6 +701,9 @@ static int clock_management_get_response(struct clock *c, struct port *p,
 	struct ptp_message *rsp;
 	int respond;
 
+	if (id == TLV_SNAPSHOT_NP) {
+		return clock_management_snapshot(c, p, req);
+	}
 	rsp = port_management_reply(pid, p, req);
 	if (!rsp) {
 		return 0;
@@ -549,9 +774,45 @@ static int clock_management_set(struct clock *c, struct port *p,
 	return respond ? 1 : 0;
 }
 
-static void clock_stats_update(struct clock_stats *s,
-			       double offset, double freq)
+static int clock_management_command(struct clock *c, struct port *p,
+				    int id, struct ptp_message *req)
+{
+	switch (id) {
+	case TLV_RELOAD_CONFIG_NP:
+		if (p != c->uds_port) {
+			/* Sorry, only allowed on the UDS port. */
+			clock_management_send_error(p, req, TLV_NOT_SUPPORTED);
+			return 1;
+		}
+		c->reload_pending = 1;
+		break;
+	default:
+		return 0;
+	}
+	if (!clock_management_get_response(c, p, id, req))
+		pr_err("failed to send management acknowledge");
+	return 1;
+}
+
+static void clock_latency_display(struct clock *c)
+{
+	const struct latency_hist *h = &c->latency.hist[LATENCY_POLL];
+	struct port *p;
+
+	LIST_FOREACH(p, &c->ports, list) {
+		port_latency_display(p);
+	}
+	if (h->count) {
+		pr_info("latency p50/p99/max ns poll %u/%u/%u",
+			latency_percentile(h, 50.0),
+			latency_percentile(h, 99.0), h->max);
+	}
+}
+
+static void clock_stats_update(struct clock *c, double offset, double freq)
 {
+	struct clock_stats *s = &c->stats;
+
 	stats_add_value(s->offset, offset);
 	stats_add_value(s->freq, freq);
 
@@ -559,6 +820,9 @@ static void clock_stats_update(struct clock_stats *s,
 		return;
 
 	clock_stats_display(s);
+	if (latency_enabled) {
+		clock_latency_display(c);
+	}
 }
 
 static void clock_stats_display(struct clock_stats *s)
@@ -631,7 +895,7 @@ static enum servo_state clock_no_adjust(struct clock *c, tmv_t ingress,
 	freq = (1.0 - ratio) * 1e9;
 
 	if (c->stats.max_count > 1) {
-		clock_stats_update(&c->stats, tmv_dbl(c->master_offset), freq);
+		clock_stats_update(c, tmv_dbl(c->master_offset), freq);
 	} else {
 		pr_info("master offset %10" PRId64 " s%d freq %+7.0f "
 			"path delay %9" PRId64,
@@ -847,7 +1111,8 @@ static void clock_remove_port(struct clock *c, struct port *p)
 	 * the allocated memory at this point, clock_destroy will free
 	 * it all anyway. This function is usable from other parts of
 	 * the code, but even then we don't mind if pollfd is larger
-	 * than necessary. */
+	 * than necessary. Note that the port is left in c->links,
+	 * which clock_destroy frees first. */
 	LIST_REMOVE(p, list);
 	c->nports--;
 	clock_fda_changed(c);
@@ -884,15 +1149,14 @@ int clock_required_modes(struct clock *c)
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////// clock_create used in ptp4l.c
-struct clock *clock_create(enum clock_type type, struct config *config,
-			   const char *phc_device)
+static struct clock *clock_setup(struct clock *c, enum clock_type type,
+				  struct config *config, const char *phc_device)
 {
 	enum servo_type servo = config_get_int(config, NULL, "clock_servo");
 	char ts_label[IF_NAMESIZE], phc[32], *tmp;
 	enum timestamp_type timestamping;
 	int fadj = 0, max_adj = 0, sw_ts;
 	int phc_index, required_modes = 0;
-	struct clock *c = &the_clock;
 	const char *uds_ifname;
 	struct port *p;
 	unsigned char oui[OUI_LEN];
@@ -903,10 +1167,6 @@ struct clock *clock_create(enum clock_type type, struct config *config,
 	clock_gettime(CLOCK_REALTIME, &ts);
 	srandom(ts.tv_sec ^ ts.tv_nsec);
 
-	if (c->nports) {
-		clock_destroy(c);
-	}
-
 	switch (type) {
 	case CLOCK_TYPE_ORDINARY:
 	case CLOCK_TYPE_BOUNDARY:
@@ -993,6 +1253,11 @@ struct clock *clock_create(enum clock_type type, struct config *config,
 	c->timestamping = timestamping;
 	required_modes = clock_required_modes(c);
 	STAILQ_FOREACH(iface, &config->interfaces, list) {
+		if (config_get_int(config, interface_name(iface),
+				   "network_transport") == TRANS_SIM) {
+			interface_ensure_tslabel(iface);
+			continue;
+		}
 		memset(ts_label, 0, sizeof(ts_label));
 		rtnl_get_ts_device(interface_name(iface), ts_label);
 		interface_set_label(iface, ts_label);
@@ -1128,6 +1393,8 @@ struct clock *clock_create(enum clock_type type, struct config *config,
 		pr_err("Failed to create clock servo");
 		return NULL;
 	}
+	c->max_adj = max_adj;
+	tsrec_write(TSREC_SERVO, c->clkid, max_adj, sw_ts, 0, fadj);
 	c->servo_state = SERVO_UNLOCKED;
 	c->servo_type = servo;
 	if (config_get_int(config, NULL, "dataset_comparison") == DS_CMP_G8275) {
@@ -1143,6 +1410,18 @@ struct clock *clock_create(enum clock_type type, struct config *config,
 		return NULL;
 	}
 	c->initial_delay = dbl_tmv(config_get_int(config, NULL, "initial_delay"));
+	if (config_get_string(config, NULL, "state_file")[0]) {
+		snprintf(c->warm_clock, sizeof(c->warm_clock), "%s",
+			 cid2str(&c->dds.clockIdentity));
+	}
+	if (c->warm_clock[0] && !warm_find(c->warm_clock, &c->warm)) {
+		pr_info("found saved state, waiting for parent %s",
+			c->warm.parent);
+		c->warm_pending = 1;
+		if (c->warm.utc_offset_valid) {
+			c->utc_offset = c->warm.utc_offset;
+		}
+	}
 	c->master_local_rr = 1.0;
 	c->nrr = 1.0;
 	c->stats_interval = config_get_int(config, NULL, "summary_interval");
@@ -1182,6 +1461,12 @@ struct clock *clock_create(enum clock_type type, struct config *config,
 		return NULL;
 	}
 
+	c->timers = tmo_heap_create();
+	if (!c->timers) {
+		pr_err("failed to create the timers");
+		return NULL;
+	}
+
 	/* Create the UDS interface. */
 	c->uds_port = port_open(phc_device, phc_index, timestamping, 0, c->udsif, c);
 	if (!c->uds_port) {
@@ -1214,6 +1499,24 @@ struct clock *clock_create(enum clock_type type, struct config *config,
 	return c;
 }
 
+struct clock *clock_create(enum clock_type type, struct config *config,
+			   const char *phc_device)
+{
+	struct clock *c;
+
+	c = calloc(1, sizeof(*c));
+	if (!c) {
+		pr_err("low memory");
+		return NULL;
+	}
+	c->rtnl_fd = -1;
+	if (!clock_setup(c, type, config, phc_device)) {
+		free(c);
+		return NULL;
+	}
+	return c;
+}
+
 struct dataset *clock_best_foreign(struct clock *c)
 {
 	return c->best ? &c->best->dataset : NULL;
@@ -1289,9 +1592,13 @@ static int clock_resize_pollfd(struct clock *c, int new_nports)
 {
 	struct pollfd *new_pollfd;
 
-	/* Need to allocate one whole extra block of fds for UDS. */
+	/*
+	 * Need to allocate one whole extra block of fds for UDS, and
+	 * three more fds for the slave event monitor, the link events,
+	 * and the timers.
+	 */
 	new_pollfd = realloc(c->pollfd,
-			     (new_nports + 1) * N_CLOCK_PFD *
+			     ((new_nports + 1) * N_CLOCK_PFD + 3) *
 			     sizeof(struct pollfd));
 	if (!new_pollfd) {
 		return -1;
@@ -1310,8 +1617,6 @@ static void clock_fill_pollfd(struct pollfd *dest, struct port *p)
 		dest[i].fd = fda->fd[i];
 		dest[i].events = POLLIN|POLLPRI;
 	}
-	dest[i].fd = port_fault_fd(p);
-	dest[i].events = POLLIN|POLLPRI;
 }
 
 static void clock_check_pollfd(struct clock *c)
@@ -1327,6 +1632,15 @@ static void clock_check_pollfd(struct clock *c)
 		dest += N_CLOCK_PFD;
 	}
 	clock_fill_pollfd(dest, c->uds_port);
+	dest += N_CLOCK_PFD;
+	dest->fd = monitor_fd(c->slave_event_monitor);
+	dest->events = POLLIN|POLLPRI;
+	dest++;
+	dest->fd = c->rtnl_fd;
+	dest->events = POLLIN|POLLPRI;
+	dest++;
+	dest->fd = tmo_heap_fd(c->timers);
+	dest->events = POLLIN|POLLPRI;
 	c->pollfd_valid = 1;
 }
 
@@ -1335,9 +1649,74 @@ void clock_fda_changed(struct clock *c)
 	c->pollfd_valid = 0;
 }
 
+static void clock_port_event(struct clock *c, struct port *p,
+			     enum fsm_event event)
+{
+	if (EV_STATE_DECISION_EVENT == event) {
+		c->sde = 1;
+	}
+	if (EV_ANNOUNCE_RECEIPT_TIMEOUT_EXPIRES == event) {
+		c->sde = 1;
+	}
+	if (EV_FAULT_DETECTED == event) {
+		c->sde = 1;
+	}
+	port_dispatch(p, event, 0);
+	/* Clear any fault after a little while. */
+	if (PS_FAULTY == port_state(p)) {
+		clock_fault_timeout(p, 1);
+	}
+}
+
+static void *clock_link_lookup(void *ctx, const char *ifname)
+{
+	struct clock *c = ctx;
+
+	return hash_lookup(c->links, ifname);
+}
+
+static void clock_link_status(void *ctx, void *link, int linkup, int ts_index)
+{
+	struct port *p = link;
+	struct clock *c = ctx;
+	enum fsm_event event;
+
+	event = port_link_event(p, linkup, ts_index);
+	clock_port_event(c, p, event);
+}
+
+void clock_link_query(struct clock *c, struct port *p, const char *ifname)
+{
+	if (c->rtnl_fd < 0) {
+		c->links = hash_create();
+		if (!c->links) {
+			pr_err("low memory");
+			return;
+		}
+		c->rtnl_fd = rtnl_open();
+		if (c->rtnl_fd < 0) {
+			hash_destroy(c->links, NULL);
+			c->links = NULL;
+			return;
+		}
+		clock_fda_changed(c);
+	}
+	/*
+	 * Watch the interface by name, like rtnl_link_status() does, so
+	 * that an interface which appears later or which is created again
+	 * with a new index is still found.
+	 */
+	if (!hash_lookup(c->links, ifname) && hash_insert(c->links, ifname, p)) {
+		pr_err("low memory");
+		return;
+	}
+	rtnl_link_query(c->rtnl_fd, ifname);
+}
+
 static int clock_do_forward_mgmt(struct clock *c,
 				 struct port *in, struct port *out,
-				 struct ptp_message *msg, int *pre_sent)
+				 struct ptp_message *msg,
+				 struct ptp_message **wire)
 {
 	if (in == out || !forwarding(c, out))
 		return 0;
@@ -1352,34 +1731,33 @@ static int clock_do_forward_mgmt(struct clock *c,
 		}
 	}
 
-	if (!*pre_sent) {
-		/* delay calling msg_pre_send until
+	if (!*wire) {
+		/* delay serializing the message until
 		 * actually forwarding */
-		msg_pre_send(msg);
-		*pre_sent = 1;
+		*wire = msg_serialize(msg);
+		if (!*wire)
+			return -1;
 	}
-	return port_forward(out, msg);
+	return port_forward(out, *wire);
 }
 
 static void clock_forward_mgmt_msg(struct clock *c, struct port *p, struct ptp_message *msg)
 {
+	struct ptp_message *wire = NULL;
 	struct port *piter;
-	int pdulen = 0, msg_ready = 0;
 
 	if (forwarding(c, p) && msg->management.boundaryHops) {
-		pdulen = msg->header.messageLength;
 		msg->management.boundaryHops--;
 		LIST_FOREACH(piter, &c->ports, list) {
-			if (clock_do_forward_mgmt(c, p, piter, msg, &msg_ready))
+			if (clock_do_forward_mgmt(c, p, piter, msg, &wire))
 				pr_err("port %d: management forward failed",
 				       port_number(piter));
 		}
-		if (clock_do_forward_mgmt(c, p, c->uds_port, msg, &msg_ready))
+		if (clock_do_forward_mgmt(c, p, c->uds_port, msg, &wire))
 			pr_err("uds port: management forward failed");
-		if (msg_ready) {
-			msg_post_recv(msg, pdulen);
-			msg->management.boundaryHops++;
-		}
+		msg->management.boundaryHops++;
+		if (wire)
+			msg_put(wire);
 	}
 }
 
@@ -1435,6 +1813,8 @@ int clock_manage(struct clock *c, struct port *p, struct ptp_message *msg)
 			return changed;
 		break;
 	case COMMAND:
+		if (clock_management_command(c, p, mgt->id, msg))
+			return changed;
 		break;
 	default:
 		return changed;
@@ -1484,6 +1864,8 @@ int clock_manage(struct clock *c, struct port *p, struct ptp_message *msg)
 	case TLV_GRANDMASTER_SETTINGS_NP:
 	case TLV_SUBSCRIBE_EVENTS_NP:
 	case TLV_SYNCHRONIZATION_UNCERTAIN_NP:
+	case TLV_SNAPSHOT_NP:
+	case TLV_RELOAD_CONFIG_NP:
 		clock_management_send_error(p, msg, TLV_NOT_SUPPORTED);
 		break;
 	default:
@@ -1549,13 +1931,11 @@ void clock_set_sde(struct clock *c, int sde)
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////// clock_poll used in ptp4l.c
 int clock_poll(struct clock *c)
 {
-	int cnt, i;
-	enum fsm_event event;
-	struct pollfd *cur;
-	struct port *p;
+	struct pollfd *pfd;
+	int cnt, num;
 
-	clock_check_pollfd(c);
-	cnt = poll(c->pollfd, (c->nports + 1) * N_CLOCK_PFD, -1);
+	pfd = clock_pollfds(c, &num);
+	cnt = poll(pfd, num, -1);
 	if (cnt < 0) {
 		if (EINTR == errno) {
 			return 0;
@@ -1567,6 +1947,66 @@ int clock_poll(struct clock *c)
 		return 0;
 	}
 
+	return clock_poll_events(c);
+}
+
+struct tmo_heap *clock_tmo_heap(struct clock *c)
+{
+	return c->timers;
+}
+
+struct pollfd *clock_pollfds(struct clock *c, int *num)
+{
+	struct port *p;
+
+	LIST_FOREACH(p, &c->ports, list) {
+		port_flush(p);
+	}
+	clock_check_pollfd(c);
+	tmo_heap_update(c->timers);
+	*num = (c->nports + 1) * N_CLOCK_PFD + 3;
+	return c->pollfd;
+}
+
+static void clock_timer_event(struct clock *c, struct tmo *t)
+{
+	struct port *p = tmo_owner(t);
+	enum fsm_event event;
+
+	/*
+	 * When the fault timer expires we clear the fault,
+	 * but only if the link is up.
+	 */
+	if (tmo_id(t) == FD_FAULT_TIMER) {
+		clock_fault_timeout(p, 0);
+		if (port_link_status_get(p)) {
+			port_dispatch(p, EV_FAULT_CLEARED, 0);
+		}
+		return;
+	}
+
+	event = port_event(p, tmo_id(t));
+	if (p == c->uds_port) {
+		if (EV_STATE_DECISION_EVENT == event) {
+			c->sde = 1;
+		}
+		return;
+	}
+	clock_port_event(c, p, event);
+}
+
+int clock_poll_events(struct clock *c)
+{
+	enum fsm_event event;
+	struct pollfd *cur;
+	struct port *p;
+	int64_t start = 0;
+	struct tmo *t;
+	int i;
+
+	if (latency_enabled) {
+		start = latency_now();
+	}
 	cur = c->pollfd;
 
 	LIST_FOREACH(p, &c->ports, list) {
@@ -1580,35 +2020,12 @@ int clock_poll(struct clock *c)
 				} else {
 					event = port_event(p, i);
 				}
-				if (EV_STATE_DECISION_EVENT == event) {
-					c->sde = 1;
-				}
-				if (EV_ANNOUNCE_RECEIPT_TIMEOUT_EXPIRES == event) {
-					c->sde = 1;
-				}
-				if (EV_FAULT_DETECTED == event) {
-					c->sde = 1;
-				}
-				port_dispatch(p, event, 0);
-				/* Clear any fault after a little while. */
+				clock_port_event(c, p, event);
 				if (PS_FAULTY == port_state(p)) {
-					clock_fault_timeout(p, 1);
 					break;
 				}
 			}
 		}
-
-		/*
-		 * When the fault timer expires we clear the fault,
-		 * but only if the link is up.
-		 */
-		if (cur[N_POLLFD].revents & (POLLIN|POLLPRI)) {
-			clock_fault_timeout(p, 0);
-			if (port_link_status_get(p)) {
-				port_dispatch(p, EV_FAULT_CLEARED, 0);
-			}
-		}
-
 		cur += N_CLOCK_PFD;
 	}
 
@@ -1622,11 +2039,38 @@ int clock_poll(struct clock *c)
 		}
 	}
 
+	/* Check the slave event monitor flush timer. */
+	if (cur[N_CLOCK_PFD].revents & (POLLIN|POLLPRI)) {
+		monitor_flush(c->slave_event_monitor);
+	}
+
+	/* Check the link events of all ports. */
+	if (cur[N_CLOCK_PFD + 1].revents & (POLLIN|POLLPRI)) {
+		rtnl_link_events(c->rtnl_fd, clock_link_lookup,
+				 clock_link_status, c);
+	}
+
+	/*
+	 * Run the expired timers of all ports in the order of their
+	 * deadlines. A timer cleared by an earlier one does not run.
+	 */
+	if (cur[N_CLOCK_PFD + 2].revents & (POLLIN|POLLPRI)) {
+		int64_t now = tmo_now();
+
+		tmo_heap_acknowledge(c->timers);
+		while ((t = tmo_heap_expired(c->timers, now))) {
+			clock_timer_event(c, t);
+		}
+	}
+
 	if (c->sde) {
 		handle_state_decision_event(c);
 		c->sde = 0;
 	}
 	clock_prune_subscriptions(c);
+	if (latency_enabled) {
+		latency_add(&c->latency, LATENCY_POLL, latency_now() - start);
+	}
 	return 0;
 }
 
@@ -1649,6 +2093,9 @@ void clock_peer_delay(struct clock *c, tmv_t ppd, tmv_t req, tmv_t rx,
 	c->path_delay = ppd;
 	c->nrr = nrr;
 
+	tsrec_write(TSREC_PEER_DELAY, c->clkid, tmv_to_nanoseconds(ppd),
+		    tmv_to_nanoseconds(req), tmv_to_nanoseconds(rx), nrr);
+
 	tsproc_set_delay(c->tsproc, ppd);
 	tsproc_up_ts(c->tsproc, req, rx);
 
@@ -1656,6 +2103,11 @@ void clock_peer_delay(struct clock *c, tmv_t ppd, tmv_t req, tmv_t rx,
 		stats_add_value(c->stats.delay, tmv_dbl(ppd));
 }
 
+clockid_t clock_clkid(struct clock *c)
+{
+	return c->clkid;
+}
+
 struct monitor *clock_slave_monitor(struct clock *c)
 {
 	return c->slave_event_monitor;
@@ -1671,6 +2123,11 @@ double clock_get_nrr(struct clock *c)
 	return c->nrr;
 }
 
+struct latency *clock_latency(struct clock *c)
+{
+	return &c->latency;
+}
+
 int clock_slave_only(struct clock *c)
 {
 	return c->dds.flags & DDS_SLAVE_ONLY;
@@ -1718,9 +2175,245 @@ int clock_switch_phc(struct clock *c, int phc_index)
 	c->clkid = clkid;
 	c->servo = servo;
 	c->servo_state = SERVO_UNLOCKED;
+	c->max_adj = max_adj;
+	tsrec_write(TSREC_SERVO, clkid, max_adj, 0, 0, fadj);
 	return 0;
 }
 
+#define RELOAD_SET	(1 << 0) /* read where used, nothing to reset */
+#define RELOAD_CLOCK	(1 << 1) /* default and time properties data sets */
+#define RELOAD_SERVO	(1 << 2)
+#define RELOAD_TSPROC	(1 << 3)
+#define RELOAD_STATS	(1 << 4)
+#define RELOAD_CHECK	(1 << 5)
+#define RELOAD_PORT	(1 << 6)
+#define RELOAD_REOPEN	(1 << 7) /* transport options, port restarts */
+
+/*
+ * What to update when an option changes at run time. Options not
+ * listed here only take effect after a restart.
+ */
+static const unsigned char reload_tab[N_CONFIG_ITEMS] = {
+	[CFG_assume_two_step]			= RELOAD_SET,
+	[CFG_check_fup_sync]			= RELOAD_SET,
+	[CFG_latency_stats]			= RELOAD_SET,
+	[CFG_logging_level]			= RELOAD_SET,
+	[CFG_tx_timestamp_timeout]		= RELOAD_SET,
+	[CFG_use_syslog]			= RELOAD_SET,
+	[CFG_verbose]				= RELOAD_SET,
+	[CFG_clockAccuracy]			= RELOAD_CLOCK,
+	[CFG_clockClass]			= RELOAD_CLOCK,
+	[CFG_domainNumber]			= RELOAD_CLOCK,
+	[CFG_G_8275_defaultDS_localPriority]	= RELOAD_CLOCK,
+	[CFG_initial_delay]			= RELOAD_CLOCK,
+	[CFG_kernel_leap]			= RELOAD_CLOCK,
+	[CFG_maxStepsRemoved]			= RELOAD_CLOCK,
+	[CFG_offsetScaledLogVariance]		= RELOAD_CLOCK,
+	[CFG_priority1]				= RELOAD_CLOCK,
+	[CFG_priority2]				= RELOAD_CLOCK,
+	[CFG_timeSource]			= RELOAD_CLOCK,
+	[CFG_utc_offset]			= RELOAD_CLOCK,
+	[CFG_first_step_threshold]		= RELOAD_SERVO,
+	[CFG_max_frequency]			= RELOAD_SERVO,
+	[CFG_pi_integral_const]			= RELOAD_SERVO,
+	[CFG_pi_integral_exponent]		= RELOAD_SERVO,
+	[CFG_pi_integral_norm_max]		= RELOAD_SERVO,
+	[CFG_pi_integral_scale]			= RELOAD_SERVO,
+	[CFG_pi_proportional_const]		= RELOAD_SERVO,
+	[CFG_pi_proportional_exponent]		= RELOAD_SERVO,
+	[CFG_pi_proportional_norm_max]		= RELOAD_SERVO,
+	[CFG_pi_proportional_scale]		= RELOAD_SERVO,
+	[CFG_servo_num_offset_values]		= RELOAD_SERVO,
+	[CFG_servo_offset_threshold]		= RELOAD_SERVO,
+	[CFG_step_threshold]			= RELOAD_SERVO,
+	[CFG_summary_interval]			= RELOAD_STATS,
+	[CFG_sanity_freq_limit]			= RELOAD_CHECK,
+	[CFG_delay_filter]			= RELOAD_TSPROC | RELOAD_PORT,
+	[CFG_delay_filter_length]		= RELOAD_TSPROC | RELOAD_PORT,
+	[CFG_tsproc_mode]			= RELOAD_TSPROC | RELOAD_PORT,
+	[CFG_freq_est_interval]			= RELOAD_STATS | RELOAD_PORT,
+	[CFG_announceReceiptTimeout]		= RELOAD_PORT,
+	[CFG_delayAsymmetry]			= RELOAD_PORT,
+	[CFG_egressLatency]			= RELOAD_PORT,
+	[CFG_fastLogMinDelayReqInterval]	= RELOAD_PORT,
+	[CFG_fastLogSyncInterval]		= RELOAD_PORT,
+	[CFG_fast_acquisition]			= RELOAD_PORT,
+	[CFG_fast_acquisition_threshold]	= RELOAD_PORT,
+	[CFG_fault_badpeernet_interval]		= RELOAD_PORT,
+	[CFG_fault_reset_interval]		= RELOAD_PORT,
+	[CFG_follow_up_info]			= RELOAD_PORT,
+	[CFG_G_8275_portDS_localPriority]	= RELOAD_PORT,
+	[CFG_ignore_source_id]			= RELOAD_PORT,
+	[CFG_ignore_transport_specific]		= RELOAD_PORT,
+	[CFG_ingressLatency]			= RELOAD_PORT,
+	[CFG_logAnnounceInterval]		= RELOAD_PORT,
+	[CFG_logMinDelayReqInterval]		= RELOAD_PORT,
+	[CFG_logMinPdelayReqInterval]		= RELOAD_PORT,
+	[CFG_logSyncInterval]			= RELOAD_PORT,
+	[CFG_min_neighbor_prop_delay]		= RELOAD_PORT,
+	[CFG_msg_interval_request]		= RELOAD_PORT,
+	[CFG_neighborPropDelayThresh]		= RELOAD_PORT,
+	[CFG_net_sync_monitor]			= RELOAD_PORT,
+	[CFG_operLogPdelayReqInterval]		= RELOAD_PORT,
+	[CFG_operLogSyncInterval]		= RELOAD_PORT,
+	[CFG_path_trace_enabled]		= RELOAD_PORT,
+	[CFG_syncReceiptTimeout]		= RELOAD_PORT,
+	[CFG_transportSpecific]			= RELOAD_PORT,
+	[CFG_dscp_event]			= RELOAD_REOPEN,
+	[CFG_dscp_general]			= RELOAD_REOPEN,
+	[CFG_p2p_dst_mac]			= RELOAD_REOPEN,
+	[CFG_ptp_dst_mac]			= RELOAD_REOPEN,
+	[CFG_socket_priority]			= RELOAD_REOPEN,
+	[CFG_udp6_scope]			= RELOAD_REOPEN,
+	[CFG_udp_ttl]				= RELOAD_REOPEN,
+};
+
+static void clock_reload_datasets(struct clock *c)
+{
+	struct config *cfg = c->config;
+
+	c->dds.clockQuality.clockClass =
+		config_get_int_id(cfg, NULL, CFG_clockClass);
+	c->dds.clockQuality.clockAccuracy =
+		config_get_int_id(cfg, NULL, CFG_clockAccuracy);
+	c->dds.clockQuality.offsetScaledLogVariance =
+		config_get_int_id(cfg, NULL, CFG_offsetScaledLogVariance);
+	if (!c->grand_master_capable || c->dds.flags & DDS_SLAVE_ONLY) {
+		c->dds.clockQuality.clockClass = 255;
+	}
+	c->dds.domainNumber = config_get_int_id(cfg, NULL, CFG_domainNumber);
+	c->dds.priority1 = config_get_int_id(cfg, NULL, CFG_priority1);
+	c->dds.priority2 = config_get_int_id(cfg, NULL, CFG_priority2);
+	c->default_dataset.localPriority =
+		config_get_int_id(cfg, NULL, CFG_G_8275_defaultDS_localPriority);
+	c->max_steps_removed = config_get_int_id(cfg, NULL, CFG_maxStepsRemoved);
+	c->initial_delay = dbl_tmv(config_get_int_id(cfg, NULL, CFG_initial_delay));
+	c->kernel_leap = config_get_int_id(cfg, NULL, CFG_kernel_leap);
+	c->utc_offset = config_get_int_id(cfg, NULL, CFG_utc_offset);
+	c->time_source = config_get_int_id(cfg, NULL, CFG_timeSource);
+}
+
+static void clock_reload_tsproc(struct clock *c)
+{
+	struct config *cfg = c->config;
+	struct tsproc *tsp;
+
+	tsp = tsproc_create(config_get_int_id(cfg, NULL, CFG_tsproc_mode),
+			    config_get_int_id(cfg, NULL, CFG_delay_filter),
+			    config_get_int_id(cfg, NULL, CFG_delay_filter_length));
+	if (!tsp) {
+		pr_err("failed to create time stamp processor");
+		return;
+	}
+	/* Carry the path delay over, so that the servo keeps running. */
+	if (c->servo_state != SERVO_UNLOCKED) {
+		tsproc_set_delay(tsp, c->path_delay);
+	}
+	tsproc_set_clock_rate_ratio(tsp, clock_rate_ratio(c));
+	tsproc_destroy(c->tsproc);
+	c->tsproc = tsp;
+}
+
+static void clock_reload_check(struct clock *c)
+{
+	int sfl = config_get_int_id(c->config, NULL, CFG_sanity_freq_limit);
+
+	if (c->sanity_check) {
+		clockcheck_destroy(c->sanity_check);
+		c->sanity_check = NULL;
+	}
+	if (!sfl) {
+		return;
+	}
+	c->sanity_check = clockcheck_create(sfl);
+	if (!c->sanity_check) {
+		pr_err("Failed to create clock sanity check");
+		return;
+	}
+	if (c->clkid != CLOCK_INVALID) {
+		clockcheck_set_freq(c->sanity_check,
+				    (int) clockadj_get_freq(c->clkid));
+	}
+}
+
+int clock_reload(struct clock *c, struct config *src)
+{
+	struct interface *iface, *known;
+	unsigned int reload = 0;
+	struct port *p;
+	int id, err;
+
+	STAILQ_FOREACH(iface, &src->interfaces, list) {
+		STAILQ_FOREACH(known, &c->config->interfaces, list) {
+			if (!strcmp(interface_name(iface),
+				    interface_name(known))) {
+				break;
+			}
+		}
+		if (!known) {
+			pr_warning("reload: adding port %s needs a restart",
+				   interface_name(iface));
+		}
+	}
+
+	for (id = 0; id < N_CONFIG_ITEMS; id++) {
+		if (!reload_tab[id]) {
+			if (config_changed(c->config, src, id)) {
+				pr_warning("reload: changing %s needs a restart",
+					   config_label(id));
+			}
+			continue;
+		}
+		err = config_update(c->config, src, id);
+		if (err < 0) {
+			return -1;
+		}
+		if (err) {
+			pr_info("reload: %s changed", config_label(id));
+			reload |= reload_tab[id];
+		}
+	}
+
+	if (reload & RELOAD_CLOCK) {
+		clock_reload_datasets(c);
+	}
+	if (reload & RELOAD_SERVO) {
+		servo_reconfigure(c->servo, c->config, c->max_adj);
+		/* The servo gains depend on the sync interval. */
+		reload |= RELOAD_STATS;
+	}
+	if (reload & RELOAD_TSPROC) {
+		clock_reload_tsproc(c);
+	}
+	if (reload & RELOAD_CHECK) {
+		clock_reload_check(c);
+	}
+	if (reload & RELOAD_STATS) {
+		c->stats_interval =
+			config_get_int_id(c->config, NULL, CFG_summary_interval);
+		c->freq_est_interval =
+			config_get_int_id(c->config, NULL, CFG_freq_est_interval);
+		clock_sync_interval(c, c->log_sync_interval);
+	}
+	if (reload & (RELOAD_PORT | RELOAD_REOPEN)) {
+		LIST_FOREACH(p, &c->ports, list) {
+			port_reload(p, reload & RELOAD_REOPEN);
+		}
+	}
+	if (reload & RELOAD_CLOCK) {
+		c->sde = 1;
+	}
+	return 0;
+}
+
+int clock_reload_pending(struct clock *c)
+{
+	int pending = c->reload_pending;
+
+	c->reload_pending = 0;
+	return pending;
+}
+
 static void clock_synchronize_locked(struct clock *c, double adj)
 {
 	clockadj_set_freq(c->clkid, -adj);
@@ -1732,7 +2425,8 @@ static void clock_synchronize_locked(struct clock *c, double adj)
 	}
 }
 
-enum servo_state clock_synchronize(struct clock *c, tmv_t ingress, tmv_t origin)
+static enum servo_state clock_synchronize_servo(struct clock *c, tmv_t ingress,
+						tmv_t origin)
 {
 	enum servo_state state = SERVO_UNLOCKED;
 	double adj, weight;
@@ -1794,8 +2488,19 @@ enum servo_state clock_synchronize(struct clock *c, tmv_t ingress, tmv_t origin)
 		break;
 	}
 
+	monitor_servo(c->slave_event_monitor, c->dad.pds.parentPortIdentity,
+		      ingress, c->master_offset, c->path_delay, adj, state);
+
+	if (c->warm_clock[0] && (state == SERVO_LOCKED ||
+				 state == SERVO_LOCKED_STABLE) &&
+	    warm_due(c->warm_clock)) {
+		clock_warm_save(c, state == SERVO_LOCKED_STABLE &&
+				c->write_phase_mode ?
+				clockadj_get_freq(c->clkid) : -adj);
+	}
+
 	if (c->stats.max_count > 1) {
-		clock_stats_update(&c->stats, tmv_dbl(c->master_offset), adj);
+		clock_stats_update(c, tmv_dbl(c->master_offset), adj);
 	} else {
 		pr_info("master offset %10" PRId64 " s%d freq %+7.0f "
 			"path delay %9" PRId64,
@@ -1806,10 +2511,32 @@ enum servo_state clock_synchronize(struct clock *c, tmv_t ingress, tmv_t origin)
 	return state;
 }
 
+enum servo_state clock_synchronize(struct clock *c, tmv_t ingress, tmv_t origin)
+{
+	enum servo_state state;
+
+	latency_mark(LATENCY_MATCH);
+
+	if (c->clkid == CLOCK_INVALID) {
+		state = clock_synchronize_servo(c, ingress, origin);
+		latency_mark(LATENCY_SERVO);
+		return state;
+	}
+	/* Apply the leap, TAI offset, step and frequency changes at once. */
+	clockadj_begin(c->clkid);
+	state = clock_synchronize_servo(c, ingress, origin);
+	latency_mark(LATENCY_SERVO);
+	clockadj_commit(c->clkid);
+	latency_mark(LATENCY_ADJUST);
+	return state;
+}
+
 void clock_sync_interval(struct clock *c, int n)
 {
 	int shift;
 
+	c->log_sync_interval = n;
+
 	shift = c->freq_est_interval - n;
 	if (shift < 0)
 		shift = 0;
@@ -1829,6 +2556,8 @@ void clock_sync_interval(struct clock *c, int n)
 	c->stats.max_count = (1 << shift);
 
 	servo_sync_interval(c->servo, n < 0 ? 1.0 / (1 << -n) : 1 << n);
+	tsrec_write(TSREC_INTERVAL, c->clkid, 0, 0, 0,
+		    n < 0 ? 1.0 / (1 << -n) : 1 << n);
 }
 
 struct timePropertiesDS clock_time_properties(struct clock *c)
@@ -1886,6 +2615,7 @@ static void handle_state_decision_event(struct clock *c)
 	if (!cid_eq(&best_id, &c->best_id)) {
 		clock_freq_est_reset(c);
 		tsproc_reset(c->tsproc, 1);
+		tsrec_write(TSREC_RESET, c->clkid, 1, 0, 0, 0.0);
 		if (!tmv_is_zero(c->initial_delay))
 			tsproc_set_delay(c->tsproc, c->initial_delay);
 		c->ingress_ts = tmv_zero();
@@ -1894,6 +2624,12 @@ static void handle_state_decision_event(struct clock *c)
 		c->nrr = 1.0;
 		fresh_best = 1;
 		clock_disable_syfu_relay(c);
+		if (best && !port_standby_takeover(best->port,
+						   &best->dataset.sender,
+						   c->tsproc, &c->path_delay))
+			c->cur.meanPathDelay = tmv_to_TimeInterval(c->path_delay);
+		else if (best && clock_warm_parent(c, &best->dataset.sender))
+			clock_warm_start(c);
 	}
 
 	c->best = best;
@@ -33,6 +33,9 @@
 #define POW2_41 ((double)(1ULL << 41))
 
 struct ptp_message; /*forward declaration*/
+struct latency;
+struct pollfd;
+struct tmo_heap;
 
 struct syfu_relay_info {
 	tmv_t precise_origin_ts;
@@ -108,14 +111,14 @@ int clock_required_modes(struct clock *c);
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////// clock_create used in ptp4l.c
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////// defined in clock.c
 /**
- * Create a clock instance. There can only be one clock in any system,
- * so subsequent calls will destroy the previous clock instance.
+ * Create a clock instance. Usually there is one clock in a process,
+ * but a simulation may run several, each with its own configuration.
  *
  * @param type         Specifies which type of clock to create.
  * @param config       Pointer to the configuration database.
  * @param phc_device   PTP hardware clock device to use. Pass NULL for automatic
  *                     selection based on the network interface.
- * @return             A pointer to the single global clock instance.
+ * @return             A pointer to a new clock instance, or NULL on error.
  */
 struct clock *clock_create(enum clock_type type, struct config *config,
 			   const char *phc_device);
@@ -154,6 +157,15 @@ struct port *clock_first_port(struct clock *c);
  */
 void clock_follow_up_info(struct clock *c, struct follow_up_info_tlv *f);
 
+/**
+ * Tell whether a port identity is the parent saved in the state file,
+ * as long as the clock waits for it to come back.
+ * @param c    The clock instance.
+ * @param pid  The identity of a foreign master port.
+ * @return     One if the identity is the saved parent, zero otherwise.
+ */
+int clock_warm_parent(struct clock *c, struct PortIdentity *pid);
+
 /**
  * Determine if a clock is free running or not.
  * @param c  The clock instance.
@@ -183,6 +195,23 @@ struct ClockIdentity clock_identity(struct clock *c);
  */
 void clock_fda_changed(struct clock *c);
 
+/**
+ * Obtain the heap which drives the timers of a clock's ports.
+ * @param c  The clock instance.
+ * @return   The heap of timers.
+ */
+struct tmo_heap *clock_tmo_heap(struct clock *c);
+
+/**
+ * Request the link status of a port's interface. The clock watches the
+ * links of all of its ports with a single RT netlink socket, and passes
+ * each change only to the port concerned.
+ * @param c       The clock instance.
+ * @param p       The port whose link is to be watched.
+ * @param ifname  The name of the port's interface.
+ */
+void clock_link_query(struct clock *c, struct port *p, const char *ifname);
+
 /**
  * Obtains the time of the latest synchronization.
  * @param c    The clock instance.
@@ -266,6 +295,13 @@ tmv_t clock_get_path_delay(struct clock *c);
  */
 double clock_get_nrr(struct clock *c);
 
+/**
+ * Obtain the latency histograms of a clock's poll loop.
+ * @param c  The clock instance.
+ * @return   The histograms, where only LATENCY_POLL is used.
+ */
+struct latency *clock_latency(struct clock *c);
+
 /**
  * Set clock sde
  * @param c     A pointer to a clock instance obtained with clock_create().
@@ -282,6 +318,22 @@ void clock_set_sde(struct clock *c, int sde);
  */
 int clock_poll(struct clock *c);
 
+/**
+ * Obtain the file descriptors of a clock, for waiting on several
+ * clocks at once. The events must be handed to clock_poll_events().
+ * @param c    A pointer to a clock instance obtained with clock_create().
+ * @param num  Returns the number of descriptors.
+ * @return     The array of descriptors, valid until the next call.
+ */
+struct pollfd *clock_pollfds(struct clock *c, int *num);
+
+/**
+ * Dispatch the events returned in the descriptors of clock_pollfds().
+ * @param c A pointer to a clock instance obtained with clock_create().
+ * @return  Zero on success, non-zero otherwise.
+ */
+int clock_poll_events(struct clock *c);
+
 /**
  * Obtain the servo struct.
  * @param c The clock instance.
@@ -296,6 +348,13 @@ struct servo *clock_servo(struct clock *c);
  */
 enum servo_state clock_servo_state(struct clock *c);
 
+/**
+ * Obtain the ID of the clock being disciplined.
+ * @param c The clock instance.
+ * @return  The clock ID, or CLOCK_INVALID if the clock is free running.
+ */
+clockid_t clock_clkid(struct clock *c);
+
 /**
  * Obtain the slave monitor instance from a clock.
  * @param c The clock instance.
@@ -324,6 +383,26 @@ UInteger8 clock_max_steps_removed(struct clock *c);
  */
 UInteger16 clock_steps_removed(struct clock *c);
 
+/**
+ * Applies a freshly read configuration to a running clock. Only the
+ * changed options are taken over, and only the parts of the clock and
+ * the ports which depend on them are reset, so that the servo keeps
+ * its lock. Changes to options which cannot be applied at run time
+ * are reported and ignored.
+ * @param c    The clock instance.
+ * @param src  The new configuration. It is not referenced afterwards.
+ * @return     Zero on success, non-zero otherwise.
+ */
+int clock_reload(struct clock *c, struct config *src);
+
+/**
+ * Checks whether a reload of the configuration was requested by a
+ * management client, and clears the request.
+ * @param c  The clock instance.
+ * @return   One if a reload is pending, zero otherwise.
+ */
+int clock_reload_pending(struct clock *c);
+
 /**
  * Switch to a new PTP Hardware Clock, for use with the "jbod" mode.
  * @param c          The clock instance.
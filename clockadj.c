@@ -18,12 +18,14 @@
  */
 
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #include "clockadj.h"
 #include "missing.h"
 #include "print.h"
+#include "tsrec.h"
 
 #define NS_PER_SEC 1000000000LL
 
@@ -31,8 +33,136 @@ static int realtime_leap_bit;
 static long realtime_hz;
 static long realtime_nominal_tick;
 
+/*
+ * Per clock state. While a batch is open, the adjustments are merged
+ * into tx (and step) and applied by clockadj_commit(). The last
+ * frequency written to or read from the clock is cached to skip writes
+ * which would not change anything.
+ */
+struct clockadj_clock {
+	clockid_t clkid;
+	int batch;
+	struct timex tx;
+	int64_t step;
+	int freq_valid;
+	long freq;
+	long tick;
+	unsigned long issued;
+	unsigned long skipped;
+};
+
+static struct clockadj_clock *clocks;
+static int n_clocks;
+
+static struct clockadj_clock *clockadj_lookup(clockid_t clkid)
+{
+	struct clockadj_clock *cc;
+	int i;
+
+	for (i = 0; i < n_clocks; i++) {
+		if (clocks[i].clkid == clkid) {
+			return &clocks[i];
+		}
+	}
+	cc = realloc(clocks, (n_clocks + 1) * sizeof(*cc));
+	if (!cc) {
+		return NULL;
+	}
+	clocks = cc;
+	cc = &clocks[n_clocks++];
+	memset(cc, 0, sizeof(*cc));
+	cc->clkid = clkid;
+	return cc;
+}
+
+/* Simulated clocks have no kernel driver behind their IDs. */
+static int (*sim_is)(clockid_t clkid);
+static int (*sim_adjtime)(clockid_t clkid, struct timex *tx);
+
+void clockadj_set_sim(int (*is)(clockid_t clkid),
+		      int (*adjtime)(clockid_t clkid, struct timex *tx))
+{
+	sim_is = is;
+	sim_adjtime = adjtime;
+}
+
+/* The time stamp record, when the program keeps one. */
+static void (*record)(int type, clockid_t clkid, int64_t ts0, int64_t ts1,
+		      int64_t ts2, double value);
+
+void clockadj_set_record(void (*fn)(int type, clockid_t clkid,
+				    int64_t ts0, int64_t ts1,
+				    int64_t ts2, double value))
+{
+	record = fn;
+}
+
+static int clockadj_syscall(clockid_t clkid, struct timex *tx)
+{
+	if (sim_is && sim_is(clkid)) {
+		return sim_adjtime(clkid, tx);
+	}
+	return clock_adjtime(clkid, tx);
+}
+
+static int clockadj_adjtime(struct clockadj_clock *cc, clockid_t clkid,
+			    struct timex *tx)
+{
+	long freq = tx->freq, tick = tx->tick;
+	int modes = tx->modes, err;
+
+	err = clockadj_syscall(clkid, tx);
+	if (!cc) {
+		return err;
+	}
+	cc->issued++;
+	if (modes & ADJ_FREQUENCY) {
+		cc->freq_valid = err >= 0;
+		cc->freq = freq;
+		if (modes & ADJ_TICK) {
+			cc->tick = tick;
+		}
+	}
+	return err;
+}
+
+/* Returns 1 if the adjustment was queued in an open batch. */
+static int clockadj_queue(struct clockadj_clock *cc, struct timex *tx)
+{
+	if (!cc || !cc->batch) {
+		return 0;
+	}
+	if (tx->modes & ADJ_FREQUENCY) {
+		cc->tx.freq = tx->freq;
+	}
+	if (tx->modes & ADJ_TICK) {
+		cc->tx.tick = tx->tick;
+	}
+	if (tx->modes & ADJ_OFFSET) {
+		cc->tx.offset = tx->offset;
+	}
+	if (tx->modes & ADJ_STATUS) {
+		cc->tx.status = tx->status;
+	}
+	if (tx->modes & ADJ_MAXERROR) {
+		cc->tx.maxerror = tx->maxerror;
+	}
+	if (tx->modes & ADJ_TAI) {
+		cc->tx.constant = tx->constant;
+	}
+	cc->tx.modes |= tx->modes;
+	cc->skipped++;
+	return 1;
+}
+
 void clockadj_init(clockid_t clkid)
 {
+	struct clockadj_clock *cc = clockadj_lookup(clkid);
+
+	if (cc) {
+		memset(cc, 0, sizeof(*cc));
+		cc->clkid = clkid;
+	}
 #ifdef _SC_CLK_TCK
 	if (clkid == CLOCK_REALTIME) {
 		/* This is USER_HZ in the kernel. */
@@ -48,9 +178,13 @@ void clockadj_init(clockid_t clkid)
 
 void clockadj_set_freq(clockid_t clkid, double freq)
 {
+	struct clockadj_clock *cc = clockadj_lookup(clkid);
 	struct timex tx;
 	memset(&tx, 0, sizeof(tx));
 
+	if (record)
+		record(TSREC_FREQ, clkid, 0, 0, 0, freq);
+
 	/* With system clock set also the tick length. */
 	if (clkid == CLOCK_REALTIME && realtime_nominal_tick) {
 		tx.modes |= ADJ_TICK;
@@ -60,68 +194,176 @@ void clockadj_set_freq(clockid_t clkid, double freq)
 
 	tx.modes |= ADJ_FREQUENCY;
 	tx.freq = (long) (freq * 65.536);
-	if (clock_adjtime(clkid, &tx) < 0)
+
+	if (cc && cc->freq_valid && cc->freq == tx.freq &&
+	    (!(tx.modes & ADJ_TICK) || cc->tick == tx.tick)) {
+		/* Drop a different value queued earlier in the batch. */
+		if (cc->batch) {
+			cc->tx.modes &= ~(ADJ_FREQUENCY | ADJ_TICK);
+		}
+		cc->skipped++;
+		return;
+	}
+	if (clockadj_queue(cc, &tx)) {
+		return;
+	}
+	if (clockadj_adjtime(cc, clkid, &tx) < 0)
 		pr_err("failed to adjust the clock: %m");
 }
 
 double clockadj_get_freq(clockid_t clkid)
 {
+	struct clockadj_clock *cc;
 	double f = 0.0;
 	struct timex tx;
 	memset(&tx, 0, sizeof(tx));
-	if (clock_adjtime(clkid, &tx) < 0) {
+	if (clockadj_syscall(clkid, &tx) < 0) {
 		pr_err("failed to read out the clock frequency adjustment: %m");
 	} else {
 		f = tx.freq / 65.536;
 		if (clkid == CLOCK_REALTIME && realtime_nominal_tick && tx.tick)
 			f += 1e3 * realtime_hz * (tx.tick - realtime_nominal_tick);
+		cc = clockadj_lookup(clkid);
+		if (cc) {
+			cc->freq_valid = 1;
+			cc->freq = tx.freq;
+			cc->tick = tx.tick;
+		}
 	}
 	return f;
 }
 
 void clockadj_set_phase(clockid_t clkid, long offset)
 {
+	struct clockadj_clock *cc = clockadj_lookup(clkid);
 	struct timex tx;
 	memset(&tx, 0, sizeof(tx));
 
+	if (record)
+		record(TSREC_PHASE, clkid, offset, 0, 0, 0.0);
+
 	tx.modes = ADJ_OFFSET | ADJ_NANO;
 	tx.offset = offset;
-	if (clock_adjtime(clkid, &tx) < 0) {
+	if (clockadj_queue(cc, &tx)) {
+		return;
+	}
+	if (clockadj_adjtime(cc, clkid, &tx) < 0) {
 		pr_err("failed to set the clock offset: %m");
 	}
 }
 
-void clockadj_step(clockid_t clkid, int64_t step)
+static void clockadj_step_timex(struct timex *tx, int64_t step)
 {
-	struct timex tx;
 	int sign = 1;
+
 	if (step < 0) {
 		sign = -1;
 		step *= -1;
 	}
-	memset(&tx, 0, sizeof(tx));
-	tx.modes = ADJ_SETOFFSET | ADJ_NANO;
-	tx.time.tv_sec  = sign * (step / NS_PER_SEC);
-	tx.time.tv_usec = sign * (step % NS_PER_SEC);
+	tx->modes |= ADJ_SETOFFSET | ADJ_NANO;
+	tx->time.tv_sec  = sign * (step / NS_PER_SEC);
+	tx->time.tv_usec = sign * (step % NS_PER_SEC);
 	/*
 	 * The value of a timeval is the sum of its fields, but the
 	 * field tv_usec must always be non-negative.
 	 */
-	if (tx.time.tv_usec < 0) {
-		tx.time.tv_sec  -= 1;
-		tx.time.tv_usec += 1000000000;
+	if (tx->time.tv_usec < 0) {
+		tx->time.tv_sec  -= 1;
+		tx->time.tv_usec += 1000000000;
 	}
-	if (clock_adjtime(clkid, &tx) < 0)
+}
+
+void clockadj_step(clockid_t clkid, int64_t step)
+{
+	struct clockadj_clock *cc = clockadj_lookup(clkid);
+	struct timex tx;
+
+	if (record)
+		record(TSREC_STEP, clkid, step, 0, 0, 0.0);
+
+	if (cc && cc->batch) {
+		cc->step += step;
+		cc->tx.modes |= ADJ_SETOFFSET;
+		cc->skipped++;
+		return;
+	}
+	memset(&tx, 0, sizeof(tx));
+	clockadj_step_timex(&tx, step);
+	if (clockadj_adjtime(cc, clkid, &tx) < 0)
 		pr_err("failed to step clock: %m");
 }
 
+void clockadj_begin(clockid_t clkid)
+{
+	struct clockadj_clock *cc = clockadj_lookup(clkid);
+
+	if (!cc || cc->batch) {
+		return;
+	}
+	memset(&cc->tx, 0, sizeof(cc->tx));
+	cc->step = 0;
+	cc->batch = 1;
+}
+
+static void clockadj_commit_one(struct clockadj_clock *cc, struct timex *tx,
+				int modes)
+{
+	struct timex t = *tx;
+
+	t.modes = tx->modes & modes;
+	if (!(t.modes & ~ADJ_NANO)) {
+		return;
+	}
+	/* The merged adjustment was counted as skipped when queued. */
+	cc->skipped--;
+	if (clockadj_adjtime(cc, cc->clkid, &t) < 0)
+		pr_err("failed to adjust the clock: %m");
+}
+
+void clockadj_commit(clockid_t clkid)
+{
+	struct clockadj_clock *cc = clockadj_lookup(clkid);
+	struct timex tx;
+
+	if (!cc || !cc->batch) {
+		return;
+	}
+	cc->batch = 0;
+	tx = cc->tx;
+	if (tx.modes & ADJ_SETOFFSET) {
+		tx.modes &= ~ADJ_SETOFFSET;
+		clockadj_step_timex(&tx, cc->step);
+	}
+	if (clkid == CLOCK_REALTIME) {
+		/* The kernel applies all modes of one call, step first. */
+		clockadj_commit_one(cc, &tx, ~0);
+		return;
+	}
+	/*
+	 * A PHC driver handles a single kind of adjustment per call, so
+	 * the step, the frequency and the phase go separately.
+	 */
+	clockadj_commit_one(cc, &tx, ADJ_SETOFFSET | ADJ_NANO);
+	clockadj_commit_one(cc, &tx, ADJ_FREQUENCY | ADJ_TICK);
+	clockadj_commit_one(cc, &tx, ADJ_OFFSET | ADJ_NANO);
+}
+
+void clockadj_get_counts(clockid_t clkid, unsigned long *issued,
+			 unsigned long *skipped)
+{
+	struct clockadj_clock *cc = clockadj_lookup(clkid);
+
+	*issued = cc ? cc->issued : 0;
+	*skipped = cc ? cc->skipped : 0;
+}
+
 int clockadj_max_freq(clockid_t clkid)
 {
 	int f = 0;
 	struct timex tx;
 
 	memset(&tx, 0, sizeof(tx));
-	if (clock_adjtime(clkid, &tx) < 0)
+	if (clockadj_syscall(clkid, &tx) < 0)
 		pr_err("failed to read out the clock maximum adjustment: %m");
 	else
 		f = tx.tolerance / 65.536;
@@ -142,6 +384,7 @@ int clockadj_max_freq(clockid_t clkid)
 void sysclk_set_leap(int leap)
 {
 	clockid_t clkid = CLOCK_REALTIME;
+	struct clockadj_clock *cc = clockadj_lookup(clkid);
 	struct timex tx;
 	const char *m = NULL;
 	memset(&tx, 0, sizeof(tx));
@@ -158,21 +401,29 @@ void sysclk_set_leap(int leap)
 	default:
 		tx.status = 0;
 	}
-	if (clock_adjtime(clkid, &tx) < 0)
+	realtime_leap_bit = tx.status;
+	if (clockadj_queue(cc, &tx)) {
+		if (m)
+			pr_notice("%s", m);
+		return;
+	}
+	if (clockadj_adjtime(cc, clkid, &tx) < 0)
 		pr_err("failed to set the clock status: %m");
 	else if (m)
 		pr_notice("%s", m);
-	realtime_leap_bit = tx.status;
 }
 
 void sysclk_set_tai_offset(int offset)
 {
 	clockid_t clkid = CLOCK_REALTIME;
+	struct clockadj_clock *cc = clockadj_lookup(clkid);
 	struct timex tx;
 	memset(&tx, 0, sizeof(tx));
 	tx.modes = ADJ_TAI;
 	tx.constant = offset;
-	if (clock_adjtime(clkid, &tx) < 0)
+	if (clockadj_queue(cc, &tx))
+		return;
+	if (clockadj_adjtime(cc, clkid, &tx) < 0)
 		pr_err("failed to set TAI offset: %m");
 }
 
@@ -184,6 +435,7 @@ int sysclk_max_freq(void)
 void sysclk_set_sync(void)
 {
 	clockid_t clkid = CLOCK_REALTIME;
+	struct clockadj_clock *cc = clockadj_lookup(clkid);
 	struct timex tx;
 	memset(&tx, 0, sizeof(tx));
 	/* Clear the STA_UNSYNC flag from the status and keep the maxerror
@@ -191,6 +443,8 @@ void sysclk_set_sync(void)
 	   to avoid getting the STA_UNSYNC flag back. */
 	tx.modes = ADJ_STATUS | ADJ_MAXERROR;
 	tx.status = realtime_leap_bit;
-	if (clock_adjtime(clkid, &tx) < 0)
+	if (clockadj_queue(cc, &tx))
+		return;
+	if (clockadj_adjtime(cc, clkid, &tx) < 0)
 		pr_err("failed to set clock status and maximum error: %m");
 }
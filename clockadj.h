@@ -21,10 +21,30 @@
 #define HAVE_CLOCKADJ_H
 
 #include <inttypes.h>
+#include <sys/timex.h>
 #include <time.h>
 
 /**
- * Initialize state needed when adjusting or reading the clock.
+ * Hand the adjustments of simulated clocks to the simulator, instead
+ * of clock_adjtime().
+ * @param is       Tests whether a clock ID refers to a simulated clock.
+ * @param adjtime  Adjusts a simulated clock, like clock_adjtime().
+ */
+void clockadj_set_sim(int (*is)(clockid_t clkid),
+		      int (*adjtime)(clockid_t clkid, struct timex *tx));
+
+/**
+ * Record every frequency, phase and step adjustment of the clocks.
+ * @param fn  Called like tsrec_write(), with TSREC_FREQ, TSREC_PHASE or
+ *            TSREC_STEP, or NULL to stop recording.
+ */
+void clockadj_set_record(void (*fn)(int type, clockid_t clkid,
+				    int64_t ts0, int64_t ts1,
+				    int64_t ts2, double value));
+
+/**
+ * Initialize state needed when adjusting or reading the clock. This
+ * also resets the adjustment counters and the cached frequency.
  * @param clkid A clock ID obtained using phc_open() or CLOCK_REALTIME.
  */
 void clockadj_init(clockid_t clkid);
@@ -57,6 +77,35 @@ void clockadj_set_phase(clockid_t clkid, long offset);
  */
 void clockadj_step(clockid_t clkid, int64_t step);
 
+/**
+ * Start collecting the adjustments of a clock. Until the matching call
+ * to clockadj_commit(), the frequency, phase, step, status and TAI
+ * offset settings of the clock are merged instead of being applied.
+ * @param clkid A clock ID obtained using phc_open() or CLOCK_REALTIME.
+ */
+void clockadj_begin(clockid_t clkid);
+
+/**
+ * Apply the adjustments collected since clockadj_begin(). The system
+ * clock takes them in a single call of clock_adjtime(). A PHC takes one
+ * call each for the step, the frequency and the phase.
+ * @param clkid A clock ID obtained using phc_open() or CLOCK_REALTIME.
+ */
+void clockadj_commit(clockid_t clkid);
+
+/**
+ * Read the adjustment counters of a clock. A frequency equal to the
+ * last one written to or read from the clock is not written again,
+ * and the adjustments merged in a batch need only one call.
+ * @param clkid   A clock ID obtained using phc_open() or CLOCK_REALTIME.
+ * @param issued  Returns the number of calls of clock_adjtime() made
+ *                to adjust the clock.
+ * @param skipped Returns the number of adjustments which needed no
+ *                call of their own.
+ */
+void clockadj_get_counts(clockid_t clkid, unsigned long *issued,
+			 unsigned long *skipped);
+
 /**
  * Read maximum frequency adjustment of the target clock.
  * @return The maximum frequency adjustment in parts per billion (ppb).
@@ -79,8 +79,6 @@ struct config_item {
 	any_t max;
 };
 
-#define N_CONFIG_ITEMS (sizeof(config_tab) / sizeof(config_tab[0]))
-
 #define CONFIG_ITEM_DBL(_label, _port, _default, _min, _max) {	\
 	.label	= _label,				\
 	.type	= CFG_TYPE_DOUBLE,			\
@@ -111,29 +109,29 @@ struct config_item {
 	.val.s	= _default,				\
 }
 
-#define GLOB_ITEM_DBL(label, _default, min, max) \
-	CONFIG_ITEM_DBL(label, 0, _default, min, max)
+#define GLOB_ITEM_DBL(name, label, _default, min, max) \
+	[CFG_##name] = CONFIG_ITEM_DBL(label, 0, _default, min, max),
 
-#define GLOB_ITEM_ENU(label, _default, table) \
-	CONFIG_ITEM_ENUM(label, 0, _default, table)
+#define GLOB_ITEM_ENU(name, label, _default, table) \
+	[CFG_##name] = CONFIG_ITEM_ENUM(label, 0, _default, table),
 
-#define GLOB_ITEM_INT(label, _default, min, max) \
-	CONFIG_ITEM_INT(label, 0, _default, min, max)
+#define GLOB_ITEM_INT(name, label, _default, min, max) \
+	[CFG_##name] = CONFIG_ITEM_INT(label, 0, _default, min, max),
 
-#define GLOB_ITEM_STR(label, _default) \
-	CONFIG_ITEM_STRING(label, 0, _default)
+#define GLOB_ITEM_STR(name, label, _default) \
+	[CFG_##name] = CONFIG_ITEM_STRING(label, 0, _default),
 
-#define PORT_ITEM_DBL(label, _default, min, max) \
-	CONFIG_ITEM_DBL(label, 1, _default, min, max)
+#define PORT_ITEM_DBL(name, label, _default, min, max) \
+	[CFG_##name] = CONFIG_ITEM_DBL(label, 1, _default, min, max),
 
-#define PORT_ITEM_ENU(label, _default, table) \
-	CONFIG_ITEM_ENUM(label, 1, _default, table)
+#define PORT_ITEM_ENU(name, label, _default, table) \
+	[CFG_##name] = CONFIG_ITEM_ENUM(label, 1, _default, table),
 
-#define PORT_ITEM_INT(label, _default, min, max) \
-	CONFIG_ITEM_INT(label, 1, _default, min, max)
+#define PORT_ITEM_INT(name, label, _default, min, max) \
+	[CFG_##name] = CONFIG_ITEM_INT(label, 1, _default, min, max),
 
-#define PORT_ITEM_STR(label, _default) \
-	CONFIG_ITEM_STRING(label, 1, _default)
+#define PORT_ITEM_STR(name, label, _default) \
+	[CFG_##name] = CONFIG_ITEM_STRING(label, 1, _default),
 
 static struct config_enum clock_servo_enu[] = {
 	{ "pi",     CLOCK_SERVO_PI     },
@@ -188,6 +186,7 @@ static struct config_enum nw_trans_enu[] = {
 	{ "L2",    TRANS_IEEE_802_3 },
 	{ "UDPv4", TRANS_UDP_IPV4   },
 	{ "UDPv6", TRANS_UDP_IPV6   },
+	{ "sim",   TRANS_SIM        },
 	{ NULL, 0 },
 };
 
@@ -220,119 +219,19 @@ static struct config_enum bmca_enu[] = {
 	{ NULL, 0 },
 };
 
-struct config_item config_tab[] = {
-	PORT_ITEM_INT("announceReceiptTimeout", 3, 2, UINT8_MAX),
-	PORT_ITEM_ENU("asCapable", AS_CAPABLE_AUTO, as_capable_enu),
-	GLOB_ITEM_INT("assume_two_step", 0, 0, 1),
-	PORT_ITEM_INT("boundary_clock_jbod", 0, 0, 1),
-	PORT_ITEM_ENU("BMCA", BMCA_PTP, bmca_enu),
-	GLOB_ITEM_INT("check_fup_sync", 0, 0, 1),
-	GLOB_ITEM_INT("clockAccuracy", 0xfe, 0, UINT8_MAX),
-	GLOB_ITEM_INT("clockClass", 248, 0, UINT8_MAX),
-	GLOB_ITEM_STR("clockIdentity", "000000.0000.000000"),
-	GLOB_ITEM_ENU("clock_servo", CLOCK_SERVO_PI, clock_servo_enu),
-	GLOB_ITEM_ENU("clock_type", CLOCK_TYPE_ORDINARY, clock_type_enu),
-	GLOB_ITEM_ENU("dataset_comparison", DS_CMP_IEEE1588, dataset_comp_enu),
-	PORT_ITEM_INT("delayAsymmetry", 0, INT_MIN, INT_MAX),
-	PORT_ITEM_ENU("delay_filter", FILTER_MOVING_MEDIAN, delay_filter_enu),
-	PORT_ITEM_INT("delay_filter_length", 10, 1, INT_MAX),
-	PORT_ITEM_ENU("delay_mechanism", DM_E2E, delay_mech_enu),
-	GLOB_ITEM_INT("dscp_event", 0, 0, 63),
-	GLOB_ITEM_INT("dscp_general", 0, 0, 63),
-	GLOB_ITEM_INT("domainNumber", 0, 0, 127),
-	PORT_ITEM_INT("egressLatency", 0, INT_MIN, INT_MAX),
-	PORT_ITEM_INT("fault_badpeernet_interval", 16, INT32_MIN, INT32_MAX),
-	PORT_ITEM_INT("fault_reset_interval", 4, INT8_MIN, INT8_MAX),
-	GLOB_ITEM_DBL("first_step_threshold", 0.00002, 0.0, DBL_MAX),
-	PORT_ITEM_INT("follow_up_info", 0, 0, 1),
-	GLOB_ITEM_INT("free_running", 0, 0, 1),
-	PORT_ITEM_INT("freq_est_interval", 1, 0, INT_MAX),
-	GLOB_ITEM_INT("G.8275.defaultDS.localPriority", 128, 1, UINT8_MAX),
-	PORT_ITEM_INT("G.8275.portDS.localPriority", 128, 1, UINT8_MAX),
-	GLOB_ITEM_INT("gmCapable", 1, 0, 1),
-	GLOB_ITEM_ENU("hwts_filter", HWTS_FILTER_NORMAL, hwts_filter_enu),
-	PORT_ITEM_INT("hybrid_e2e", 0, 0, 1),
-	PORT_ITEM_INT("ignore_source_id", 0, 0, 1),
-	PORT_ITEM_INT("ignore_transport_specific", 0, 0, 1),
-	PORT_ITEM_INT("ingressLatency", 0, INT_MIN, INT_MAX),
-	PORT_ITEM_INT("inhibit_announce", 0, 0, 1),
-	PORT_ITEM_INT("inhibit_delay_req", 0, 0, 1),
-	PORT_ITEM_INT("inhibit_multicast_service", 0, 0, 1),
-	GLOB_ITEM_INT("initial_delay", 0, 0, INT_MAX),
-	GLOB_ITEM_INT("kernel_leap", 1, 0, 1),
-	PORT_ITEM_INT("logAnnounceInterval", 1, INT8_MIN, INT8_MAX),
-	PORT_ITEM_INT("logMinDelayReqInterval", 0, INT8_MIN, INT8_MAX),
-	PORT_ITEM_INT("logMinPdelayReqInterval", 0, INT8_MIN, INT8_MAX),
-	PORT_ITEM_INT("logSyncInterval", 0, INT8_MIN, INT8_MAX),
-	GLOB_ITEM_INT("logging_level", LOG_INFO, PRINT_LEVEL_MIN, PRINT_LEVEL_MAX),
-	PORT_ITEM_INT("masterOnly", 0, 0, 1),
-	GLOB_ITEM_INT("maxStepsRemoved", 255, 2, UINT8_MAX),
-	GLOB_ITEM_STR("message_tag", NULL),
-	GLOB_ITEM_STR("manufacturerIdentity", "00:00:00"),
-	GLOB_ITEM_INT("max_frequency", 900000000, 0, INT_MAX),
-	PORT_ITEM_INT("min_neighbor_prop_delay", -20000000, INT_MIN, -1),
-	PORT_ITEM_INT("msg_interval_request", 0, 0, 1),
-	PORT_ITEM_INT("neighborPropDelayThresh", 20000000, 0, INT_MAX),
-	PORT_ITEM_INT("net_sync_monitor", 0, 0, 1),
-	PORT_ITEM_ENU("network_transport", TRANS_UDP_IPV4, nw_trans_enu),
-	GLOB_ITEM_INT("ntpshm_segment", 0, INT_MIN, INT_MAX),
-	GLOB_ITEM_INT("offsetScaledLogVariance", 0xffff, 0, UINT16_MAX),
-	PORT_ITEM_INT("operLogPdelayReqInterval", 0, INT8_MIN, INT8_MAX),
-	PORT_ITEM_INT("operLogSyncInterval", 0, INT8_MIN, INT8_MAX),
-	PORT_ITEM_INT("path_trace_enabled", 0, 0, 1),
-	GLOB_ITEM_DBL("pi_integral_const", 0.0, 0.0, DBL_MAX),
-	GLOB_ITEM_DBL("pi_integral_exponent", 0.4, -DBL_MAX, DBL_MAX),
-	GLOB_ITEM_DBL("pi_integral_norm_max", 0.3, DBL_MIN, 2.0),
-	GLOB_ITEM_DBL("pi_integral_scale", 0.0, 0.0, DBL_MAX),
-	GLOB_ITEM_DBL("pi_proportional_const", 0.0, 0.0, DBL_MAX),
-	GLOB_ITEM_DBL("pi_proportional_exponent", -0.3, -DBL_MAX, DBL_MAX),
-	GLOB_ITEM_DBL("pi_proportional_norm_max", 0.7, DBL_MIN, 1.0),
-	GLOB_ITEM_DBL("pi_proportional_scale", 0.0, 0.0, DBL_MAX),
-	GLOB_ITEM_INT("priority1", 128, 0, UINT8_MAX),
-	GLOB_ITEM_INT("priority2", 128, 0, UINT8_MAX),
-	GLOB_ITEM_STR("productDescription", ";;"),
-	PORT_ITEM_STR("ptp_dst_mac", "01:1B:19:00:00:00"),
-	PORT_ITEM_STR("p2p_dst_mac", "01:80:C2:00:00:0E"),
-	GLOB_ITEM_STR("revisionData", ";;"),
-	GLOB_ITEM_INT("sanity_freq_limit", 200000000, 0, INT_MAX),
-	GLOB_ITEM_INT("servo_num_offset_values", 10, 0, INT_MAX),
-	GLOB_ITEM_INT("servo_offset_threshold", 0, 0, INT_MAX),
-	GLOB_ITEM_STR("slave_event_monitor", ""),
-	GLOB_ITEM_INT("slaveOnly", 0, 0, 1),
-	GLOB_ITEM_INT("socket_priority", 0, 0, 15),
-	GLOB_ITEM_DBL("step_threshold", 0.0, 0.0, DBL_MAX),
-	GLOB_ITEM_INT("summary_interval", 0, INT_MIN, INT_MAX),
-	PORT_ITEM_INT("syncReceiptTimeout", 0, 0, UINT8_MAX),
-	GLOB_ITEM_INT("tc_spanning_tree", 0, 0, 1),
-	GLOB_ITEM_INT("timeSource", INTERNAL_OSCILLATOR, 0x10, 0xfe),
-	GLOB_ITEM_ENU("time_stamping", TS_HARDWARE, timestamping_enu),
-	PORT_ITEM_INT("transportSpecific", 0, 0, 0x0F),
-	PORT_ITEM_INT("ts2phc.channel", 0, 0, INT_MAX),
-	PORT_ITEM_INT("ts2phc.extts_correction", 0, INT_MIN, INT_MAX),
-	PORT_ITEM_ENU("ts2phc.extts_polarity", PTP_RISING_EDGE, extts_polarity_enu),
-	PORT_ITEM_INT("ts2phc.master", 0, 0, 1),
-	GLOB_ITEM_STR("ts2phc.nmea_remote_host", ""),
-	GLOB_ITEM_STR("ts2phc.nmea_remote_port", ""),
-	GLOB_ITEM_STR("ts2phc.nmea_serialport", "/dev/ttyS0"),
-	PORT_ITEM_INT("ts2phc.perout_phase", -1, 0, 999999999),
-	PORT_ITEM_INT("ts2phc.pin_index", 0, 0, INT_MAX),
-	GLOB_ITEM_INT("ts2phc.pulsewidth", 500000000, 1000000, 999000000),
-	PORT_ITEM_ENU("tsproc_mode", TSPROC_FILTER, tsproc_enu),
-	GLOB_ITEM_INT("twoStepFlag", 1, 0, 1),
-	GLOB_ITEM_INT("tx_timestamp_timeout", 1, 1, INT_MAX),
-	PORT_ITEM_INT("udp_ttl", 1, 1, 255),
-	PORT_ITEM_INT("udp6_scope", 0x0E, 0x00, 0x0F),
-	GLOB_ITEM_STR("uds_address", "/var/run/ptp4l"),
-	PORT_ITEM_INT("unicast_listen", 0, 0, 1),
-	PORT_ITEM_INT("unicast_master_table", 0, 0, INT_MAX),
-	PORT_ITEM_INT("unicast_req_duration", 3600, 10, INT_MAX),
-	GLOB_ITEM_INT("use_syslog", 1, 0, 1),
-	GLOB_ITEM_STR("userDescription", ""),
-	GLOB_ITEM_INT("utc_offset", CURRENT_UTC_OFFSET, 0, INT_MAX),
-	GLOB_ITEM_INT("verbose", 0, 0, 1),
-	GLOB_ITEM_INT("write_phase_mode", 0, 0, 1),
+static const struct config_item config_tab[N_CONFIG_ITEMS] = {
+#include "config_tab.h"
 };
 
+#undef GLOB_ITEM_DBL
+#undef GLOB_ITEM_ENU
+#undef GLOB_ITEM_INT
+#undef GLOB_ITEM_STR
+#undef PORT_ITEM_DBL
+#undef PORT_ITEM_ENU
+#undef PORT_ITEM_INT
+#undef PORT_ITEM_STR
+
 static struct unicast_master_table *current_uc_mtab;
 
 static enum parser_result
@@ -718,7 +617,7 @@ static void check_deprecated_options(const char **option)
 
 static struct option *config_alloc_longopts(void)
 {
-	struct config_item *ci;
+	const struct config_item *ci;
 	struct option *opts;
 	int i;
 
@@ -894,9 +793,18 @@ struct config *config_create(void)
 		return NULL;
 	}
 
+	cfg->global = malloc(sizeof(config_tab));
+	if (!cfg->global) {
+		hash_destroy(cfg->htab, NULL);
+		free(cfg->opts);
+		free(cfg);
+		return NULL;
+	}
+	memcpy(cfg->global, config_tab, sizeof(config_tab));
+
 	/* Populate the hash table with global defaults. */
 	for (i = 0; i < N_CONFIG_ITEMS; i++) {
-		ci = &config_tab[i];
+		ci = &cfg->global[i];
 		ci->flags |= CFG_ITEM_STATIC;
 		snprintf(buf, sizeof(buf), "global.%s", ci->label);
 		if (hash_insert(cfg->htab, buf, ci)) {
@@ -907,9 +815,8 @@ struct config *config_create(void)
 
 	/* Perform a Built In Self Test.*/
 	for (i = 0; i < N_CONFIG_ITEMS; i++) {
-		ci = &config_tab[i];
-		ci = config_global_item(cfg, ci->label);
-		if (ci != &config_tab[i]) {
+		ci = config_global_item(cfg, config_tab[i].label);
+		if (ci != &cfg->global[i]) {
 			fprintf(stderr, "config BIST failed at %s\n",
 				config_tab[i].label);
 			goto fail;
@@ -918,6 +825,7 @@ struct config *config_create(void)
 	return cfg;
 fail:
 	hash_destroy(cfg->htab, NULL);
+	free(cfg->global);
 	free(cfg->opts);
 	free(cfg);
 	return NULL;
@@ -945,6 +853,7 @@ void config_destroy(struct config *cfg)
 		free(table);
 	}
 	hash_destroy(cfg->htab, config_item_free);
+	free(cfg->global);
 	free(cfg->opts);
 	free(cfg);
 }
@@ -996,6 +905,224 @@ char *config_get_string(struct config *cfg, const char *section,
 	return ci->val.s;
 }
 
+static struct config_item *config_find_id(struct config *cfg,
+					  const char *section,
+					  enum config_id id)
+{
+	struct config_item *ci;
+
+	if (section) {
+		ci = config_section_item(cfg, section, cfg->global[id].label);
+		if (ci) {
+			return ci;
+		}
+	}
+	return &cfg->global[id];
+}
+
+double config_get_double_id(struct config *cfg, const char *section,
+			    enum config_id id)
+{
+	struct config_item *ci = config_find_id(cfg, section, id);
+
+	if (ci->type != CFG_TYPE_DOUBLE) {
+		pr_err("bug: config option %s type mismatch!", ci->label);
+		exit(-1);
+	}
+	return ci->val.d;
+}
+
+int config_get_int_id(struct config *cfg, const char *section,
+		      enum config_id id)
+{
+	struct config_item *ci = config_find_id(cfg, section, id);
+
+	if (ci->type != CFG_TYPE_INT && ci->type != CFG_TYPE_ENUM) {
+		pr_err("bug: config option %s type mismatch!", ci->label);
+		exit(-1);
+	}
+	return ci->val.i;
+}
+
+char *config_get_string_id(struct config *cfg, const char *section,
+			   enum config_id id)
+{
+	struct config_item *ci = config_find_id(cfg, section, id);
+
+	if (ci->type != CFG_TYPE_STRING) {
+		pr_err("bug: config option %s type mismatch!", ci->label);
+		exit(-1);
+	}
+	return ci->val.s;
+}
+
+#define GLOB_ITEM_DBL(name, ...)
+#define GLOB_ITEM_ENU(name, ...)
+#define GLOB_ITEM_INT(name, ...)
+#define GLOB_ITEM_STR(name, ...)
+#define PORT_ITEM_DBL(name, ...) \
+	cp->name = config_find_id(cfg, section, CFG_##name)->val.d;
+#define PORT_ITEM_ENU(name, ...) \
+	cp->name = config_find_id(cfg, section, CFG_##name)->val.i;
+#define PORT_ITEM_INT(name, ...) \
+	cp->name = config_find_id(cfg, section, CFG_##name)->val.i;
+#define PORT_ITEM_STR(name, ...) \
+	cp->name = config_find_id(cfg, section, CFG_##name)->val.s;
+
+void config_resolve_port(struct config *cfg, const char *section,
+			 struct config_port *cp)
+{
+#include "config_tab.h"
+}
+
+#undef GLOB_ITEM_DBL
+#undef GLOB_ITEM_ENU
+#undef GLOB_ITEM_INT
+#undef GLOB_ITEM_STR
+#undef PORT_ITEM_DBL
+#undef PORT_ITEM_ENU
+#undef PORT_ITEM_INT
+#undef PORT_ITEM_STR
+
+const char *config_label(enum config_id id)
+{
+	return config_tab[id].label;
+}
+
+static int config_item_differs(struct config_item *a, struct config_item *b)
+{
+	switch (a->type) {
+	case CFG_TYPE_INT:
+	case CFG_TYPE_ENUM:
+		return a->val.i != b->val.i;
+	case CFG_TYPE_DOUBLE:
+		return a->val.d != b->val.d;
+	case CFG_TYPE_STRING:
+		if (!a->val.s || !b->val.s) {
+			return a->val.s != b->val.s;
+		}
+		return strcmp(a->val.s, b->val.s) != 0;
+	}
+	return 0;
+}
+
+static int config_item_copy(struct config_item *dst, struct config_item *src)
+{
+	char *s;
+
+	if (dst == src || !config_item_differs(dst, src)) {
+		return 0;
+	}
+	if (dst->type != CFG_TYPE_STRING) {
+		dst->val = src->val;
+		return 0;
+	}
+	s = src->val.s ? strdup(src->val.s) : NULL;
+	if (src->val.s && !s) {
+		pr_err("low memory");
+		return -1;
+	}
+	if (dst->flags & CFG_ITEM_DYNSTR) {
+		free(dst->val.s);
+	}
+	dst->val.s = s;
+	if (s) {
+		dst->flags |= CFG_ITEM_DYNSTR;
+	} else {
+		dst->flags &= ~CFG_ITEM_DYNSTR;
+	}
+	return 0;
+}
+
+/*
+ * Returns the item holding the value which an option will have after
+ * taking over the configuration 'src'. Values set on the command line
+ * or by the program itself are kept.
+ */
+static struct config_item *config_next_item(struct config *cfg,
+					    struct config *src,
+					    const char *section,
+					    enum config_id id)
+{
+	struct config_item *ci;
+
+	if (section) {
+		ci = config_section_item(cfg, section, cfg->global[id].label);
+		if (ci && ci->flags & CFG_ITEM_LOCKED) {
+			return ci;
+		}
+		ci = config_section_item(src, section, cfg->global[id].label);
+		if (ci) {
+			return ci;
+		}
+	}
+	if (cfg->global[id].flags & CFG_ITEM_LOCKED) {
+		return &cfg->global[id];
+	}
+	return &src->global[id];
+}
+
+int config_changed(struct config *cfg, struct config *src, enum config_id id)
+{
+	struct interface *iface;
+	const char *name;
+
+	if (config_item_differs(&cfg->global[id],
+				config_next_item(cfg, src, NULL, id))) {
+		return 1;
+	}
+	STAILQ_FOREACH(iface, &cfg->interfaces, list) {
+		name = interface_name(iface);
+		if (config_item_differs(config_find_id(cfg, name, id),
+					config_next_item(cfg, src, name, id))) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int config_update(struct config *cfg, struct config *src, enum config_id id)
+{
+	struct config_item *dst, *next;
+	struct interface *iface;
+	const char *name;
+
+	if (!config_changed(cfg, src, id)) {
+		return 0;
+	}
+	if (config_item_copy(&cfg->global[id],
+			     config_next_item(cfg, src, NULL, id))) {
+		return -1;
+	}
+	STAILQ_FOREACH(iface, &cfg->interfaces, list) {
+		name = interface_name(iface);
+		dst = config_section_item(cfg, name, cfg->global[id].label);
+		next = config_next_item(cfg, src, name, id);
+		if (!dst) {
+			if (!config_item_differs(&cfg->global[id], next)) {
+				continue;
+			}
+			dst = config_item_alloc(cfg, name,
+						cfg->global[id].label,
+						cfg->global[id].type);
+			if (!dst) {
+				return -1;
+			}
+			if (dst->type == CFG_TYPE_STRING) {
+				dst->val.s = "";
+			}
+		}
+		/*
+		 * The hash table offers no removal, so a section item
+		 * which is gone from the new file takes the global value.
+		 */
+		if (config_item_copy(dst, next)) {
+			return -1;
+		}
+	}
+	return 1;
+}
+
 int config_harmonize_onestep(struct config *cfg)
 {
 	enum timestamp_type tstype = config_get_int(cfg, NULL, "time_stamping");
@@ -1109,20 +1236,34 @@ int config_set_section_int(struct config *cfg, const char *section,
 			return -1;
 		}
 	}
+	dst->flags |= CFG_ITEM_LOCKED;
 	dst->val.i = val;
-	pr_debug("section item %s.%s now %d", section, option, dst->val.i);
+	pr_debug("locked item %s.%s as %d", section, option, dst->val.i);
 	return 0;
 }
 
-int config_set_string(struct config *cfg, const char *option,
-		      const char *val)
+int config_set_section_string(struct config *cfg, const char *section,
+			      const char *option, const char *val)
 {
-	struct config_item *ci = config_find_item(cfg, NULL, option);
+	struct config_item *cgi, *ci;
 
-	if (!ci || ci->type != CFG_TYPE_STRING) {
+	cgi = config_find_item(cfg, NULL, option);
+	if (!cgi || cgi->type != CFG_TYPE_STRING) {
 		pr_err("bug: config option %s missing or invalid!", option);
 		return -1;
 	}
+	if (!section) {
+		ci = cgi;
+	} else {
+		/* Create or update this port specific item. */
+		ci = config_section_item(cfg, section, option);
+		if (!ci) {
+			ci = config_item_alloc(cfg, section, option, cgi->type);
+			if (!ci) {
+				return -1;
+			}
+		}
+	}
 	ci->flags |= CFG_ITEM_LOCKED;
 	if (ci->flags & CFG_ITEM_DYNSTR) {
 		free(ci->val.s);
@@ -1133,6 +1274,7 @@ int config_set_string(struct config *cfg, const char *option,
 		return -1;
 	}
 	ci->flags |= CFG_ITEM_DYNSTR;
-	pr_debug("locked item global.%s as '%s'", option, ci->val.s);
+	pr_debug("locked item %s.%s as '%s'", section ? section : "global",
+		 option, ci->val.s);
 	return 0;
 }
@@ -32,6 +32,57 @@
 #include "servo.h"
 #include "sk.h"
 
+#define GLOB_ITEM_DBL(name, ...) CFG_##name,
+#define GLOB_ITEM_ENU(name, ...) CFG_##name,
+#define GLOB_ITEM_INT(name, ...) CFG_##name,
+#define GLOB_ITEM_STR(name, ...) CFG_##name,
+#define PORT_ITEM_DBL(name, ...) CFG_##name,
+#define PORT_ITEM_ENU(name, ...) CFG_##name,
+#define PORT_ITEM_INT(name, ...) CFG_##name,
+#define PORT_ITEM_STR(name, ...) CFG_##name,
+
+/* Identifies a configuration option, generated from config_tab.h. */
+enum config_id {
+#include "config_tab.h"
+	N_CONFIG_ITEMS
+};
+
+#undef GLOB_ITEM_DBL
+#undef GLOB_ITEM_ENU
+#undef GLOB_ITEM_INT
+#undef GLOB_ITEM_STR
+#undef PORT_ITEM_DBL
+#undef PORT_ITEM_ENU
+#undef PORT_ITEM_INT
+#undef PORT_ITEM_STR
+
+#define GLOB_ITEM_DBL(name, ...)
+#define GLOB_ITEM_ENU(name, ...)
+#define GLOB_ITEM_INT(name, ...)
+#define GLOB_ITEM_STR(name, ...)
+#define PORT_ITEM_DBL(name, ...) double name;
+#define PORT_ITEM_ENU(name, ...) int name;
+#define PORT_ITEM_INT(name, ...) int name;
+#define PORT_ITEM_STR(name, ...) const char *name;
+
+/*
+ * The effective values of all of the port options for one port,
+ * taking the port section into account. The fields are named after
+ * the options, with the dots replaced by underscores.
+ */
+struct config_port {
+#include "config_tab.h"
+};
+
+#undef GLOB_ITEM_DBL
+#undef GLOB_ITEM_ENU
+#undef GLOB_ITEM_INT
+#undef GLOB_ITEM_STR
+#undef PORT_ITEM_DBL
+#undef PORT_ITEM_ENU
+#undef PORT_ITEM_INT
+#undef PORT_ITEM_STR
+
 struct config {
 	/* configured interfaces */
 	STAILQ_HEAD(interfaces_head, interface) interfaces;
@@ -43,6 +94,9 @@ struct config {
 	/* hash of all non-legacy items */
 	struct hash *htab;
 
+	/* global items, indexed by enum config_id */
+	struct config_item *global;
+
 	/* unicast master tables */
 	STAILQ_HEAD(ucmtab_head, unicast_master_table) unicast_master_tables;
 };
@@ -68,6 +122,59 @@ int config_get_int(struct config *cfg, const char *section,
 char *config_get_string(struct config *cfg, const char *section,
 			const char *option);
 
+/*
+ * The xxx_id() variants look up the option by its identifier. Without
+ * a section, the global value is read directly from an array.
+ */
+double config_get_double_id(struct config *cfg, const char *section,
+			    enum config_id id);
+
+int config_get_int_id(struct config *cfg, const char *section,
+		      enum config_id id);
+
+char *config_get_string_id(struct config *cfg, const char *section,
+			   enum config_id id);
+
+/**
+ * Resolves the effective values of all port options for one port.
+ * The strings remain owned by the configuration.
+ * @param cfg      The configuration.
+ * @param section  The name of the port section.
+ * @param cp       Filled with the values of the port options.
+ */
+void config_resolve_port(struct config *cfg, const char *section,
+			 struct config_port *cp);
+
+/**
+ * Obtains the name of an option.
+ * @param id  The identifier of the option.
+ * @return    The label of the option as used in the configuration file.
+ */
+const char *config_label(enum config_id id);
+
+/**
+ * Checks whether taking over another configuration would change the
+ * value of an option, either globally or in the section of one of the
+ * configured interfaces. Values set on the command line are kept and
+ * do not count as a change.
+ * @param cfg  The running configuration.
+ * @param src  A freshly read configuration.
+ * @param id   The option to compare.
+ * @return     One if the value would change, zero otherwise.
+ */
+int config_changed(struct config *cfg, struct config *src, enum config_id id);
+
+/**
+ * Takes over the value of an option from another configuration, as
+ * compared by @ref config_changed(). Strings are copied, so that the
+ * other configuration may be destroyed afterwards.
+ * @param cfg  The running configuration.
+ * @param src  A freshly read configuration.
+ * @param id   The option to update.
+ * @return     One if the value changed, zero if not, -1 on error.
+ */
+int config_update(struct config *cfg, struct config *src, enum config_id id);
+
 int config_harmonize_onestep(struct config *cfg);
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////// config_long_options used in ptp4l.c
@@ -92,7 +199,13 @@ static inline int config_set_int(struct config *cfg,
 	return config_set_section_int(cfg, NULL, option, val);
 }
 
-int config_set_string(struct config *cfg, const char *option,
-		      const char *val);
+int config_set_section_string(struct config *cfg, const char *section,
+			      const char *option, const char *val);
+
+static inline int config_set_string(struct config *cfg,
+				    const char *option, const char *val)
+{
+	return config_set_section_string(cfg, NULL, option, val);
+}
 
 #endif
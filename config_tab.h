@@ -0,0 +1,171 @@
+/**
+ * @file config_tab.h
+ * @brief The table of configuration options, moved out of config.c.
+ * @note Copyright (C) 2011 Richard Cochran <richardcochran@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This file is included several times, with the XXX_ITEM_YYY() macros
+ * defined differently each time, in order to generate the option
+ * identifiers and the resolved port settings in config.h, and the
+ * table of defaults in config.c.
+ *
+ * The first argument of each entry is the option name as a C
+ * identifier, with the dots replaced by underscores.
+ */
+PORT_ITEM_INT(announceReceiptTimeout, "announceReceiptTimeout", 3, 2, UINT8_MAX)
+PORT_ITEM_ENU(asCapable, "asCapable", AS_CAPABLE_AUTO, as_capable_enu)
+GLOB_ITEM_INT(assume_two_step, "assume_two_step", 0, 0, 1)
+PORT_ITEM_INT(boundary_clock_jbod, "boundary_clock_jbod", 0, 0, 1)
+PORT_ITEM_ENU(BMCA, "BMCA", BMCA_PTP, bmca_enu)
+GLOB_ITEM_INT(check_fup_sync, "check_fup_sync", 0, 0, 1)
+GLOB_ITEM_INT(clockAccuracy, "clockAccuracy", 0xfe, 0, UINT8_MAX)
+GLOB_ITEM_INT(clockClass, "clockClass", 248, 0, UINT8_MAX)
+GLOB_ITEM_STR(clockIdentity, "clockIdentity", "000000.0000.000000")
+GLOB_ITEM_ENU(clock_servo, "clock_servo", CLOCK_SERVO_PI, clock_servo_enu)
+GLOB_ITEM_ENU(clock_type, "clock_type", CLOCK_TYPE_ORDINARY, clock_type_enu)
+GLOB_ITEM_STR(cpu_affinity, "cpu_affinity", "")
+GLOB_ITEM_ENU(dataset_comparison, "dataset_comparison", DS_CMP_IEEE1588, dataset_comp_enu)
+PORT_ITEM_INT(delayAsymmetry, "delayAsymmetry", 0, INT_MIN, INT_MAX)
+PORT_ITEM_ENU(delay_filter, "delay_filter", FILTER_MOVING_MEDIAN, delay_filter_enu)
+PORT_ITEM_INT(delay_filter_length, "delay_filter_length", 10, 1, INT_MAX)
+PORT_ITEM_ENU(delay_mechanism, "delay_mechanism", DM_E2E, delay_mech_enu)
+GLOB_ITEM_INT(dscp_event, "dscp_event", 0, 0, 63)
+GLOB_ITEM_INT(dscp_general, "dscp_general", 0, 0, 63)
+GLOB_ITEM_INT(domainNumber, "domainNumber", 0, 0, 127)
+PORT_ITEM_INT(egressLatency, "egressLatency", 0, INT_MIN, INT_MAX)
+PORT_ITEM_INT(fastLogMinDelayReqInterval, "fastLogMinDelayReqInterval", -4, INT8_MIN, INT8_MAX)
+PORT_ITEM_INT(fastLogSyncInterval, "fastLogSyncInterval", -4, INT8_MIN, INT8_MAX)
+PORT_ITEM_INT(fast_acquisition, "fast_acquisition", 0, 0, 1)
+PORT_ITEM_INT(fast_acquisition_threshold, "fast_acquisition_threshold", 100000, 0, INT_MAX)
+PORT_ITEM_INT(fault_badpeernet_interval, "fault_badpeernet_interval", 16, INT32_MIN, INT32_MAX)
+PORT_ITEM_INT(fault_reset_interval, "fault_reset_interval", 4, INT8_MIN, INT8_MAX)
+GLOB_ITEM_DBL(first_step_threshold, "first_step_threshold", 0.00002, 0.0, DBL_MAX)
+PORT_ITEM_INT(follow_up_info, "follow_up_info", 0, 0, 1)
+GLOB_ITEM_INT(free_running, "free_running", 0, 0, 1)
+PORT_ITEM_INT(freq_est_interval, "freq_est_interval", 1, 0, INT_MAX)
+GLOB_ITEM_INT(G_8275_defaultDS_localPriority, "G.8275.defaultDS.localPriority", 128, 1, UINT8_MAX)
+PORT_ITEM_INT(G_8275_portDS_localPriority, "G.8275.portDS.localPriority", 128, 1, UINT8_MAX)
+GLOB_ITEM_INT(gmCapable, "gmCapable", 1, 0, 1)
+PORT_ITEM_INT(hot_standby, "hot_standby", 0, 0, 1)
+GLOB_ITEM_ENU(hwts_filter, "hwts_filter", HWTS_FILTER_NORMAL, hwts_filter_enu)
+PORT_ITEM_INT(hybrid_e2e, "hybrid_e2e", 0, 0, 1)
+PORT_ITEM_INT(ignore_source_id, "ignore_source_id", 0, 0, 1)
+PORT_ITEM_INT(ignore_transport_specific, "ignore_transport_specific", 0, 0, 1)
+PORT_ITEM_INT(ingressLatency, "ingressLatency", 0, INT_MIN, INT_MAX)
+PORT_ITEM_INT(inhibit_announce, "inhibit_announce", 0, 0, 1)
+PORT_ITEM_INT(inhibit_delay_req, "inhibit_delay_req", 0, 0, 1)
+PORT_ITEM_INT(inhibit_multicast_service, "inhibit_multicast_service", 0, 0, 1)
+GLOB_ITEM_INT(initial_delay, "initial_delay", 0, 0, INT_MAX)
+PORT_ITEM_INT(io_uring, "io_uring", 0, 0, 1)
+GLOB_ITEM_INT(kernel_leap, "kernel_leap", 1, 0, 1)
+GLOB_ITEM_INT(latency_stats, "latency_stats", 0, 0, 1)
+PORT_ITEM_INT(logAnnounceInterval, "logAnnounceInterval", 1, INT8_MIN, INT8_MAX)
+PORT_ITEM_INT(logMinDelayReqInterval, "logMinDelayReqInterval", 0, INT8_MIN, INT8_MAX)
+PORT_ITEM_INT(logMinPdelayReqInterval, "logMinPdelayReqInterval", 0, INT8_MIN, INT8_MAX)
+PORT_ITEM_INT(logSyncInterval, "logSyncInterval", 0, INT8_MIN, INT8_MAX)
+GLOB_ITEM_INT(logging_level, "logging_level", LOG_INFO, PRINT_LEVEL_MIN, PRINT_LEVEL_MAX)
+PORT_ITEM_INT(masterOnly, "masterOnly", 0, 0, 1)
+GLOB_ITEM_INT(maxStepsRemoved, "maxStepsRemoved", 255, 2, UINT8_MAX)
+GLOB_ITEM_STR(message_tag, "message_tag", NULL)
+GLOB_ITEM_STR(manufacturerIdentity, "manufacturerIdentity", "00:00:00")
+GLOB_ITEM_INT(max_frequency, "max_frequency", 900000000, 0, INT_MAX)
+GLOB_ITEM_INT(memory_lock, "memory_lock", 0, 0, 1)
+PORT_ITEM_INT(min_neighbor_prop_delay, "min_neighbor_prop_delay", -20000000, INT_MIN, -1)
+PORT_ITEM_INT(msg_interval_request, "msg_interval_request", 0, 0, 1)
+PORT_ITEM_INT(neighborPropDelayThresh, "neighborPropDelayThresh", 20000000, 0, INT_MAX)
+PORT_ITEM_INT(net_sync_monitor, "net_sync_monitor", 0, 0, 1)
+PORT_ITEM_ENU(network_transport, "network_transport", TRANS_UDP_IPV4, nw_trans_enu)
+GLOB_ITEM_INT(ntpshm_segment, "ntpshm_segment", 0, INT_MIN, INT_MAX)
+GLOB_ITEM_STR(ntpshm_socket, "ntpshm_socket", NULL)
+GLOB_ITEM_INT(offsetScaledLogVariance, "offsetScaledLogVariance", 0xffff, 0, UINT16_MAX)
+PORT_ITEM_INT(operLogPdelayReqInterval, "operLogPdelayReqInterval", 0, INT8_MIN, INT8_MAX)
+PORT_ITEM_INT(operLogSyncInterval, "operLogSyncInterval", 0, INT8_MIN, INT8_MAX)
+PORT_ITEM_INT(path_trace_enabled, "path_trace_enabled", 0, 0, 1)
+GLOB_ITEM_DBL(pi_integral_const, "pi_integral_const", 0.0, 0.0, DBL_MAX)
+GLOB_ITEM_DBL(pi_integral_exponent, "pi_integral_exponent", 0.4, -DBL_MAX, DBL_MAX)
+GLOB_ITEM_DBL(pi_integral_norm_max, "pi_integral_norm_max", 0.3, DBL_MIN, 2.0)
+GLOB_ITEM_DBL(pi_integral_scale, "pi_integral_scale", 0.0, 0.0, DBL_MAX)
+GLOB_ITEM_DBL(pi_proportional_const, "pi_proportional_const", 0.0, 0.0, DBL_MAX)
+GLOB_ITEM_DBL(pi_proportional_exponent, "pi_proportional_exponent", -0.3, -DBL_MAX, DBL_MAX)
+GLOB_ITEM_DBL(pi_proportional_norm_max, "pi_proportional_norm_max", 0.7, DBL_MIN, 1.0)
+GLOB_ITEM_DBL(pi_proportional_scale, "pi_proportional_scale", 0.0, 0.0, DBL_MAX)
+GLOB_ITEM_INT(prefault_heap, "prefault_heap", 0, 0, INT_MAX)
+GLOB_ITEM_INT(prefault_stack, "prefault_stack", 0, 0, 4194304)
+GLOB_ITEM_INT(priority1, "priority1", 128, 0, UINT8_MAX)
+GLOB_ITEM_INT(priority2, "priority2", 128, 0, UINT8_MAX)
+GLOB_ITEM_STR(productDescription, "productDescription", ";;")
+PORT_ITEM_STR(ptp_dst_mac, "ptp_dst_mac", "01:1B:19:00:00:00")
+PORT_ITEM_STR(p2p_dst_mac, "p2p_dst_mac", "01:80:C2:00:00:0E")
+GLOB_ITEM_STR(revisionData, "revisionData", ";;")
+GLOB_ITEM_INT(rt_priority, "rt_priority", 0, 0, 99)
+PORT_ITEM_INT(rx_ring_blocks, "rx_ring_blocks", 0, 0, 1024)
+GLOB_ITEM_INT(sanity_freq_limit, "sanity_freq_limit", 200000000, 0, INT_MAX)
+GLOB_ITEM_INT(servo_num_offset_values, "servo_num_offset_values", 10, 0, INT_MAX)
+GLOB_ITEM_INT(servo_offset_threshold, "servo_offset_threshold", 0, 0, INT_MAX)
+PORT_ITEM_STR(sim_clock, "sim_clock", "sim:0")
+PORT_ITEM_INT(sim_delay, "sim_delay", 1000, 0, INT_MAX)
+PORT_ITEM_INT(sim_delay_jitter, "sim_delay_jitter", 0, 0, INT_MAX)
+PORT_ITEM_STR(sim_network, "sim_network", "sim")
+GLOB_ITEM_STR(slave_event_monitor, "slave_event_monitor", "")
+GLOB_ITEM_DBL(slave_event_monitor_flush, "slave_event_monitor_flush", 0.0, 0.0, DBL_MAX)
+GLOB_ITEM_INT(slave_event_monitor_records, "slave_event_monitor_records", 1, 1, INT_MAX)
+GLOB_ITEM_STR(slave_event_monitor_ring, "slave_event_monitor_ring", "")
+GLOB_ITEM_INT(slave_event_monitor_ring_size, "slave_event_monitor_ring_size", 4096, 1, INT_MAX)
+GLOB_ITEM_INT(slave_event_monitor_servo, "slave_event_monitor_servo", 0, 0, 1)
+GLOB_ITEM_INT(slaveOnly, "slaveOnly", 0, 0, 1)
+GLOB_ITEM_INT(socket_priority, "socket_priority", 0, 0, 15)
+GLOB_ITEM_STR(state_file, "state_file", "")
+GLOB_ITEM_INT(state_file_interval, "state_file_interval", 60, 1, INT_MAX)
+GLOB_ITEM_INT(state_file_max_age, "state_file_max_age", 3600, 1, INT_MAX)
+GLOB_ITEM_DBL(step_threshold, "step_threshold", 0.0, 0.0, DBL_MAX)
+GLOB_ITEM_INT(summary_interval, "summary_interval", 0, INT_MIN, INT_MAX)
+PORT_ITEM_INT(syncReceiptTimeout, "syncReceiptTimeout", 0, 0, UINT8_MAX)
+GLOB_ITEM_INT(tc_spanning_tree, "tc_spanning_tree", 0, 0, 1)
+GLOB_ITEM_INT(timeSource, "timeSource", INTERNAL_OSCILLATOR, 0x10, 0xfe)
+GLOB_ITEM_INT(timer_slack, "timer_slack", 0, 0, INT_MAX)
+GLOB_ITEM_STR(timestamp_record, "timestamp_record", "")
+GLOB_ITEM_ENU(time_stamping, "time_stamping", TS_HARDWARE, timestamping_enu)
+PORT_ITEM_INT(transportSpecific, "transportSpecific", 0, 0, 0x0F)
+PORT_ITEM_INT(ts2phc_channel, "ts2phc.channel", 0, 0, INT_MAX)
+PORT_ITEM_INT(ts2phc_extts_correction, "ts2phc.extts_correction", 0, INT_MIN, INT_MAX)
+PORT_ITEM_ENU(ts2phc_extts_polarity, "ts2phc.extts_polarity", PTP_RISING_EDGE, extts_polarity_enu)
+PORT_ITEM_INT(ts2phc_master, "ts2phc.master", 0, 0, 1)
+GLOB_ITEM_INT(ts2phc_nmea_baudrate, "ts2phc.nmea_baudrate", 9600, 300, INT_MAX)
+GLOB_ITEM_STR(ts2phc_nmea_remote_host, "ts2phc.nmea_remote_host", "")
+GLOB_ITEM_STR(ts2phc_nmea_remote_port, "ts2phc.nmea_remote_port", "")
+GLOB_ITEM_STR(ts2phc_nmea_serialport, "ts2phc.nmea_serialport", "/dev/ttyS0")
+PORT_ITEM_INT(ts2phc_perout_phase, "ts2phc.perout_phase", -1, 0, 999999999)
+PORT_ITEM_INT(ts2phc_pin_index, "ts2phc.pin_index", 0, 0, INT_MAX)
+GLOB_ITEM_INT(ts2phc_pulsewidth, "ts2phc.pulsewidth", 500000000, 1000000, 999000000)
+PORT_ITEM_ENU(tsproc_mode, "tsproc_mode", TSPROC_FILTER, tsproc_enu)
+GLOB_ITEM_INT(twoStepFlag, "twoStepFlag", 1, 0, 1)
+GLOB_ITEM_INT(tx_timestamp_timeout, "tx_timestamp_timeout", 1, 1, INT_MAX)
+PORT_ITEM_INT(udp_ttl, "udp_ttl", 1, 1, 255)
+PORT_ITEM_INT(udp6_scope, "udp6_scope", 0x0E, 0x00, 0x0F)
+GLOB_ITEM_STR(uds_address, "uds_address", "/var/run/ptp4l")
+PORT_ITEM_INT(unicast_listen, "unicast_listen", 0, 0, 1)
+PORT_ITEM_INT(unicast_master_table, "unicast_master_table", 0, 0, INT_MAX)
+PORT_ITEM_INT(unicast_req_duration, "unicast_req_duration", 3600, 10, INT_MAX)
+PORT_ITEM_INT(unicast_workers, "unicast_workers", 0, 0, 64)
+GLOB_ITEM_INT(use_syslog, "use_syslog", 1, 0, 1)
+GLOB_ITEM_STR(userDescription, "userDescription", "")
+GLOB_ITEM_INT(utc_offset, "utc_offset", CURRENT_UTC_OFFSET, 0, INT_MAX)
+GLOB_ITEM_INT(verbose, "verbose", 0, 0, 1)
+GLOB_ITEM_INT(wakeup_check, "wakeup_check", 0, 0, 100000)
+GLOB_ITEM_INT(wakeup_limit, "wakeup_limit", 100000, 1, INT_MAX)
+GLOB_ITEM_INT(write_phase_mode, "write_phase_mode", 0, 0, 1)
@@ -22,16 +22,20 @@
 
 #define N_TIMER_FDS 8
 
-/*
- * The order matters here.  The DELAY timer must appear before the
- * ANNOUNCE and SYNC_RX timers in order to correctly handle the case
- * when the DELAY timer and one of the other two expire during the
- * same call to poll().
- */
 enum {
 	FD_EVENT,
 	FD_GENERAL,
-	FD_DELAY_TIMER,
+	N_POLLFD,
+};
+
+/*
+ * The timers of a port. They are not file descriptors but entries in
+ * the timer heap of the clock, and they share the index space of the
+ * descriptors so that port_event() can handle both. Timers expiring
+ * in the same wake up are handled in the order of their deadlines.
+ */
+enum {
+	FD_DELAY_TIMER = N_POLLFD,
 	FD_ANNOUNCE_TIMER,
 	FD_SYNC_RX_TIMER,
 	FD_QUALIFICATION_TIMER,
@@ -39,8 +43,7 @@ enum {
 	FD_SYNC_TX_TIMER,
 	FD_UNICAST_REQ_TIMER,
 	FD_UNICAST_SRV_TIMER,
-	FD_RTNL,
-	N_POLLFD,
+	FD_FAULT_TIMER,
 };
 
 #define FD_FIRST_TIMER FD_DELAY_TIMER
@@ -47,3 +47,8 @@ void filter_reset(struct filter *filter)
 {
 	filter->reset(filter);
 }
+
+int filter_samples(struct filter *filter, tmv_t *buf, int len)
+{
+	return filter->samples(filter, buf, len);
+}
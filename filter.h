@@ -61,4 +61,15 @@ tmv_t filter_sample(struct filter *filter, tmv_t sample);
  */
 void filter_reset(struct filter *filter);
 
+/**
+ * Copy out the samples held by a filter, oldest first. Feeding them
+ * into a reset filter restores its state.
+ * @param filter   Pointer to a filter obtained via @ref filter_create().
+ * @param buf      Buffer to receive the samples.
+ * @param len      The number of samples which fit into 'buf'.
+ * @return The number of samples copied. When the filter holds more
+ *         than 'len' samples, the newest ones are copied.
+ */
+int filter_samples(struct filter *filter, tmv_t *buf, int len);
+
 #endif
@@ -28,6 +28,8 @@ struct filter {
 	tmv_t (*sample)(struct filter *filter, tmv_t sample);
 
 	void (*reset)(struct filter *filter);
+
+	int (*samples)(struct filter *filter, tmv_t *buf, int len);
 };
 
 #endif
@@ -47,6 +47,13 @@ struct foreign_clock {
 	 */
 	unsigned int n_messages;
 
+	/**
+	 * Set when this is the parent saved before a restart. It then
+	 * qualifies with its first announce message, until it reaches
+	 * the normal threshold.
+	 */
+	int warm;
+
 	/**
 	 * Pointer to the associated port.
 	 */
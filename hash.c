@@ -17,97 +17,202 @@
  * with this program; if not, write to the Free Software Foundation, Inc.,
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "hash.h"
 
-#define HASH_TABLE_SIZE 200
+/*
+ * Open addressing with linear probing. The table size is a power of
+ * two and doubles whenever the table would become more than half full.
+ * The keys are copied into one contiguous arena and referred to by
+ * their offset, so that growing the arena does not invalidate them.
+ * Offset zero marks an empty slot.
+ */
+#define HASH_INITIAL_SLOTS	64
+#define HASH_INITIAL_ARENA	2048
 
-struct node {
-	char *key;
+struct slot {
+	uint32_t hash;
+	uint32_t key;
 	void *data;
-	struct node *next;
 };
 
 struct hash {
-	struct node *table[HASH_TABLE_SIZE];
+	struct slot *slot;
+	unsigned int mask;
+	unsigned int count;
+	char *arena;
+	size_t arena_len;
+	size_t arena_size;
 };
 
-static unsigned int hash_function(const char* s)
+/*
+ * Mixes the key eight bytes at a time, finishing with the 64 bit
+ * MurmurHash3 finalizer, so that long keys sharing a prefix, like
+ * those of the configuration, still spread evenly over the table.
+ */
+static uint32_t hash_function(const char *s, size_t *len)
+{
+	uint64_t h = 0x9e3779b97f4a7c15ULL, w;
+	size_t i, n = strlen(s);
+
+	for (i = 0; i + sizeof(w) <= n; i += sizeof(w)) {
+		memcpy(&w, s + i, sizeof(w));
+		h = (h ^ w) * 0xff51afd7ed558ccdULL;
+		h ^= h >> 32;
+	}
+	for (w = 0; i < n; i++) {
+		w = (w << 8) | (unsigned char) s[i];
+	}
+	h = (h ^ w ^ n) * 0xff51afd7ed558ccdULL;
+
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+
+	*len = n;
+	return h;
+}
+
+static struct slot *hash_find(struct hash *ht, const char *key, uint32_t h)
 {
 	unsigned int i;
+	struct slot *s;
 
-	for (i = 0; *s; s++) {
-		i = 131 * i + *s;
+	for (i = h & ht->mask; ; i = (i + 1) & ht->mask) {
+		s = &ht->slot[i];
+		if (!s->key) {
+			return s;
+		}
+		if (s->hash == h && !strcmp(ht->arena + s->key, key)) {
+			return s;
+		}
 	}
-	return i % HASH_TABLE_SIZE;
+}
+
+static int hash_grow(struct hash *ht)
+{
+	unsigned int i, j, size = (ht->mask + 1) * 2;
+	struct slot *slot;
+
+	slot = calloc(size, sizeof(*slot));
+	if (!slot) {
+		return -1;
+	}
+	for (i = 0; i <= ht->mask; i++) {
+		if (!ht->slot[i].key) {
+			continue;
+		}
+		for (j = ht->slot[i].hash & (size - 1); slot[j].key;
+		     j = (j + 1) & (size - 1))
+			;
+		slot[j] = ht->slot[i];
+	}
+	free(ht->slot);
+	ht->slot = slot;
+	ht->mask = size - 1;
+	return 0;
+}
+
+static int hash_intern(struct hash *ht, const char *key, size_t len,
+		       uint32_t *offset)
+{
+	size_t size = ht->arena_size;
+	char *arena;
+
+	while (ht->arena_len + len + 1 > size) {
+		size *= 2;
+	}
+	if (size > UINT32_MAX) {
+		return -1;
+	}
+	if (size != ht->arena_size) {
+		arena = realloc(ht->arena, size);
+		if (!arena) {
+			return -1;
+		}
+		ht->arena = arena;
+		ht->arena_size = size;
+	}
+	memcpy(ht->arena + ht->arena_len, key, len + 1);
+	*offset = ht->arena_len;
+	ht->arena_len += len + 1;
+	return 0;
 }
 
 struct hash *hash_create(void)
 {
 	struct hash *ht = calloc(1, sizeof(*ht));
+
+	if (!ht) {
+		return NULL;
+	}
+	ht->slot = calloc(HASH_INITIAL_SLOTS, sizeof(*ht->slot));
+	ht->arena = malloc(HASH_INITIAL_ARENA);
+	if (!ht->slot || !ht->arena) {
+		free(ht->slot);
+		free(ht->arena);
+		free(ht);
+		return NULL;
+	}
+	ht->mask = HASH_INITIAL_SLOTS - 1;
+	ht->arena_size = HASH_INITIAL_ARENA;
+	/* Reserve offset zero for the empty slots. */
+	ht->arena[0] = 0;
+	ht->arena_len = 1;
 	return ht;
 }
 
 void hash_destroy(struct hash *ht, void (*func)(void *))
 {
 	unsigned int i;
-	struct node *n, *next, **table = ht->table;
 
-	for (i = 0; i < HASH_TABLE_SIZE; i++) {
-		for (n = table[i] ; n; n = next) {
-			next = n->next;
-			if (func) {
-				func(n->data);
+	if (func) {
+		for (i = 0; i <= ht->mask; i++) {
+			if (ht->slot[i].key) {
+				func(ht->slot[i].data);
 			}
-			free(n->key);
-			free(n);
 		}
 	}
-
+	free(ht->slot);
+	free(ht->arena);
 	free(ht);
 }
 
 int hash_insert(struct hash *ht, const char* key, void *data)
 {
-	unsigned int h;
-	struct node *n, **table = ht->table;
-
-	h = hash_function(key);
-
-	for (n = table[h] ; n; n = n->next) {
-		if (!strcmp(n->key, key)) {
-			/* reject duplicate keys */
+	struct slot *s;
+	uint32_t h;
+	size_t len;
+
+	h = hash_function(key, &len);
+	s = hash_find(ht, key, h);
+	if (s->key) {
+		/* reject duplicate keys */
+		return -1;
+	}
+	if (2 * (ht->count + 1) > ht->mask + 1) {
+		if (hash_grow(ht)) {
 			return -1;
 		}
+		s = hash_find(ht, key, h);
 	}
-	n = calloc(1, sizeof(*n));
-	if (!n) {
+	if (hash_intern(ht, key, len, &s->key)) {
 		return -1;
 	}
-	n->key = strdup(key);
-	if (!n->key) {
-		free(n);
-		return -1;
-	}
-	n->data = data;
-	n->next = table[h];
-	table[h] = n;
+	s->hash = h;
+	s->data = data;
+	ht->count++;
 	return 0;
 }
 
 void *hash_lookup(struct hash *ht, const char* key)
 {
-	unsigned int h;
-	struct node *n, **table = ht->table;
-
-	h = hash_function(key);
+	struct slot *s;
+	size_t len;
 
-	for (n = table[h] ; n; n = n->next) {
-		if (!strcmp(n->key, key)) {
-			return n->data;
-		}
-	}
-	return NULL;
+	s = hash_find(ht, key, hash_function(key, &len));
+	return s->key ? s->data : NULL;
 }
@@ -86,6 +86,12 @@ kernel_flags()
 	if grep -q HWTSTAMP_TX_ONESTEP_P2P ${prefix}${tstamp}; then
 		printf " -DHAVE_ONESTEP_P2P"
 	fi
+
+	uring=/usr/include/linux/io_uring.h
+	if [ -f ${prefix}${uring} ] &&
+	   grep -q IORING_RECV_MULTISHOT ${prefix}${uring}; then
+		printf " -DHAVE_IO_URING"
+	fi
 }
 
 flags="$(user_flags)$(kernel_flags)"
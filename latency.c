@@ -0,0 +1,100 @@
+/**
+ * @file latency.c
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#include <time.h>
+
+#include "latency.h"
+
+#define NS_PER_SEC 1000000000LL
+
+int latency_enabled;
+
+/* The message being measured, there is only one at a time. */
+static struct latency *current;
+static int64_t start, mark;
+
+void latency_set_enabled(int enable)
+{
+	latency_enabled = enable;
+	current = NULL;
+}
+
+int64_t latency_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+void latency_add(struct latency *l, enum latency_stage stage, int64_t ns)
+{
+	struct latency_hist *h = &l->hist[stage];
+	uint32_t val;
+	int i;
+
+	val = ns < 0 ? 0 : ns > UINT32_MAX ? UINT32_MAX : ns;
+	i = val ? 31 - __builtin_clz(val) : 0;
+
+	if (!h->count || val < h->min) {
+		h->min = val;
+	}
+	if (val > h->max) {
+		h->max = val;
+	}
+	h->count++;
+	h->sum += val;
+	h->bucket[i]++;
+}
+
+void latency_start(struct latency *l)
+{
+	current = l;
+	start = mark = latency_now();
+}
+
+void latency_stop(void)
+{
+	current = NULL;
+}
+
+void latency_record(enum latency_stage stage)
+{
+	int64_t now;
+
+	if (!current) {
+		return;
+	}
+	now = latency_now();
+	latency_add(current, stage, now - mark);
+	mark = now;
+
+	if (stage == LATENCY_ADJUST) {
+		latency_add(current, LATENCY_TOTAL, now - start);
+	}
+}
+
+uint32_t latency_percentile(const struct latency_hist *h, double p)
+{
+	uint64_t n, sum = 0;
+	uint32_t limit;
+	int i;
+
+	if (!h->count) {
+		return 0;
+	}
+	n = (uint64_t) (h->count * p / 100.0 + 0.5);
+	if (!n) {
+		n = 1;
+	}
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		sum += h->bucket[i];
+		if (sum >= n) {
+			break;
+		}
+	}
+	limit = i < 31 ? (2U << i) - 1 : UINT32_MAX;
+	return limit < h->max ? limit : h->max;
+}
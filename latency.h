@@ -0,0 +1,139 @@
+/**
+ * @file latency.h
+ * @brief Measures the latency of the stages of the time stamp hot path.
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#ifndef HAVE_LATENCY_H
+#define HAVE_LATENCY_H
+
+#include <stdint.h>
+
+/*
+ * Each stage is measured from the end of the previous one. The stages
+ * of one message are bracketed by latency_begin() and latency_end().
+ */
+enum latency_stage {
+	LATENCY_RECV,		/* transport_recv() */
+	LATENCY_PARSE,		/* msg_post_recv() and the receive checks */
+	LATENCY_DISPATCH,	/* until process_sync() or process_follow_up() */
+	LATENCY_MATCH,		/* until clock_synchronize() */
+	LATENCY_SERVO,		/* the servo, until the clock is adjusted */
+	LATENCY_ADJUST,		/* the clock adjustment */
+	LATENCY_TOTAL,		/* from the receive to the adjusted clock */
+	LATENCY_POLL,		/* one pass of the clock's poll loop */
+	N_LATENCY_STAGES
+};
+
+/* Bucket N counts the latencies from 2^N to 2^(N+1) - 1 ns. */
+#define LATENCY_BUCKETS 32
+
+struct latency_hist {
+	uint64_t count;
+	uint64_t sum;
+	uint32_t min;
+	uint32_t max;
+	uint32_t bucket[LATENCY_BUCKETS];
+};
+
+struct latency {
+	struct latency_hist hist[N_LATENCY_STAGES];
+};
+
+extern int latency_enabled;
+
+void latency_start(struct latency *l);
+void latency_stop(void);
+void latency_record(enum latency_stage stage);
+
+/**
+ * Enable or disable the measurements. When disabled, the hooks cost
+ * one test of a global flag.
+ * @param enable  Pass one (1) to enable and zero to disable.
+ */
+void latency_set_enabled(int enable);
+
+/**
+ * Start the measurement of one received message.
+ * @param l  The histograms of the port receiving the message.
+ */
+static inline void latency_begin(struct latency *l)
+{
+	if (latency_enabled)
+		latency_start(l);
+}
+
+/**
+ * Mark the end of a stage of the message being measured. Does nothing
+ * outside of latency_begin() and latency_end().
+ * @param stage  The stage which has just ended.
+ */
+static inline void latency_mark(enum latency_stage stage)
+{
+	if (latency_enabled)
+		latency_record(stage);
+}
+
+/**
+ * End the measurement of the current message.
+ */
+static inline void latency_end(void)
+{
+	if (latency_enabled)
+		latency_stop();
+}
+
+/**
+ * Read the monotonic time for a measurement by latency_add().
+ * @return  The time in ns.
+ */
+int64_t latency_now(void);
+
+/**
+ * Add one measured latency to a histogram.
+ * @param l      The histograms.
+ * @param stage  The stage which was measured.
+ * @param ns     The latency in ns.
+ */
+void latency_add(struct latency *l, enum latency_stage stage, int64_t ns);
+
+/**
+ * Estimate a percentile of a histogram, rounded up to the bucket limit.
+ * @param h  The histogram.
+ * @param p  The percentile, between 0 and 100.
+ * @return   The latency in ns, or zero if the histogram is empty.
+ */
+uint32_t latency_percentile(const struct latency_hist *h, double p);
+
+/**
+ * Obtain the name of a stage. This is inline, so that pmc can print
+ * the stages without linking the measurements.
+ * @param stage  The stage.
+ * @return       A short name, like "recv".
+ */
+static inline const char *latency_stage_name(enum latency_stage stage)
+{
+	switch (stage) {
+	case LATENCY_RECV:
+		return "recv";
+	case LATENCY_PARSE:
+		return "parse";
+	case LATENCY_DISPATCH:
+		return "dispatch";
+	case LATENCY_MATCH:
+		return "match";
+	case LATENCY_SERVO:
+		return "servo";
+	case LATENCY_ADJUST:
+		return "adjust";
+	case LATENCY_TOTAL:
+		return "total";
+	case LATENCY_POLL:
+		return "poll";
+	case N_LATENCY_STAGES:
+		break;
+	}
+	return "unknown";
+}
+
+#endif
@@ -62,6 +62,17 @@ static void mave_reset(struct filter *filter)
 	memset(m->val, 0, m->len * sizeof(*m->val));
 }
 
+static int mave_samples(struct filter *filter, tmv_t *buf, int len)
+{
+	struct mave *m = container_of(filter, struct mave, filter);
+	int i, n = m->cnt < len ? m->cnt : len;
+
+	for (i = 0; i < n; i++) {
+		buf[i] = m->val[(m->index + m->len - n + i) % m->len];
+	}
+	return n;
+}
+
 struct filter *mave_create(int length)
 {
 	struct mave *m;
@@ -72,6 +83,7 @@ struct filter *mave_create(int length)
 	m->filter.destroy = mave_destroy;
 	m->filter.sample = mave_accumulate;
 	m->filter.reset = mave_reset;
+	m->filter.samples = mave_samples;
 	m->val = calloc(1, length * sizeof(*m->val));
 	if (!m->val) {
 		free(m);
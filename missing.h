@@ -245,6 +245,22 @@ struct ptp_pin_desc {
 #define SO_SELECT_ERR_QUEUE 45
 #endif
 
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+
+#ifndef IP_MULTICAST_ALL
+#define IP_MULTICAST_ALL 49
+#endif
+
+#ifndef IPV6_MULTICAST_ALL
+#define IPV6_MULTICAST_ALL 29
+#endif
+
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
+
 #ifndef HAVE_CLOCK_ADJTIME
 static inline int clock_adjtime(clockid_t id, struct timex *tx)
 {
@@ -314,6 +330,8 @@ enum {
 #else
 
 #define TFD_TIMER_ABSTIME (1 << 0)
+#define TFD_CLOEXEC O_CLOEXEC
+#define TFD_NONBLOCK O_NONBLOCK
 
 static inline int clock_nanosleep(clockid_t clock_id, int flags,
 				  const struct timespec *request,
@@ -83,6 +83,17 @@ static void mmedian_reset(struct filter *filter)
 	m->index = 0;
 }
 
+static int mmedian_samples(struct filter *filter, tmv_t *buf, int len)
+{
+	struct mmedian *m = container_of(filter, struct mmedian, filter);
+	int i, n = m->cnt < len ? m->cnt : len;
+
+	for (i = 0; i < n; i++) {
+		buf[i] = m->samples[(m->index + m->len - n + i) % m->len];
+	}
+	return n;
+}
+
 struct filter *mmedian_create(int length)
 {
 	struct mmedian *m;
@@ -95,6 +106,7 @@ struct filter *mmedian_create(int length)
 	m->filter.destroy = mmedian_destroy;
 	m->filter.sample = mmedian_sample;
 	m->filter.reset = mmedian_reset;
+	m->filter.samples = mmedian_samples;
 	m->order = calloc(1, length * sizeof(*m->order));
 	if (!m->order) {
 		free(m);
@@ -3,60 +3,199 @@
  * @note Copyright (C) 2020 Richard Cochran <richardcochran@gmail.com>
  * @note SPDX-License-Identifier: GPL-2.0+
  */
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 #include "address.h"
 #include "monitor.h"
 #include "print.h"
 
-#define RECORDS_PER_MESSAGE 1
-
 struct monitor_message {
 	struct ptp_message *msg;
+	struct TLV *tlv;
+	size_t record_size;
 	int records_per_msg;
 	int count;
 };
 
+struct monitor_ring {
+	struct monitor_ring_header hdr;
+	struct monitor_ring_record record[0];
+};
+
 struct monitor {
 	struct port *dst_port;
 	struct slave_rx_sync_timing_data_tlv *sync_tlv;
 	struct slave_delay_timing_data_tlv *delay_tlv;
+	struct slave_servo_data_tlv *servo_tlv;
 	struct monitor_message delay;
 	struct monitor_message sync;
+	struct monitor_message servo;
+	struct monitor_ring *ring;
+	size_t ring_len;
+	double flush_interval;
+	bool flush_armed;
+	int flush_fd;
+	int servo_data;
 };
 
 static bool monitor_active(struct monitor *monitor)
 {
-	return monitor->dst_port ? true : false;
+	return monitor->dst_port || monitor->ring ? true : false;
 }
 
-static int monitor_forward(struct port *port, struct ptp_message *msg)
+static int monitor_forward(struct monitor *monitor, struct monitor_message *mm)
 {
-	int err, pdulen = msg->header.messageLength;
+	struct ptp_message *wire, *msg = mm->msg;
+	int err;
+
+	/* Only send as many records as have been collected so far. */
+	mm->tlv->length = sizeof(struct PortIdentity) +
+		mm->count * mm->record_size;
+	msg->header.messageLength = sizeof(struct signaling_msg) +
+		sizeof(struct TLV) + mm->tlv->length;
+	mm->count = 0;
 
-	if (msg_pre_send(msg)) {
+	wire = msg_serialize(msg);
+	if (!wire) {
 		return -1;
 	}
-	err = port_forward_to(port, msg);
+	err = port_forward_to(monitor->dst_port, wire);
 	if (err) {
 		pr_debug("failed to send signaling message to slave event monitor: %s",
 			 strerror(-err));
 	}
-	if (msg_post_recv(msg, pdulen)) {
-		return -1;
-	}
+	msg_put(wire);
 	msg->header.sequenceId++;
 
 	return 0;
 }
 
+static void monitor_arm(struct monitor *monitor)
+{
+	struct itimerspec tmo;
+
+	if (monitor->flush_fd < 0 || monitor->flush_armed) {
+		return;
+	}
+	memset(&tmo, 0, sizeof(tmo));
+	tmo.it_value.tv_sec = (time_t) monitor->flush_interval;
+	tmo.it_value.tv_nsec = (monitor->flush_interval - tmo.it_value.tv_sec) *
+		NS_PER_SEC;
+	if (!tmo.it_value.tv_sec && !tmo.it_value.tv_nsec) {
+		tmo.it_value.tv_nsec = 1;
+	}
+	if (timerfd_settime(monitor->flush_fd, 0, &tmo, NULL)) {
+		pr_err("failed to arm slave event monitor timer: %m");
+		return;
+	}
+	monitor->flush_armed = true;
+}
+
+static int monitor_record(struct monitor *monitor, struct monitor_message *mm)
+{
+	mm->count++;
+	if (mm->count == mm->records_per_msg) {
+		return monitor_forward(monitor, mm);
+	}
+	if (mm->count == 1) {
+		monitor_arm(monitor);
+	}
+	return 0;
+}
+
+static struct monitor_ring_record *monitor_ring_next(struct monitor *monitor,
+						     uint64_t *seq)
+{
+	struct monitor_ring_record *rec;
+	struct monitor_ring *ring = monitor->ring;
+
+	*seq = ring->hdr.head + 1;
+	rec = &ring->record[(*seq - 1) % ring->hdr.records];
+	__atomic_store_n(&rec->sequence, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return rec;
+}
+
+static void monitor_ring_commit(struct monitor *monitor,
+				struct monitor_ring_record *rec, uint64_t seq)
+{
+	__atomic_store_n(&rec->sequence, seq, __ATOMIC_RELEASE);
+	__atomic_store_n(&monitor->ring->hdr.head, seq, __ATOMIC_RELEASE);
+}
+
+static void monitor_ring_write(struct monitor *monitor, uint16_t type,
+			       struct PortIdentity source_pid, uint16_t seqid,
+			       tmv_t ts0, tmv_t ts1, tmv_t ts2,
+			       double frequency, uint8_t state)
+{
+	struct monitor_ring_record *rec;
+	uint64_t seq;
+
+	rec = monitor_ring_next(monitor, &seq);
+	rec->type = type;
+	rec->sequenceId = seqid;
+	rec->servoState = state;
+	rec->reserved = 0;
+	rec->sourcePortIdentity = source_pid;
+	rec->ts[0] = tmv_to_nanoseconds(ts0);
+	rec->ts[1] = tmv_to_nanoseconds(ts1);
+	rec->ts[2] = tmv_to_nanoseconds(ts2);
+	rec->frequency = frequency;
+	monitor_ring_commit(monitor, rec, seq);
+}
+
+static int monitor_ring_open(struct monitor *monitor, const char *path,
+			     int records)
+{
+	struct monitor_ring *ring;
+	size_t len;
+	int fd;
+
+	len = sizeof(*ring) + records * sizeof(ring->record[0]);
+
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		pr_err("failed to open %s: %m", path);
+		return -1;
+	}
+	if (ftruncate(fd, len)) {
+		pr_err("failed to resize %s: %m", path);
+		close(fd);
+		return -1;
+	}
+	ring = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (ring == MAP_FAILED) {
+		pr_err("failed to map %s: %m", path);
+		return -1;
+	}
+	ring->hdr.version = MONITOR_RING_VERSION;
+	ring->hdr.record_size = sizeof(ring->record[0]);
+	ring->hdr.records = records;
+	ring->hdr.head = 0;
+	/* Publish the magic number last, once the header is valid. */
+	__atomic_store_n(&ring->hdr.magic, MONITOR_RING_MAGIC, __ATOMIC_RELEASE);
+
+	monitor->ring = ring;
+	monitor->ring_len = len;
+	return 0;
+}
+
 static struct tlv_extra *monitor_init_message(struct monitor_message *mm,
 					      struct port *destination,
 					      uint16_t tlv_type,
-					      size_t tlv_size,
+					      size_t record_size,
+					      int records_per_msg,
 					      struct address address)
 {
+	size_t tlv_size = sizeof(struct TLV) + sizeof(struct PortIdentity) +
+		record_size * records_per_msg;
 	struct ptp_message *msg;
 	struct tlv_extra *extra;
 
@@ -75,21 +214,26 @@ static struct tlv_extra *monitor_init_message(struct monitor_message *mm,
 
 	mm->msg = msg;
 	mm->msg->address = address;
-	mm->records_per_msg = RECORDS_PER_MESSAGE;
+	mm->tlv = extra->tlv;
+	mm->record_size = record_size;
+	mm->records_per_msg = records_per_msg;
 	mm->count = 0;
 
 	return extra;
 }
 
-static int monitor_init_delay(struct monitor *monitor, struct address address)
+static int monitor_init_delay(struct monitor *monitor, struct address address,
+			      int records)
 {
-	const size_t tlv_size = sizeof(struct slave_delay_timing_data_tlv) +
-		sizeof(struct slave_delay_timing_record) * RECORDS_PER_MESSAGE;
 	struct tlv_extra *extra;
 
+	if (records > SLAVE_DELAY_TIMING_MAX) {
+		records = SLAVE_DELAY_TIMING_MAX;
+	}
 	extra = monitor_init_message(&monitor->delay, monitor->dst_port,
-				     TLV_SLAVE_DELAY_TIMING_DATA_NP, tlv_size,
-				     address);
+				     TLV_SLAVE_DELAY_TIMING_DATA_NP,
+				     sizeof(struct slave_delay_timing_record),
+				     records, address);
 	if (!extra) {
 		return -1;
 	}
@@ -98,15 +242,38 @@ static int monitor_init_delay(struct monitor *monitor, struct address address)
 	return 0;
 }
 
-static int monitor_init_sync(struct monitor *monitor, struct address address)
+static int monitor_init_servo(struct monitor *monitor, struct address address,
+			      int records)
+{
+	struct tlv_extra *extra;
+
+	if (records > SLAVE_SERVO_MAX) {
+		records = SLAVE_SERVO_MAX;
+	}
+	extra = monitor_init_message(&monitor->servo, monitor->dst_port,
+				     TLV_SLAVE_SERVO_DATA_NP,
+				     sizeof(struct slave_servo_record),
+				     records, address);
+	if (!extra) {
+		return -1;
+	}
+	monitor->servo_tlv = (struct slave_servo_data_tlv *) extra->tlv;
+
+	return 0;
+}
+
+static int monitor_init_sync(struct monitor *monitor, struct address address,
+			     int records)
 {
-	const size_t tlv_size = sizeof(struct slave_rx_sync_timing_data_tlv) +
-		sizeof(struct slave_rx_sync_timing_record) * RECORDS_PER_MESSAGE;
 	struct tlv_extra *extra;
 
+	if (records > SLAVE_RX_SYNC_TIMING_MAX) {
+		records = SLAVE_RX_SYNC_TIMING_MAX;
+	}
 	extra = monitor_init_message(&monitor->sync, monitor->dst_port,
-				     TLV_SLAVE_RX_SYNC_TIMING_DATA, tlv_size,
-				     address);
+				     TLV_SLAVE_RX_SYNC_TIMING_DATA,
+				     sizeof(struct slave_rx_sync_timing_record),
+				     records, address);
 	if (!extra) {
 		return -1;
 	}
@@ -115,37 +282,77 @@ static int monitor_init_sync(struct monitor *monitor, struct address address)
 	return 0;
 }
 
-struct monitor *monitor_create(struct config *config, struct port *dst)
+static int monitor_init_signaling(struct monitor *monitor,
+				  struct config *config, const char *path)
 {
-	struct monitor *monitor;
 	struct address address;
 	struct sockaddr_un sa;
-	const char *path;
+	int records;
 
-	monitor = calloc(1, sizeof(*monitor));
-	if (!monitor) {
-		return NULL;
-	}
-	path = config_get_string(config, NULL, "slave_event_monitor");
-	if (!path || !path[0]) {
-		/* Return an inactive monitor. */
-		return monitor;
-	}
 	memset(&sa, 0, sizeof(sa));
 	sa.sun_family = AF_LOCAL;
 	snprintf(sa.sun_path, sizeof(sa.sun_path) - 1, "%s", path);
 	address.sun = sa;
 	address.len = sizeof(sa);
 
-	monitor->dst_port = dst;
+	records = config_get_int(config, NULL, "slave_event_monitor_records");
+
+	if (monitor_init_delay(monitor, address, records)) {
+		return -1;
+	}
+	if (monitor_init_sync(monitor, address, records)) {
+		return -1;
+	}
+	if (monitor->servo_data &&
+	    monitor_init_servo(monitor, address, records)) {
+		return -1;
+	}
+
+	monitor->flush_interval =
+		config_get_double(config, NULL, "slave_event_monitor_flush");
+	if (records > 1 && monitor->flush_interval > 0.0) {
+		monitor->flush_fd = timerfd_create(CLOCK_MONOTONIC,
+						   TFD_NONBLOCK);
+		if (monitor->flush_fd < 0) {
+			pr_err("failed to create slave event monitor timer: %m");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+struct monitor *monitor_create(struct config *config, struct port *dst)
+{
+	const char *path, *ring_path;
+	struct monitor *monitor;
 
-	if (monitor_init_delay(monitor, address)) {
-		free(monitor);
+	monitor = calloc(1, sizeof(*monitor));
+	if (!monitor) {
 		return NULL;
 	}
-	if (monitor_init_sync(monitor, address)) {
-		msg_put(monitor->delay.msg);
-		free(monitor);
+	monitor->flush_fd = -1;
+
+	path = config_get_string(config, NULL, "slave_event_monitor");
+	ring_path = config_get_string(config, NULL, "slave_event_monitor_ring");
+	if ((!path || !path[0]) && (!ring_path || !ring_path[0])) {
+		/* Return an inactive monitor. */
+		return monitor;
+	}
+	monitor->servo_data =
+		config_get_int(config, NULL, "slave_event_monitor_servo");
+
+	if (path && path[0]) {
+		monitor->dst_port = dst;
+		if (monitor_init_signaling(monitor, config, path)) {
+			monitor_destroy(monitor);
+			return NULL;
+		}
+	}
+	if (ring_path && ring_path[0] &&
+	    monitor_ring_open(monitor, ring_path,
+			      config_get_int(config, NULL,
+					     "slave_event_monitor_ring_size"))) {
+		monitor_destroy(monitor);
 		return NULL;
 	}
 
@@ -156,13 +363,18 @@ int monitor_delay(struct monitor *monitor, struct PortIdentity source_pid,
 		  uint16_t seqid, tmv_t t3, tmv_t corr, tmv_t t4)
 {
 	struct slave_delay_timing_record *record;
-	struct ptp_message *msg;
 
 	if (!monitor_active(monitor)) {
 		return 0;
 	}
 
-	msg = monitor->delay.msg;
+	if (monitor->ring) {
+		monitor_ring_write(monitor, TLV_SLAVE_DELAY_TIMING_DATA_NP,
+				   source_pid, seqid, t3, corr, t4, 0.0, 0);
+	}
+	if (!monitor->dst_port) {
+		return 0;
+	}
 
 	if (!pid_eq(&monitor->delay_tlv->sourcePortIdentity, &source_pid)) {
 		/* There was a change in remote master. Drop stale records. */
@@ -177,12 +389,7 @@ int monitor_delay(struct monitor *monitor, struct PortIdentity source_pid,
 	record->totalCorrectionField        = tmv_to_TimeInterval(corr);
 	record->delayResponseTimestamp      = tmv_to_Timestamp(t4);
 
-	monitor->delay.count++;
-	if (monitor->delay.count == monitor->delay.records_per_msg) {
-		monitor->delay.count = 0;
-		return monitor_forward(monitor->dst_port, msg);
-	}
-	return 0;
+	return monitor_record(monitor, &monitor->delay);
 }
 
 void monitor_destroy(struct monitor *monitor)
@@ -193,20 +400,97 @@ void monitor_destroy(struct monitor *monitor)
 	if (monitor->sync.msg) {
 		msg_put(monitor->sync.msg);
 	}
+	if (monitor->servo.msg) {
+		msg_put(monitor->servo.msg);
+	}
+	if (monitor->flush_fd >= 0) {
+		close(monitor->flush_fd);
+	}
+	if (monitor->ring) {
+		munmap(monitor->ring, monitor->ring_len);
+	}
 	free(monitor);
 }
 
+int monitor_fd(struct monitor *monitor)
+{
+	return monitor->flush_fd;
+}
+
+void monitor_flush(struct monitor *monitor)
+{
+	struct monitor_message *mm[] = {
+		&monitor->sync, &monitor->delay, &monitor->servo,
+	};
+	uint64_t expirations;
+	unsigned int i;
+
+	if (monitor->flush_fd >= 0 &&
+	    read(monitor->flush_fd, &expirations, sizeof(expirations)) < 0) {
+		pr_debug("slave event monitor timer read failed: %m");
+	}
+	monitor->flush_armed = false;
+
+	for (i = 0; i < sizeof(mm) / sizeof(mm[0]); i++) {
+		if (mm[i]->msg && mm[i]->count) {
+			monitor_forward(monitor, mm[i]);
+		}
+	}
+}
+
+int monitor_servo(struct monitor *monitor, struct PortIdentity source_pid,
+		  tmv_t ingress, tmv_t offset, tmv_t delay, double adj,
+		  enum servo_state state)
+{
+	struct slave_servo_record *record;
+
+	if (!monitor_active(monitor) || !monitor->servo_data) {
+		return 0;
+	}
+
+	if (monitor->ring) {
+		monitor_ring_write(monitor, TLV_SLAVE_SERVO_DATA_NP,
+				   source_pid, 0, ingress, offset, delay,
+				   adj, state);
+	}
+	if (!monitor->dst_port) {
+		return 0;
+	}
+
+	if (!pid_eq(&monitor->servo_tlv->sourcePortIdentity, &source_pid)) {
+		/* There was a change in remote master. Drop stale records. */
+		memcpy(&monitor->servo_tlv->sourcePortIdentity, &source_pid,
+		       sizeof(monitor->servo_tlv->sourcePortIdentity));
+		monitor->servo.count = 0;
+	}
+
+	record = monitor->servo_tlv->record + monitor->servo.count;
+	record->syncEventIngressTimestamp  = tmv_to_Timestamp(ingress);
+	record->offsetFromMaster           = tmv_to_TimeInterval(offset);
+	record->meanPathDelay              = tmv_to_TimeInterval(delay);
+	record->scaledFrequencyAdjustment  = (Integer64) (adj * 65536.0);
+	record->servoState                 = state;
+	record->reserved                   = 0;
+
+	return monitor_record(monitor, &monitor->servo);
+}
+
 int monitor_sync(struct monitor *monitor, struct PortIdentity source_pid,
 		 uint16_t seqid, tmv_t t1, tmv_t corr, tmv_t t2)
 {
 	struct slave_rx_sync_timing_record *record;
-	struct ptp_message *msg;
 
 	if (!monitor_active(monitor)) {
 		return 0;
 	}
 
-	msg = monitor->sync.msg;
+	if (monitor->ring) {
+		monitor_ring_write(monitor, TLV_SLAVE_RX_SYNC_TIMING_DATA,
+				   source_pid, seqid, t1, corr, t2, 0.0, 0);
+	}
+	if (!monitor->dst_port) {
+		return 0;
+	}
 
 	if (!pid_eq(&monitor->sync_tlv->sourcePortIdentity, &source_pid)) {
 		/* There was a change in remote master. Drop stale records. */
@@ -222,10 +506,5 @@ int monitor_sync(struct monitor *monitor, struct PortIdentity source_pid,
 	record->scaledCumulativeRateOffset = 0;
 	record->syncEventIngressTimestamp  = tmv_to_Timestamp(t2);
 
-	monitor->sync.count++;
-	if (monitor->sync.count == monitor->sync.records_per_msg) {
-		monitor->sync.count = 0;
-		return monitor_forward(monitor->dst_port, msg);
-	}
-	return 0;
+	return monitor_record(monitor, &monitor->sync);
 }
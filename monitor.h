@@ -6,10 +6,56 @@
 #ifndef HAVE_MONITOR_H
 #define HAVE_MONITOR_H
 
+#include <stdint.h>
+
 #include "config.h"
 #include "port.h"
+#include "servo.h"
 #include "tmv.h"
 
+#define MONITOR_RING_MAGIC	0x474e5252 /* "RRNG" */
+#define MONITOR_RING_VERSION	1
+
+/*
+ * Layout of the shared memory ring of the slave event monitor. The
+ * file starts with the header, followed by header.records fixed size
+ * records, all in host byte order. There is a single writer.
+ *
+ * The writer fills record number N, counting from one, into slot
+ * (N - 1) % records. While the slot is being written, its sequence
+ * field is zero. Afterwards the sequence field is set to N, and then
+ * the head of the ring is advanced to N. A reader has a consistent
+ * copy of a record when the sequence field read before and after
+ * copying the record holds the expected number.
+ */
+struct monitor_ring_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t record_size;
+	uint32_t records;
+	uint32_t reserved;
+	uint64_t head;
+};
+
+struct monitor_ring_record {
+	uint64_t sequence;
+	/* TLV_SLAVE_RX_SYNC_TIMING_DATA, _DELAY_TIMING_DATA_NP or _SERVO_DATA_NP */
+	uint16_t type;
+	uint16_t sequenceId;
+	uint8_t  servoState;
+	uint8_t  reserved;
+	struct PortIdentity sourcePortIdentity;
+	/*
+	 * Sync:  t1, total correction, t2.
+	 * Delay: t3, total correction, t4.
+	 * Servo: ingress time, offset from master, mean path delay.
+	 * All in nanoseconds.
+	 */
+	int64_t  ts[3];
+	/* Servo: frequency adjustment in ppb. */
+	double   frequency;
+};
+
 struct monitor;
 
 struct monitor *monitor_create(struct config *config, struct port *dst);
@@ -19,6 +65,24 @@ int monitor_delay(struct monitor *monitor, struct PortIdentity source_pid,
 
 void monitor_destroy(struct monitor *monitor);
 
+/**
+ * Obtains the file descriptor of the flush timer of a monitor.
+ * @param monitor  A monitor obtained via @ref monitor_create().
+ * @return         The timer descriptor, or -1 if there is no timer.
+ */
+int monitor_fd(struct monitor *monitor);
+
+/**
+ * Sends the pending records of a monitor. To be called when the file
+ * descriptor returned by @ref monitor_fd() becomes readable.
+ * @param monitor  A monitor obtained via @ref monitor_create().
+ */
+void monitor_flush(struct monitor *monitor);
+
+int monitor_servo(struct monitor *monitor, struct PortIdentity source_pid,
+		  tmv_t ingress, tmv_t offset, tmv_t delay, double adj,
+		  enum servo_state state);
+
 int monitor_sync(struct monitor *monitor, struct PortIdentity source_pid,
 		 uint16_t seqid, tmv_t t1, tmv_t corr, tmv_t t2);
 
@@ -1091,6 +1091,70 @@ int msg_pre_send(struct ptp_message *m)
 	return 0;
 }
 
+static void *msg_rebase(void *ptr, struct ptp_message *from,
+			struct ptp_message *to)
+{
+	uint8_t *p = ptr, *base = (uint8_t *) from;
+
+	if (p < base || p >= (uint8_t *) &from->tail_room) {
+		return ptr;
+	}
+	return (uint8_t *) to + (p - base);
+}
+
+struct ptp_message *msg_serialize(struct ptp_message *m)
+{
+	struct tlv_extra *extra, *copy;
+	struct mgmt_clock_description *cd;
+	struct ptp_message *wire;
+
+	wire = msg_allocate();
+	if (!wire) {
+		return NULL;
+	}
+	memcpy(wire, m, sizeof(*wire));
+	wire->refcnt = 1;
+	TAILQ_INIT(&wire->tlv_list);
+
+	/*
+	 * Give the copy its own TLV descriptors. Every pointer held by
+	 * a descriptor which refers into the original buffer is moved
+	 * to the same offset in the copy. The clock description and
+	 * the NSM footer share storage, so rebasing each member of the
+	 * former also covers the latter.
+	 */
+	TAILQ_FOREACH(extra, &m->tlv_list, list) {
+		copy = tlv_extra_alloc();
+		if (!copy) {
+			pr_err("failed to allocate TLV descriptor");
+			msg_put(wire);
+			return NULL;
+		}
+		*copy = *extra;
+		copy->tlv = msg_rebase(extra->tlv, m, wire);
+		cd = &copy->cd;
+		cd->clockType = msg_rebase(cd->clockType, m, wire);
+		cd->physicalLayerProtocol =
+			msg_rebase(cd->physicalLayerProtocol, m, wire);
+		cd->physicalAddress = msg_rebase(cd->physicalAddress, m, wire);
+		cd->protocolAddress = msg_rebase(cd->protocolAddress, m, wire);
+		cd->manufacturerIdentity =
+			msg_rebase(cd->manufacturerIdentity, m, wire);
+		cd->productDescription =
+			msg_rebase(cd->productDescription, m, wire);
+		cd->revisionData = msg_rebase(cd->revisionData, m, wire);
+		cd->userDescription = msg_rebase(cd->userDescription, m, wire);
+		cd->profileIdentity = msg_rebase(cd->profileIdentity, m, wire);
+		msg_tlv_attach(wire, copy);
+	}
+
+	if (msg_pre_send(wire)) {
+		msg_put(wire);
+		return NULL;
+	}
+	return wire;
+}
+
 struct tlv_extra *msg_tlv_append(struct ptp_message *msg, int length)
 {
 	struct tlv_extra *extra;
@@ -383,6 +383,22 @@ int msg_post_recv(struct ptp_message *m, int cnt);
  */
 int msg_pre_send(struct ptp_message *m);
 
+/**
+ * Serialize a message into a separate buffer for transmission.
+ *
+ * The message is copied, and the copy is passed to @ref msg_pre_send().
+ * The original message and its TLV descriptors are left untouched in
+ * host byte order, so that a message which is sent more than once, or
+ * which is still needed after being sent, never has to be converted
+ * back with @ref msg_post_recv().
+ *
+ * @param m  A message in host byte order.
+ * @return   Pointer to a message in network byte order on success,
+ *           NULL otherwise. The caller must release the returned
+ *           message using @ref msg_put().
+ */
+struct ptp_message *msg_serialize(struct ptp_message *m);
+
 /**
  * Print messages for debugging purposes.
  * @param type  Value of the messageType field as returned by @ref msg_type().
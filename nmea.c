@@ -33,6 +33,10 @@ struct nmea_parser {
 	enum nmea_state state;
 	uint8_t checksum;
 	int offset;
+	/* The following fields persist across nmea_reset(). */
+	uint64_t nbytes;	/* total number of bytes consumed */
+	uint64_t dollar;	/* value of 'nbytes' at the current '$' */
+	bool rmc_fix_valid;	/* status from the most recent RMC */
 };
 
 static void nmea_reset(struct nmea_parser *np);
@@ -47,9 +51,17 @@ static void nmea_accumulate(struct nmea_parser *np, char c)
 		nmea_reset(np);
 	}
 	np->sentence[np->offset++] = c;
+	np->sentence[np->offset] = 0;
 	np->checksum ^= c;
 }
 
+static bool nmea_wanted(struct nmea_parser *np)
+{
+	/* The sentence holds the talker ID and sentence type, "GPRMC". */
+	return !strncmp(np->sentence + 2, "RMC", 3) ||
+	       !strncmp(np->sentence + 2, "ZDA", 3);
+}
+
 static int nmea_parse_symbol(struct nmea_parser *np, char c)
 {
 	switch (np->state) {
@@ -77,8 +89,12 @@ static int nmea_parse_symbol(struct nmea_parser *np, char c)
 	case NMEA_HAVE_BODY:
 		if (c == '*') {
 			np->state = NMEA_HAVE_CSUMA;
-		} else {
-			nmea_accumulate(np, c);
+			break;
+		}
+		nmea_accumulate(np, c);
+		/* Drop unwanted sentences as soon as the type is known. */
+		if (np->offset == 5 && !nmea_wanted(np)) {
+			nmea_reset(np);
 		}
 		break;
 	case NMEA_HAVE_CSUMA:
@@ -112,30 +128,39 @@ static int nmea_parse_symbol(struct nmea_parser *np, char c)
 
 static void nmea_reset(struct nmea_parser *np)
 {
-	memset(np, 0, sizeof(*np));
+	np->sentence[0] = 0;
+	memset(np->payload_checksum, 0, sizeof(np->payload_checksum));
+	np->state = NMEA_IDLE;
+	np->checksum = 0;
+	np->offset = 0;
 }
 
-static int nmea_scan_rmc(struct nmea_parser *np, struct nmea_rmc *result)
+/* Converts the digits of fractional seconds, e.g. "5" or "500", to ns. */
+static long nmea_fraction(const char *digits)
 {
-	int cnt, i, msec = 0;
-	char *ptr, status;
-	uint8_t checksum;
-	struct tm tm;
+	long nsec = 0;
+	int i;
 
-	pr_debug("nmea sentence: %s", np->sentence);
-	cnt = sscanf(np->payload_checksum, "%02hhx", &checksum);
-	if (cnt != 1) {
-		return -1;
-	}
-	if (checksum != np->checksum) {
-		pr_err("checksum mismatch 0x%02hhx != 0x%02hhx on %s",
-		       checksum, np->checksum, np->sentence);
-		return -1;
+	for (i = 0; i < 9; i++) {
+		nsec *= 10;
+		if (*digits) {
+			nsec += *digits++ - '0';
+		}
 	}
+	return nsec;
+}
+
+static int nmea_scan_rmc(struct nmea_parser *np, struct nmea_rmc *result)
+{
+	char *ptr, status, frac[10] = "";
+	struct tm tm = {0};
+	int cnt, i;
+
 	cnt = sscanf(np->sentence,
-		     "G%*cRMC,%2d%2d%2d.%d,%c",
-		     &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &msec, &status);
+		     "G%*cRMC,%2d%2d%2d.%9[0-9],%c",
+		     &tm.tm_hour, &tm.tm_min, &tm.tm_sec, frac, &status);
 	if (cnt != 5) {
+		frac[0] = '\0';
 		cnt = sscanf(np->sentence,
 			     "G%*cRMC,%2d%2d%2d,%c",
 			     &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &status);
@@ -158,19 +183,93 @@ static int nmea_scan_rmc(struct nmea_parser *np, struct nmea_rmc *result)
 	tm.tm_year += 100;
 	tm.tm_mon--;
 	result->ts.tv_sec = mktime(&tm);
-	result->ts.tv_nsec = msec * 1000000UL;
+	result->ts.tv_nsec = nmea_fraction(frac);
 	result->fix_valid = status == 'A' ? true : false;
+	np->rmc_fix_valid = result->fix_valid;
 	return 0;
 }
 
+static int nmea_scan_zda(struct nmea_parser *np, struct nmea_rmc *result)
+{
+	char frac[10] = "";
+	struct tm tm = {0};
+	int cnt;
+
+	cnt = sscanf(np->sentence,
+		     "G%*cZDA,%2d%2d%2d.%9[0-9],%d,%d,%d",
+		     &tm.tm_hour, &tm.tm_min, &tm.tm_sec, frac,
+		     &tm.tm_mday, &tm.tm_mon, &tm.tm_year);
+	if (cnt != 7) {
+		frac[0] = '\0';
+		cnt = sscanf(np->sentence,
+			     "G%*cZDA,%2d%2d%2d,%d,%d,%d",
+			     &tm.tm_hour, &tm.tm_min, &tm.tm_sec,
+			     &tm.tm_mday, &tm.tm_mon, &tm.tm_year);
+		if (cnt != 6) {
+			return -1;
+		}
+	}
+	tm.tm_year -= 1900;
+	tm.tm_mon--;
+	result->ts.tv_sec = mktime(&tm);
+	result->ts.tv_nsec = nmea_fraction(frac);
+	/* ZDA carries no status, so rely on the last RMC seen. */
+	result->fix_valid = np->rmc_fix_valid;
+	return 0;
+}
+
+static int nmea_scan(struct nmea_parser *np, struct nmea_rmc *result)
+{
+	uint8_t checksum;
+	int cnt;
+
+	pr_debug("nmea sentence: %s", np->sentence);
+	cnt = sscanf(np->payload_checksum, "%02hhx", &checksum);
+	if (cnt != 1) {
+		return -1;
+	}
+	if (checksum != np->checksum) {
+		pr_err("checksum mismatch 0x%02hhx != 0x%02hhx on %s",
+		       checksum, np->checksum, np->sentence);
+		return -1;
+	}
+	if (!strncmp(np->sentence + 2, "RMC", 3)) {
+		return nmea_scan_rmc(np, result);
+	}
+	if (!strncmp(np->sentence + 2, "ZDA", 3)) {
+		return nmea_scan_zda(np, result);
+	}
+	return -1;
+}
+
 int nmea_parse(struct nmea_parser *np, const char *ptr, int buflen,
 	       struct nmea_rmc *result, int *parsed)
 {
-	int count = 0;
+	uint64_t base = np->nbytes;
+	const char *dollar;
+	int count = 0, skip;
+
 	while (buflen) {
+		if (np->state == NMEA_IDLE) {
+			/* Skip everything up to the next '$' in one go. */
+			dollar = memchr(ptr, '$', buflen);
+			skip = dollar ? dollar - ptr : buflen;
+			np->nbytes += skip;
+			buflen -= skip;
+			count += skip;
+			ptr += skip;
+			if (!buflen) {
+				break;
+			}
+			np->dollar = np->nbytes;
+		}
+		np->nbytes++;
 		if (!nmea_parse_symbol(np, *ptr)) {
-			if (!nmea_scan_rmc(np, result)) {
+			if (!nmea_scan(np, result)) {
+				result->start = (long) ((int64_t) np->dollar -
+							(int64_t) base);
 				*parsed = count + 1;
+				nmea_reset(np);
 				return 0;
 			}
 			nmea_reset(np);
@@ -190,6 +289,7 @@ struct nmea_parser *nmea_parser_create(void)
 	if (!np) {
 		return NULL;
 	}
+	memset(np, 0, sizeof(*np));
 	nmea_reset(np);
 	/* Ensure that mktime(3) returns a value in the UTC time scale. */
 	setenv("TZ", "UTC", 1);
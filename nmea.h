@@ -12,13 +12,24 @@
 /** Opaque type. */
 struct nmea_parser;
 
+/**
+ * Result of parsing a time of day sentence, either RMC or ZDA.
+ */
 struct nmea_rmc {
+	/** UTC time of day carried by the sentence. */
 	struct timespec ts;
+	/** Receiver fix status. ZDA sentences report the last RMC status. */
 	bool fix_valid;
+	/**
+	 * Position of the sentence's leading '$' relative to the start
+	 * of the buffer passed to nmea_parse(). This is negative when
+	 * the sentence began in an earlier buffer.
+	 */
+	long start;
 };
 
 /**
- * Parses NMEA RMC sentences out of a given buffer.
+ * Parses NMEA RMC and ZDA sentences out of a given buffer.
  * @param np		Pointer obtained via nmea_parser_create().
  * @param buf		Pointer to the data to be parsed.
  * @param buflen	Length of 'buf' in bytes.
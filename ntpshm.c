@@ -19,8 +19,12 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 #include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/shm.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 #include "config.h"
 #include "print.h"
@@ -59,9 +63,31 @@ struct shmTime {
 	int    dummy[8];
 };
 
+/* Magic value of the SOCK refclock samples (chrony/refclock_sock.c) */
+#define SOCK_MAGIC 0x534f434b
+
+/* Declaration of the SOCK refclock sample from chrony */
+struct sock_sample {
+	/* Time of the measurement (system time) */
+	struct timeval tv;
+	/* Offset between the true time and the system time (in seconds) */
+	double offset;
+	/* Non-zero if the sample is from a PPS signal */
+	int pulse;
+	/* 0 - normal, 1 - insert leap second, 2 - delete leap second */
+	int leap;
+	/* Padding, ignored */
+	int _pad;
+	/* Protocol identifier (SOCK_MAGIC) */
+	int magic;
+};
+
 struct ntpshm_servo {
 	struct servo servo;
 	struct shmTime *shm;
+	int fd;
+	struct sockaddr_un addr;
+	int send_failed;
 	int leap;
 };
 
@@ -69,10 +95,50 @@ static void ntpshm_destroy(struct servo *servo)
 {
 	struct ntpshm_servo *s = container_of(servo, struct ntpshm_servo, servo);
 
-	shmdt(s->shm);
+	if (s->shm)
+		shmdt(s->shm);
+	if (s->fd >= 0)
+		close(s->fd);
 	free(s);
 }
 
+static int ntpshm_leap_value(int leap)
+{
+	switch (leap) {
+	case -1:
+		return LEAP_DELETE;
+	case 1:
+		return LEAP_INSERT;
+	default:
+		return LEAP_NORMAL;
+	}
+}
+
+static void ntpshm_send(struct ntpshm_servo *s, int64_t offset,
+			uint64_t local_ts)
+{
+	struct sock_sample sample;
+
+	memset(&sample, 0, sizeof(sample));
+	sample.tv.tv_sec = local_ts / NS_PER_SEC;
+	sample.tv.tv_usec = local_ts % NS_PER_SEC / 1000;
+	sample.offset = -offset / 1e9;
+	sample.leap = ntpshm_leap_value(s->leap);
+	sample.magic = SOCK_MAGIC;
+
+	/* The server may not be running yet, report that only once. */
+	if (sendto(s->fd, &sample, sizeof(sample), MSG_DONTWAIT,
+		   (struct sockaddr *)&s->addr, sizeof(s->addr)) < 0) {
+		if (!s->send_failed)
+			pr_err("ntpshm: failed to send to %s: %m",
+			       s->addr.sun_path);
+		s->send_failed = 1;
+	} else if (s->send_failed) {
+		pr_info("ntpshm: sending to %s", s->addr.sun_path);
+		s->send_failed = 0;
+	}
+}
+
 static double ntpshm_sample(struct servo *servo,
 			    int64_t offset,
 			    uint64_t local_ts,
@@ -80,36 +146,37 @@ static double ntpshm_sample(struct servo *servo,
 			    enum servo_state *state)
 {
 	struct ntpshm_servo *s = container_of(servo, struct ntpshm_servo, servo);
+	struct shmTime *shm = s->shm;
 	uint64_t clock_ts = local_ts - offset;
 
-	s->shm->mode = 1;
-	s->shm->count++;
-	s->shm->valid = 0;
-	/* TODO: write memory barrier */
-
-	s->shm->clockTimeStampSec = clock_ts / NS_PER_SEC;
-	s->shm->clockTimeStampNSec = clock_ts % NS_PER_SEC;
-	s->shm->clockTimeStampUSec = s->shm->clockTimeStampNSec / 1000;
-	s->shm->receiveTimeStampSec = local_ts / NS_PER_SEC;
-	s->shm->receiveTimeStampNSec = local_ts % NS_PER_SEC;
-	s->shm->receiveTimeStampUSec = s->shm->receiveTimeStampNSec / 1000;
-	s->shm->precision = -30; /* 1 nanosecond */
-
-	switch (s->leap) {
-		case -1:
-			s->shm->leap = LEAP_DELETE;
-			break;
-		case 1:
-			s->shm->leap = LEAP_INSERT;
-			break;
-		default:
-			s->shm->leap = LEAP_NORMAL;
+	if (s->fd >= 0) {
+		ntpshm_send(s, offset, local_ts);
+		*state = SERVO_UNLOCKED;
+		return 0.0;
 	}
 
-	/* TODO: write memory barrier */
-
-	s->shm->count++;
-	s->shm->valid = 1;
+	/*
+	 * The reader (in mode 1) uses the sample only if the count is the
+	 * same before and after reading it. Order the updates of the count
+	 * and valid flag against the sample with write memory barriers.
+	 */
+	shm->valid = 0;
+	shm->count++;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	shm->clockTimeStampSec = clock_ts / NS_PER_SEC;
+	shm->clockTimeStampNSec = clock_ts % NS_PER_SEC;
+	shm->clockTimeStampUSec = shm->clockTimeStampNSec / 1000;
+	shm->receiveTimeStampSec = local_ts / NS_PER_SEC;
+	shm->receiveTimeStampNSec = local_ts % NS_PER_SEC;
+	shm->receiveTimeStampUSec = shm->receiveTimeStampNSec / 1000;
+	shm->precision = -30; /* 1 nanosecond */
+	shm->leap = ntpshm_leap_value(s->leap);
+
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	shm->count++;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	shm->valid = 1;
 
 	*state = SERVO_UNLOCKED;
 	return 0.0;
@@ -134,6 +201,7 @@ struct servo *ntpshm_servo_create(struct config *cfg)
 {
 	struct ntpshm_servo *s;
 	int ntpshm_segment = config_get_int(cfg, NULL, "ntpshm_segment");
+	char *ntpshm_socket = config_get_string(cfg, NULL, "ntpshm_socket");
 	int shmid;
 
 	s = calloc(1, sizeof(*s));
@@ -146,6 +214,27 @@ struct servo *ntpshm_servo_create(struct config *cfg)
 	s->servo.reset = ntpshm_reset;
 	s->servo.leap = ntpshm_leap;
 
+	s->fd = -1;
+
+	if (ntpshm_socket && *ntpshm_socket) {
+		if (strlen(ntpshm_socket) >= sizeof(s->addr.sun_path)) {
+			pr_err("ntpshm: socket path %s too long",
+			       ntpshm_socket);
+			free(s);
+			return NULL;
+		}
+		s->addr.sun_family = AF_UNIX;
+		strcpy(s->addr.sun_path, ntpshm_socket);
+
+		s->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+		if (s->fd < 0) {
+			pr_err("ntpshm: socket failed: %m");
+			free(s);
+			return NULL;
+		}
+		return &s->servo;
+	}
+
 	shmid = shmget(SHMKEY + ntpshm_segment, sizeof (struct shmTime),
 		       IPC_CREAT | 0600);
 	if (shmid == -1) {
@@ -160,6 +249,7 @@ struct servo *ntpshm_servo_create(struct config *cfg)
 		free(s);
 		return NULL;
 	}
+	s->shm->mode = 1;
 
 	return &s->servo;
 }
@@ -21,7 +21,6 @@
 #include "port.h"
 #include "port_private.h"
 #include "print.h"
-#include "rtnl.h"
 #include "tc.h"
 
 static int p2p_delay_request(struct port *p)
@@ -53,12 +52,12 @@ void p2p_dispatch(struct port *p, enum fsm_event event, int mdiff)
 		return;
 	}
 
-	port_clr_tmo(p->fda.fd[FD_ANNOUNCE_TIMER]);
-	port_clr_tmo(p->fda.fd[FD_SYNC_RX_TIMER]);
+	port_clr_tmo(port_timer(p, FD_ANNOUNCE_TIMER));
+	port_clr_tmo(port_timer(p, FD_SYNC_RX_TIMER));
 	/* Leave FD_DELAY_TIMER running. */
-	port_clr_tmo(p->fda.fd[FD_QUALIFICATION_TIMER]);
-	port_clr_tmo(p->fda.fd[FD_MANNO_TIMER]);
-	port_clr_tmo(p->fda.fd[FD_SYNC_TX_TIMER]);
+	port_clr_tmo(port_timer(p, FD_QUALIFICATION_TIMER));
+	port_clr_tmo(port_timer(p, FD_MANNO_TIMER));
+	port_clr_tmo(port_timer(p, FD_SYNC_TX_TIMER));
 
 	/*
 	 * Handle the side effects of the state transition.
@@ -92,7 +91,7 @@ void p2p_dispatch(struct port *p, enum fsm_event event, int mdiff)
 
 enum fsm_event p2p_event(struct port *p, int fd_index)
 {
-	int cnt, fd = p->fda.fd[fd_index];
+	int cnt;
 	enum fsm_event event = EV_NONE;
 	struct ptp_message *msg, *dup;
 
@@ -123,18 +122,6 @@ enum fsm_event p2p_event(struct port *p, int fd_index)
 	case FD_UNICAST_SRV_TIMER:
 		pr_err("unexpected timer expiration");
 		return EV_NONE;
-
-	case FD_RTNL:
-		pr_debug("port %hu: received link status notification", portnum(p));
-		rtnl_link_status(fd, p->name, port_link_status, p);
-		if (p->link_status == (LINK_UP|LINK_STATE_CHANGED)) {
-			return EV_FAULT_CLEARED;
-		} else if ((p->link_status == (LINK_DOWN|LINK_STATE_CHANGED)) ||
-			   (p->link_status & TS_LABEL_CHANGED)) {
-			return EV_FAULT_DETECTED;
-		} else {
-			return EV_NONE;
-		}
 	}
 
 	msg = msg_allocate();
@@ -143,12 +130,16 @@ enum fsm_event p2p_event(struct port *p, int fd_index)
 	}
 	msg->hwts.type = p->timestamping;
 
-	cnt = transport_recv(p->trp, fd, msg);
-	if (cnt <= 0) {
+	cnt = transport_recv(p->trp, p->fda.fd[fd_index], msg);
+	if (cnt < 0) {
 		pr_err("port %hu: recv message failed", portnum(p));
 		msg_put(msg);
 		return EV_FAULT_DETECTED;
 	}
+	if (!cnt) {
+		msg_put(msg);
+		return EV_NONE;
+	}
 	if (msg_sots_valid(msg)) {
 		ts_add(&msg->hwts.ts, -p->rx_timestamp_offset);
 	}
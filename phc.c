@@ -27,6 +27,7 @@
 #include <unistd.h>
 
 #include "phc.h"
+#include "simclock.h"
 
 /*
  * On 32 bit platforms, the PHC driver's maximum adjustment (type
@@ -39,6 +40,17 @@
 
 static int phc_get_caps(clockid_t clkid, struct ptp_clock_caps *caps);
 
+/* The simulated clocks, only present in the simulator. */
+static clockid_t (*sim_open)(const char *phc);
+static int (*sim_is)(clockid_t clkid);
+
+void phc_set_sim(clockid_t (*open)(const char *phc),
+		 int (*is)(clockid_t clkid))
+{
+	sim_open = open;
+	sim_is = is;
+}
+
 clockid_t phc_open(const char *phc)
 {
 	clockid_t clkid;
@@ -48,6 +60,9 @@ clockid_t phc_open(const char *phc)
 
 	memset(&tx, 0, sizeof(tx));
 
+	if (sim_open && !strncmp(phc, SIMCLOCK_PREFIX, strlen(SIMCLOCK_PREFIX)))
+		return sim_open(phc);
+
 	fd = open(phc, O_RDWR);
 	if (fd < 0)
 		return CLOCK_INVALID;
@@ -68,7 +83,7 @@ clockid_t phc_open(const char *phc)
 
 void phc_close(clockid_t clkid)
 {
-	if (clkid == CLOCK_INVALID)
+	if (clkid == CLOCK_INVALID || (sim_is && sim_is(clkid)))
 		return;
 
 	close(CLOCKID_TO_FD(clkid));
@@ -30,6 +30,16 @@
  */
 clockid_t phc_open(const char *phc);
 
+/**
+ * Hands the device names starting with SIMCLOCK_PREFIX to the simulated
+ * clocks. Without this, such a name is opened like any other device.
+ *
+ * @param open  Looks up a simulated clock by its device name.
+ * @param is    Tests whether a clock ID refers to a simulated clock.
+ */
+void phc_set_sim(clockid_t (*open)(const char *phc),
+		 int (*is)(clockid_t clkid));
+
 /**
  * Closes a PTP hardware clock device.
  *
@@ -49,13 +49,16 @@
 #include "pi.h"
 #include "pmc_common.h"
 #include "print.h"
+#include "rtprof.h"
 #include "servo.h"
 #include "sk.h"
 #include "stats.h"
 #include "sysoff.h"
 #include "tlv.h"
+#include "tsrec.h"
 #include "uds.h"
 #include "util.h"
+#include "warm.h"
 #include "version.h"
 
 #define KP 0.7
@@ -77,6 +80,7 @@ struct clock {
 	int sync_offset;
 	int leap_set;
 	int utc_offset_set;
+	int warm_checked;
 	struct servo *servo;
 	enum servo_state servo_state;
 	char *device;
@@ -148,7 +152,9 @@ static struct servo *servo_add(struct phc2sys_private *priv,
 		return NULL;
 	}
 
+	tsrec_write(TSREC_SERVO, clock->clkid, max_ppb, 0, 0, ppb);
 	servo_sync_interval(servo, priv->phc_interval);
+	tsrec_write(TSREC_INTERVAL, clock->clkid, 0, 0, 0, priv->phc_interval);
 
 	return servo;
 }
@@ -212,12 +218,70 @@ static struct clock *clock_add(struct phc2sys_private *priv, char *device)
 	return c;
 }
 
+/*
+ * Start from the frequency saved in the state file, when the clock is
+ * synchronized to the same source as before. The source of a clock is
+ * only known once it becomes a destination.
+ */
+static void clock_warm_start(struct phc2sys_private *priv,
+			     struct clock *clock)
+{
+	struct servo *servo;
+	struct warm_record w;
+	double ppb;
+
+	clock->warm_checked = 1;
+
+	if (!clock->device || !priv->master || !priv->master->device ||
+	    warm_find(clock->device, &w) || strcmp(w.parent, priv->master->device))
+		return;
+
+	ppb = clockadj_get_freq(clock->clkid);
+	clockadj_set_freq(clock->clkid, w.freq);
+	servo = servo_add(priv, clock);
+	if (!servo) {
+		clockadj_set_freq(clock->clkid, ppb);
+		return;
+	}
+	servo_destroy(clock->servo);
+	clock->servo = servo;
+	clock->servo_state = SERVO_UNLOCKED;
+	pr_info("%s: warm start from %s at %+.0f ppb",
+		clock->device, w.parent, w.freq);
+}
+
+static void clock_warm_save(struct phc2sys_private *priv,
+			    struct clock *clock, double freq)
+{
+	struct warm_record w;
+
+	if (!clock->device || !priv->master || !priv->master->device)
+		return;
+
+	memset(&w, 0, sizeof(w));
+	snprintf(w.clock, sizeof(w.clock), "%s", clock->device);
+	snprintf(w.parent, sizeof(w.parent), "%s", priv->master->device);
+	w.freq = freq;
+	warm_save(&w);
+}
+
 static void clock_cleanup(struct phc2sys_private *priv)
 {
+	unsigned long issued, skipped;
 	struct clock *c, *tmp;
 
+	/* Save the state while the source of each clock is still there. */
+	LIST_FOREACH(c, &priv->clocks, list) {
+		if (c->servo_state == SERVO_LOCKED ||
+		    c->servo_state == SERVO_LOCKED_STABLE)
+			clock_warm_save(priv, c, clockadj_get_freq(c->clkid));
+	}
+
 	LIST_FOREACH_SAFE(c, &priv->clocks, list, tmp) {
 		if (c->servo) {
+			clockadj_get_counts(c->clkid, &issued, &skipped);
+			pr_info("%s: clock adjustments: %lu issued, %lu skipped",
+				c->device, issued, skipped);
 			servo_destroy(c->servo);
 		}
 		if (c->sanity_check) {
@@ -552,14 +616,24 @@ static void update_clock(struct phc2sys_private *priv, struct clock *clock,
 	enum servo_state state;
 	double ppb;
 
-	if (clock_handle_leap(priv, clock, offset, ts))
+	if (!clock->warm_checked)
+		clock_warm_start(priv, clock);
+
+	/* Apply the leap, TAI offset, step and frequency changes at once. */
+	clockadj_begin(clock->clkid);
+
+	if (clock_handle_leap(priv, clock, offset, ts)) {
+		clockadj_commit(clock->clkid);
 		return;
+	}
 
 	offset += get_sync_offset(priv, clock);
 
 	if (clock->sanity_check && clockcheck_sample(clock->sanity_check, ts))
 		servo_reset(clock->servo);
 
+	tsrec_write(TSREC_OFFSET, clock->clkid, offset, ts, delay, 0.0);
+
 	ppb = servo_sample(clock->servo, offset, ts, 1.0, &state);
 	clock->servo_state = state;
 
@@ -578,8 +652,11 @@ static void update_clock(struct phc2sys_private *priv, struct clock *clock,
 			sysclk_set_sync();
 		if (clock->sanity_check)
 			clockcheck_set_freq(clock->sanity_check, -ppb);
+		if (state != SERVO_JUMP && warm_due(clock->device))
+			clock_warm_save(priv, clock, -ppb);
 		break;
 	}
+	clockadj_commit(clock->clkid);
 
 	if (clock->offset_stats) {
 		update_clock_stats(clock, priv->stats_max_count, offset, ppb, delay);
@@ -674,6 +751,7 @@ static int do_pps_loop(struct phc2sys_private *priv, struct clock *clock,
 		if (update_pmc_node(&priv->node, 0) < 0)
 			continue;
 		update_clock(priv, clock, pps_offset, pps_ts, -1);
+		warm_flush();
 	}
 	close(fd);
 	return 0;
@@ -769,6 +847,7 @@ static int do_loop(struct phc2sys_private *priv, int subscriptions)
 			}
 			update_clock(priv, clock, offset, ts, delay);
 		}
+		warm_flush();
 	}
 	return 0;
 }
@@ -1251,9 +1330,32 @@ int main(int argc, char *argv[])
 	priv.kernel_leap = config_get_int(cfg, NULL, "kernel_leap");
 	priv.sanity_freq_limit = config_get_int(cfg, NULL, "sanity_freq_limit");
 
+	if (tsrec_open(config_get_string(cfg, NULL, "timestamp_record"))) {
+		config_destroy(cfg);
+		return -1;
+	}
+	clockadj_set_record(tsrec_write);
+
+	if (warm_open(config_get_string(cfg, NULL, "state_file"),
+		      config_get_int(cfg, NULL, "state_file_max_age"),
+		      config_get_int(cfg, NULL, "state_file_interval"))) {
+		tsrec_close();
+		config_destroy(cfg);
+		return -1;
+	}
+
+	if (rtprof_apply(cfg)) {
+		warm_close();
+		tsrec_close();
+		config_destroy(cfg);
+		return -1;
+	}
+
 	snprintf(uds_local, sizeof(uds_local), "/var/run/phc2sys.%d",
 		 getpid());
 
+	rtprof_check(cfg);
+
 	if (autocfg) {
 		if (init_pmc_node(cfg, &priv.node, uds_local,
 				  phc2sys_recv_subscribed))
@@ -1324,7 +1426,9 @@ int main(int argc, char *argv[])
 	if (pps_fd >= 0) {
 		/* only one destination clock allowed with PPS until we
 		 * implement a mean to specify PTP port to PPS mapping */
+		clock_warm_start(&priv, dst);
 		servo_sync_interval(dst->servo, 1.0);
+		tsrec_write(TSREC_INTERVAL, dst->clkid, 0, 0, 0, 1.0);
 		r = do_pps_loop(&priv, dst, pps_fd);
 	} else {
 		r = do_loop(&priv, 0);
@@ -1334,11 +1438,14 @@ end:
 	close_pmc_node(&priv.node);
 	clock_cleanup(&priv);
 	port_cleanup(&priv);
+	warm_close();
+	tsrec_close();
 	config_destroy(cfg);
 	msg_cleanup();
 	return r;
 bad_usage:
 	usage(progname);
+	tsrec_close();
 	config_destroy(cfg);
 	return -1;
 }
@@ -44,6 +44,7 @@ struct pi_servo {
 	double ki;
 	double last_freq;
 	int count;
+	int sw_ts;
 	/* configuration: */
 	double configured_pi_kp;
 	double configured_pi_ki;
@@ -177,35 +178,21 @@ static void pi_reset(struct servo *servo)
 	s->count = 0;
 }
 
-struct servo *pi_servo_create(struct config *cfg, int fadj, int sw_ts)
+static void pi_configure(struct pi_servo *s, struct config *cfg)
 {
-	struct pi_servo *s;
-
-	s = calloc(1, sizeof(*s));
-	if (!s)
-		return NULL;
-
-	s->servo.destroy = pi_destroy;
-	s->servo.sample  = pi_sample;
-	s->servo.sync_interval = pi_sync_interval;
-	s->servo.reset   = pi_reset;
-	s->drift         = fadj;
-	s->last_freq     = fadj;
-	s->kp            = 0.0;
-	s->ki            = 0.0;
-	s->configured_pi_kp = config_get_double(cfg, NULL, "pi_proportional_const");
-	s->configured_pi_ki = config_get_double(cfg, NULL, "pi_integral_const");
-	s->configured_pi_kp_scale = config_get_double(cfg, NULL, "pi_proportional_scale");
+	s->configured_pi_kp = config_get_double_id(cfg, NULL, CFG_pi_proportional_const);
+	s->configured_pi_ki = config_get_double_id(cfg, NULL, CFG_pi_integral_const);
+	s->configured_pi_kp_scale = config_get_double_id(cfg, NULL, CFG_pi_proportional_scale);
 	s->configured_pi_kp_exponent =
-		config_get_double(cfg, NULL, "pi_proportional_exponent");
+		config_get_double_id(cfg, NULL, CFG_pi_proportional_exponent);
 	s->configured_pi_kp_norm_max =
-		config_get_double(cfg, NULL, "pi_proportional_norm_max");
+		config_get_double_id(cfg, NULL, CFG_pi_proportional_norm_max);
 	s->configured_pi_ki_scale =
-		config_get_double(cfg, NULL, "pi_integral_scale");
+		config_get_double_id(cfg, NULL, CFG_pi_integral_scale);
 	s->configured_pi_ki_exponent =
-		config_get_double(cfg, NULL, "pi_integral_exponent");
+		config_get_double_id(cfg, NULL, CFG_pi_integral_exponent);
 	s->configured_pi_ki_norm_max =
-		config_get_double(cfg, NULL, "pi_integral_norm_max");
+		config_get_double_id(cfg, NULL, CFG_pi_integral_norm_max);
 
 	if (s->configured_pi_kp && s->configured_pi_ki) {
 		/* Use the constants as configured by the user without
@@ -218,7 +205,7 @@ struct servo *pi_servo_create(struct config *cfg, int fadj, int sw_ts)
 		s->configured_pi_kp_norm_max = MAX_KP_NORM_MAX;
 		s->configured_pi_ki_norm_max = MAX_KI_NORM_MAX;
 	} else if (!s->configured_pi_kp_scale || !s->configured_pi_ki_scale) {
-		if (sw_ts) {
+		if (s->sw_ts) {
 			s->configured_pi_kp_scale = SWTS_KP_SCALE;
 			s->configured_pi_ki_scale = SWTS_KI_SCALE;
 		} else {
@@ -226,6 +213,34 @@ struct servo *pi_servo_create(struct config *cfg, int fadj, int sw_ts)
 			s->configured_pi_ki_scale = HWTS_KI_SCALE;
 		}
 	}
+}
+
+static void pi_reconfigure(struct servo *servo, struct config *cfg)
+{
+	struct pi_servo *s = container_of(servo, struct pi_servo, servo);
+
+	pi_configure(s, cfg);
+}
+
+struct servo *pi_servo_create(struct config *cfg, int fadj, int sw_ts)
+{
+	struct pi_servo *s;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return NULL;
+
+	s->servo.destroy = pi_destroy;
+	s->servo.sample  = pi_sample;
+	s->servo.sync_interval = pi_sync_interval;
+	s->servo.reset   = pi_reset;
+	s->servo.reconfigure = pi_reconfigure;
+	s->drift         = fadj;
+	s->last_freq     = fadj;
+	s->kp            = 0.0;
+	s->ki            = 0.0;
+	s->sw_ts         = sw_ts;
+	pi_configure(s, cfg);
 
 	return &s->servo;
 }
@@ -28,6 +28,7 @@
 
 #include "ds.h"
 #include "fsm.h"
+#include "latency.h"
 #include "notification.h"
 #include "pmc_common.h"
 #include "print.h"
@@ -40,6 +41,20 @@ static struct pmc *pmc;
 
 #define IFMT "\n\t\t"
 #define P41 ((double)(1ULL << 41))
+#define BULK_TMO 1000 /*milliseconds*/
+
+struct bulk_request {
+	UInteger16 sequence_id;
+	int id;
+	int quiet;
+};
+
+/* The answers of one clock to all of the requests. */
+struct bulk_clock {
+	struct ClockIdentity identity;
+	int *answers;
+	int *expected;	/* -1 until the number of ports is known */
+};
 
 static char *text2str(struct PTPText *text)
 {
@@ -88,12 +103,29 @@ static void pmc_show_rx_sync_timing(struct slave_rx_sync_timing_record *record,
 		SHOW_TIMESTAMP(record->syncEventIngressTimestamp));
 }
 
+static void pmc_show_servo(struct slave_servo_record *record, FILE *fp)
+{
+	fprintf(fp,
+		IFMT "syncEventIngressTimestamp  %" PRId64 ".%09u"
+		IFMT "offsetFromMaster           %.1f"
+		IFMT "meanPathDelay              %.1f"
+		IFMT "frequencyAdjustment        %.3f"
+		IFMT "servoState                 %hhu",
+		SHOW_TIMESTAMP(record->syncEventIngressTimestamp),
+		record->offsetFromMaster / 65536.0,
+		record->meanPathDelay / 65536.0,
+		record->scaledFrequencyAdjustment / 65536.0,
+		record->servoState);
+}
+
 static void pmc_show_signaling(struct ptp_message *msg, FILE *fp)
 {
 	struct slave_rx_sync_timing_record *sync_record;
 	struct slave_delay_timing_record *delay_record;
 	struct slave_rx_sync_timing_data_tlv *srstd;
 	struct slave_delay_timing_data_tlv *sdtdt;
+	struct slave_servo_record *servo_record;
+	struct slave_servo_data_tlv *ssdt;
 	struct tlv_extra *extra;
 	int i, cnt;
 
@@ -129,6 +161,19 @@ static void pmc_show_signaling(struct ptp_message *msg, FILE *fp)
 				delay_record++;
 			}
 			break;
+		case TLV_SLAVE_SERVO_DATA_NP:
+			ssdt = (struct slave_servo_data_tlv *) extra->tlv;
+			cnt = (ssdt->length - sizeof(ssdt->sourcePortIdentity)) /
+				sizeof(*servo_record);
+			fprintf(fp, "SLAVE_SERVO_DATA_NP N %d "
+				IFMT "sourcePortIdentity         %s",
+				cnt, pid2str(&ssdt->sourcePortIdentity));
+			servo_record = ssdt->record;
+			for (i = 0; i < cnt; i++) {
+				pmc_show_servo(servo_record, fp);
+				servo_record++;
+			}
+			break;
 		default:
 			break;
 		}
@@ -137,7 +182,7 @@ static void pmc_show_signaling(struct ptp_message *msg, FILE *fp)
 	fflush(fp);
 }
 
-static void pmc_show(struct ptp_message *msg, FILE *fp)
+static void pmc_show_tlv(struct tlv_extra *extra, FILE *fp)
 {
 	struct grandmaster_settings_np *gsn;
 	struct mgmt_clock_description *cd;
@@ -147,48 +192,35 @@ static void pmc_show(struct ptp_message *msg, FILE *fp)
 	struct timePropertiesDS *tp;
 	struct management_tlv *mgt;
 	struct time_status_np *tsn;
+	struct latency_stats_np *lsn;
 	struct port_stats_np *pcp;
-	struct tlv_extra *extra;
 	struct port_ds_np *pnp;
 	struct defaultDS *dds;
 	struct currentDS *cds;
 	struct parentDS *pds;
 	struct portDS *p;
+	struct snapshot_np *snp;
 	struct TLV *tlv;
-	int action;
+	int i;
 
-	if (msg_type(msg) == SIGNALING) {
-		pmc_show_signaling(msg, fp);
-		return;
-	}
-	if (msg_type(msg) != MANAGEMENT) {
-		return;
-	}
-	action = management_action(msg);
-	if (action < GET || action > ACKNOWLEDGE) {
-		return;
-	}
-	fprintf(fp, "\t%s seq %hu %s ",
-		pid2str(&msg->header.sourcePortIdentity),
-		msg->header.sequenceId, pmc_action_string(action));
-	if (msg_tlv_count(msg) != 1) {
-		goto out;
-	}
-	extra = TAILQ_FIRST(&msg->tlv_list);
-	tlv = (struct TLV *) msg->management.suffix;
+	tlv = extra->tlv;
 	if (tlv->type == TLV_MANAGEMENT) {
 		fprintf(fp, "MANAGEMENT ");
 	} else if (tlv->type == TLV_MANAGEMENT_ERROR_STATUS) {
 		fprintf(fp, "MANAGEMENT_ERROR_STATUS ");
-		goto out;
+		return;
 	} else {
 		fprintf(fp, "unknown-tlv ");
-		goto out;
+		return;
+	}
+	mgt = (struct management_tlv *) extra->tlv;
+	if (mgt->id == TLV_RELOAD_CONFIG_NP) {
+		fprintf(fp, "RELOAD_CONFIG_NP ");
+		return;
 	}
-	mgt = (struct management_tlv *) msg->management.suffix;
 	if (mgt->length == 2 && mgt->id != TLV_NULL_MANAGEMENT) {
 		fprintf(fp, "empty-tlv ");
-		goto out;
+		return;
 	}
 	switch (mgt->id) {
 	case TLV_CLOCK_DESCRIPTION:
@@ -396,6 +428,14 @@ static void pmc_show(struct ptp_message *msg, FILE *fp)
 		fprintf(fp, "SYNCHRONIZATION_UNCERTAIN_NP "
 			IFMT "uncertain %hhu", mtd->val);
 		break;
+	case TLV_SNAPSHOT_NP:
+		snp = (struct snapshot_np *) mgt->data;
+		fprintf(fp, "SNAPSHOT_NP "
+			IFMT "fragment     %hu"
+			IFMT "lastFragment %hu"
+			IFMT "numberPorts  %hu",
+			snp->fragment, snp->lastFragment, snp->numberPorts);
+		break;
 	case TLV_PORT_DATA_SET:
 		p = (struct portDS *) mgt->data;
 		if (p->portState > PS_SLAVE) {
@@ -487,6 +527,20 @@ static void pmc_show(struct ptp_message *msg, FILE *fp)
 			pcp->stats.txMsgType[SIGNALING],
 			pcp->stats.txMsgType[MANAGEMENT]);
 		break;
+	case TLV_LATENCY_STATS_NP:
+		lsn = (struct latency_stats_np *) mgt->data;
+		fprintf(fp, "LATENCY_STATS_NP "
+			IFMT "portIdentity  %s",
+			pid2str(&lsn->portIdentity));
+		for (i = 0; i < lsn->numberStages; i++) {
+			fprintf(fp, IFMT "%-9s count %" PRIu64
+				" min %u mean %u p50 %u p99 %u max %u",
+				latency_stage_name(i), lsn->stage[i].count,
+				lsn->stage[i].min, lsn->stage[i].mean,
+				lsn->stage[i].p50, lsn->stage[i].p99,
+				lsn->stage[i].max);
+		}
+		break;
 	case TLV_LOG_ANNOUNCE_INTERVAL:
 		mtd = (struct management_tlv_datum *) mgt->data;
 		fprintf(fp, "LOG_ANNOUNCE_INTERVAL "
@@ -518,11 +572,559 @@ static void pmc_show(struct ptp_message *msg, FILE *fp)
 			IFMT "logMinPdelayReqInterval %hhd", mtd->val);
 		break;
 	}
-out:
+}
+
+static void pmc_show(struct ptp_message *msg, FILE *fp)
+{
+	struct tlv_extra *extra;
+	int action;
+
+	if (msg_type(msg) == SIGNALING) {
+		pmc_show_signaling(msg, fp);
+		return;
+	}
+	if (msg_type(msg) != MANAGEMENT) {
+		return;
+	}
+	action = management_action(msg);
+	if (action < GET || action > ACKNOWLEDGE) {
+		return;
+	}
+	fprintf(fp, "\t%s seq %hu %s ",
+		pid2str(&msg->header.sourcePortIdentity),
+		msg->header.sequenceId, pmc_action_string(action));
+	TAILQ_FOREACH(extra, &msg->tlv_list, list) {
+		if (extra != TAILQ_FIRST(&msg->tlv_list)) {
+			fprintf(fp, "\n\t");
+		}
+		pmc_show_tlv(extra, fp);
+	}
 	fprintf(fp, "\n");
 	fflush(fp);
 }
 
+/* Prints a string received from the network as a JSON string. */
+static void pmc_json_str(FILE *fp, const char *str)
+{
+	const unsigned char *c;
+
+	fputc('"', fp);
+	for (c = (const unsigned char *) str; *c; c++) {
+		if (*c == '"' || *c == '\\') {
+			fprintf(fp, "\\%c", *c);
+		} else if (*c < 0x20 || *c == 0x7f) {
+			fprintf(fp, "\\u%04x", *c);
+		} else {
+			fputc(*c, fp);
+		}
+	}
+	fputc('"', fp);
+}
+
+static void pmc_show_json_tlv(struct tlv_extra *extra, FILE *fp)
+{
+	struct management_error_status *mes;
+	struct mgmt_clock_description *cd;
+	struct management_tlv_datum *mtd;
+	struct port_properties_np *ppn;
+	struct timePropertiesDS *tp;
+	struct management_tlv *mgt;
+	struct time_status_np *tsn;
+	struct latency_stats_np *lsn;
+	struct port_stats_np *pcp;
+	struct port_ds_np *pnp;
+	struct defaultDS *dds;
+	struct currentDS *cds;
+	struct parentDS *pds;
+	struct portDS *p;
+	struct snapshot_np *snp;
+	struct TLV *tlv;
+	int i;
+
+	tlv = extra->tlv;
+	if (tlv->type == TLV_MANAGEMENT_ERROR_STATUS) {
+		mes = (struct management_error_status *) tlv;
+		fprintf(fp, "\"id\":\"%s\",\"error\":%hu",
+			pmc_id_string(mes->id), mes->error);
+		return;
+	}
+	if (tlv->type != TLV_MANAGEMENT) {
+		fprintf(fp, "\"type\":%hu", tlv->type);
+		return;
+	}
+	mgt = (struct management_tlv *) tlv;
+	fprintf(fp, "\"id\":\"%s\"", pmc_id_string(mgt->id));
+	if (mgt->length == 2 && mgt->id != TLV_NULL_MANAGEMENT) {
+		return;
+	}
+	mtd = (struct management_tlv_datum *) mgt->data;
+	switch (mgt->id) {
+	case TLV_CLOCK_DESCRIPTION:
+		cd = &extra->cd;
+		fprintf(fp, ",\"data\":{\"clockType\":%hu,"
+			"\"physicalLayerProtocol\":", align16(cd->clockType));
+		pmc_json_str(fp, text2str(cd->physicalLayerProtocol));
+		fprintf(fp, ",\"physicalAddress\":\"%s\",\"protocolAddress\":",
+			bin2str(cd->physicalAddress->address,
+				cd->physicalAddress->length));
+		pmc_json_str(fp, portaddr2str(cd->protocolAddress));
+		fprintf(fp, ",\"manufacturerId\":\"%s\",\"productDescription\":",
+			bin2str(cd->manufacturerIdentity, OUI_LEN));
+		pmc_json_str(fp, text2str(cd->productDescription));
+		fprintf(fp, ",\"revisionData\":");
+		pmc_json_str(fp, text2str(cd->revisionData));
+		fprintf(fp, ",\"userDescription\":");
+		pmc_json_str(fp, text2str(cd->userDescription));
+		fprintf(fp, ",\"profileId\":\"%s\"}",
+			bin2str(cd->profileIdentity, PROFILE_ID_LEN));
+		break;
+	case TLV_USER_DESCRIPTION:
+		fprintf(fp, ",\"data\":{\"userDescription\":");
+		pmc_json_str(fp, text2str(extra->cd.userDescription));
+		fprintf(fp, "}");
+		break;
+	case TLV_DEFAULT_DATA_SET:
+		dds = (struct defaultDS *) mgt->data;
+		fprintf(fp, ",\"data\":{"
+			"\"twoStepFlag\":%d,"
+			"\"slaveOnly\":%d,"
+			"\"numberPorts\":%hu,"
+			"\"priority1\":%hhu,"
+			"\"clockClass\":%hhu,"
+			"\"clockAccuracy\":%hhu,"
+			"\"offsetScaledLogVariance\":%hu,"
+			"\"priority2\":%hhu,"
+			"\"clockIdentity\":\"%s\","
+			"\"domainNumber\":%hhu}",
+			dds->flags & DDS_TWO_STEP_FLAG ? 1 : 0,
+			dds->flags & DDS_SLAVE_ONLY ? 1 : 0,
+			dds->numberPorts,
+			dds->priority1,
+			dds->clockQuality.clockClass,
+			dds->clockQuality.clockAccuracy,
+			dds->clockQuality.offsetScaledLogVariance,
+			dds->priority2,
+			cid2str(&dds->clockIdentity),
+			dds->domainNumber);
+		break;
+	case TLV_CURRENT_DATA_SET:
+		cds = (struct currentDS *) mgt->data;
+		fprintf(fp, ",\"data\":{"
+			"\"stepsRemoved\":%hd,"
+			"\"offsetFromMaster\":%.1f,"
+			"\"meanPathDelay\":%.1f}",
+			cds->stepsRemoved, cds->offsetFromMaster / 65536.0,
+			cds->meanPathDelay / 65536.0);
+		break;
+	case TLV_PARENT_DATA_SET:
+		pds = (struct parentDS *) mgt->data;
+		fprintf(fp, ",\"data\":{"
+			"\"parentPortIdentity\":\"%s\","
+			"\"parentStats\":%hhu,"
+			"\"observedParentOffsetScaledLogVariance\":%hu,"
+			"\"observedParentClockPhaseChangeRate\":%u,"
+			"\"grandmasterPriority1\":%hhu,"
+			"\"gm.ClockClass\":%hhu,"
+			"\"gm.ClockAccuracy\":%hhu,"
+			"\"gm.OffsetScaledLogVariance\":%hu,"
+			"\"grandmasterPriority2\":%hhu,"
+			"\"grandmasterIdentity\":\"%s\"}",
+			pid2str(&pds->parentPortIdentity),
+			pds->parentStats,
+			pds->observedParentOffsetScaledLogVariance,
+			pds->observedParentClockPhaseChangeRate,
+			pds->grandmasterPriority1,
+			pds->grandmasterClockQuality.clockClass,
+			pds->grandmasterClockQuality.clockAccuracy,
+			pds->grandmasterClockQuality.offsetScaledLogVariance,
+			pds->grandmasterPriority2,
+			cid2str(&pds->grandmasterIdentity));
+		break;
+	case TLV_TIME_PROPERTIES_DATA_SET:
+		tp = (struct timePropertiesDS *) mgt->data;
+		fprintf(fp, ",\"data\":{"
+			"\"currentUtcOffset\":%hd,"
+			"\"leap61\":%d,"
+			"\"leap59\":%d,"
+			"\"currentUtcOffsetValid\":%d,"
+			"\"ptpTimescale\":%d,"
+			"\"timeTraceable\":%d,"
+			"\"frequencyTraceable\":%d,"
+			"\"timeSource\":%hhu}",
+			tp->currentUtcOffset,
+			tp->flags & LEAP_61 ? 1 : 0,
+			tp->flags & LEAP_59 ? 1 : 0,
+			tp->flags & UTC_OFF_VALID ? 1 : 0,
+			tp->flags & PTP_TIMESCALE ? 1 : 0,
+			tp->flags & TIME_TRACEABLE ? 1 : 0,
+			tp->flags & FREQ_TRACEABLE ? 1 : 0,
+			tp->timeSource);
+		break;
+	case TLV_TIME_STATUS_NP:
+		tsn = (struct time_status_np *) mgt->data;
+		fprintf(fp, ",\"data\":{"
+			"\"master_offset\":%" PRId64 ","
+			"\"ingress_time\":%" PRId64 ","
+			"\"cumulativeScaledRateOffset\":%.9f,"
+			"\"scaledLastGmPhaseChange\":%d,"
+			"\"gmTimeBaseIndicator\":%hu,"
+			"\"gmPresent\":%s,"
+			"\"gmIdentity\":\"%s\"}",
+			tsn->master_offset,
+			tsn->ingress_time,
+			(tsn->cumulativeScaledRateOffset + 0.0) / P41,
+			tsn->scaledLastGmPhaseChange,
+			tsn->gmTimeBaseIndicator,
+			tsn->gmPresent ? "true" : "false",
+			cid2str(&tsn->gmIdentity));
+		break;
+	case TLV_SNAPSHOT_NP:
+		snp = (struct snapshot_np *) mgt->data;
+		fprintf(fp, ",\"data\":{"
+			"\"fragment\":%hu,"
+			"\"lastFragment\":%hu,"
+			"\"numberPorts\":%hu}",
+			snp->fragment, snp->lastFragment, snp->numberPorts);
+		break;
+	case TLV_PORT_DATA_SET:
+		p = (struct portDS *) mgt->data;
+		if (p->portState > PS_SLAVE) {
+			p->portState = 0;
+		}
+		fprintf(fp, ",\"data\":{"
+			"\"portIdentity\":\"%s\","
+			"\"portState\":\"%s\","
+			"\"logMinDelayReqInterval\":%hhd,"
+			"\"peerMeanPathDelay\":%" PRId64 ","
+			"\"logAnnounceInterval\":%hhd,"
+			"\"announceReceiptTimeout\":%hhu,"
+			"\"logSyncInterval\":%hhd,"
+			"\"delayMechanism\":%hhu,"
+			"\"logMinPdelayReqInterval\":%hhd,"
+			"\"versionNumber\":%hhu}",
+			pid2str(&p->portIdentity), ps_str[p->portState],
+			p->logMinDelayReqInterval, p->peerMeanPathDelay >> 16,
+			p->logAnnounceInterval, p->announceReceiptTimeout,
+			p->logSyncInterval, p->delayMechanism,
+			p->logMinPdelayReqInterval, p->versionNumber);
+		break;
+	case TLV_PORT_DATA_SET_NP:
+		pnp = (struct port_ds_np *) mgt->data;
+		fprintf(fp, ",\"data\":{"
+			"\"neighborPropDelayThresh\":%u,"
+			"\"asCapable\":%d}",
+			pnp->neighborPropDelayThresh,
+			pnp->asCapable ? 1 : 0);
+		break;
+	case TLV_PORT_PROPERTIES_NP:
+		ppn = (struct port_properties_np *) mgt->data;
+		if (ppn->port_state > PS_SLAVE) {
+			ppn->port_state = 0;
+		}
+		fprintf(fp, ",\"data\":{"
+			"\"portIdentity\":\"%s\","
+			"\"portState\":\"%s\","
+			"\"timestamping\":\"%s\","
+			"\"interface\":",
+			pid2str(&ppn->portIdentity),
+			ps_str[ppn->port_state],
+			ts_str(ppn->timestamping));
+		pmc_json_str(fp, text2str(&ppn->interface));
+		fprintf(fp, "}");
+		break;
+	case TLV_PORT_STATS_NP:
+		pcp = (struct port_stats_np *) mgt->data;
+		fprintf(fp, ",\"data\":{\"portIdentity\":\"%s\",\"rx\":[",
+			pid2str(&pcp->portIdentity));
+		for (i = 0; i < MAX_MESSAGE_TYPES; i++) {
+			fprintf(fp, "%s%" PRIu64, i ? "," : "",
+				pcp->stats.rxMsgType[i]);
+		}
+		fprintf(fp, "],\"tx\":[");
+		for (i = 0; i < MAX_MESSAGE_TYPES; i++) {
+			fprintf(fp, "%s%" PRIu64, i ? "," : "",
+				pcp->stats.txMsgType[i]);
+		}
+		fprintf(fp, "]}");
+		break;
+	case TLV_LATENCY_STATS_NP:
+		lsn = (struct latency_stats_np *) mgt->data;
+		fprintf(fp, ",\"data\":{\"portIdentity\":\"%s\",\"stages\":{",
+			pid2str(&lsn->portIdentity));
+		for (i = 0; i < lsn->numberStages; i++) {
+			fprintf(fp, "%s\"%s\":{\"count\":%" PRIu64 ",\"min\":%u,"
+				"\"mean\":%u,\"p50\":%u,\"p99\":%u,\"max\":%u}",
+				i ? "," : "", latency_stage_name(i),
+				lsn->stage[i].count, lsn->stage[i].min,
+				lsn->stage[i].mean, lsn->stage[i].p50,
+				lsn->stage[i].p99, lsn->stage[i].max);
+		}
+		fprintf(fp, "}}");
+		break;
+	case TLV_PRIORITY1:
+	case TLV_PRIORITY2:
+	case TLV_DOMAIN:
+	case TLV_SLAVE_ONLY:
+	case TLV_CLOCK_ACCURACY:
+	case TLV_TRACEABILITY_PROPERTIES:
+	case TLV_TIMESCALE_PROPERTIES:
+	case TLV_SYNCHRONIZATION_UNCERTAIN_NP:
+	case TLV_ANNOUNCE_RECEIPT_TIMEOUT:
+	case TLV_VERSION_NUMBER:
+	case TLV_DELAY_MECHANISM:
+		fprintf(fp, ",\"data\":{\"value\":%hhu}", mtd->val);
+		break;
+	case TLV_LOG_ANNOUNCE_INTERVAL:
+	case TLV_LOG_SYNC_INTERVAL:
+	case TLV_LOG_MIN_PDELAY_REQ_INTERVAL:
+		fprintf(fp, ",\"data\":{\"value\":%hhd}", mtd->val);
+		break;
+	}
+}
+
+static void pmc_show_json(struct ptp_message *msg, FILE *fp)
+{
+	struct tlv_extra *extra;
+	int action;
+
+	if (msg_type(msg) != MANAGEMENT) {
+		return;
+	}
+	action = management_action(msg);
+	if (action < GET || action > ACKNOWLEDGE) {
+		return;
+	}
+	fprintf(fp, "{\"source\":\"%s\",\"seq\":%hu,\"action\":\"%s\"",
+		pid2str(&msg->header.sourcePortIdentity),
+		msg->header.sequenceId, pmc_action_string(action));
+	if (msg_tlv_count(msg) == 1) {
+		fprintf(fp, ",");
+		pmc_show_json_tlv(TAILQ_FIRST(&msg->tlv_list), fp);
+	} else if (msg_tlv_count(msg) > 1) {
+		fprintf(fp, ",\"tlvs\":[");
+		TAILQ_FOREACH(extra, &msg->tlv_list, list) {
+			if (extra != TAILQ_FIRST(&msg->tlv_list)) {
+				fprintf(fp, ",");
+			}
+			fprintf(fp, "{");
+			pmc_show_json_tlv(extra, fp);
+			fprintf(fp, "}");
+		}
+		fprintf(fp, "]");
+	}
+	fprintf(fp, "}\n");
+	fflush(fp);
+}
+
+static struct bulk_request *bulk_find(struct bulk_request *req, int n,
+				      UInteger16 sequence_id)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (req[i].sequence_id == sequence_id) {
+			return &req[i];
+		}
+	}
+	return NULL;
+}
+
+static struct bulk_clock *bulk_clock_find(struct bulk_clock **clocks,
+					  int *nclocks,
+					  struct bulk_request *req, int n,
+					  struct ClockIdentity *identity)
+{
+	struct bulk_clock *c;
+	int i;
+
+	for (i = 0; i < *nclocks; i++) {
+		if (cid_eq(&(*clocks)[i].identity, identity)) {
+			return &(*clocks)[i];
+		}
+	}
+	c = realloc(*clocks, (*nclocks + 1) * sizeof(*c));
+	if (!c) {
+		return NULL;
+	}
+	*clocks = c;
+	c = &c[*nclocks];
+	c->identity = *identity;
+	c->answers = calloc(n, sizeof(*c->answers));
+	c->expected = calloc(n, sizeof(*c->expected));
+	if (!c->answers || !c->expected) {
+		free(c->answers);
+		free(c->expected);
+		return NULL;
+	}
+	for (i = 0; i < n; i++) {
+		c->expected[i] = pmc_id_is_port(req[i].id) ? -1 : 1;
+	}
+	(*nclocks)++;
+	return c;
+}
+
+static int bulk_clock_done(struct bulk_clock *c, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (c->expected[i] < 0 || c->answers[i] < c->expected[i]) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int bulk_done(struct bulk_clock *clocks, int nclocks, int n)
+{
+	int i;
+
+	for (i = 0; i < nclocks; i++) {
+		if (!bulk_clock_done(&clocks[i], n)) {
+			return 0;
+		}
+	}
+	return nclocks > 0;
+}
+
+/*
+ * Sends GET requests for all of the given management IDs back to back
+ * and collects the responses in whatever order they arrive. Requests
+ * for port data sets are answered once per port, and the number of
+ * ports is learned from the DEFAULT_DATA_SET, which is always asked
+ * for first. The answers are counted per responding clock.
+ */
+static int run_bulk(char **names, int count, int json)
+{
+	struct bulk_clock *clocks = NULL, *c;
+	struct management_error_status *mes;
+	struct bulk_request *req, *r;
+	struct management_tlv *mgt;
+	struct pollfd pollfd;
+	struct ptp_message *msg;
+	struct snapshot_np *snp;
+	int i, id, k, n = 0, nclocks = 0, tmo;
+	struct defaultDS *dds;
+	int64_t deadline, now;
+	struct timespec ts;
+	struct TLV *tlv;
+
+	req = calloc(count + 1, sizeof(*req));
+	if (!req) {
+		return -1;
+	}
+	req[n].id = TLV_DEFAULT_DATA_SET;
+	req[n].quiet = 1;
+	n++;
+	for (i = 0; i < count; i++) {
+		id = pmc_parse_get_id(names[i]);
+		if (id < 0) {
+			fprintf(stderr, "bad management ID: %s\n", names[i]);
+			free(req);
+			return -1;
+		}
+		if (id == TLV_DEFAULT_DATA_SET) {
+			req[0].quiet = 0;
+			continue;
+		}
+		req[n].id = id;
+		n++;
+	}
+	for (i = 0; i < n; i++) {
+		req[i].sequence_id = pmc_next_sequence_id(pmc);
+		if (pmc_send_get_action(pmc, req[i].id)) {
+			free(req);
+			return -1;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	deadline = ts.tv_sec * 1000LL + ts.tv_nsec / 1000000 + BULK_TMO;
+	pollfd.fd = pmc_get_transport_fd(pmc);
+	pollfd.events = POLLIN | POLLPRI;
+
+	while (is_running() && !bulk_done(clocks, nclocks, n)) {
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		now = ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+		if (now >= deadline) {
+			break;
+		}
+		tmo = deadline - now;
+		if (poll(&pollfd, 1, tmo) <= 0) {
+			continue;
+		}
+		msg = pmc_recv(pmc);
+		if (!msg) {
+			continue;
+		}
+		if (msg_type(msg) != MANAGEMENT || !msg_tlv_count(msg) ||
+		    !(r = bulk_find(req, n, msg->header.sequenceId))) {
+			msg_put(msg);
+			continue;
+		}
+		c = bulk_clock_find(&clocks, &nclocks, req, n,
+				    &msg->header.sourcePortIdentity.clockIdentity);
+		if (!c) {
+			fprintf(stderr, "low memory\n");
+			msg_put(msg);
+			break;
+		}
+		k = r - req;
+		c->answers[k]++;
+		tlv = (struct TLV *) msg->management.suffix;
+		mgt = (struct management_tlv *) tlv;
+		if (tlv->type == TLV_MANAGEMENT && mgt->id == TLV_SNAPSHOT_NP) {
+			snp = (struct snapshot_np *) mgt->data;
+			if (!snp->lastFragment) {
+				c->expected[k]++;
+			}
+		}
+		if (tlv->type == TLV_MANAGEMENT_ERROR_STATUS) {
+			/* An error is the answer of one port, not of all. */
+			mes = (struct management_error_status *) tlv;
+			pr_debug("%s: error %hu", pmc_id_string(mes->id),
+				 mes->error);
+		} else if (r == &req[0] && tlv->type == TLV_MANAGEMENT) {
+			dds = (struct defaultDS *) mgt->data;
+			for (i = 1; i < n; i++) {
+				if (c->expected[i] < 0) {
+					c->expected[i] = dds->numberPorts;
+				}
+			}
+		}
+		if (!r->quiet) {
+			if (json) {
+				pmc_show_json(msg, stdout);
+			} else {
+				pmc_show(msg, stdout);
+			}
+		}
+		msg_put(msg);
+	}
+
+	if (!nclocks) {
+		fprintf(stderr, "no response\n");
+	}
+	for (k = 0; k < nclocks; k++) {
+		c = &clocks[k];
+		for (i = 0; i < n; i++) {
+			if (c->expected[i] < 0 || c->answers[i] < c->expected[i]) {
+				fprintf(stderr, "%s: incomplete from %s, "
+					"%d responses\n", pmc_id_string(req[i].id),
+					cid2str(&c->identity), c->answers[i]);
+			}
+		}
+	}
+	i = bulk_done(clocks, nclocks, n) ? 0 : -1;
+	for (k = 0; k < nclocks; k++) {
+		free(clocks[k].answers);
+		free(clocks[k].expected);
+	}
+	free(clocks);
+	free(req);
+	return i;
+}
+
 static void usage(char *progname)
 {
 	fprintf(stderr,
@@ -533,12 +1135,14 @@ static void usage(char *progname)
 		" -6        UDP IPV6\n"
 		" -u        UDS local\n\n"
 		" Other Options\n\n"
+		" -B        bulk mode, GET all of the given management IDs at once\n"
 		" -b [num]  boundary hops, default 1\n"
 		" -d [num]  domain number, default 0\n"
 		" -f [file] read configuration from 'file'\n"
 		" -h        prints this message and exits\n"
 		" -i [dev]  interface device to use, default 'eth0'\n"
 		"           for network and '/var/run/pmc.$pid' for UDS.\n"
+		" -j        print responses as JSON, one per line\n"
 		" -s [path] server address for UDS, default '/var/run/ptp4l'.\n"
 		" -t [hex]  transport specific field, default 0x0\n"
 		" -v        prints the software version and exits\n"
@@ -552,7 +1156,7 @@ int main(int argc, char *argv[])
 	const char *iface_name = NULL;
 	char *config = NULL, *progname;
 	int c, cnt, index, length, tmo = -1, batch_mode = 0, zero_datalen = 0;
-	int ret = 0;
+	int bulk_mode = 0, json = 0, ret = 0;
 	char line[1024], *command = NULL, uds_local[MAX_IFNAME_SIZE + 1];
 	enum transport_type transport_type = TRANS_UDP_IPV4;
 	UInteger8 boundary_hops = 1, domain_number = 0, transport_specific = 0;
@@ -574,7 +1178,7 @@ int main(int argc, char *argv[])
 	/* Process the command line arguments. */
 	progname = strrchr(argv[0], '/');
 	progname = progname ? 1+progname : argv[0];
-	while (EOF != (c = getopt_long(argc, argv, "246u""b:d:f:hi:s:t:vz",
+	while (EOF != (c = getopt_long(argc, argv, "246u""Bb:d:f:hi:js:t:vz",
 				       opts, &index))) {
 		switch (c) {
 		case 0:
@@ -607,6 +1211,9 @@ int main(int argc, char *argv[])
 				goto out;
 			}
 			break;
+		case 'B':
+			bulk_mode = 1;
+			break;
 		case 'b':
 			boundary_hops = atoi(optarg);
 			break;
@@ -622,6 +1229,9 @@ int main(int argc, char *argv[])
 		case 'i':
 			iface_name = optarg;
 			break;
+		case 'j':
+			json = 1;
+			break;
 		case 's':
 			if (strlen(optarg) > MAX_IFNAME_SIZE) {
 				fprintf(stderr, "path %s too long, max is %d\n",
@@ -695,6 +1305,11 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
+	if (bulk_mode) {
+		ret = run_bulk(&argv[optind], argc - optind, json);
+		goto done;
+	}
+
 	pollfd[0].fd = batch_mode ? -1 : STDIN_FILENO;
 	pollfd[1].fd = pmc_get_transport_fd(pmc);
 
@@ -759,12 +1374,16 @@ int main(int argc, char *argv[])
 		if (pollfd[1].revents & (POLLIN|POLLPRI)) {
 			msg = pmc_recv(pmc);
 			if (msg) {
-				pmc_show(msg, stdout);
+				if (json) {
+					pmc_show_json(msg, stdout);
+				} else {
+					pmc_show(msg, stdout);
+				}
 				msg_put(msg);
 			}
 		}
 	}
-
+done:
 	pmc_destroy(pmc);
 	msg_cleanup();
 
@@ -69,6 +69,7 @@ static void do_get_action(struct pmc *pmc, int action, int index, char *str);
 static void do_set_action(struct pmc *pmc, int action, int index, char *str);
 static void not_supported(struct pmc *pmc, int action, int index, char *str);
 static void null_management(struct pmc *pmc, int action, int index, char *str);
+static void do_command_action(struct pmc *pmc, int action, int index, char *str);
 
 static const char *action_string[] = {
 	"GET",
@@ -120,6 +121,8 @@ struct management_id idtab[] = {
 	{ "GRANDMASTER_SETTINGS_NP", TLV_GRANDMASTER_SETTINGS_NP, do_set_action },
 	{ "SUBSCRIBE_EVENTS_NP", TLV_SUBSCRIBE_EVENTS_NP, do_set_action },
 	{ "SYNCHRONIZATION_UNCERTAIN_NP", TLV_SYNCHRONIZATION_UNCERTAIN_NP, do_set_action },
+	{ "SNAPSHOT_NP", TLV_SNAPSHOT_NP, do_get_action },
+	{ "RELOAD_CONFIG_NP", TLV_RELOAD_CONFIG_NP, do_command_action },
 /* Port management ID values */
 	{ "NULL_MANAGEMENT", TLV_NULL_MANAGEMENT, null_management },
 	{ "CLOCK_DESCRIPTION", TLV_CLOCK_DESCRIPTION, do_get_action },
@@ -140,6 +143,7 @@ struct management_id idtab[] = {
 	{ "LOG_MIN_PDELAY_REQ_INTERVAL", TLV_LOG_MIN_PDELAY_REQ_INTERVAL, do_get_action },
 	{ "PORT_DATA_SET_NP", TLV_PORT_DATA_SET_NP, do_set_action },
 	{ "PORT_STATS_NP", TLV_PORT_STATS_NP, do_get_action },
+	{ "LATENCY_STATS_NP", TLV_LATENCY_STATS_NP, do_get_action },
 	{ "PORT_PROPERTIES_NP", TLV_PORT_PROPERTIES_NP, do_get_action },
 };
 
@@ -296,6 +300,15 @@ static void null_management(struct pmc *pmc, int action, int index, char *str)
 		puts("non-get actions still todo");
 }
 
+static void do_command_action(struct pmc *pmc, int action, int index,
+			      char *str)
+{
+	if (action == COMMAND)
+		pmc_send_command_action(pmc, idtab[index].code);
+	else
+		fprintf(stderr, "%s only allows COMMAND\n", idtab[index].name);
+}
+
 static int parse_action(char *s)
 {
 	int len = strlen(s);
@@ -521,6 +534,9 @@ static int pmc_tlv_datalen(struct pmc *pmc, int id)
 	case TLV_GRANDMASTER_SETTINGS_NP:
 		len += sizeof(struct grandmaster_settings_np);
 		break;
+	case TLV_SNAPSHOT_NP:
+		len += sizeof(struct snapshot_np);
+		break;
 	case TLV_NULL_MANAGEMENT:
 		break;
 	case TLV_CLOCK_DESCRIPTION:
@@ -625,6 +641,31 @@ int pmc_send_set_action(struct pmc *pmc, int id, void *data, int datasize)
 	return 0;
 }
 
+int pmc_send_command_action(struct pmc *pmc, int id)
+{
+	struct management_tlv *mgt;
+	struct ptp_message *msg;
+	struct tlv_extra *extra;
+
+	msg = pmc_message(pmc, COMMAND);
+	if (!msg) {
+		return -1;
+	}
+	extra = msg_tlv_append(msg, sizeof(*mgt));
+	if (!extra) {
+		msg_put(msg);
+		return -ENOMEM;
+	}
+	mgt = (struct management_tlv *) extra->tlv;
+	mgt->type = TLV_MANAGEMENT;
+	mgt->length = 2;
+	mgt->id = id;
+	pmc_send(pmc, msg);
+	msg_put(msg);
+
+	return 0;
+}
+
 struct ptp_message *pmc_recv(struct pmc *pmc)
 {
 	struct ptp_message *msg;
@@ -686,6 +727,62 @@ const char *pmc_action_string(int action)
 	return action_string[action];
 }
 
+UInteger16 pmc_next_sequence_id(struct pmc *pmc)
+{
+	return pmc->sequence_id;
+}
+
+int pmc_parse_get_id(char *str)
+{
+	int index = parse_id(str);
+
+	if (index < 0 || idtab[index].func == not_supported)
+		return -1;
+
+	return idtab[index].code;
+}
+
+const char *pmc_id_string(int id)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(idtab); i++) {
+		if (idtab[i].code == id)
+			return idtab[i].name;
+	}
+	return "unknown";
+}
+
+int pmc_id_is_port(int id)
+{
+	/* These are answered once by every port of a clock. */
+	switch (id) {
+	case TLV_NULL_MANAGEMENT:
+	case TLV_CLOCK_DESCRIPTION:
+	case TLV_PORT_DATA_SET:
+	case TLV_LOG_ANNOUNCE_INTERVAL:
+	case TLV_ANNOUNCE_RECEIPT_TIMEOUT:
+	case TLV_LOG_SYNC_INTERVAL:
+	case TLV_VERSION_NUMBER:
+	case TLV_ENABLE_PORT:
+	case TLV_DISABLE_PORT:
+	case TLV_UNICAST_NEGOTIATION_ENABLE:
+	case TLV_UNICAST_MASTER_TABLE:
+	case TLV_UNICAST_MASTER_MAX_TABLE_SIZE:
+	case TLV_ACCEPTABLE_MASTER_TABLE_ENABLED:
+	case TLV_ALTERNATE_MASTER:
+	case TLV_TRANSPARENT_CLOCK_PORT_DATA_SET:
+	case TLV_DELAY_MECHANISM:
+	case TLV_LOG_MIN_PDELAY_REQ_INTERVAL:
+	case TLV_PORT_DATA_SET_NP:
+	case TLV_PORT_STATS_NP:
+	case TLV_LATENCY_STATS_NP:
+	case TLV_PORT_PROPERTIES_NP:
+		return 1;
+	}
+	return 0;
+}
+
 int pmc_do_command(struct pmc *pmc, char *str)
 {
 	int action, id;
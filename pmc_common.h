@@ -41,6 +41,8 @@ int pmc_send_get_action(struct pmc *pmc, int id);
 
 int pmc_send_set_action(struct pmc *pmc, int id, void *data, int datasize);
 
+int pmc_send_command_action(struct pmc *pmc, int id);
+
 struct ptp_message *pmc_recv(struct pmc *pmc);
 
 int pmc_target(struct pmc *pmc, struct PortIdentity *pid);
@@ -50,6 +52,11 @@ void pmc_target_all(struct pmc *pmc);
 const char *pmc_action_string(int action);
 int pmc_do_command(struct pmc *pmc, char *str);
 
+UInteger16 pmc_next_sequence_id(struct pmc *pmc);
+int pmc_parse_get_id(char *str);
+const char *pmc_id_string(int id);
+int pmc_id_is_port(int id);
+
 struct pmc_node;
 
 typedef int pmc_node_recv_subscribed_t(struct pmc_node *node,
@@ -35,14 +35,15 @@
 #include "port.h"
 #include "port_private.h"
 #include "print.h"
-#include "rtnl.h"
 #include "sk.h"
 #include "tc.h"
 #include "tlv.h"
 #include "tmv.h"
 #include "tsproc.h"
+#include "tsrec.h"
 #include "unicast_client.h"
 #include "unicast_service.h"
+#include "unicast_worker.h"
 #include "util.h"
 
 #define ALLOWED_LOST_RESPONSES 3
@@ -184,59 +185,40 @@ void fault_interval(struct port *port, enum fault_type ft,
 	i->val = port->flt_interval_pertype[ft].val;
 }
 
-int port_fault_fd(struct port *port)
+struct fdarray *port_fda(struct port *port)
 {
-	return port->fault_fd;
+	return &port->fda;
 }
 
-struct fdarray *port_fda(struct port *port)
+void port_flush(struct port *port)
 {
-	return &port->fda;
+	transport_flush(port->trp);
 }
 
-int set_tmo_log(int fd, unsigned int scale, int log_seconds)
+int set_tmo_log(struct tmo *t, unsigned int scale, int log_seconds)
 {
-	struct itimerspec tmo = {
-		{0, 0}, {0, 0}
-	};
-	uint64_t ns;
+	int64_t ns;
 	int i;
 
 	if (log_seconds < 0) {
-
 		log_seconds *= -1;
 		for (i = 1, ns = scale * 500000000ULL; i < log_seconds; i++) {
 			ns >>= 1;
 		}
-		tmo.it_value.tv_nsec = ns;
-
-		while (tmo.it_value.tv_nsec >= NS_PER_SEC) {
-			tmo.it_value.tv_nsec -= NS_PER_SEC;
-			tmo.it_value.tv_sec++;
-		}
-
 	} else
-		tmo.it_value.tv_sec = scale * (1 << log_seconds);
+		ns = scale * (1LL << log_seconds) * NS_PER_SEC;
 
-	return timerfd_settime(fd, 0, &tmo, NULL);
+	return tmo_arm(t, ns);
 }
 
-int set_tmo_lin(int fd, int seconds)
+int set_tmo_lin(struct tmo *t, int seconds)
 {
-	struct itimerspec tmo = {
-		{0, 0}, {0, 0}
-	};
-
-	tmo.it_value.tv_sec = seconds;
-	return timerfd_settime(fd, 0, &tmo, NULL);
+	return tmo_arm(t, seconds * NS_PER_SEC);
 }
 
-int set_tmo_random(int fd, int min, int span, int log_seconds)
+int set_tmo_random(struct tmo *t, int min, int span, int log_seconds)
 {
 	uint64_t value_ns, min_ns, span_ns;
-	struct itimerspec tmo = {
-		{0, 0}, {0, 0}
-	};
 
 	if (log_seconds >= 0) {
 		min_ns = min * NS_PER_SEC << log_seconds;
@@ -248,21 +230,18 @@ int set_tmo_random(int fd, int min, int span, int log_seconds)
 
 	value_ns = min_ns + (span_ns * (random() % (1 << 15) + 1) >> 15);
 
-	tmo.it_value.tv_sec = value_ns / NS_PER_SEC;
-	tmo.it_value.tv_nsec = value_ns % NS_PER_SEC;
-
-	return timerfd_settime(fd, 0, &tmo, NULL);
+	return tmo_arm(t, value_ns);
 }
 
 int port_set_fault_timer_log(struct port *port,
 			     unsigned int scale, int log_seconds)
 {
-	return set_tmo_log(port->fault_fd, scale, log_seconds);
+	return set_tmo_log(&port->fault_timer, scale, log_seconds);
 }
 
 int port_set_fault_timer_lin(struct port *port, int seconds)
 {
-	return set_tmo_lin(port->fault_fd, seconds);
+	return set_tmo_lin(&port->fault_timer, seconds);
 }
 
 void fc_clear(struct foreign_clock *fc)
@@ -277,17 +256,25 @@ void fc_clear(struct foreign_clock *fc)
 	}
 }
 
+/*
+ * A foreign master qualifies with its first Announce message under
+ * 802.1AS, and when it is the parent saved before a restart.
+ */
+static int fc_threshold(struct foreign_clock *fc)
+{
+	if (port_is_ieee8021as(fc->port) || fc->warm)
+		return 1;
+	return FOREIGN_MASTER_THRESHOLD;
+}
+
 static void fc_prune(struct foreign_clock *fc)
 {
-	int threshold = FOREIGN_MASTER_THRESHOLD;
+	int threshold = fc_threshold(fc);
 	struct timespec now;
 	struct ptp_message *m;
 
 	clock_gettime(CLOCK_MONOTONIC, &now);
 
-	if (port_is_ieee8021as(fc->port))
-		threshold = 1;
-
 	while (fc->n_messages > threshold) {
 		m = TAILQ_LAST(&fc->messages, messages);
 		TAILQ_REMOVE(&fc->messages, m, list);
@@ -344,7 +331,6 @@ void ts_add(tmv_t *ts, Integer64 correction)
  */
 static int add_foreign_master(struct port *p, struct ptp_message *m)
 {
-	int threshold = FOREIGN_MASTER_THRESHOLD;
 	struct foreign_clock *fc;
 	struct ptp_message *tmp;
 	int broke_threshold = 0, diff = 0;
@@ -368,8 +354,9 @@ static int add_foreign_master(struct port *p, struct ptp_message *m)
 		LIST_INSERT_HEAD(&p->foreign_masters, fc, list);
 		fc->port = p;
 		fc->dataset.sender = m->header.sourcePortIdentity;
+		fc->warm = clock_warm_parent(p->clock, &fc->dataset.sender);
 		/* For 1588, we do not count this first message, see 9.5.3(b) */
-		if (!port_is_ieee8021as(fc->port))
+		if (fc_threshold(fc) > 1)
 			return 0;
 	}
 
@@ -378,10 +365,7 @@ static int add_foreign_master(struct port *p, struct ptp_message *m)
 	 */
 	fc_prune(fc);
 
-	if (port_is_ieee8021as(fc->port))
-		threshold = 1;
-
-	if (threshold - 1 == fc->n_messages) {
+	if (fc_threshold(fc) - 1 == fc->n_messages) {
 		broke_threshold = 1;
 	}
 
@@ -391,6 +375,8 @@ static int add_foreign_master(struct port *p, struct ptp_message *m)
 	msg_get(m);
 	fc->n_messages++;
 	TAILQ_INSERT_HEAD(&fc->messages, m, list);
+	if (fc->n_messages >= FOREIGN_MASTER_THRESHOLD)
+		fc->warm = 0;
 
 	/*
 	 * Test if this announcement contains changed information.
@@ -690,12 +676,10 @@ not_capable:
 	return 0;
 }
 
-int port_clr_tmo(int fd)
+int port_clr_tmo(struct tmo *t)
 {
-	struct itimerspec tmo = {
-		{0, 0}, {0, 0}
-	};
-	return timerfd_settime(fd, 0, &tmo, NULL);
+	tmo_clear(t);
+	return 0;
 }
 
 static int port_ignore(struct port *p, struct ptp_message *m)
@@ -792,6 +776,51 @@ static void port_management_send_error(struct port *p, struct port *ingress,
 static const Octet profile_id_drr[] = {0x00, 0x1B, 0x19, 0x00, 0x01, 0x00};
 static const Octet profile_id_p2p[] = {0x00, 0x1B, 0x19, 0x00, 0x02, 0x00};
 
+static void port_latency_fill(struct port *p, struct latency_stage_np *out)
+{
+	const struct latency_hist *h;
+	int i;
+
+	for (i = 0; i < N_LATENCY_STAGES; i++) {
+		/* The poll loop belongs to the clock. */
+		h = i == LATENCY_POLL ?
+			&clock_latency(p->clock)->hist[i] : &p->latency.hist[i];
+		memset(&out[i], 0, sizeof(out[i]));
+		out[i].count = h->count;
+		if (!h->count) {
+			continue;
+		}
+		out[i].min = h->min;
+		out[i].mean = h->sum / h->count;
+		out[i].p50 = latency_percentile(h, 50.0);
+		out[i].p99 = latency_percentile(h, 99.0);
+		out[i].max = h->max;
+	}
+}
+
+void port_latency_display(struct port *p)
+{
+	const struct latency_hist *h;
+	char buf[256];
+	int i, len = 0;
+
+	for (i = 0; i < LATENCY_POLL; i++) {
+		h = &p->latency.hist[i];
+		if (!h->count) {
+			continue;
+		}
+		len += snprintf(buf + len, sizeof(buf) - len, " %s %u/%u/%u",
+				latency_stage_name(i), latency_percentile(h, 50.0),
+				latency_percentile(h, 99.0), h->max);
+		if (len >= sizeof(buf)) {
+			break;
+		}
+	}
+	if (len) {
+		pr_info("port %hu: latency p50/p99/max ns%s", portnum(p), buf);
+	}
+}
+
 static int port_management_fill_response(struct port *target,
 					 struct ptp_message *rsp, int id)
 {
@@ -799,7 +828,9 @@ static int port_management_fill_response(struct port *target,
 	struct management_tlv_datum *mtd;
 	struct clock_description *desc;
 	struct port_properties_np *ppn;
+	struct latency_stats_np *lsn;
 	struct port_stats_np *psn;
+	struct PortStats stats;
 	struct management_tlv *tlv;
 	struct port_ds_np *pdsnp;
 	struct tlv_extra *extra;
@@ -814,9 +845,11 @@ static int port_management_fill_response(struct port *target,
 		pr_err("failed to allocate TLV descriptor");
 		return 0;
 	}
-	extra->tlv = (struct TLV *) rsp->management.suffix;
+	/* Append the TLV, as the response may already carry others. */
+	extra->tlv = (struct TLV *) (rsp->data.buffer +
+				     rsp->header.messageLength);
 
-	tlv = (struct management_tlv *) rsp->management.suffix;
+	tlv = (struct management_tlv *) extra->tlv;
 	tlv->type = TLV_MANAGEMENT;
 	tlv->id = id;
 
@@ -960,9 +993,19 @@ static int port_management_fill_response(struct port *target,
 	case TLV_PORT_STATS_NP:
 		psn = (struct port_stats_np *)tlv->data;
 		psn->portIdentity = target->portIdentity;
-		psn->stats = target->stats;
+		stats = target->stats;
+		unicast_worker_stats(target, &stats);
+		psn->stats = stats;
 		datalen = sizeof(*psn);
 		break;
+	case TLV_LATENCY_STATS_NP:
+		lsn = (struct latency_stats_np *)tlv->data;
+		lsn->portIdentity = target->portIdentity;
+		lsn->numberStages = N_LATENCY_STAGES;
+		lsn->reserved = 0;
+		port_latency_fill(target, lsn->stage);
+		datalen = sizeof(*lsn) + N_LATENCY_STAGES * sizeof(lsn->stage[0]);
+		break;
 	default:
 		/* The caller should *not* respond to this message. */
 		tlv_extra_recycle(extra);
@@ -981,6 +1024,12 @@ static int port_management_fill_response(struct port *target,
 	return 1;
 }
 
+int port_management_append(struct port *target, struct ptp_message *rsp,
+			   int id)
+{
+	return port_management_fill_response(target, rsp, id);
+}
+
 static int port_management_get_response(struct port *target,
 					struct port *ingress, int id,
 					struct ptp_message *req)
@@ -1090,7 +1139,7 @@ static void port_nrate_initialize(struct port *p)
 
 int port_set_announce_tmo(struct port *p)
 {
-	return set_tmo_random(p->fda.fd[FD_ANNOUNCE_TIMER],
+	return set_tmo_random(port_timer(p, FD_ANNOUNCE_TIMER),
 			      p->announceReceiptTimeout,
 			      p->announce_span, p->logAnnounceInterval);
 }
@@ -1102,34 +1151,34 @@ int port_set_delay_tmo(struct port *p)
 	}
 
 	if (p->delayMechanism == DM_P2P) {
-		return set_tmo_log(p->fda.fd[FD_DELAY_TIMER], 1,
+		return set_tmo_log(port_timer(p, FD_DELAY_TIMER), 1,
 			       p->logPdelayReqInterval);
 	} else {
-		return set_tmo_random(p->fda.fd[FD_DELAY_TIMER], 0, 2,
+		return set_tmo_random(port_timer(p, FD_DELAY_TIMER), 0, 2,
 				p->logMinDelayReqInterval);
 	}
 }
 
 static int port_set_manno_tmo(struct port *p)
 {
-	return set_tmo_log(p->fda.fd[FD_MANNO_TIMER], 1, p->logAnnounceInterval);
+	return set_tmo_log(port_timer(p, FD_MANNO_TIMER), 1, p->logAnnounceInterval);
 }
 
 int port_set_qualification_tmo(struct port *p)
 {
-	return set_tmo_log(p->fda.fd[FD_QUALIFICATION_TIMER],
+	return set_tmo_log(port_timer(p, FD_QUALIFICATION_TIMER),
 		       1+clock_steps_removed(p->clock), p->logAnnounceInterval);
 }
 
 static int port_set_sync_rx_tmo(struct port *p)
 {
-	return set_tmo_log(p->fda.fd[FD_SYNC_RX_TIMER],
+	return set_tmo_log(port_timer(p, FD_SYNC_RX_TIMER),
 			   p->syncReceiptTimeout, p->logSyncInterval);
 }
 
 static int port_set_sync_tx_tmo(struct port *p)
 {
-	return set_tmo_log(p->fda.fd[FD_SYNC_TX_TIMER], 1, p->logSyncInterval);
+	return set_tmo_log(port_timer(p, FD_SYNC_TX_TIMER), 1, p->logSyncInterval);
 }
 
 void port_show_transition(struct port *p, enum port_state next,
@@ -1162,7 +1211,8 @@ static void message_interval_request(struct port *p,
 	if (last_state == SERVO_LOCKED) {
 		p->logPdelayReqInterval = p->operLogPdelayReqInterval;
 		p->logSyncInterval = p->operLogSyncInterval;
-		port_tx_interval_request(p, SIGNAL_NO_CHANGE,
+		port_tx_interval_request(p, &wildcard_pid,
+					 SIGNAL_NO_CHANGE,
 					 p->logSyncInterval,
 					 SIGNAL_NO_CHANGE);
 		port_dispatch(p, EV_MASTER_CLOCK_SELECTED, 0);
@@ -1176,6 +1226,98 @@ static void message_interval_request(struct port *p,
 	}
 }
 
+/*
+ * Fast acquisition asks the master for the fast message rates while the
+ * servo is unlocked or far off, and for the operational rates after it
+ * locks. With multicast, the Sync rate is requested in a message interval
+ * request TLV, while the Delay_Req rate remains the one announced by the
+ * master in its Delay_Resp messages. With unicast, both grants are
+ * renegotiated.
+ */
+static void port_acquisition_set(struct port *p, int acquiring)
+{
+	Integer8 delay, sync;
+
+	p->acquiring = acquiring;
+	if (acquiring) {
+		/* Ask only the parent, not every master on the segment. */
+		p->acquisition_parent = clock_parent_identity(p->clock);
+		sync = p->settings.fastLogSyncInterval;
+		delay = p->settings.fastLogMinDelayReqInterval;
+		p->logPdelayReqInterval = p->logMinPdelayReqInterval;
+	} else {
+		sync = p->operLogSyncInterval;
+		delay = p->settings.logMinDelayReqInterval;
+		p->logPdelayReqInterval = p->operLogPdelayReqInterval;
+	}
+	pr_info("port %hu: %s fast acquisition, sync interval 2^%d",
+		portnum(p), acquiring ? "start" : "end", sync);
+
+	p->logSyncInterval = sync;
+	if (unicast_client_enabled(p)) {
+		p->logMinDelayReqInterval = delay;
+		unicast_client_renegotiate(p);
+		return;
+	}
+	if (p->hybrid_e2e) {
+		/* Unicast Delay_Resp carry no interval, the rate is ours. */
+		p->logMinDelayReqInterval = delay;
+	}
+	port_tx_interval_request(p, &p->acquisition_parent,
+				 SIGNAL_NO_CHANGE, sync, SIGNAL_NO_CHANGE);
+}
+
+static void port_acquisition_reset(struct port *p, enum port_state next)
+{
+	if (!p->acquiring) {
+		return;
+	}
+	/*
+	 * With multicast, the master keeps the fast rate for all of its
+	 * slaves until asked otherwise. Unicast grants end by themselves.
+	 */
+	if (!unicast_client_enabled(p) && port_is_enabled(p) &&
+	    next != PS_FAULTY && next != PS_DISABLED) {
+		port_tx_interval_request(p, &p->acquisition_parent,
+					 SIGNAL_NO_CHANGE, SIGNAL_SET_INITIAL,
+					 SIGNAL_NO_CHANGE);
+	}
+	p->acquiring = 0;
+	p->logSyncInterval = p->initialLogSyncInterval;
+	p->logMinDelayReqInterval = p->settings.logMinDelayReqInterval;
+	p->logPdelayReqInterval = p->logMinPdelayReqInterval;
+}
+
+static void port_acquisition_update(struct port *p, enum servo_state state)
+{
+	int64_t offset, threshold = p->settings.fast_acquisition_threshold;
+	int acquiring = p->acquiring;
+
+	offset = clock_current_dataset(p->clock)->offsetFromMaster >> 16;
+	if (offset < 0) {
+		offset = -offset;
+	}
+
+	switch (state) {
+	case SERVO_UNLOCKED:
+	case SERVO_JUMP:
+		acquiring = 1;
+		break;
+	case SERVO_LOCKED:
+	case SERVO_LOCKED_STABLE:
+		/* Leave at half the threshold, to avoid flapping. */
+		if (!threshold || offset <= threshold / 2) {
+			acquiring = 0;
+		} else if (offset > threshold) {
+			acquiring = 1;
+		}
+		break;
+	}
+	if (acquiring != p->acquiring) {
+		port_acquisition_set(p, acquiring);
+	}
+}
+
 static void port_synchronize(struct port *p,
 			     uint16_t seqid,
 			     tmv_t ingress_ts,
@@ -1205,16 +1347,22 @@ static void port_synchronize(struct port *p,
 		break;
 	}
 
+	tsrec_write(TSREC_SYNC, clock_clkid(p->clock), tmv_to_nanoseconds(t1),
+		    tmv_to_nanoseconds(t2), tmv_to_nanoseconds(tmv_add(c1, c2)),
+		    0.0);
+
 	last_state = clock_servo_state(p->clock);
 	state = clock_synchronize(p->clock, t2, t1c);
 	switch (state) {
 	case SERVO_UNLOCKED:
 		port_dispatch(p, EV_SYNCHRONIZATION_FAULT, 0);
-		if (servo_offset_threshold(clock_servo(p->clock)) != 0 &&
+		if (!p->settings.fast_acquisition &&
+		    servo_offset_threshold(clock_servo(p->clock)) != 0 &&
 		    sync_interval != p->initialLogSyncInterval) {
 			p->logPdelayReqInterval = p->logMinPdelayReqInterval;
 			p->logSyncInterval = p->initialLogSyncInterval;
-			port_tx_interval_request(p, SIGNAL_NO_CHANGE,
+			port_tx_interval_request(p, &wildcard_pid,
+						 SIGNAL_NO_CHANGE,
 						 SIGNAL_SET_INITIAL,
 						 SIGNAL_NO_CHANGE);
 		}
@@ -1231,9 +1379,15 @@ static void port_synchronize(struct port *p,
 		port_dispatch(p, EV_MASTER_CLOCK_SELECTED, 0);
 		break;
 	case SERVO_LOCKED_STABLE:
-		message_interval_request(p, last_state, sync_interval);
+		if (!p->settings.fast_acquisition) {
+			message_interval_request(p, last_state, sync_interval);
+		}
 		break;
 	}
+
+	if (p->settings.fast_acquisition) {
+		port_acquisition_update(p, state);
+	}
 }
 
 static void port_syfufsm_print_mismatch(struct port *p, enum syfu_event event,
@@ -1763,77 +1917,65 @@ void port_disable(struct port *p)
 	flush_last_sync(p);
 	flush_delay_req(p);
 	flush_peer_delay(p);
+	port_standby_flush(p);
 
 	p->best = NULL;
 	free_foreign_masters(p);
+	unicast_worker_stop(p);
 	transport_close(p->trp, &p->fda);
 
 	for (i = 0; i < N_TIMER_FDS; i++) {
-		close(p->fda.fd[FD_FIRST_TIMER + i]);
+		tmo_clear(&p->timers[i]);
 	}
 
-	/* Keep rtnl socket to get link status info. */
-	port_clear_fda(p, FD_RTNL);
 	clock_fda_changed(p->clock);
 }
 
 int port_initialize(struct port *p)
 {
-	struct config *cfg = clock_config(p->clock);
-	int fd[N_TIMER_FDS], i;
+	int i;
 
 	p->multiple_seq_pdr_count  = 0;
 	p->multiple_pdr_detected   = 0;
 	p->last_fault_type         = FT_UNSPECIFIED;
-	p->logMinDelayReqInterval  = config_get_int(cfg, p->name, "logMinDelayReqInterval");
+	p->logMinDelayReqInterval  = p->settings.logMinDelayReqInterval;
 	p->peerMeanPathDelay       = 0;
-	p->initialLogAnnounceInterval = config_get_int(cfg, p->name, "logAnnounceInterval");
+	p->initialLogAnnounceInterval = p->settings.logAnnounceInterval;
 	p->logAnnounceInterval     = p->initialLogAnnounceInterval;
-	p->inhibit_announce        = config_get_int(cfg, p->name, "inhibit_announce");
-	p->ignore_source_id        = config_get_int(cfg, p->name, "ignore_source_id");
-	p->announceReceiptTimeout  = config_get_int(cfg, p->name, "announceReceiptTimeout");
-	p->syncReceiptTimeout      = config_get_int(cfg, p->name, "syncReceiptTimeout");
-	p->transportSpecific       = config_get_int(cfg, p->name, "transportSpecific");
+	p->inhibit_announce        = p->settings.inhibit_announce;
+	p->ignore_source_id        = p->settings.ignore_source_id;
+	p->announceReceiptTimeout  = p->settings.announceReceiptTimeout;
+	p->syncReceiptTimeout      = p->settings.syncReceiptTimeout;
+	p->transportSpecific       = p->settings.transportSpecific;
 	p->transportSpecific     <<= 4;
-	p->match_transport_specific = !config_get_int(cfg, p->name, "ignore_transport_specific");
-	p->localPriority           = config_get_int(cfg, p->name, "G.8275.portDS.localPriority");
-	p->initialLogSyncInterval  = config_get_int(cfg, p->name, "logSyncInterval");
+	p->match_transport_specific = !p->settings.ignore_transport_specific;
+	p->localPriority           = p->settings.G_8275_portDS_localPriority;
+	p->initialLogSyncInterval  = p->settings.logSyncInterval;
 	p->logSyncInterval         = p->initialLogSyncInterval;
-	p->operLogSyncInterval     = config_get_int(cfg, p->name, "operLogSyncInterval");
-	p->logMinPdelayReqInterval = config_get_int(cfg, p->name, "logMinPdelayReqInterval");
+	p->operLogSyncInterval     = p->settings.operLogSyncInterval;
+	p->logMinPdelayReqInterval = p->settings.logMinPdelayReqInterval;
 	p->logPdelayReqInterval    = p->logMinPdelayReqInterval;
-	p->operLogPdelayReqInterval = config_get_int(cfg, p->name, "operLogPdelayReqInterval");
-	p->neighborPropDelayThresh = config_get_int(cfg, p->name, "neighborPropDelayThresh");
-	p->min_neighbor_prop_delay = config_get_int(cfg, p->name, "min_neighbor_prop_delay");
+	p->operLogPdelayReqInterval = p->settings.operLogPdelayReqInterval;
+	p->neighborPropDelayThresh = p->settings.neighborPropDelayThresh;
+	p->min_neighbor_prop_delay = p->settings.min_neighbor_prop_delay;
+	p->acquiring               = 0;
 
-	if (config_get_int(cfg, p->name, "asCapable") == AS_CAPABLE_TRUE) {
+	if (p->settings.asCapable == AS_CAPABLE_TRUE) {
 		p->asCapable = ALWAYS_CAPABLE;
 	} else {
 		p->asCapable = NOT_CAPABLE;
 	}
 
-	p->inhibit_delay_req = config_get_int(cfg, p->name, "inhibit_delay_req");
+	p->inhibit_delay_req = p->settings.inhibit_delay_req;
 	if (p->inhibit_delay_req && p->asCapable != ALWAYS_CAPABLE) {
 		pr_err("inhibit_delay_req can only be set when asCapable == 'true'.");
 		return -1;
 	}
 
-	for (i = 0; i < N_TIMER_FDS; i++) {
-		fd[i] = -1;
-	}
-	for (i = 0; i < N_TIMER_FDS; i++) {
-		fd[i] = timerfd_create(CLOCK_MONOTONIC, 0);
-		if (fd[i] < 0) {
-			pr_err("timerfd_create: %s", strerror(errno));
-			goto no_timers;
-		}
-	}
 	if (transport_open(p->trp, p->iface, &p->fda, p->timestamping))
-		goto no_tropen;
+		return -1;
 
-	for (i = 0; i < N_TIMER_FDS; i++) {
-		p->fda.fd[FD_FIRST_TIMER + i] = fd[i];
-	}
+	unicast_worker_start(p);
 
 	if (port_set_announce_tmo(p)) {
 		goto no_tmo;
@@ -1842,7 +1984,7 @@ int port_initialize(struct port *p)
 		goto no_tmo;
 	}
 
-	/* No need to open rtnl socket on UDS port. */
+	/* No need to query the link status of the UDS port. */
 	if (transport_type(p->trp) != TRANS_UDS) {
 		/*
 		 * The delay timer is usually started when the device
@@ -1852,12 +1994,9 @@ int port_initialize(struct port *p)
 		if (p->bmca == BMCA_NOOP) {
 			port_set_delay_tmo(p);
 		}
-		if (p->fda.fd[FD_RTNL] == -1) {
-			p->fda.fd[FD_RTNL] = rtnl_open();
-		}
-		if (p->fda.fd[FD_RTNL] >= 0) {
-			const char *ifname = interface_name(p->iface);
-			rtnl_link_query(p->fda.fd[FD_RTNL], ifname);
+		/* A simulated port has no link to watch. */
+		if (transport_type(p->trp) != TRANS_SIM) {
+			clock_link_query(p->clock, p, interface_name(p->iface));
 		}
 	}
 
@@ -1867,16 +2006,112 @@ int port_initialize(struct port *p)
 	return 0;
 
 no_tmo:
-	transport_close(p->trp, &p->fda);
-no_tropen:
-no_timers:
 	for (i = 0; i < N_TIMER_FDS; i++) {
-		if (fd[i] >= 0)
-			close(fd[i]);
+		tmo_clear(&p->timers[i]);
 	}
+	unicast_worker_stop(p);
+	transport_close(p->trp, &p->fda);
 	return -1;
 }
 
+void port_reload(struct port *p, int reopen)
+{
+	struct config *cfg = clock_config(p->clock);
+	struct config_port old = p->settings;
+	struct tsproc *tsproc;
+	int master;
+
+	config_resolve_port(cfg, p->name, &p->settings);
+	master = p->state == PS_MASTER || p->state == PS_GRAND_MASTER;
+
+	/*
+	 * The message intervals may have been changed at run time, by
+	 * the peer or after locking. Only follow the new configuration
+	 * if the port still uses the configured interval.
+	 */
+	if (old.logAnnounceInterval != p->settings.logAnnounceInterval) {
+		if (p->logAnnounceInterval == p->initialLogAnnounceInterval) {
+			p->logAnnounceInterval = p->settings.logAnnounceInterval;
+			if (master && !p->inhibit_announce) {
+				port_set_manno_tmo(p);
+			}
+		}
+		p->initialLogAnnounceInterval = p->settings.logAnnounceInterval;
+	}
+	if (old.logSyncInterval != p->settings.logSyncInterval) {
+		if (p->logSyncInterval == p->initialLogSyncInterval) {
+			p->logSyncInterval = p->settings.logSyncInterval;
+			if (master) {
+				port_set_sync_tx_tmo(p);
+			}
+		}
+		p->initialLogSyncInterval = p->settings.logSyncInterval;
+	}
+	if (old.logMinDelayReqInterval != p->settings.logMinDelayReqInterval) {
+		p->logMinDelayReqInterval = p->settings.logMinDelayReqInterval;
+	}
+	if (old.logMinPdelayReqInterval != p->settings.logMinPdelayReqInterval) {
+		if (p->logPdelayReqInterval == p->logMinPdelayReqInterval) {
+			p->logPdelayReqInterval =
+				p->settings.logMinPdelayReqInterval;
+		}
+		p->logMinPdelayReqInterval = p->settings.logMinPdelayReqInterval;
+	}
+	p->operLogSyncInterval     = p->settings.operLogSyncInterval;
+	p->operLogPdelayReqInterval = p->settings.operLogPdelayReqInterval;
+	p->announceReceiptTimeout  = p->settings.announceReceiptTimeout;
+	p->syncReceiptTimeout      = p->settings.syncReceiptTimeout;
+	p->transportSpecific       = p->settings.transportSpecific;
+	p->transportSpecific     <<= 4;
+	p->match_transport_specific = !p->settings.ignore_transport_specific;
+	p->localPriority           = p->settings.G_8275_portDS_localPriority;
+	p->neighborPropDelayThresh = p->settings.neighborPropDelayThresh;
+	p->min_neighbor_prop_delay = p->settings.min_neighbor_prop_delay;
+	p->ignore_source_id        = p->settings.ignore_source_id;
+	p->asymmetry = p->settings.delayAsymmetry;
+	p->asymmetry <<= 16;
+	p->rx_timestamp_offset = p->settings.ingressLatency;
+	p->rx_timestamp_offset <<= 16;
+	p->tx_timestamp_offset = p->settings.egressLatency;
+	p->tx_timestamp_offset <<= 16;
+	p->follow_up_info = p->settings.follow_up_info;
+	p->freq_est_interval = p->settings.freq_est_interval;
+	p->msg_interval_request = p->settings.msg_interval_request;
+	if (p->acquiring && !p->settings.fast_acquisition) {
+		port_acquisition_set(p, 0);
+	}
+	p->net_sync_monitor = p->settings.net_sync_monitor;
+	p->path_trace_enabled = p->settings.path_trace_enabled;
+	p->flt_interval_pertype[FT_BAD_PEER_NETWORK].val =
+		p->settings.fault_badpeernet_interval;
+	p->flt_interval_pertype[FT_UNSPECIFIED].val =
+		p->settings.fault_reset_interval;
+
+	if (old.tsproc_mode != p->settings.tsproc_mode ||
+	    old.delay_filter != p->settings.delay_filter ||
+	    old.delay_filter_length != p->settings.delay_filter_length) {
+		tsproc = tsproc_create(p->settings.tsproc_mode,
+				       p->settings.delay_filter,
+				       p->settings.delay_filter_length);
+		if (!tsproc) {
+			pr_err("port %hu: failed to create time stamp processor",
+			       portnum(p));
+		} else {
+			if (!tmv_is_zero(p->peer_delay)) {
+				tsproc_set_delay(tsproc, p->peer_delay);
+			}
+			tsproc_destroy(p->tsproc);
+			p->tsproc = tsproc;
+		}
+	}
+
+	if (reopen && port_is_enabled(p)) {
+		pr_notice("port %hu: reopening to apply the new configuration",
+			  portnum(p));
+		port_dispatch(p, EV_INITIALIZE, 0);
+	}
+}
+
 static int port_renew_transport(struct port *p)
 {
 	int res;
@@ -1884,9 +2119,13 @@ static int port_renew_transport(struct port *p)
 	if (!port_is_enabled(p)) {
 		return 0;
 	}
+	unicast_worker_stop(p);
 	transport_close(p->trp, &p->fda);
-	port_clear_fda(p, FD_FIRST_TIMER);
+	port_clear_fda(p, N_POLLFD);
 	res = transport_open(p->trp, p->iface, &p->fda, p->timestamping);
+	if (!res) {
+		unicast_worker_start(p);
+	}
 	/* Need to call clock_fda_changed even if transport_open failed in
 	 * order to update clock to the now closed descriptors. */
 	clock_fda_changed(p->clock);
@@ -1924,6 +2163,8 @@ static int update_current_master(struct port *p, struct ptp_message *m)
 	msg_get(m);
 	fc->n_messages++;
 	TAILQ_INSERT_HEAD(&fc->messages, m, list);
+	if (fc->n_messages >= FOREIGN_MASTER_THRESHOLD)
+		fc->warm = 0;
 	if (fc->n_messages > 1) {
 		tmp = TAILQ_NEXT(m, list);
 		return announce_compare(m, tmp);
@@ -1972,6 +2213,107 @@ int process_announce(struct port *p, struct ptp_message *m)
 	return result;
 }
 
+/*
+ * The Delay_Resp of the fast path is kept in network byte order. Only
+ * the fields which depend on the request are written for each reply.
+ */
+static int delay_resp_template_init(struct port *p)
+{
+	struct ptp_message *msg;
+
+	msg = msg_allocate();
+	if (!msg) {
+		pr_err("low memory");
+		return -1;
+	}
+	msg->header.ver = PTP_VERSION;
+	msg->header.messageLength = htons(sizeof(struct delay_resp_msg));
+	msg->header.sourcePortIdentity.clockIdentity =
+		p->portIdentity.clockIdentity;
+	msg->header.sourcePortIdentity.portNumber =
+		htons(p->portIdentity.portNumber);
+	msg->header.control = CTL_DELAY_RESP;
+	p->delay_resp = msg;
+	return 0;
+}
+
+/*
+ * Answers a Delay_Req straight from the receive buffer, before
+ * msg_post_recv(). Anything out of the ordinary, like a request with
+ * TLVs or one which the port would ignore, is left to the general path.
+ * Returns one if the request was answered, zero if the general path
+ * must handle it, and -1 on error.
+ */
+static int process_delay_req_fast(struct port *p, struct ptp_message *m,
+				  int cnt)
+{
+	struct ptp_header *req = &m->header;
+	struct ptp_message *rsp = p->delay_resp;
+	struct ClockIdentity cid;
+	struct Timestamp ts;
+	int unicast;
+
+	if (p->state != PS_MASTER && p->state != PS_GRAND_MASTER) {
+		return 0;
+	}
+	if (!rsp || p->delayMechanism == DM_P2P) {
+		return 0;
+	}
+	if (cnt < (int) sizeof(struct delay_req_msg) ||
+	    cnt - (int) sizeof(struct delay_req_msg) >= (int) sizeof(struct TLV)) {
+		return 0;
+	}
+	if ((req->tsmt & 0x0f) != DELAY_REQ || (req->ver & 0x0f) != PTP_VERSION) {
+		return 0;
+	}
+	if (p->match_transport_specific &&
+	    (req->tsmt & 0xf0) != p->transportSpecific) {
+		return 0;
+	}
+	if (req->domainNumber != clock_domain_number(p->clock)) {
+		return 0;
+	}
+	cid = clock_identity(p->clock);
+	if (cid_eq(&cid, &req->sourcePortIdentity.clockIdentity)) {
+		return 0;
+	}
+	if (!msg_sots_valid(m)) {
+		return 0;
+	}
+	port_stats_inc_rx(p, m);
+	ts_add(&m->hwts.ts, -p->rx_timestamp_offset);
+	clock_check_ts(p->clock, tmv_to_nanoseconds(m->hwts.ts));
+
+	unicast = p->hybrid_e2e && (req->flagField[0] & UNICAST);
+
+	rsp->header.tsmt = DELAY_RESP | p->transportSpecific;
+	rsp->header.domainNumber = req->domainNumber;
+	rsp->header.flagField[0] = unicast ? UNICAST : 0;
+	rsp->header.correction = req->correction;
+	rsp->header.sequenceId = req->sequenceId;
+	rsp->header.logMessageInterval =
+		unicast ? 0x7f : p->logMinDelayReqInterval;
+
+	ts = tmv_to_Timestamp(m->hwts.ts);
+	rsp->delay_resp.receiveTimestamp.seconds_msb = htons(ts.seconds_msb);
+	rsp->delay_resp.receiveTimestamp.seconds_lsb = htonl(ts.seconds_lsb);
+	rsp->delay_resp.receiveTimestamp.nanoseconds = htonl(ts.nanoseconds);
+	rsp->delay_resp.requestingPortIdentity = req->sourcePortIdentity;
+
+	if (unicast) {
+		rsp->address = m->address;
+		cnt = transport_sendto(p->trp, &p->fda, TRANS_GENERAL, rsp);
+	} else {
+		cnt = transport_send(p->trp, &p->fda, TRANS_GENERAL, rsp);
+	}
+	if (cnt <= 0) {
+		pr_err("port %hu: send delay response failed", portnum(p));
+		return -1;
+	}
+	port_stats_inc_tx(p, rsp);
+	return 1;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////// process_delay_req
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////// uses ptp_message->header
 static int process_delay_req(struct port *p, struct ptp_message *m)
@@ -2058,6 +2400,7 @@ void process_delay_resp(struct port *p, struct ptp_message *m)
 		return;
 	}
 	if (check_source_identity(p, m)) {
+		port_standby_delay_resp(p, m);
 		return;
 	}
 	TAILQ_FOREACH(req, &p->delay_req, list) {
@@ -2077,6 +2420,9 @@ void process_delay_resp(struct port *p, struct ptp_message *m)
 	monitor_delay(p->slave_event_monitor, clock_parent_identity(p->clock),
 		      m->header.sequenceId, t3, c3, t4);
 
+	tsrec_write(TSREC_DELAY, clock_clkid(p->clock), tmv_to_nanoseconds(t3),
+		    tmv_to_nanoseconds(t4), tmv_to_nanoseconds(c3), 0.0);
+
 	clock_path_delay(p->clock, t3, t4c);
 
 	TAILQ_REMOVE(&p->delay_req, req, list);
@@ -2109,6 +2455,8 @@ void process_follow_up(struct port *p, struct ptp_message *m)
 	// fprintf(stderr, "[DEBUG]\tport.c\tprocess_follow_up\n");
 
 	enum syfu_event event;
+
+	latency_mark(LATENCY_DISPATCH);
 	switch (p->state) {
 	case PS_INITIALIZING:
 	case PS_FAULTY:
@@ -2125,6 +2473,7 @@ void process_follow_up(struct port *p, struct ptp_message *m)
 	}
 
 	if (check_source_identity(p, m)) {
+		port_standby_follow_up(p, m);
 		return;
 	}
 
@@ -2428,6 +2777,8 @@ void process_sync(struct port *p, struct ptp_message *m)
 	// fprintf(stderr, "[DEBUG]\tport.c\tprocess_sync\n");
 
 	enum syfu_event event;
+
+	latency_mark(LATENCY_DISPATCH);
 	switch (p->state) {
 	case PS_INITIALIZING:
 	case PS_FAULTY:
@@ -2444,6 +2795,7 @@ void process_sync(struct port *p, struct ptp_message *m)
 	}
 
 	if (check_source_identity(p, m)) {
+		port_standby_sync(p, m);
 		return;
 	}
 
@@ -2482,16 +2834,15 @@ void port_close(struct port *p)
 		port_disable(p);
 	}
 
-	if (p->fda.fd[FD_RTNL] >= 0) {
-		rtnl_close(p->fda.fd[FD_RTNL]);
-	}
-
 	unicast_client_cleanup(p);
+	unicast_worker_cleanup(p);
 	unicast_service_cleanup(p);
+	port_standby_destroy(p);
 	transport_destroy(p->trp);
 	tsproc_destroy(p->tsproc);
-	if (p->fault_fd >= 0) {
-		close(p->fault_fd);
+	tmo_clear(&p->fault_timer);
+	if (p->delay_resp) {
+		msg_put(p->delay_resp);
 	}
 	free(p);
 }
@@ -2499,8 +2850,7 @@ void port_close(struct port *p)
 struct foreign_clock *port_compute_best(struct port *p)
 {
 	int (*dscmp)(struct dataset *a, struct dataset *b);
-	int threshold = FOREIGN_MASTER_THRESHOLD;
-	struct foreign_clock *fc;
+	struct foreign_clock *fc, *second = NULL;
 	struct ptp_message *tmp;
 
 	dscmp = clock_dscmp(p->clock);
@@ -2518,31 +2868,46 @@ struct foreign_clock *port_compute_best(struct port *p)
 
 		fc_prune(fc);
 
-		if (port_is_ieee8021as(fc->port))
-			threshold = 1;
-
-		if (fc->n_messages < threshold)
+		if (fc->n_messages < fc_threshold(fc))
 			continue;
 
 		if (!p->best)
 			p->best = fc;
 		else if (dscmp(&fc->dataset, &p->best->dataset) > 0)
 			p->best = fc;
-		else
+		else if (!p->standby)
+			fc_clear(fc);
+	}
+
+	if (!p->standby)
+		return p->best;
+
+	/* Keep the runner up qualified, ready to take over. */
+	LIST_FOREACH(fc, &p->foreign_masters, list) {
+		if (fc == p->best || fc->n_messages < fc_threshold(fc))
+			continue;
+		if (!second) {
+			second = fc;
+		} else if (dscmp(&fc->dataset, &second->dataset) > 0) {
+			fc_clear(second);
+			second = fc;
+		} else {
 			fc_clear(fc);
+		}
 	}
+	port_standby_select(p, second);
 
 	return p->best;
 }
 
 static void port_e2e_transition(struct port *p, enum port_state next)
 {
-	port_clr_tmo(p->fda.fd[FD_ANNOUNCE_TIMER]);
-	port_clr_tmo(p->fda.fd[FD_SYNC_RX_TIMER]);
-	port_clr_tmo(p->fda.fd[FD_DELAY_TIMER]);
-	port_clr_tmo(p->fda.fd[FD_QUALIFICATION_TIMER]);
-	port_clr_tmo(p->fda.fd[FD_MANNO_TIMER]);
-	port_clr_tmo(p->fda.fd[FD_SYNC_TX_TIMER]);
+	port_clr_tmo(port_timer(p, FD_ANNOUNCE_TIMER));
+	port_clr_tmo(port_timer(p, FD_SYNC_RX_TIMER));
+	port_clr_tmo(port_timer(p, FD_DELAY_TIMER));
+	port_clr_tmo(port_timer(p, FD_QUALIFICATION_TIMER));
+	port_clr_tmo(port_timer(p, FD_MANNO_TIMER));
+	port_clr_tmo(port_timer(p, FD_SYNC_TX_TIMER));
 	/* Leave FD_UNICAST_REQ_TIMER running. */
 
 	switch (next) {
@@ -2561,7 +2926,7 @@ static void port_e2e_transition(struct port *p, enum port_state next)
 	case PS_MASTER:
 	case PS_GRAND_MASTER:
 		if (!p->inhibit_announce) {
-			set_tmo_log(p->fda.fd[FD_MANNO_TIMER], 1, -10); /*~1ms*/
+			set_tmo_log(port_timer(p, FD_MANNO_TIMER), 1, -10); /*~1ms*/
 		}
 		port_set_sync_tx_tmo(p);
 		break;
@@ -2581,12 +2946,12 @@ static void port_e2e_transition(struct port *p, enum port_state next)
 
 static void port_p2p_transition(struct port *p, enum port_state next)
 {
-	port_clr_tmo(p->fda.fd[FD_ANNOUNCE_TIMER]);
-	port_clr_tmo(p->fda.fd[FD_SYNC_RX_TIMER]);
+	port_clr_tmo(port_timer(p, FD_ANNOUNCE_TIMER));
+	port_clr_tmo(port_timer(p, FD_SYNC_RX_TIMER));
 	/* Leave FD_DELAY_TIMER running. */
-	port_clr_tmo(p->fda.fd[FD_QUALIFICATION_TIMER]);
-	port_clr_tmo(p->fda.fd[FD_MANNO_TIMER]);
-	port_clr_tmo(p->fda.fd[FD_SYNC_TX_TIMER]);
+	port_clr_tmo(port_timer(p, FD_QUALIFICATION_TIMER));
+	port_clr_tmo(port_timer(p, FD_MANNO_TIMER));
+	port_clr_tmo(port_timer(p, FD_SYNC_TX_TIMER));
 	/* Leave FD_UNICAST_REQ_TIMER running. */
 
 	switch (next) {
@@ -2606,7 +2971,7 @@ static void port_p2p_transition(struct port *p, enum port_state next)
 	case PS_MASTER:
 	case PS_GRAND_MASTER:
 		if (!p->inhibit_announce) {
-			set_tmo_log(p->fda.fd[FD_MANNO_TIMER], 1, -10); /*~1ms*/
+			set_tmo_log(port_timer(p, FD_MANNO_TIMER), 1, -10); /*~1ms*/
 		}
 		port_set_sync_tx_tmo(p);
 		break;
@@ -2626,6 +2991,7 @@ static void port_p2p_transition(struct port *p, enum port_state next)
 void port_dispatch(struct port *p, enum fsm_event event, int mdiff)
 {
 	p->dispatch(p, event, mdiff);
+	unicast_worker_publish(p);
 }
 
 static void bc_dispatch(struct port *p, enum fsm_event event, int mdiff)
@@ -2721,6 +3087,19 @@ void port_link_status(void *ctx, int linkup, int ts_index)
 		clock_set_sde(p->clock, 1);
 }
 
+enum fsm_event port_link_event(struct port *p, int linkup, int ts_index)
+{
+	pr_debug("port %hu: received link status notification", portnum(p));
+	port_link_status(p, linkup, ts_index);
+	if (p->link_status == (LINK_UP | LINK_STATE_CHANGED))
+		return EV_FAULT_CLEARED;
+	else if ((p->link_status == (LINK_DOWN | LINK_STATE_CHANGED)) ||
+		 (p->link_status & TS_LABEL_CHANGED))
+		return EV_FAULT_DETECTED;
+	else
+		return EV_NONE;
+}
+
 enum fsm_event port_event(struct port *p, int fd_index)
 {
 	return p->event(p, fd_index);
@@ -2730,7 +3109,7 @@ static enum fsm_event bc_event(struct port *p, int fd_index)
 {
 	enum fsm_event event = EV_NONE;
 	struct ptp_message *msg;
-	int cnt, fd = p->fda.fd[fd_index], err;
+	int cnt, err;
 
 	switch (fd_index) {
 	case FD_ANNOUNCE_TIMER:
@@ -2747,11 +3126,11 @@ static enum fsm_event bc_event(struct port *p, int fd_index)
 		 * state transition. So, it won't be cleared anywhere else.
 		 */
 		if (p->bmca == BMCA_NOOP) {
-			port_clr_tmo(p->fda.fd[FD_SYNC_RX_TIMER]);
+			port_clr_tmo(port_timer(p, FD_SYNC_RX_TIMER));
 		}
 
 		if (p->inhibit_announce) {
-			port_clr_tmo(p->fda.fd[FD_ANNOUNCE_TIMER]);
+			port_clr_tmo(port_timer(p, FD_ANNOUNCE_TIMER));
 		} else {
 			port_set_announce_tmo(p);
 		}
@@ -2771,6 +3150,7 @@ static enum fsm_event bc_event(struct port *p, int fd_index)
 		pr_debug("port %hu: delay timeout", portnum(p));
 		port_set_delay_tmo(p);
 		delay_req_prune(p);
+		port_standby_delay_request(p);
 		return port_delay_request(p) ? EV_FAULT_DETECTED : EV_NONE;
 
 	case FD_QUALIFICATION_TIMER:
@@ -2780,6 +3160,7 @@ static enum fsm_event bc_event(struct port *p, int fd_index)
 	case FD_MANNO_TIMER:
 		pr_debug("port %hu: master tx announce timeout", portnum(p));
 		port_set_manno_tmo(p);
+		unicast_worker_publish(p);
 		return port_tx_announce(p, NULL) ? EV_FAULT_DETECTED : EV_NONE;
 
 	case FD_SYNC_TX_TIMER:
@@ -2794,17 +3175,6 @@ static enum fsm_event bc_event(struct port *p, int fd_index)
 	case FD_UNICAST_REQ_TIMER:
 		pr_debug("port %hu: unicast request timeout", portnum(p));
 		return unicast_client_timer(p) ? EV_FAULT_DETECTED : EV_NONE;
-
-	case FD_RTNL:
-		pr_debug("port %hu: received link status notification", portnum(p));
-		rtnl_link_status(fd, p->name, port_link_status, p);
-		if (p->link_status == (LINK_UP | LINK_STATE_CHANGED))
-			return EV_FAULT_CLEARED;
-		else if ((p->link_status == (LINK_DOWN | LINK_STATE_CHANGED)) ||
-			 (p->link_status & TS_LABEL_CHANGED))
-			return EV_FAULT_DETECTED;
-		else
-			return EV_NONE;
 	}
 
 	msg = msg_allocate();
@@ -2813,11 +3183,24 @@ static enum fsm_event bc_event(struct port *p, int fd_index)
 
 	msg->hwts.type = p->timestamping;
 
-	cnt = transport_recv(p->trp, fd, msg);
+	latency_begin(&p->latency);
+	cnt = transport_recv(p->trp, p->fda.fd[fd_index], msg);
 	if (cnt < 0) {
 		pr_err("port %hu: recv message failed", portnum(p));
-		msg_put(msg);
-		return EV_FAULT_DETECTED;
+		event = EV_FAULT_DETECTED;
+		goto out;
+	}
+	if (!cnt) {
+		/* The io_uring held no message after all. */
+		goto out;
+	}
+	latency_mark(LATENCY_RECV);
+	err = process_delay_req_fast(p, msg, cnt);
+	if (err) {
+		if (err < 0) {
+			event = EV_FAULT_DETECTED;
+		}
+		goto out;
 	}
 	err = msg_post_recv(msg, cnt);
 	if (err) {
@@ -2829,25 +3212,23 @@ static enum fsm_event bc_event(struct port *p, int fd_index)
 			pr_debug("port %hu: ignoring message", portnum(p));
 			break;
 		}
-		msg_put(msg);
-		return EV_NONE;
+		goto out;
 	}
 	port_stats_inc_rx(p, msg);
 	if (port_ignore(p, msg)) {
-		msg_put(msg);
-		return EV_NONE;
+		goto out;
 	}
 	if (msg_sots_missing(msg) &&
 	    !(p->timestamping == TS_P2P1STEP && msg_type(msg) == PDELAY_REQ)) {
 		pr_err("port %hu: received %s without timestamp",
 		       portnum(p), msg_type_string(msg_type(msg)));
-		msg_put(msg);
-		return EV_NONE;
+		goto out;
 	}
 	if (msg_sots_valid(msg)) {
 		ts_add(&msg->hwts.ts, -p->rx_timestamp_offset);
 		clock_check_ts(p->clock, tmv_to_nanoseconds(msg->hwts.ts));
 	}
+	latency_mark(LATENCY_PARSE);
 
 	// DEBUG
 	// fprintf(stderr, "[DEBUG]\tport.c\tfsm_event bc_event\n");
@@ -2891,7 +3272,8 @@ static enum fsm_event bc_event(struct port *p, int fd_index)
 			event = EV_STATE_DECISION_EVENT;
 		break;
 	}
-
+out:
+	latency_end();
 	msg_put(msg);
 	return event;
 }
@@ -3166,14 +3548,16 @@ struct port *port_open(const char *phc_device,
 		goto err_port;
 	}
 
+	config_resolve_port(cfg, interface_name(interface), &p->settings);
+
 	p->phc_index = phc_index;
-	p->jbod = config_get_int(cfg, interface_name(interface), "boundary_clock_jbod");
-	transport = config_get_int(cfg, interface_name(interface), "network_transport");
-	p->master_only = config_get_int(cfg, interface_name(interface), "masterOnly");
-	p->bmca = config_get_int(cfg, interface_name(interface), "BMCA");
+	p->jbod = p->settings.boundary_clock_jbod;
+	transport = p->settings.network_transport;
+	p->master_only = p->settings.masterOnly;
+	p->bmca = p->settings.BMCA;
 
-	if (transport == TRANS_UDS) {
-		; /* UDS cannot have a PHC. */
+	if (transport == TRANS_UDS || transport == TRANS_SIM) {
+		; /* UDS cannot have a PHC, simulated ports use sim_clock. */
 	} else if (!interface_tsinfo_valid(interface)) {
 		pr_warning("port %d: get_ts_info not supported", number);
 	} else if (phc_index >= 0 &&
@@ -3197,18 +3581,18 @@ struct port *port_open(const char *phc_device,
 
 	p->name = interface_name(interface);
 	p->iface = interface;
-	p->asymmetry = config_get_int(cfg, p->name, "delayAsymmetry");
+	p->asymmetry = p->settings.delayAsymmetry;
 	p->asymmetry <<= 16;
 	p->announce_span = transport == TRANS_UDS ? 0 : ANNOUNCE_SPAN;
-	p->follow_up_info = config_get_int(cfg, p->name, "follow_up_info");
-	p->freq_est_interval = config_get_int(cfg, p->name, "freq_est_interval");
-	p->msg_interval_request = config_get_int(cfg, p->name, "msg_interval_request");
-	p->net_sync_monitor = config_get_int(cfg, p->name, "net_sync_monitor");
-	p->path_trace_enabled = config_get_int(cfg, p->name, "path_trace_enabled");
-	p->tc_spanning_tree = config_get_int(cfg, p->name, "tc_spanning_tree");
-	p->rx_timestamp_offset = config_get_int(cfg, p->name, "ingressLatency");
+	p->follow_up_info = p->settings.follow_up_info;
+	p->freq_est_interval = p->settings.freq_est_interval;
+	p->msg_interval_request = p->settings.msg_interval_request;
+	p->net_sync_monitor = p->settings.net_sync_monitor;
+	p->path_trace_enabled = p->settings.path_trace_enabled;
+	p->tc_spanning_tree = config_get_int_id(cfg, NULL, CFG_tc_spanning_tree);
+	p->rx_timestamp_offset = p->settings.ingressLatency;
 	p->rx_timestamp_offset <<= 16;
-	p->tx_timestamp_offset = config_get_int(cfg, p->name, "egressLatency");
+	p->tx_timestamp_offset = p->settings.egressLatency;
 	p->tx_timestamp_offset <<= 16;
 	p->link_status = LINK_UP;
 	p->clock = clock;
@@ -3216,15 +3600,18 @@ struct port *port_open(const char *phc_device,
 	if (!p->trp) {
 		goto err_port;
 	}
+	if (number && p->settings.io_uring && transport_use_uring(p->trp)) {
+		pr_warning("port %d: io_uring needs the UDP transport", number);
+	}
 	p->timestamping = timestamping;
 	p->portIdentity.clockIdentity = clock_identity(clock);
 	p->portIdentity.portNumber = number;
 	p->state = PS_INITIALIZING;
-	p->delayMechanism = config_get_int(cfg, p->name, "delay_mechanism");
+	p->delayMechanism = p->settings.delay_mechanism;
 	p->versionNumber = PTP_VERSION;
 	p->slave_event_monitor = clock_slave_monitor(clock);
 
-	if (config_get_int(cfg, p->name, "asCapable") == AS_CAPABLE_TRUE) {
+	if (p->settings.asCapable == AS_CAPABLE_TRUE) {
 		p->asCapable = ALWAYS_CAPABLE;
 	} else {
 		p->asCapable = NOT_CAPABLE;
@@ -3247,14 +3634,19 @@ struct port *port_open(const char *phc_device,
 	if (number && unicast_client_initialize(p)) {
 		goto err_transport;
 	}
-	if (unicast_client_enabled(p) &&
-	    config_set_section_int(cfg, p->name, "hybrid_e2e", 1)) {
-		goto err_uc_client;
+	if (unicast_client_enabled(p)) {
+		if (config_set_section_int(cfg, p->name, "hybrid_e2e", 1)) {
+			goto err_uc_client;
+		}
+		p->settings.hybrid_e2e = 1;
 	}
 	if (number && unicast_service_initialize(p)) {
 		goto err_uc_client;
 	}
-	p->hybrid_e2e = config_get_int(cfg, p->name, "hybrid_e2e");
+	if (number && unicast_worker_initialize(p)) {
+		goto err_uc_service;
+	}
+	p->hybrid_e2e = p->settings.hybrid_e2e;
 
 	if (number && type == CLOCK_TYPE_P2P && p->delayMechanism != DM_P2P) {
 		pr_err("port %d: P2P TC needs P2P ports", number);
@@ -3278,14 +3670,14 @@ struct port *port_open(const char *phc_device,
 	}
 	p->flt_interval_pertype[FT_BAD_PEER_NETWORK].type = FTMO_LINEAR_SECONDS;
 	p->flt_interval_pertype[FT_BAD_PEER_NETWORK].val =
-		config_get_int(cfg, p->name, "fault_badpeernet_interval");
+		p->settings.fault_badpeernet_interval;
 
 	p->flt_interval_pertype[FT_UNSPECIFIED].val =
-		config_get_int(cfg, p->name, "fault_reset_interval");
+		p->settings.fault_reset_interval;
 
-	p->tsproc = tsproc_create(config_get_int(cfg, p->name, "tsproc_mode"),
-				  config_get_int(cfg, p->name, "delay_filter"),
-				  config_get_int(cfg, p->name, "delay_filter_length"));
+	p->tsproc = tsproc_create(p->settings.tsproc_mode,
+				  p->settings.delay_filter,
+				  p->settings.delay_filter_length);
 	if (!p->tsproc) {
 		pr_err("Failed to create time stamp processor");
 		goto err_uc_service;
@@ -3293,19 +3685,26 @@ struct port *port_open(const char *phc_device,
 	p->nrate.ratio = 1.0;
 
 	port_clear_fda(p, N_POLLFD);
-	p->fault_fd = -1;
-	if (number) {
-		p->fault_fd = timerfd_create(CLOCK_MONOTONIC, 0);
-		if (p->fault_fd < 0) {
-			pr_err("timerfd_create failed: %m");
-			goto err_tsproc;
-		}
+	for (i = 0; i < N_TIMER_FDS; i++) {
+		tmo_init(&p->timers[i], clock_tmo_heap(clock), p,
+			 FD_FIRST_TIMER + i);
+	}
+	tmo_init(&p->fault_timer, clock_tmo_heap(clock), p, FD_FAULT_TIMER);
+
+	if (number && port_standby_create(p)) {
+		goto err_tsproc;
+	}
+	if (number && delay_resp_template_init(p)) {
+		goto err_standby;
 	}
 	return p;
 
+err_standby:
+	port_standby_destroy(p);
 err_tsproc:
 	tsproc_destroy(p->tsproc);
 err_uc_service:
+	unicast_worker_cleanup(p);
 	unicast_service_cleanup(p);
 err_uc_client:
 	unicast_client_cleanup(p);
@@ -3351,6 +3750,12 @@ int port_state_update(struct port *p, enum fsm_event event, int mdiff)
 		next = p->state_machine(next, event, 0);
 	}
 
+	/* A new parent has not seen our rate requests. */
+	if ((next != PS_UNCALIBRATED && next != PS_SLAVE) ||
+	    (event == EV_RS_SLAVE && mdiff)) {
+		port_acquisition_reset(p, next);
+	}
+
 	if (next != p->state) {
 		port_show_transition(p, next, event);
 		p->state = next;
@@ -24,11 +24,13 @@
 #include "foreign.h"
 #include "fsm.h"
 #include "notification.h"
+#include "tmo.h"
 #include "transport.h"
 
 /* forward declarations */
 struct interface;
 struct clock;
+struct tsproc;
 
 /** Opaque type. */
 struct port;
@@ -65,6 +67,31 @@ void port_close(struct port *port);
  */
 struct foreign_clock *port_compute_best(struct port *port);
 
+/**
+ * Hands the measurements of a hot standby master over to the clock,
+ * when the standby becomes the parent.
+ *
+ * @param port        A pointer previously obtained via port_open().
+ * @param pid         The identity of the new parent.
+ * @param tsp         The time stamp processor of the clock, which
+ *                    receives the delay of the standby.
+ * @param path_delay  Receives the path delay to the standby.
+ * @return Zero when the port tracked the new parent as its standby,
+ *         non-zero otherwise.
+ */
+int port_standby_takeover(struct port *port, struct PortIdentity *pid,
+			  struct tsproc *tsp, tmv_t *path_delay);
+
+/**
+ * Applies the changed options of the clock's configuration to a port,
+ * keeping its state and foreign masters.
+ *
+ * @param port   A pointer previously obtained via port_open().
+ * @param reopen Non-zero if options of the transport have changed,
+ *               in which case the port is initialized again.
+ */
+void port_reload(struct port *p, int reopen);
+
 /**
  * Dispatch a port event. This may cause a state transition on the
  * port, with the associated side effect.
@@ -134,6 +161,16 @@ int port_number(struct port *p);
  */
 int port_link_status_get(struct port *p);
 
+/**
+ * Update the link status of a port from a notification of the kernel.
+ * @param p         A port instance.
+ * @param linkup    One (1) if the link is up, zero otherwise.
+ * @param ts_index  The index of the interface which time stamps the
+ *                  port's packets, or -1 if not known.
+ * @return          The event to dispatch to the port.
+ */
+enum fsm_event port_link_event(struct port *p, int linkup, int ts_index);
+
 /**
  * Manage a port according to a given message.
  * @param p        A pointer previously obtained via port_open().
@@ -171,6 +208,24 @@ struct ptp_message *port_management_reply(struct PortIdentity pid,
 					  struct port *ingress,
 					  struct ptp_message *req);
 
+/**
+ * Append a management TLV holding one of a port's data sets to a
+ * response message.
+ *
+ * @param target   The port whose data set is reported.
+ * @param rsp      A message obtained via @ref port_management_reply().
+ * @param id       The management ID of the data set.
+ * @return         One if a TLV was appended, zero otherwise.
+ */
+int port_management_append(struct port *target, struct ptp_message *rsp,
+			   int id);
+
+/**
+ * Log the hot path latencies measured on a port.
+ * @param p  A port instance.
+ */
+void port_latency_display(struct port *p);
+
 /**
  * Allocate a standalone reply management message.
  *
@@ -230,7 +285,7 @@ enum port_state port_state(struct port *port);
 int port_state_update(struct port *p, enum fsm_event event, int mdiff);
 
 /**
- * Return array of file descriptors for this port. The fault fd is not
+ * Return array of file descriptors for this port. The timers are not
  * included.
  * @param port	A port instance
  * @return	Array of file descriptors. Unused descriptors are guranteed
@@ -239,58 +294,58 @@ int port_state_update(struct port *p, enum fsm_event event, int mdiff);
 struct fdarray *port_fda(struct port *port);
 
 /**
- * Return file descriptor of the port.
- * @param port	A port instance.
- * @return	File descriptor or -1 if not applicable.
+ * Send the messages which the transport of a port queued. Call this
+ * before polling the descriptors of the port.
+ * @param port	A port instance
  */
-int port_fault_fd(struct port *port);
+void port_flush(struct port *port);
 
 /**
- * Utility function for setting or resetting a file descriptor timer.
+ * Utility function for setting or resetting a port timer.
  *
- * This function sets the timer 'fd' to the value M(2^N), where M is
+ * This function sets the timer 't' to the value M(2^N), where M is
  * the value of the 'scale' parameter and N in the value of the
  * 'log_seconds' parameter.
  *
  * Passing both 'scale' and 'log_seconds' as zero disables the timer.
  *
- * @param fd A file descriptor previously opened with timerfd_create(2).
+ * @param t A timer previously initialized with tmo_init().
  * @param scale The multiplicative factor for the timer.
  * @param log_seconds The exponential factor for the timer.
  * @return Zero on success, non-zero otherwise.
  */
-int set_tmo_log(int fd, unsigned int scale, int log_seconds);
+int set_tmo_log(struct tmo *t, unsigned int scale, int log_seconds);
 
 /**
- * Utility function for setting a file descriptor timer.
+ * Utility function for setting a port timer.
  *
- * This function sets the timer 'fd' to a random value between M * 2^N and
+ * This function sets the timer 't' to a random value between M * 2^N and
  * (M + S) * 2^N, where M is the value of the 'min' parameter, S is the value
  * of the 'span' parameter, and N in the value of the 'log_seconds' parameter.
  *
- * @param fd A file descriptor previously opened with timerfd_create(2).
+ * @param t A timer previously initialized with tmo_init().
  * @param min The minimum value for the timer.
  * @param span The span value for the timer. Must be a positive value.
  * @param log_seconds The exponential factor for the timer.
  * @return Zero on success, non-zero otherwise.
  */
-int set_tmo_random(int fd, int min, int span, int log_seconds);
+int set_tmo_random(struct tmo *t, int min, int span, int log_seconds);
 
 /**
- * Utility function for setting or resetting a file descriptor timer.
+ * Utility function for setting or resetting a port timer.
  *
- * This function sets the timer 'fd' to the value of the 'seconds' parameter.
+ * This function sets the timer 't' to the value of the 'seconds' parameter.
  *
  * Passing 'seconds' as zero disables the timer.
  *
- * @param fd A file descriptor previously opened with timerfd_create(2).
+ * @param t A timer previously initialized with tmo_init().
  * @param seconds The timeout value for the timer.
  * @return Zero on success, non-zero otherwise.
  */
-int set_tmo_lin(int fd, int seconds);
+int set_tmo_lin(struct tmo *t, int seconds);
 
 /**
- * Sets port's fault file descriptor timer.
+ * Sets port's fault timer.
  * Passing both 'scale' and 'log_seconds' as zero disables the timer.
  *
  * @param fd		A port instance.
@@ -302,7 +357,7 @@ int port_set_fault_timer_log(struct port *port,
 			     unsigned int scale, int log_seconds);
 
 /**
- * Sets port's fault file descriptor timer.
+ * Sets port's fault timer.
  * Passing 'seconds' as zero disables the timer.
  *
  * @param fd		A port instance.
@@ -23,9 +23,12 @@
 
 #include "as_capable.h"
 #include "clock.h"
+#include "fd.h"
 #include "fsm.h"
+#include "latency.h"
 #include "monitor.h"
 #include "msg.h"
+#include "tmo.h"
 #include "tmv.h"
 
 #define NSEC2SEC 1000000000LL
@@ -67,8 +70,10 @@ struct port {
 	struct transport *trp;
 	enum timestamp_type timestamping;
 	struct fdarray fda;
-	int fault_fd;
+	struct tmo timers[N_TIMER_FDS];
+	struct tmo fault_timer;
 	int phc_index;
+	struct config_port settings;
 
 	void (*dispatch)(struct port *p, enum fsm_event event, int mdiff);
 	enum fsm_event (*event)(struct port *p, int fd_index);
@@ -124,6 +129,8 @@ struct port {
 	Integer8            operLogPdelayReqInterval;
 	Integer8            logPdelayReqInterval;
 	UInteger32          neighborPropDelayThresh;
+	int                 acquiring;
+	struct PortIdentity acquisition_parent;
 	int                 follow_up_info;
 	int                 freq_est_interval;
 	int                 hybrid_e2e;
@@ -142,6 +149,8 @@ struct port {
 	enum fault_type     last_fault_type;
 	unsigned int        versionNumber; /*UInteger4*/
 	struct PortStats    stats;
+	struct latency      latency;
+	struct ptp_message  *delay_resp; /* template of the Delay_Req fast path */
 	/* foreignMasterDS */
 	LIST_HEAD(fm, foreign_clock) foreign_masters;
 	/* TC book keeping */
@@ -150,9 +159,12 @@ struct port {
 	struct unicast_master_table *unicast_master_table;
 	/* unicast service mode */
 	struct unicast_service *unicast_service;
+	struct unicast_workers *unicast_workers;
 	int inhibit_multicast_service;
 	/* slave event monitoring */
 	struct monitor *slave_event_monitor;
+	/* hot standby master */
+	struct port_standby *standby;
 };
 
 #define portnum(p) (p->portIdentity.portNumber)
@@ -164,12 +176,18 @@ void p2p_dispatch(struct port *p, enum fsm_event event, int mdiff);
 enum fsm_event p2p_event(struct port *p, int fd_index);
 
 int clear_fault_asap(struct fault_interval *faint);
+/* Obtain a timer of a port by its index, like FD_DELAY_TIMER. */
+static inline struct tmo *port_timer(struct port *p, int index)
+{
+	return &p->timers[index - FD_FIRST_TIMER];
+}
+
 void delay_req_prune(struct port *p);
 void fc_clear(struct foreign_clock *fc);
 void flush_delay_req(struct port *p);
 void flush_last_sync(struct port *p);
 int port_capable(struct port *p);
-int port_clr_tmo(int fd);
+int port_clr_tmo(struct tmo *t);
 int port_delay_request(struct port *p);
 void port_disable(struct port *p);
 int port_initialize(struct port *p);
@@ -185,6 +203,7 @@ struct ptp_message *port_signaling_uc_construct(struct port *p,
 						struct PortIdentity *tpid);
 int port_tx_announce(struct port *p, struct address *dst);
 int port_tx_interval_request(struct port *p,
+			     const struct PortIdentity *target,
 			     Integer8 announceInterval,
 			     Integer8 timeSyncInterval,
 			     Integer8 linkDelayInterval);
@@ -200,4 +219,14 @@ void process_sync(struct port *p, struct ptp_message *m);
 int source_pid_eq(struct ptp_message *m1, struct ptp_message *m2);
 void ts_add(tmv_t *ts, Integer64 correction);
 
+int port_standby_create(struct port *p);
+int port_standby_delay_request(struct port *p);
+void port_standby_delay_resp(struct port *p, struct ptp_message *m);
+void port_standby_destroy(struct port *p);
+void port_standby_flush(struct port *p);
+void port_standby_follow_up(struct port *p, struct ptp_message *m);
+void port_standby_select(struct port *p, struct foreign_clock *fc);
+int port_standby_selected(struct port *p, struct PortIdentity *pid);
+void port_standby_sync(struct port *p, struct ptp_message *m);
+
 #endif
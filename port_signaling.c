@@ -172,12 +172,12 @@ int process_signaling(struct port *p, struct ptp_message *m)
 }
 
 int port_tx_interval_request(struct port *p,
+			     const struct PortIdentity *target,
 			     Integer8 announceInterval,
 			     Integer8 timeSyncInterval,
 			     Integer8 linkDelayInterval)
 {
 	struct msg_interval_req_tlv *mir;
-	struct PortIdentity tpid;
 	struct ptp_message *msg;
 	struct tlv_extra *extra;
 	int err;
@@ -185,8 +185,7 @@ int port_tx_interval_request(struct port *p,
 	if (!port_capable(p)) {
 		return 0;
 	}
-	memset(&tpid, 0xff, sizeof(tpid));
-	msg = port_signaling_construct(p, &tpid);
+	msg = port_signaling_construct(p, target);
 	if (!msg) {
 		return -1;
 	}
@@ -0,0 +1,407 @@
+/**
+ * @file port_standby.c
+ * @brief Tracks a hot standby master next to the parent of a slave port.
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#include <arpa/inet.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.h"
+#include "msg.h"
+#include "port.h"
+#include "port_private.h"
+#include "print.h"
+#include "tmv.h"
+#include "tsproc.h"
+#include "unicast_client.h"
+#include "util.h"
+
+#define STANDBY_DELAY_SAMPLES 64
+
+struct standby_track {
+	struct PortIdentity pid;
+	int selected;
+	struct tsproc *tsproc;
+	tmv_t offset;
+	tmv_t delay;
+	int have_delay;
+	int64_t rx_sync;	/* CLOCK_MONOTONIC of the last Sync, or zero */
+	int64_t updated;	/* CLOCK_MONOTONIC of the last offset, or zero */
+};
+
+struct port_standby {
+	struct standby_track cur;	/* the standby master */
+	struct standby_track prev;	/* the standby just promoted to parent */
+	struct address address;
+	struct ptp_message *sync;	/* two step Sync awaiting its Follow_Up */
+	struct ptp_message *fup;	/* or the other way around */
+	struct ptp_message *delay_req;
+};
+
+static void standby_flush_msgs(struct port_standby *sb)
+{
+	if (sb->sync) {
+		msg_put(sb->sync);
+		sb->sync = NULL;
+	}
+	if (sb->fup) {
+		msg_put(sb->fup);
+		sb->fup = NULL;
+	}
+	if (sb->delay_req) {
+		msg_put(sb->delay_req);
+		sb->delay_req = NULL;
+	}
+}
+
+static void standby_track_reset(struct standby_track *t)
+{
+	memset(&t->pid, 0, sizeof(t->pid));
+	t->selected = 0;
+	tsproc_reset(t->tsproc, 1);
+	t->offset = tmv_zero();
+	t->delay = tmv_zero();
+	t->have_delay = 0;
+	t->rx_sync = 0;
+	t->updated = 0;
+}
+
+static int standby_match(struct port *p, struct ptp_message *m)
+{
+	struct port_standby *sb = p->standby;
+
+	return sb && sb->cur.selected &&
+		pid_eq(&sb->cur.pid, &m->header.sourcePortIdentity);
+}
+
+/* Measurements older than the announce receipt window are worthless. */
+static int standby_recent(struct port *p, int64_t when)
+{
+	int64_t window = p->announceReceiptTimeout * NSEC2SEC;
+
+	if (!when) {
+		return 0;
+	}
+	if (p->logAnnounceInterval < 0) {
+		window >>= -p->logAnnounceInterval;
+	} else {
+		window <<= p->logAnnounceInterval;
+	}
+	return tmo_now() - when <= window;
+}
+
+static int standby_fresh(struct port *p, struct standby_track *t)
+{
+	return t->have_delay && standby_recent(p, t->updated);
+}
+
+static void standby_offset(struct port *p, struct ptp_message *sync,
+			   struct ptp_message *fup)
+{
+	struct standby_track *t = &p->standby->cur;
+	tmv_t c, t1, t2;
+
+	t1 = timestamp_to_tmv(fup ? fup->ts.pdu : sync->ts.pdu);
+	t2 = sync->hwts.ts;
+	c = correction_to_tmv(sync->header.correction);
+	if (fup) {
+		c = tmv_add(c, correction_to_tmv(fup->header.correction));
+	}
+
+	if (p->delayMechanism == DM_P2P && !tmv_is_zero(p->peer_delay)) {
+		t->delay = p->peer_delay;
+		t->have_delay = 1;
+		tsproc_set_delay(t->tsproc, t->delay);
+	}
+	t->rx_sync = tmo_now();
+	tsproc_down_ts(t->tsproc, tmv_add(t1, c), t2);
+	if (tsproc_update_offset(t->tsproc, &t->offset, NULL)) {
+		return;
+	}
+	t->updated = tmo_now();
+
+	pr_debug("port %hu: standby %s offset %" PRId64 " delay %" PRId64,
+		 portnum(p), pid2str(&t->pid), tmv_to_nanoseconds(t->offset),
+		 tmv_to_nanoseconds(t->delay));
+}
+
+int port_standby_create(struct port *p)
+{
+	struct port_standby *sb;
+
+	if (!p->settings.hot_standby) {
+		return 0;
+	}
+	sb = calloc(1, sizeof(*sb));
+	if (!sb) {
+		pr_err("low memory");
+		return -1;
+	}
+	/* Only the filtered delay is of interest. */
+	sb->cur.tsproc = tsproc_create(TSPROC_FILTER, p->settings.delay_filter,
+				       p->settings.delay_filter_length);
+	sb->prev.tsproc = tsproc_create(TSPROC_FILTER, p->settings.delay_filter,
+					p->settings.delay_filter_length);
+	if (!sb->cur.tsproc || !sb->prev.tsproc) {
+		pr_err("failed to create time stamp processor");
+		if (sb->cur.tsproc)
+			tsproc_destroy(sb->cur.tsproc);
+		if (sb->prev.tsproc)
+			tsproc_destroy(sb->prev.tsproc);
+		free(sb);
+		return -1;
+	}
+	p->standby = sb;
+	return 0;
+}
+
+void port_standby_destroy(struct port *p)
+{
+	struct port_standby *sb = p->standby;
+
+	if (!sb) {
+		return;
+	}
+	standby_flush_msgs(sb);
+	tsproc_destroy(sb->cur.tsproc);
+	tsproc_destroy(sb->prev.tsproc);
+	free(sb);
+	p->standby = NULL;
+}
+
+void port_standby_flush(struct port *p)
+{
+	struct port_standby *sb = p->standby;
+
+	if (!sb) {
+		return;
+	}
+	standby_flush_msgs(sb);
+	standby_track_reset(&sb->cur);
+	standby_track_reset(&sb->prev);
+}
+
+void port_standby_select(struct port *p, struct foreign_clock *fc)
+{
+	struct port_standby *sb = p->standby;
+	struct ptp_message *ann;
+	struct standby_track tmp;
+
+	if (!sb) {
+		return;
+	}
+	ann = fc ? TAILQ_FIRST(&fc->messages) : NULL;
+	if (fc && sb->cur.selected && pid_eq(&fc->dataset.sender, &sb->cur.pid)) {
+		sb->address = ann->address;
+		return;
+	}
+	if (!fc && !sb->cur.selected) {
+		return;
+	}
+
+	/* Keep what was learned, when the standby becomes the parent. */
+	if (sb->cur.selected && p->best &&
+	    pid_eq(&p->best->dataset.sender, &sb->cur.pid)) {
+		tmp = sb->prev;
+		sb->prev = sb->cur;
+		sb->cur = tmp;
+	}
+	standby_flush_msgs(sb);
+	standby_track_reset(&sb->cur);
+
+	if (fc) {
+		sb->cur.pid = fc->dataset.sender;
+		sb->cur.selected = 1;
+		sb->address = ann->address;
+		pr_info("port %hu: hot standby master %s",
+			portnum(p), pid2str(&sb->cur.pid));
+	} else {
+		pr_info("port %hu: no hot standby master", portnum(p));
+	}
+	unicast_client_state_changed(p);
+}
+
+int port_standby_selected(struct port *p, struct PortIdentity *pid)
+{
+	struct port_standby *sb = p->standby;
+
+	if (!sb || !sb->cur.selected) {
+		return 0;
+	}
+	if (p->state != PS_UNCALIBRATED && p->state != PS_SLAVE) {
+		return 0;
+	}
+	return pid_eq(&sb->cur.pid, pid);
+}
+
+void port_standby_sync(struct port *p, struct ptp_message *m)
+{
+	struct port_standby *sb = p->standby;
+
+	if (!standby_match(p, m)) {
+		return;
+	}
+	m->header.correction += p->asymmetry;
+
+	if (one_step(m)) {
+		standby_offset(p, m, NULL);
+		return;
+	}
+	if (sb->fup && sb->fup->header.sequenceId == m->header.sequenceId) {
+		standby_offset(p, m, sb->fup);
+		msg_put(sb->fup);
+		sb->fup = NULL;
+		return;
+	}
+	if (sb->sync) {
+		msg_put(sb->sync);
+	}
+	msg_get(m);
+	sb->sync = m;
+}
+
+void port_standby_follow_up(struct port *p, struct ptp_message *m)
+{
+	struct port_standby *sb = p->standby;
+
+	if (!standby_match(p, m)) {
+		return;
+	}
+	if (sb->sync && sb->sync->header.sequenceId == m->header.sequenceId) {
+		standby_offset(p, sb->sync, m);
+		msg_put(sb->sync);
+		sb->sync = NULL;
+		return;
+	}
+	if (sb->fup) {
+		msg_put(sb->fup);
+	}
+	msg_get(m);
+	sb->fup = m;
+}
+
+int port_standby_delay_request(struct port *p)
+{
+	struct port_standby *sb = p->standby;
+	struct ptp_message *msg;
+
+	if (!sb || !sb->cur.selected || p->delayMechanism == DM_P2P) {
+		return 0;
+	}
+	if (sb->delay_req) {
+		msg_put(sb->delay_req);
+		sb->delay_req = NULL;
+	}
+	/*
+	 * A standby which sends no Sync, like a passive port, does not
+	 * answer Delay_Req either.
+	 */
+	if (!standby_recent(p, sb->cur.rx_sync)) {
+		return 0;
+	}
+
+	msg = msg_allocate();
+	if (!msg) {
+		return -1;
+	}
+	msg->hwts.type = p->timestamping;
+
+	msg->header.tsmt               = DELAY_REQ | p->transportSpecific;
+	msg->header.ver                = PTP_VERSION;
+	msg->header.messageLength      = sizeof(struct delay_req_msg);
+	msg->header.domainNumber       = clock_domain_number(p->clock);
+	msg->header.correction         = -p->asymmetry;
+	msg->header.sourcePortIdentity = p->portIdentity;
+	msg->header.sequenceId         = p->seqnum.delayreq++;
+	msg->header.control            = CTL_DELAY_REQ;
+	msg->header.logMessageInterval = 0x7f;
+	msg->header.flagField[0]      |= UNICAST;
+	msg->address                   = sb->address;
+
+	if (port_prepare_and_send(p, msg, TRANS_EVENT)) {
+		pr_err("port %hu: send standby delay request failed",
+		       portnum(p));
+		msg_put(msg);
+		return -1;
+	}
+	if (msg_sots_missing(msg)) {
+		pr_err("missing timestamp on transmitted delay request");
+		msg_put(msg);
+		return -1;
+	}
+	sb->delay_req = msg;
+	return 0;
+}
+
+void port_standby_delay_resp(struct port *p, struct ptp_message *m)
+{
+	struct port_standby *sb = p->standby;
+	struct delay_resp_msg *rsp = &m->delay_resp;
+	struct standby_track *t;
+	tmv_t c3, t3, t4c;
+
+	if (!standby_match(p, m) || !sb->delay_req) {
+		return;
+	}
+	if (rsp->hdr.sequenceId != ntohs(sb->delay_req->delay_req.hdr.sequenceId)) {
+		return;
+	}
+	t = &sb->cur;
+
+	c3 = correction_to_tmv(m->header.correction);
+	t3 = sb->delay_req->hwts.ts;
+	t4c = tmv_sub(timestamp_to_tmv(m->ts.pdu), c3);
+
+	tsproc_set_clock_rate_ratio(t->tsproc, clock_rate_ratio(p->clock));
+	tsproc_up_ts(t->tsproc, t3, t4c);
+	if (!tsproc_update_delay(t->tsproc, &t->delay)) {
+		t->have_delay = 1;
+	}
+	msg_put(sb->delay_req);
+	sb->delay_req = NULL;
+}
+
+int port_standby_takeover(struct port *p, struct PortIdentity *pid,
+			  struct tsproc *tsp, tmv_t *path_delay)
+{
+	struct port_standby *sb = p->standby;
+	tmv_t delay[STANDBY_DELAY_SAMPLES];
+	struct standby_track *t;
+	int n;
+
+	if (!sb) {
+		return -1;
+	}
+	if (sb->prev.selected && pid_eq(&sb->prev.pid, pid)) {
+		t = &sb->prev;
+	} else if (sb->cur.selected && pid_eq(&sb->cur.pid, pid)) {
+		t = &sb->cur;
+	} else {
+		return -1;
+	}
+	if (!standby_fresh(p, t)) {
+		pr_info("port %hu: no recent measurement of standby %s",
+			portnum(p), pid2str(pid));
+		return -1;
+	}
+
+	n = tsproc_get_delay_samples(t->tsproc, delay, STANDBY_DELAY_SAMPLES);
+	if (n > 0) {
+		tsproc_seed_delay(tsp, delay, n);
+	} else {
+		tsproc_set_delay(tsp, t->delay);
+	}
+	*path_delay = t->delay;
+
+	pr_notice("port %hu: hot standby %s takes over, offset %" PRId64
+		  " path delay %" PRId64, portnum(p), pid2str(pid),
+		  tmv_to_nanoseconds(t->offset), tmv_to_nanoseconds(t->delay));
+
+	if (t == &sb->prev) {
+		standby_track_reset(t);
+	}
+	return 0;
+}
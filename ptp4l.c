@@ -32,6 +32,8 @@
 	#include "clock.h"
 		// clock_create
 		// clock_poll
+	#include "clockadj.h"
+		// clockadj_set_record
 	#include "config.h"
 		// config_create
 		// config_long_options
@@ -39,6 +41,8 @@
 		// config_set_int
 		// config_read
 		// config_destroy
+	#include "latency.h"
+		// latency_set_enabled
 	#include "ntpshm.h"
 	#include "pi.h"
 	#include "print.h"
@@ -48,13 +52,25 @@
 		// print_set_syslog
 		// print_set_level
 	#include "raw.h"
+	#include "rtprof.h"
+		// rtprof_apply
+		// rtprof_check
 	#include "sk.h"
 	#include "transport.h"
+	#include "tsrec.h"
+		// tsrec_open
+		// tsrec_close
 	#include "udp6.h"
 	#include "uds.h"
 	#include "util.h"
 		// handle_term_signals
+		// handle_reload_signal
+		// reload_requested
 	#include "version.h"
+	#include "warm.h"
+		// warm_open
+		// warm_flush
+		// warm_close
 
 
 /* 
@@ -94,6 +110,53 @@ static void usage(char *progname)
 		progname);
 }
 
+/*
+ * Applies the settings which live in global variables. This is done
+ * at start up and again after each reload of the configuration.
+ */
+static void set_globals(struct config *cfg)
+{
+	print_set_tag(config_get_string(cfg, NULL, "message_tag"));
+	print_set_verbose(config_get_int(cfg, NULL, "verbose"));
+	print_set_syslog(config_get_int(cfg, NULL, "use_syslog"));
+	print_set_level(config_get_int(cfg, NULL, "logging_level"));
+
+	assume_two_step = config_get_int(cfg, NULL, "assume_two_step");
+	sk_check_fupsync = config_get_int(cfg, NULL, "check_fup_sync");
+	sk_tx_timeout = config_get_int(cfg, NULL, "tx_timestamp_timeout");
+	sk_hwts_filter_mode = config_get_int(cfg, NULL, "hwts_filter");
+	latency_set_enabled(config_get_int(cfg, NULL, "latency_stats"));
+}
+
+/*
+ * Reads the configuration file again and applies the changes to the
+ * running clock. On any error, the running configuration is kept.
+ */
+static void reload_config(struct clock *clock, struct config *cfg,
+			  const char *file)
+{
+	struct config *src;
+
+	if (!file || !strcmp(file, "-")) {
+		pr_warning("reload: no configuration file to read");
+		return;
+	}
+	pr_notice("reloading configuration file %s", file);
+
+	src = config_create();
+	if (!src) {
+		pr_err("reload: low memory");
+		return;
+	}
+	if (config_read(file, src)) {
+		pr_err("reload: keeping the running configuration");
+	} else if (clock_reload(clock, src)) {
+		pr_err("reload: failed to apply the configuration");
+	}
+	config_destroy(src);
+	set_globals(cfg);
+}
+
 /* 
  * %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
  *  main
@@ -113,6 +176,8 @@ int main(int argc, char *argv[])
 	// TODO: what does this mean?
 	if (handle_term_signals())
 		return -1;
+	if (handle_reload_signal())
+		return -1;
 
 	// initialize a config struct
 	cfg = config_create();
@@ -268,17 +333,7 @@ int main(int argc, char *argv[])
 	// ???
 	// TODO: what does this mean?
 	print_set_progname(progname);
-	print_set_tag(config_get_string(cfg, NULL, "message_tag"));
-	print_set_verbose(config_get_int(cfg, NULL, "verbose"));
-	print_set_syslog(config_get_int(cfg, NULL, "use_syslog"));
-	print_set_level(config_get_int(cfg, NULL, "logging_level"));
-
-	// ???
-	// TODO: what does this mean?
-	assume_two_step = config_get_int(cfg, NULL, "assume_two_step");
-	sk_check_fupsync = config_get_int(cfg, NULL, "check_fup_sync");
-	sk_tx_timeout = config_get_int(cfg, NULL, "tx_timestamp_timeout");
-	sk_hwts_filter_mode = config_get_int(cfg, NULL, "hwts_filter");
+	set_globals(cfg);
 
 	// if clock_servo == CLOCK_SERVO_NTPSHM, set kernel_leap and sanity_freq_limit to 0
 	if (config_get_int(cfg, NULL, "clock_servo") == CLOCK_SERVO_NTPSHM) {
@@ -332,8 +387,25 @@ int main(int argc, char *argv[])
 		goto out;
 	}
 
+	// optionally record the time stamps fed to the servo
+	if (tsrec_open(config_get_string(cfg, NULL, "timestamp_record"))) {
+		goto out;
+	}
+	clockadj_set_record(tsrec_write);
+
+	// read the state saved by the previous run, if any
+	if (warm_open(config_get_string(cfg, NULL, "state_file"),
+		      config_get_int(cfg, NULL, "state_file_max_age"),
+		      config_get_int(cfg, NULL, "state_file_interval"))) {
+		goto out;
+	}
+
+	// set up affinity, scheduling and memory before any thread starts
+	if (rtprof_apply(cfg)) {
+		goto out;
+	}
+
 	// create a clock instance
-	// note: there can only be one clock in any system, so subsequent calls will destroy the previous instance
 	clock = clock_create(type, cfg, req_phc);
 	// if fail to create a clock, go to out statement
 	if (!clock) {
@@ -343,10 +415,18 @@ int main(int argc, char *argv[])
 
 	err = 0;
 
+	// measure the wake up latency of the event loop, if requested
+	rtprof_check(cfg);
+
 	while (is_running()) {
 		// poll for events and dispatch them (zero on success, non-zero otherwise)
 		if (clock_poll(clock))
 			break;
+		// write the state file, if the servo saved a record
+		warm_flush();
+		// reload the configuration file on SIGHUP or on request of a management client
+		if (reload_requested() || clock_reload_pending(clock))
+			reload_config(clock, cfg, config);
 	}
 
 // out statement
@@ -356,6 +436,12 @@ out:
 	if (clock)
 		clock_destroy(clock);
 
+	// flush the time stamp record, if any
+	tsrec_close();
+
+	// write the last records and forget the state file
+	warm_close();
+
 	// destroy config object
 	config_destroy(cfg);
 	
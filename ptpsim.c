@@ -0,0 +1,465 @@
+/**
+ * @file ptpsim.c
+ * @brief Runs a simulated PTP network of many clocks in one process.
+ * @note Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "clock.h"
+#include "clockadj.h"
+#include "config.h"
+#include "latency.h"
+#include "missing.h"
+#include "phc.h"
+#include "print.h"
+#include "simclock.h"
+#include "simnet.h"
+#include "transport.h"
+#include "util.h"
+#include "version.h"
+#include "warm.h"
+
+#define NS_PER_SEC	1000000000LL
+#define MAX_OPTIONS	64
+
+struct node {
+	struct config *cfg;
+	struct clock *clock;
+	clockid_t clkid;
+	char phc[16];
+	char tag[16];
+	char uds[64];
+	int first_pfd;
+	int num_pfd;
+};
+
+static struct {
+	int nodes;
+	int ports;
+	int duration;
+	int lock;
+	double drift;
+	double noise;
+	long offset;
+	int level;
+	unsigned int seed;
+	const char *config;
+	/* long options, applied to every node */
+	int num_options;
+	const char *option_name[MAX_OPTIONS];
+	const char *option_val[MAX_OPTIONS];
+} opts = {
+	.nodes = 4,
+	.ports = 1,
+	.duration = 60,
+	.lock = 100,
+	.drift = 10000.0,
+	.noise = 10.0,
+	.offset = 1000000,
+	.level = LOG_WARNING,
+	.seed = 1,
+};
+
+static double uniform(double max)
+{
+	return max * (2.0 * rand_r(&opts.seed) / RAND_MAX - 1.0);
+}
+
+static int node_config(struct node *n, int index)
+{
+	char name[32], network[32], buf[32];
+	struct config *cfg;
+	int i;
+
+	cfg = config_create();
+	if (!cfg) {
+		return -1;
+	}
+	n->cfg = cfg;
+	if (opts.config && config_read(opts.config, cfg)) {
+		fprintf(stderr, "failed to read config\n");
+		return -1;
+	}
+	for (i = 0; i < opts.num_options; i++) {
+		if (config_parse_option(cfg, opts.option_name[i],
+					opts.option_val[i])) {
+			return -1;
+		}
+	}
+
+	snprintf(n->phc, sizeof(n->phc), "%s%d", SIMCLOCK_PREFIX, index);
+	if (config_set_string(cfg, "sim_clock", n->phc)) {
+		return -1;
+	}
+	snprintf(buf, sizeof(buf), "000000.fffe.%06x", index + 1);
+	if (config_set_string(cfg, "clockIdentity", buf)) {
+		return -1;
+	}
+	snprintf(n->uds, sizeof(n->uds), "/tmp/ptpsim.%d.%d", getpid(), index);
+	if (config_set_string(cfg, "uds_address", n->uds) ||
+	    config_set_int(cfg, "network_transport", TRANS_SIM) ||
+	    config_set_int(cfg, "time_stamping", TS_HARDWARE)) {
+		return -1;
+	}
+
+	/* The first node is the grand master, with a port per network. */
+	if (!index) {
+		if (config_set_int(cfg, "priority1", 100)) {
+			return -1;
+		}
+		for (i = 0; i < opts.ports; i++) {
+			snprintf(name, sizeof(name), "sim0.%d", i);
+			snprintf(network, sizeof(network), "net%d", i);
+			if (!config_create_interface(name, cfg) ||
+			    config_set_section_string(cfg, name, "sim_network",
+						      network)) {
+				return -1;
+			}
+		}
+		return 0;
+	}
+
+	if (config_set_int(cfg, "slaveOnly", 1)) {
+		return -1;
+	}
+	snprintf(name, sizeof(name), "sim%d", index);
+	snprintf(network, sizeof(network), "net%d", (index - 1) % opts.ports);
+	if (!config_create_interface(name, cfg) ||
+	    config_set_section_string(cfg, name, "sim_network", network)) {
+		return -1;
+	}
+	return 0;
+}
+
+static int node_create(struct node *n, int index)
+{
+	enum clock_type type;
+
+	if (node_config(n, index)) {
+		return -1;
+	}
+	snprintf(n->tag, sizeof(n->tag), "node%d", index);
+	print_set_tag(n->tag);
+
+	/* The nodes share one state file, with a record per clock. */
+	if (!index &&
+	    warm_open(config_get_string(n->cfg, NULL, "state_file"),
+		      config_get_int(n->cfg, NULL, "state_file_max_age"),
+		      config_get_int(n->cfg, NULL, "state_file_interval"))) {
+		return -1;
+	}
+
+	type = n->cfg->n_interfaces > 1 ?
+		CLOCK_TYPE_BOUNDARY : CLOCK_TYPE_ORDINARY;
+	n->clock = clock_create(type, n->cfg, n->phc);
+	if (!n->clock) {
+		fprintf(stderr, "failed to create clock of node %d\n", index);
+		return -1;
+	}
+	return 0;
+}
+
+static void node_destroy(struct node *n)
+{
+	if (n->clock) {
+		print_set_tag(n->tag);
+		clock_destroy(n->clock);
+	}
+	if (n->cfg) {
+		config_destroy(n->cfg);
+	}
+}
+
+/* Returns the true offsets of the slaves from the grand master. */
+static void report(struct node *nodes, int t, int *converged, double *rms)
+{
+	int64_t now, master, err, max = 0;
+	double sum = 0.0;
+	int i, locked = 0;
+
+	now = simclock_mono();
+	master = simclock_read(nodes[0].clkid, now);
+
+	for (i = 1; i < opts.nodes; i++) {
+		err = simclock_read(nodes[i].clkid, now) - master;
+		sum += (double) err * err;
+		if (llabs(err) > max) {
+			max = llabs(err);
+		}
+		if (llabs(err) <= opts.lock) {
+			locked++;
+		}
+	}
+	*rms = sqrt(sum / (opts.nodes - 1));
+
+	if (locked == opts.nodes - 1) {
+		if (*converged < 0) {
+			*converged = t;
+		}
+	} else {
+		*converged = -1;
+	}
+	printf("t %4d locked %3d/%-3d rms %12.1f max %12" PRId64 "\n",
+	       t, locked, opts.nodes - 1, *rms, max);
+	fflush(stdout);
+}
+
+static int run(struct node *nodes)
+{
+	int64_t start, next, now;
+	int converged = -1, i, j, cnt, num, t = 0, timeout;
+	struct pollfd *pfd = NULL, *src, *tmp;
+	double rms = 0.0;
+	struct rusage ru;
+
+	start = simclock_mono();
+	next = start + NS_PER_SEC;
+
+	while (is_running() && t < opts.duration) {
+		/* The descriptors of the clocks may change on every call. */
+		for (num = 0, i = 0; i < opts.nodes; i++) {
+			clock_pollfds(nodes[i].clock, &nodes[i].num_pfd);
+			nodes[i].first_pfd = num;
+			num += nodes[i].num_pfd;
+		}
+		tmp = realloc(pfd, num * sizeof(*pfd));
+		if (!tmp) {
+			pr_err("low memory");
+			free(pfd);
+			return -1;
+		}
+		pfd = tmp;
+		for (i = 0; i < opts.nodes; i++) {
+			src = clock_pollfds(nodes[i].clock, &cnt);
+			memcpy(pfd + nodes[i].first_pfd, src, cnt * sizeof(*pfd));
+		}
+
+		now = simclock_mono();
+		timeout = next > now ? (next - now + 999999) / 1000000 : 0;
+		cnt = poll(pfd, num, timeout);
+		if (cnt < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			pr_emerg("poll failed");
+			free(pfd);
+			return -1;
+		}
+
+		for (i = 0; cnt > 0 && i < opts.nodes; i++) {
+			src = clock_pollfds(nodes[i].clock, &num);
+			for (j = 0; j < num; j++) {
+				src[j].revents = pfd[nodes[i].first_pfd + j].revents;
+			}
+			print_set_tag(nodes[i].tag);
+			if (clock_poll_events(nodes[i].clock)) {
+				free(pfd);
+				return -1;
+			}
+		}
+		warm_flush();
+
+		if (simclock_mono() >= next) {
+			report(nodes, ++t, &converged, &rms);
+			next += NS_PER_SEC;
+		}
+	}
+	free(pfd);
+
+	getrusage(RUSAGE_SELF, &ru);
+	printf("nodes %d ports %d seconds %d\n", opts.nodes, opts.ports, t);
+	if (converged >= 0) {
+		printf("converged after %d s, rms %.1f ns\n", converged, rms);
+	} else {
+		printf("not converged within %d ns, rms %.1f ns\n",
+		       opts.lock, rms);
+	}
+	printf("cpu user %.3f s system %.3f s (%.2f%% of one cpu)\n",
+	       ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6,
+	       ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6,
+	       t ? 100.0 * (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+			    (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6) / t
+		 : 0.0);
+	printf("messages dropped %lu\n", simnet_dropped());
+	return 0;
+}
+
+static void usage(char *progname)
+{
+	fprintf(stderr,
+		"\n"
+		"usage: %s [options]\n\n"
+		" -n [num]  number of nodes, including the grand master (4)\n"
+		" -p [num]  number of ports of the grand master (1)\n"
+		" -t [num]  simulated seconds (60)\n"
+		" -f [file] read configuration of every node from 'file'\n"
+		" -d [ppb]  maximum frequency error of the slaves (10000)\n"
+		" -o [ns]   maximum initial offset of the slaves (1000000)\n"
+		" -N [ns]   standard deviation of the time stamp noise (10)\n"
+		" -L [ns]   offset counted as locked (100)\n"
+		" -l [num]  set the logging level to 'num' (4)\n"
+		" -s [num]  seed of the random clock errors (1)\n"
+		" -h        prints this message and exits\n"
+		" -v        prints the software version and exits\n"
+		"\n"
+		" Long options of ptp4l are applied to every node.\n"
+		"\n",
+		progname);
+}
+
+int main(int argc, char *argv[])
+{
+	char *progname;
+	int c, err = -1, i, index;
+	struct option *long_opts;
+	struct node *nodes = NULL;
+	struct config *cfg;
+
+	if (handle_term_signals())
+		return -1;
+
+	/* Only used for the table of long options. */
+	cfg = config_create();
+	if (!cfg) {
+		return -1;
+	}
+	long_opts = config_long_options(cfg);
+	print_set_verbose(1);
+	print_set_syslog(0);
+
+	progname = strrchr(argv[0], '/');
+	progname = progname ? 1+progname : argv[0];
+	while (EOF != (c = getopt_long(argc, argv, "n:p:t:f:d:o:N:L:l:s:hv",
+				       long_opts, &index))) {
+		switch (c) {
+		case 0:
+			if (opts.num_options == MAX_OPTIONS) {
+				fprintf(stderr, "too many options\n");
+				goto out;
+			}
+			opts.option_name[opts.num_options] = long_opts[index].name;
+			opts.option_val[opts.num_options] = optarg;
+			opts.num_options++;
+			break;
+		case 'n':
+			if (get_arg_val_i(c, optarg, &opts.nodes, 2, 4096))
+				goto out;
+			break;
+		case 'p':
+			if (get_arg_val_i(c, optarg, &opts.ports, 1, 256))
+				goto out;
+			break;
+		case 't':
+			if (get_arg_val_i(c, optarg, &opts.duration, 1, INT_MAX))
+				goto out;
+			break;
+		case 'f':
+			opts.config = optarg;
+			break;
+		case 'd':
+			if (get_arg_val_d(c, optarg, &opts.drift, 0.0, 500000.0))
+				goto out;
+			break;
+		case 'o':
+			if (get_arg_val_i(c, optarg, &i, 0, INT_MAX))
+				goto out;
+			opts.offset = i;
+			break;
+		case 'N':
+			if (get_arg_val_d(c, optarg, &opts.noise, 0.0, 1e9))
+				goto out;
+			break;
+		case 'L':
+			if (get_arg_val_i(c, optarg, &opts.lock, 0, INT_MAX))
+				goto out;
+			break;
+		case 'l':
+			if (get_arg_val_i(c, optarg, &opts.level,
+					  PRINT_LEVEL_MIN, PRINT_LEVEL_MAX))
+				goto out;
+			break;
+		case 's':
+			if (get_arg_val_ui(c, optarg, &opts.seed, 0, UINT_MAX))
+				goto out;
+			break;
+		case 'v':
+			version_show(stdout);
+			err = 0;
+			goto out;
+		case 'h':
+			usage(progname);
+			err = 0;
+			goto out;
+		case '?':
+		default:
+			usage(progname);
+			goto out;
+		}
+	}
+	print_set_progname(progname);
+	print_set_level(opts.level);
+
+	nodes = calloc(opts.nodes, sizeof(*nodes));
+	if (!nodes) {
+		pr_err("low memory");
+		goto out;
+	}
+
+	/* Only this program links the simulated clocks and network. */
+	phc_set_sim(simclock_open, simclock_is);
+	clockadj_set_sim(simclock_is, simclock_adjtime);
+	transport_set_sim(simnet_transport_create);
+
+	/* All clocks must exist before the first port looks them up. */
+	for (i = 0; i < opts.nodes; i++) {
+		nodes[i].clkid = i ?
+			simclock_create(uniform(opts.drift), opts.noise,
+					llround(uniform(opts.offset))) :
+			simclock_create(0.0, opts.noise, 0);
+		if (nodes[i].clkid == CLOCK_INVALID) {
+			goto out;
+		}
+	}
+	for (i = 0; i < opts.nodes; i++) {
+		if (node_create(&nodes[i], i)) {
+			goto out;
+		}
+	}
+	latency_set_enabled(config_get_int(nodes[0].cfg, NULL, "latency_stats"));
+
+	err = run(nodes);
+out:
+	if (nodes) {
+		for (i = 0; i < opts.nodes; i++) {
+			node_destroy(&nodes[i]);
+		}
+		free(nodes);
+	}
+	warm_close();
+	simclock_cleanup();
+	config_destroy(cfg);
+	return err;
+}
@@ -20,13 +20,14 @@
 #include <fcntl.h>
 #include <linux/filter.h>
 #include <linux/if_ether.h>
+#include <linux/if_packet.h>
 #include <net/if.h>
 #include <netinet/in.h>
-#include <netpacket/packet.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -45,12 +46,34 @@
 #include "transport_private.h"
 #include "util.h"
 
+/*
+ * A TPACKET_V3 receive ring, mapped from one of the sockets. The kernel
+ * fills a block with frames and passes it over as a whole, either when
+ * it is full or when its retire timer expires. We hand it back once all
+ * of its frames have been read.
+ */
+struct raw_ring {
+	int fd;
+	unsigned char *map;
+	size_t map_len;
+	unsigned int block_size;
+	unsigned int block_nr;
+	unsigned int block;
+	unsigned int left;
+	struct tpacket3_hdr *frame;
+};
+
+#define RAW_RING_FRAME_SIZE	2048
+#define RAW_RING_RETIRE_TOV	1 /* milliseconds */
+
 struct raw {
 	struct transport t;
 	struct address src_addr;
 	struct address ptp_addr;
 	struct address p2p_addr;
 	int vlan;
+	enum timestamp_type ts_type;
+	struct raw_ring ring[N_POLLFD];
 };
 
 #define OP_AND  (BPF_ALU | BPF_AND | BPF_K)
@@ -142,8 +165,175 @@ static int raw_configure(int fd, int event, int index,
 	return -1;
 }
 
+static void raw_ring_release(int fd)
+{
+	struct tpacket_req3 req;
+
+	memset(&req, 0, sizeof(req));
+	setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+}
+
+static int raw_ring_open(struct raw_ring *r, int fd, int blocks,
+			 enum timestamp_type ts_type)
+{
+	int version = TPACKET_V3, flags = SOF_TIMESTAMPING_RAW_HARDWARE;
+	struct tpacket_req3 req;
+	long page;
+
+	if (setsockopt(fd, SOL_PACKET, PACKET_VERSION,
+		       &version, sizeof(version))) {
+		pr_err("setsockopt PACKET_VERSION failed: %m");
+		return -1;
+	}
+	if (ts_type != TS_SOFTWARE &&
+	    setsockopt(fd, SOL_PACKET, PACKET_TIMESTAMP,
+		       &flags, sizeof(flags))) {
+		pr_err("setsockopt PACKET_TIMESTAMP failed: %m");
+		return -1;
+	}
+
+	page = sysconf(_SC_PAGESIZE);
+	if (page < RAW_RING_FRAME_SIZE)
+		page = RAW_RING_FRAME_SIZE;
+
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = page;
+	req.tp_block_nr = blocks;
+	req.tp_frame_size = RAW_RING_FRAME_SIZE;
+	req.tp_frame_nr = blocks * (page / RAW_RING_FRAME_SIZE);
+	req.tp_retire_blk_tov = RAW_RING_RETIRE_TOV;
+	if (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req))) {
+		pr_err("setsockopt PACKET_RX_RING failed: %m");
+		return -1;
+	}
+
+	r->map_len = (size_t) req.tp_block_size * req.tp_block_nr;
+	r->map = mmap(NULL, r->map_len, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_POPULATE, fd, 0);
+	if (r->map == MAP_FAILED) {
+		pr_err("mmap of the receive ring failed: %m");
+		r->map = NULL;
+		raw_ring_release(fd);
+		return -1;
+	}
+	r->fd = fd;
+	r->block_size = req.tp_block_size;
+	r->block_nr = req.tp_block_nr;
+	r->block = 0;
+	r->left = 0;
+	r->frame = NULL;
+	return 0;
+}
+
+static void raw_ring_close(struct raw_ring *r)
+{
+	if (r->map) {
+		munmap(r->map, r->map_len);
+		raw_ring_release(r->fd);
+	}
+	memset(r, 0, sizeof(*r));
+	r->fd = -1;
+}
+
+static struct raw_ring *raw_ring_of(struct raw *raw, int fd)
+{
+	int i;
+
+	for (i = 0; i < N_POLLFD; i++) {
+		if (raw->ring[i].map && raw->ring[i].fd == fd)
+			return &raw->ring[i];
+	}
+	return NULL;
+}
+
+static struct tpacket_block_desc *raw_ring_block(struct raw_ring *r)
+{
+	return (struct tpacket_block_desc *) (r->map + r->block * r->block_size);
+}
+
+/*
+ * Take the next frame from the ring, copying out the PTP message behind
+ * the Ethernet header. Returns zero when the ring holds no frame.
+ */
+static int raw_ring_recv(struct raw *raw, struct raw_ring *r, void *buf,
+			 int buflen, struct address *addr,
+			 struct hw_timestamp *hwts)
+{
+	struct tpacket_block_desc *bd = raw_ring_block(r);
+	struct tpacket3_hdr *f;
+	struct sockaddr_ll *sll;
+	unsigned char *frame;
+	struct eth_hdr *hdr;
+	struct timespec ts;
+	int cnt, hlen;
+
+	if (!r->left) {
+		if (!(__atomic_load_n(&bd->hdr.bh1.block_status,
+				      __ATOMIC_ACQUIRE) & TP_STATUS_USER))
+			return 0;
+		r->left = bd->hdr.bh1.num_pkts;
+		r->frame = (struct tpacket3_hdr *)
+			((unsigned char *) bd + bd->hdr.bh1.offset_to_first_pkt);
+	}
+
+	cnt = 0;
+	if (r->left) {
+		f = r->frame;
+		frame = (unsigned char *) f + f->tp_mac;
+		hdr = (struct eth_hdr *) frame;
+		if (ETH_P_8021Q == ntohs(hdr->type)) {
+			hlen = sizeof(struct vlan_hdr);
+		} else {
+			hlen = sizeof(struct eth_hdr);
+		}
+		if (f->tp_snaplen >= hlen) {
+			cnt = f->tp_snaplen - hlen;
+			if (cnt > buflen)
+				cnt = buflen;
+			memcpy(buf, frame + hlen, cnt);
+		}
+
+		if (addr) {
+			sll = (struct sockaddr_ll *)
+				((unsigned char *) f +
+				 TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+			memcpy(&addr->sll, sll, sizeof(addr->sll));
+			addr->len = sizeof(addr->sll);
+		}
+
+		ts.tv_sec = f->tp_sec;
+		ts.tv_nsec = f->tp_nsec;
+		if (f->tp_status & TP_STATUS_TS_RAW_HARDWARE) {
+			hwts->ts = timespec_to_tmv(ts);
+		} else {
+			hwts->sw = timespec_to_tmv(ts);
+			if (raw->ts_type == TS_SOFTWARE) {
+				hwts->ts = hwts->sw;
+			} else {
+				memset(&hwts->ts, 0, sizeof(hwts->ts));
+			}
+		}
+		r->left--;
+		r->frame = (struct tpacket3_hdr *)
+			((unsigned char *) f + f->tp_next_offset);
+	}
+
+	if (!r->left) {
+		__atomic_store_n(&bd->hdr.bh1.block_status, TP_STATUS_KERNEL,
+				 __ATOMIC_RELEASE);
+		r->block = (r->block + 1) % r->block_nr;
+	}
+	return cnt;
+}
+
 static int raw_close(struct transport *t, struct fdarray *fda)
 {
+	struct raw *raw = container_of(t, struct raw, t);
+	int i;
+
+	for (i = 0; i < N_POLLFD; i++) {
+		raw_ring_close(&raw->ring[i]);
+	}
 	close(fda->fd[0]);
 	close(fda->fd[1]);
 	return 0;
@@ -212,7 +402,7 @@ static int raw_open(struct transport *t, struct interface *iface,
 	struct raw *raw = container_of(t, struct raw, t);
 	unsigned char ptp_dst_mac[MAC_LEN];
 	unsigned char p2p_dst_mac[MAC_LEN];
-	int efd, gfd, socket_priority;
+	int efd, gfd, i, ring_blocks, socket_priority;
 	const char *name;
 	char *str;
 
@@ -249,6 +439,23 @@ static int raw_open(struct transport *t, struct interface *iface,
 	if (sk_general_init(gfd))
 		goto no_timestamping;
 
+	raw->ts_type = ts_type;
+	ring_blocks = config_get_int(t->cfg, name, "rx_ring_blocks");
+	if (ring_blocks && ts_type == TS_LEGACY_HW) {
+		pr_warning("port %s: rx_ring_blocks ignored with legacy "
+			   "hardware time stamping", name);
+		ring_blocks = 0;
+	}
+	if (ring_blocks &&
+	    (raw_ring_open(&raw->ring[FD_EVENT], efd, ring_blocks, ts_type) ||
+	     raw_ring_open(&raw->ring[FD_GENERAL], gfd, ring_blocks,
+			   TS_SOFTWARE))) {
+		pr_warning("port %s: falling back to socket reception", name);
+		for (i = 0; i < N_POLLFD; i++) {
+			raw_ring_close(&raw->ring[i]);
+		}
+	}
+
 	fda->fd[FD_EVENT] = efd;
 	fda->fd[FD_GENERAL] = gfd;
 	return 0;
@@ -269,6 +476,11 @@ static int raw_recv(struct transport *t, int fd, void *buf, int buflen,
 	unsigned char *ptr = buf;
 	struct eth_hdr *hdr;
 	struct raw *raw = container_of(t, struct raw, t);
+	struct raw_ring *r = raw_ring_of(raw, fd);
+
+	if (r) {
+		return raw_ring_recv(raw, r, buf, buflen, addr, hwts);
+	}
 
 	if (raw->vlan) {
 		hlen = sizeof(struct vlan_hdr);
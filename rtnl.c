@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <unistd.h>
 
 #include "missing.h"
@@ -35,8 +36,20 @@
 #define BUF_SIZE 4096
 #define GENLMSG_DATA(glh) ((void *)(NLMSG_DATA(glh) + GENL_HDRLEN))
 
+/*
+ * The active port of a team is only known via a generic netlink query,
+ * so remember it until the team or one of its ports changes.
+ */
+struct team_cache {
+	LIST_ENTRY(team_cache) list;
+	int master_index;
+	int active_index;
+};
+
 static int rtnl_len;
 static char *rtnl_buf;
+static LIST_HEAD(team_cache_head, team_cache) team_caches =
+	LIST_HEAD_INITIALIZER(team_caches);
 static int get_team_active_iface(int master_index);
 
 static int nl_close(int fd)
@@ -66,8 +79,45 @@ static int nl_open(int family)
 	return fd;
 }
 
+static void team_cache_flush(int master_index)
+{
+	struct team_cache *tc, *next;
+
+	for (tc = LIST_FIRST(&team_caches); tc; tc = next) {
+		next = LIST_NEXT(tc, list);
+		if (master_index < 0 || tc->master_index == master_index) {
+			LIST_REMOVE(tc, list);
+			free(tc);
+		}
+	}
+}
+
+static int team_cache_lookup(int master_index)
+{
+	struct team_cache *tc;
+	int index;
+
+	LIST_FOREACH(tc, &team_caches, list) {
+		if (tc->master_index == master_index) {
+			return tc->active_index;
+		}
+	}
+	index = get_team_active_iface(master_index);
+	if (index < 0) {
+		return index;
+	}
+	tc = malloc(sizeof(*tc));
+	if (tc) {
+		tc->master_index = master_index;
+		tc->active_index = index;
+		LIST_INSERT_HEAD(&team_caches, tc, list);
+	}
+	return index;
+}
+
 int rtnl_close(int fd)
 {
+	team_cache_flush(-1);
 	if (rtnl_buf) {
 		free(rtnl_buf);
 		rtnl_buf = NULL;
@@ -221,24 +271,19 @@ static int rtnl_linkinfo_parse(int master_index, struct rtattr *rta)
 				index = rta_getattr_u32(bond[IFLA_BOND_ACTIVE_SLAVE]);
 			}
 		} else if (kind && !strncmp(kind, "team", 4)) {
-			index = get_team_active_iface(master_index);
+			index = team_cache_lookup(master_index);
 		}
 	}
 	return index;
 }
 
-int rtnl_link_status(int fd, const char *device, rtnl_callback cb, void *ctx)
+static int rtnl_recv(int fd)
 {
-	struct rtattr *tb[IFLA_MAX+1];
-	struct ifinfomsg *info = NULL;
-	int index, len, link_up;
 	struct sockaddr_nl sa;
-	int slave_index = -1;
-	struct nlmsghdr *nh;
 	struct msghdr msg;
 	struct iovec iov;
+	int len;
 
-	index = if_nametoindex(device);
 	if (!rtnl_buf) {
 		rtnl_len = BUF_SIZE;
 		rtnl_buf = malloc(rtnl_len);
@@ -278,6 +323,22 @@ int rtnl_link_status(int fd, const char *device, rtnl_callback cb, void *ctx)
 		pr_err("rtnl: recvmsg: %m");
 		return -1;
 	}
+	return len;
+}
+
+int rtnl_link_status(int fd, const char *device, rtnl_callback cb, void *ctx)
+{
+	struct rtattr *tb[IFLA_MAX+1];
+	struct ifinfomsg *info = NULL;
+	int index, len, link_up;
+	int slave_index = -1;
+	struct nlmsghdr *nh;
+
+	index = if_nametoindex(device);
+	len = rtnl_recv(fd);
+	if (len < 0) {
+		return -1;
+	}
 	nh = (struct nlmsghdr *) rtnl_buf;
 
 	for ( ; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
@@ -305,6 +366,62 @@ int rtnl_link_status(int fd, const char *device, rtnl_callback cb, void *ctx)
 	return 0;
 }
 
+int rtnl_link_events(int fd, rtnl_lookup lookup, rtnl_link_callback cb,
+		     void *ctx)
+{
+	struct rtattr *tb[IFLA_MAX+1];
+	struct ifinfomsg *info;
+	int index, len, link_up;
+	struct nlmsghdr *nh;
+	int slave_index;
+	void *link;
+
+	len = rtnl_recv(fd);
+	if (len < 0) {
+		return -1;
+	}
+	nh = (struct nlmsghdr *) rtnl_buf;
+
+	for ( ; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+		if (nh->nlmsg_type != RTM_NEWLINK &&
+		    nh->nlmsg_type != RTM_DELLINK)
+			continue;
+
+		info = NLMSG_DATA(nh);
+		index = info->ifi_index;
+		rtnl_rtattr_parse(tb, IFLA_MAX, IFLA_RTA(info),
+				  IFLA_PAYLOAD(nh));
+
+		/*
+		 * A change of a team port or of the team itself may
+		 * change the active port.
+		 */
+		if (tb[IFLA_MASTER])
+			team_cache_flush(rta_getattr_u32(tb[IFLA_MASTER]));
+		if (info->ifi_change || nh->nlmsg_type == RTM_DELLINK)
+			team_cache_flush(index);
+
+		if (nh->nlmsg_type != RTM_NEWLINK || !tb[IFLA_IFNAME])
+			continue;
+
+		link = lookup(ctx, rta_getattr_str(tb[IFLA_IFNAME]));
+		if (!link)
+			continue;
+
+		link_up = info->ifi_flags & IFF_RUNNING ? 1 : 0;
+		pr_debug("interface index %d is %s", index,
+			 link_up ? "up" : "down");
+
+		slave_index = -1;
+		if (tb[IFLA_LINKINFO])
+			slave_index = rtnl_linkinfo_parse(index, tb[IFLA_LINKINFO]);
+
+		cb(ctx, link, link_up, slave_index);
+	}
+
+	return 0;
+}
+
 static int genl_send_msg(int fd, int family_id, int genl_cmd, int genl_version,
 		  int rta_type, void *rta_data, int rta_len)
 {
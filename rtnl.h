@@ -23,6 +23,9 @@
 #include <net/if.h>
 
 typedef void (*rtnl_callback)(void *ctx, int linkup, int ts_index);
+typedef void *(*rtnl_lookup)(void *ctx, const char *ifname);
+typedef void (*rtnl_link_callback)(void *ctx, void *link, int linkup,
+				   int ts_index);
 
 /**
  * Close a RT netlink socket.
@@ -49,6 +52,22 @@ int rtnl_get_ts_device(const char *device, char ts_device[IF_NAMESIZE]);
  */
 int rtnl_link_query(int fd, const char *device);
 
+/**
+ * Read kernel messages looking for link up/down events of many
+ * interfaces at once. Each message is parsed only once, and only the
+ * interfaces known to the lookup function are passed to the callback.
+ * The active port of a team is cached until the team or one of its
+ * ports changes.
+ * @param fd      Readable socket obtained via rtnl_open().
+ * @param lookup  Returns the object watching an interface name, or NULL.
+ * @param cb      Callback function to be invoked on each event of a
+ *                watched interface, with the object found by lookup.
+ * @param ctx     Private context passed to the lookup and the callback.
+ * @return        Zero on success, non-zero otherwise.
+ */
+int rtnl_link_events(int fd, rtnl_lookup lookup, rtnl_link_callback cb,
+		     void *ctx);
+
 /**
  * Read kernel messages looking for a link up/down events.
  * @param fd     Readable socket obtained via rtnl_open().
@@ -0,0 +1,212 @@
+/**
+ * @file rtprof.c
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#include <alloca.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "print.h"
+#include "rtprof.h"
+
+#define RTPROF_CHECK_PERIOD	1000000 /* nanoseconds */
+
+static int rtprof_parse_cpus(const char *str, cpu_set_t *set)
+{
+	unsigned long first, last;
+	char *end;
+
+	CPU_ZERO(set);
+	while (*str) {
+		first = strtoul(str, &end, 10);
+		if (end == str)
+			return -1;
+		last = first;
+		if (*end == '-') {
+			str = end + 1;
+			last = strtoul(str, &end, 10);
+			if (end == str || last < first)
+				return -1;
+		}
+		if (last >= CPU_SETSIZE)
+			return -1;
+		for (; first <= last; first++) {
+			CPU_SET(first, set);
+		}
+		if (*end == ',') {
+			end++;
+		} else if (*end) {
+			return -1;
+		}
+		str = end;
+	}
+	return CPU_COUNT(set) ? 0 : -1;
+}
+
+static void rtprof_prefault_heap(size_t size)
+{
+	unsigned char *p = malloc(size);
+
+	if (!p) {
+		pr_warning("failed to prefault %zu bytes of heap", size);
+		return;
+	}
+	memset(p, 0, size);
+	free(p);
+}
+
+static void __attribute__((noinline)) rtprof_prefault_stack(size_t size)
+{
+	volatile unsigned char *p = alloca(size);
+	size_t i, page = sysconf(_SC_PAGESIZE);
+
+	for (i = 0; i < size; i += page) {
+		p[i] = 0;
+	}
+}
+
+int rtprof_apply(struct config *cfg)
+{
+	const char *cpus = config_get_string(cfg, NULL, "cpu_affinity");
+	int heap = config_get_int(cfg, NULL, "prefault_heap");
+	int lock = config_get_int(cfg, NULL, "memory_lock");
+	int prio = config_get_int(cfg, NULL, "rt_priority");
+	int slack = config_get_int(cfg, NULL, "timer_slack");
+	int stack = config_get_int(cfg, NULL, "prefault_stack");
+	struct sched_param sp;
+	cpu_set_t set;
+
+	if (cpus[0]) {
+		if (rtprof_parse_cpus(cpus, &set)) {
+			pr_err("invalid cpu_affinity '%s'", cpus);
+			return -1;
+		}
+		if (sched_setaffinity(0, sizeof(set), &set)) {
+			pr_err("sched_setaffinity failed: %m");
+			return -1;
+		}
+	}
+	if (slack && prctl(PR_SET_TIMERSLACK, (unsigned long) slack, 0, 0, 0)) {
+		pr_err("prctl PR_SET_TIMERSLACK failed: %m");
+		return -1;
+	}
+	if (lock || heap) {
+		/* Keep the prefaulted heap from going back to the kernel. */
+		mallopt(M_TRIM_THRESHOLD, -1);
+		mallopt(M_MMAP_MAX, 0);
+	}
+	if (lock && mlockall(MCL_CURRENT | MCL_FUTURE)) {
+		pr_err("mlockall failed: %m");
+		return -1;
+	}
+	if (heap) {
+		rtprof_prefault_heap(heap);
+	}
+	if (stack) {
+		rtprof_prefault_stack(stack);
+	}
+	if (prio) {
+		memset(&sp, 0, sizeof(sp));
+		sp.sched_priority = prio;
+		if (sched_setscheduler(0, SCHED_FIFO, &sp)) {
+			pr_err("sched_setscheduler failed: %m");
+			return -1;
+		}
+	}
+	if (cpus[0] || slack || lock || heap || stack || prio) {
+		pr_info("real time profile: cpus '%s' priority %d memory lock %d "
+			"prefault heap %d stack %d timer slack %d",
+			cpus, prio, lock, heap, stack, slack);
+	}
+	return 0;
+}
+
+static int64_t rtprof_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void rtprof_check(struct config *cfg)
+{
+	int i, limit, samples = config_get_int(cfg, NULL, "wakeup_check");
+	int64_t expiry, late, now, min = INT64_MAX, max = 0, sum = 0;
+	struct itimerspec tmo;
+	struct pollfd pfd;
+	uint64_t count;
+
+	if (!samples)
+		return;
+
+	limit = config_get_int(cfg, NULL, "wakeup_limit");
+
+	/*
+	 * Wake up the way the event loops do, through a timerfd reported
+	 * by poll(), so that the result includes the whole path.
+	 */
+	pfd.fd = timerfd_create(CLOCK_MONOTONIC, 0);
+	if (pfd.fd < 0) {
+		pr_err("timerfd_create failed: %m");
+		return;
+	}
+	pfd.events = POLLIN;
+
+	/*
+	 * Each wake up is measured against its own deadline, one period
+	 * after the previous wake up, so that one late wake up does not
+	 * count against all of the following ones.
+	 */
+	memset(&tmo, 0, sizeof(tmo));
+	now = rtprof_now();
+	for (i = 0; i < samples; i++) {
+		expiry = now + RTPROF_CHECK_PERIOD;
+		tmo.it_value.tv_sec = expiry / 1000000000LL;
+		tmo.it_value.tv_nsec = expiry % 1000000000LL;
+		if (timerfd_settime(pfd.fd, TFD_TIMER_ABSTIME, &tmo, NULL)) {
+			pr_err("timerfd_settime failed: %m");
+			break;
+		}
+		if (poll(&pfd, 1, -1) < 0) {
+			if (errno == EINTR)
+				break;
+			pr_err("poll failed: %m");
+			break;
+		}
+		now = rtprof_now();
+		late = now - expiry;
+		if (read(pfd.fd, &count, sizeof(count)) < 0) {
+			pr_err("read failed: %m");
+			break;
+		}
+		if (late < min)
+			min = late;
+		if (late > max)
+			max = late;
+		sum += late;
+	}
+	close(pfd.fd);
+
+	if (!i)
+		return;
+
+	pr_info("wake up latency: min %" PRId64 " avg %" PRId64
+		" max %" PRId64 " ns over %d wake ups", min, sum / i, max, i);
+	if (max > limit) {
+		pr_warning("wake up latency of %" PRId64 " ns exceeds wakeup_limit "
+			   "of %d ns, check the real time profile of the host",
+			   max, limit);
+	}
+}
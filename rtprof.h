@@ -0,0 +1,29 @@
+/**
+ * @file rtprof.h
+ * @brief Applies the real time execution profile of a program.
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#ifndef HAVE_RTPROF_H
+#define HAVE_RTPROF_H
+
+#include "config.h"
+
+/**
+ * Apply the CPU affinity, scheduling policy, memory locking, prefaulting
+ * and timer slack given by the global options of a configuration. Call
+ * this before creating any threads, so that they inherit the profile.
+ * @param cfg  The configuration of the program.
+ * @return     Zero on success, non-zero otherwise.
+ */
+int rtprof_apply(struct config *cfg);
+
+/**
+ * Measure how late the calling thread wakes up from timed sleeps, and
+ * report the result. A warning is logged when the worst wake up exceeds
+ * the configured limit. Does nothing unless wakeup_check is set.
+ * @param cfg  The configuration of the program.
+ */
+void rtprof_check(struct config *cfg);
+
+#endif
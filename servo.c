@@ -30,12 +30,43 @@
 
 #define NSEC_PER_SEC 1000000000
 
-struct servo *servo_create(struct config *cfg, enum servo_type type,
-			   int fadj, int max_ppb, int sw_ts)
+static void servo_configure(struct servo *servo, struct config *cfg,
+			    int max_ppb)
 {
 	double servo_first_step_threshold;
 	double servo_step_threshold;
 	int servo_max_frequency;
+
+	servo_step_threshold = config_get_double_id(cfg, NULL, CFG_step_threshold);
+	if (servo_step_threshold > 0.0) {
+		servo->step_threshold = servo_step_threshold * NSEC_PER_SEC;
+	} else {
+		servo->step_threshold = 0.0;
+	}
+
+	servo_first_step_threshold =
+		config_get_double_id(cfg, NULL, CFG_first_step_threshold);
+
+	if (servo_first_step_threshold > 0.0) {
+		servo->first_step_threshold =
+			servo_first_step_threshold * NSEC_PER_SEC;
+	} else {
+		servo->first_step_threshold = 0.0;
+	}
+
+	servo_max_frequency = config_get_int_id(cfg, NULL, CFG_max_frequency);
+	servo->max_frequency = max_ppb;
+	if (servo_max_frequency && servo->max_frequency > servo_max_frequency) {
+		servo->max_frequency = servo_max_frequency;
+	}
+
+	servo->offset_threshold = config_get_int_id(cfg, NULL, CFG_servo_offset_threshold);
+	servo->num_offset_values = config_get_int_id(cfg, NULL, CFG_servo_num_offset_values);
+}
+
+struct servo *servo_create(struct config *cfg, enum servo_type type,
+			   int fadj, int max_ppb, int sw_ts)
+{
 	struct servo *servo;
 
 	switch (type) {
@@ -58,37 +89,24 @@ struct servo *servo_create(struct config *cfg, enum servo_type type,
 	if (!servo)
 		return NULL;
 
-	servo_step_threshold = config_get_double(cfg, NULL, "step_threshold");
-	if (servo_step_threshold > 0.0) {
-		servo->step_threshold = servo_step_threshold * NSEC_PER_SEC;
-	} else {
-		servo->step_threshold = 0.0;
-	}
-
-	servo_first_step_threshold =
-		config_get_double(cfg, NULL, "first_step_threshold");
-
-	if (servo_first_step_threshold > 0.0) {
-		servo->first_step_threshold =
-			servo_first_step_threshold * NSEC_PER_SEC;
-	} else {
-		servo->first_step_threshold = 0.0;
-	}
-
-	servo_max_frequency = config_get_int(cfg, NULL, "max_frequency");
-	servo->max_frequency = max_ppb;
-	if (servo_max_frequency && servo->max_frequency > servo_max_frequency) {
-		servo->max_frequency = servo_max_frequency;
-	}
-
+	servo_configure(servo, cfg, max_ppb);
 	servo->first_update = 1;
-	servo->offset_threshold = config_get_int(cfg, NULL, "servo_offset_threshold");
-	servo->num_offset_values = config_get_int(cfg, NULL, "servo_num_offset_values");
 	servo->curr_offset_values = servo->num_offset_values;
 
 	return servo;
 }
 
+void servo_reconfigure(struct servo *servo, struct config *cfg, int max_ppb)
+{
+	servo_configure(servo, cfg, max_ppb);
+	if (servo->curr_offset_values > servo->num_offset_values) {
+		servo->curr_offset_values = servo->num_offset_values;
+	}
+	if (servo->reconfigure) {
+		servo->reconfigure(servo, cfg);
+	}
+}
+
 void servo_destroy(struct servo *servo)
 {
 	servo->destroy(servo);
@@ -79,6 +79,16 @@ enum servo_state {
 struct servo *servo_create(struct config *cfg, enum servo_type type,
 			   int fadj, int max_ppb, int sw_ts);
 
+/**
+ * Apply changed configuration options to a running clock servo,
+ * keeping its frequency estimate and lock state. The caller should
+ * report the sync interval again afterwards.
+ * @param servo   Pointer to a servo obtained via @ref servo_create().
+ * @param cfg     The configuration holding the new values.
+ * @param max_ppb The absolute maxinum adjustment allowed by the clock.
+ */
+void servo_reconfigure(struct servo *servo, struct config *cfg, int max_ppb);
+
 /**
  * Destroy an instance of a clock servo.
  * @param servo Pointer to a servo obtained via @ref servo_create().
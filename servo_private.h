@@ -46,6 +46,8 @@ struct servo {
 	double (*rate_ratio)(struct servo *servo);
 
 	void (*leap)(struct servo *servo, int leap);
+
+	void (*reconfigure)(struct servo *servo, struct config *cfg);
 };
 
 #endif
@@ -0,0 +1,182 @@
+/**
+ * @file simclock.c
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "missing.h"
+#include "print.h"
+#include "simclock.h"
+
+#define NS_PER_SEC	1000000000LL
+#define SIMCLOCK_MAX_ADJ	1000000 /* ppb */
+
+/*
+ * The simulated clocks have IDs of dynamic POSIX clocks, with file
+ * descriptor numbers above any real descriptor.
+ */
+#define SIMCLOCK_FD_BASE	(1 << 24)
+#define CLOCKFD_MASK		7
+
+struct simclock {
+	double drift;
+	double noise;
+	/* frequency adjustment in ppb and as written to timex.freq */
+	double freq;
+	long tx_freq;
+	/* the clock reads base_time at the monotonic time base_mono */
+	int64_t base_mono;
+	int64_t base_time;
+	unsigned int seed;
+};
+
+static struct simclock *simclocks;
+static int n_simclocks;
+
+int64_t simclock_mono(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static struct simclock *simclock_get(clockid_t clkid)
+{
+	int fd;
+
+	if ((clkid & CLOCKFD_MASK) != CLOCKFD) {
+		return NULL;
+	}
+	fd = CLOCKID_TO_FD(clkid);
+	if (fd < SIMCLOCK_FD_BASE || fd >= SIMCLOCK_FD_BASE + n_simclocks) {
+		return NULL;
+	}
+	return &simclocks[fd - SIMCLOCK_FD_BASE];
+}
+
+static int64_t simclock_at(struct simclock *s, int64_t mono)
+{
+	int64_t elapsed = mono - s->base_mono;
+
+	return s->base_time + elapsed +
+		llround(elapsed * (s->drift + s->freq) / 1e9);
+}
+
+/* Returns a normally distributed random number (Box-Muller). */
+static double simclock_gauss(struct simclock *s)
+{
+	double u1, u2;
+
+	u1 = (rand_r(&s->seed) + 1.0) / (RAND_MAX + 2.0);
+	u2 = (rand_r(&s->seed) + 1.0) / (RAND_MAX + 2.0);
+	return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+clockid_t simclock_create(double drift, double noise, int64_t offset)
+{
+	struct simclock *s;
+	struct timespec ts;
+	int fd;
+
+	s = realloc(simclocks, (n_simclocks + 1) * sizeof(*s));
+	if (!s) {
+		pr_err("low memory");
+		return CLOCK_INVALID;
+	}
+	simclocks = s;
+	s = &simclocks[n_simclocks];
+	memset(s, 0, sizeof(*s));
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	s->drift = drift;
+	s->noise = noise;
+	s->base_mono = simclock_mono();
+	s->base_time = ts.tv_sec * NS_PER_SEC + ts.tv_nsec + offset;
+	s->seed = n_simclocks + 1;
+
+	fd = SIMCLOCK_FD_BASE + n_simclocks++;
+	return FD_TO_CLOCKID(fd);
+}
+
+clockid_t simclock_open(const char *name)
+{
+	char *end;
+	long index;
+	int fd;
+
+	if (strncmp(name, SIMCLOCK_PREFIX, strlen(SIMCLOCK_PREFIX))) {
+		return CLOCK_INVALID;
+	}
+	name += strlen(SIMCLOCK_PREFIX);
+	index = strtol(name, &end, 10);
+	if (!*name || *end || index < 0 || index >= n_simclocks) {
+		return CLOCK_INVALID;
+	}
+	fd = SIMCLOCK_FD_BASE + index;
+	return FD_TO_CLOCKID(fd);
+}
+
+int simclock_is(clockid_t clkid)
+{
+	return simclock_get(clkid) ? 1 : 0;
+}
+
+int simclock_adjtime(clockid_t clkid, struct timex *tx)
+{
+	struct simclock *s = simclock_get(clkid);
+	int64_t now, step;
+
+	if (!s) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (tx->modes & ADJ_SETOFFSET) {
+		step = tx->time.tv_sec * NS_PER_SEC;
+		step += tx->modes & ADJ_NANO ?
+			tx->time.tv_usec : tx->time.tv_usec * 1000;
+		s->base_time += step;
+	}
+	if (tx->modes & ADJ_FREQUENCY) {
+		now = simclock_mono();
+		s->base_time = simclock_at(s, now);
+		s->base_mono = now;
+		s->tx_freq = tx->freq;
+		s->freq = tx->freq / 65.536;
+	}
+	if (tx->modes & ADJ_OFFSET) {
+		s->base_time += tx->modes & ADJ_NANO ?
+			tx->offset : tx->offset * 1000;
+	}
+	tx->freq = s->tx_freq;
+	tx->tolerance = (long) (SIMCLOCK_MAX_ADJ * 65.536);
+	return 0;
+}
+
+int64_t simclock_read(clockid_t clkid, int64_t mono)
+{
+	struct simclock *s = simclock_get(clkid);
+
+	return s ? simclock_at(s, mono) : 0;
+}
+
+int64_t simclock_stamp(clockid_t clkid, int64_t mono)
+{
+	struct simclock *s = simclock_get(clkid);
+
+	if (!s) {
+		return 0;
+	}
+	return simclock_at(s, mono) + llround(s->noise * simclock_gauss(s));
+}
+
+void simclock_cleanup(void)
+{
+	free(simclocks);
+	simclocks = NULL;
+	n_simclocks = 0;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file simclock.h
+ * @brief Implements simulated PTP hardware clocks.
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#ifndef HAVE_SIMCLOCK_H
+#define HAVE_SIMCLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/timex.h>
+
+/* Prefix of the device names of simulated clocks, as in "sim:0". */
+#define SIMCLOCK_PREFIX "sim:"
+
+/**
+ * Create a simulated clock. The clock runs from the monotonic system
+ * clock with a constant frequency error, and its time stamps have a
+ * normally distributed error.
+ * @param drift   The frequency error of the clock in ppb.
+ * @param noise   The standard deviation of the time stamp error in ns.
+ * @param offset  The initial offset of the clock from CLOCK_REALTIME in ns.
+ * @return        The ID of the clock, usable with the clockadj functions,
+ *                or CLOCK_INVALID on error. The device name of the Nth
+ *                created clock is "sim:N", counting from zero.
+ */
+clockid_t simclock_create(double drift, double noise, int64_t offset);
+
+/**
+ * Look up a simulated clock by its device name.
+ * @param name  The device name, for example "sim:0".
+ * @return      The ID of the clock or CLOCK_INVALID.
+ */
+clockid_t simclock_open(const char *name);
+
+/**
+ * Test whether a clock ID refers to a simulated clock.
+ * @param clkid  A clock ID.
+ * @return       One if the clock is simulated, zero otherwise.
+ */
+int simclock_is(clockid_t clkid);
+
+/**
+ * Adjust a simulated clock, like clock_adjtime(). The phase offset
+ * (ADJ_OFFSET) is applied as a step.
+ * @param clkid  The ID of a simulated clock.
+ * @param tx     The adjustment, updated with the clock's state.
+ * @return       Zero on success, -1 with errno set otherwise.
+ */
+int simclock_adjtime(clockid_t clkid, struct timex *tx);
+
+/**
+ * Read the exact time of a simulated clock.
+ * @param clkid  The ID of a simulated clock.
+ * @param mono   A time of CLOCK_MONOTONIC in ns.
+ * @return       The time of the clock at that instant in ns.
+ */
+int64_t simclock_read(clockid_t clkid, int64_t mono);
+
+/**
+ * Take a time stamp from a simulated clock, including the noise.
+ * @param clkid  The ID of a simulated clock.
+ * @param mono   A time of CLOCK_MONOTONIC in ns.
+ * @return       The time stamp in ns.
+ */
+int64_t simclock_stamp(clockid_t clkid, int64_t mono);
+
+/**
+ * Read CLOCK_MONOTONIC, the reference time of the simulation.
+ * @return  The monotonic time in ns.
+ */
+int64_t simclock_mono(void);
+
+/**
+ * Free all simulated clocks.
+ */
+void simclock_cleanup(void);
+
+#endif
@@ -0,0 +1,225 @@
+/**
+ * @file simnet.c
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/queue.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "contain.h"
+#include "interface.h"
+#include "missing.h"
+#include "print.h"
+#include "simclock.h"
+#include "simnet.h"
+#include "transport_private.h"
+
+/*
+ * Every message on the wire is preceded by the monotonic time at which
+ * it arrives. The receiver takes its time stamp from its own clock at
+ * that time, so the time stamps hold the simulated delay even though
+ * the message is delivered at once.
+ */
+struct simnet_frame {
+	int64_t rx_mono;
+};
+
+struct simnet {
+	struct transport t;
+	LIST_ENTRY(simnet) list;
+	struct address address;
+	const char *network;
+	clockid_t clkid;
+	int fd;
+	int delay;
+	int jitter;
+	unsigned int seed;
+};
+
+static LIST_HEAD(simnet_list, simnet) simnets = LIST_HEAD_INITIALIZER(simnets);
+static unsigned long dropped;
+
+static int simnet_close(struct transport *t, struct fdarray *fda)
+{
+	struct simnet *s = container_of(t, struct simnet, t);
+
+	if (s->fd < 0) {
+		return 0;
+	}
+	LIST_REMOVE(s, list);
+	close(s->fd);
+	s->fd = -1;
+	fda->fd[FD_EVENT] = -1;
+	return 0;
+}
+
+static int simnet_open(struct transport *t, struct interface *iface,
+		       struct fdarray *fda, enum timestamp_type tt)
+{
+	struct simnet *s = container_of(t, struct simnet, t);
+	const char *name = interface_name(iface);
+	char *clock;
+
+	clock = config_get_string(t->cfg, name, "sim_clock");
+	s->clkid = simclock_open(clock);
+	if (s->clkid == CLOCK_INVALID) {
+		pr_err("simnet: no simulated clock %s", clock);
+		return -1;
+	}
+	s->network = config_get_string(t->cfg, name, "sim_network");
+	s->delay = config_get_int(t->cfg, name, "sim_delay");
+	s->jitter = config_get_int(t->cfg, name, "sim_delay_jitter");
+	s->seed = s->clkid ^ s->delay;
+
+	s->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (s->fd < 0) {
+		pr_err("simnet: failed to create socket: %m");
+		return -1;
+	}
+	simnet_address(name, &s->address);
+	if (bind(s->fd, &s->address.sa, s->address.len)) {
+		pr_err("simnet: bind failed: %m");
+		close(s->fd);
+		s->fd = -1;
+		return -1;
+	}
+	LIST_INSERT_HEAD(&simnets, s, list);
+
+	fda->fd[FD_EVENT] = s->fd;
+	fda->fd[FD_GENERAL] = -1;
+	return 0;
+}
+
+static int simnet_recv(struct transport *t, int fd, void *buf, int buflen,
+		       struct address *addr, struct hw_timestamp *hwts)
+{
+	struct simnet *s = container_of(t, struct simnet, t);
+	struct simnet_frame frame;
+	struct msghdr msg;
+	struct iovec iov[2];
+	ssize_t cnt;
+
+	iov[0].iov_base = &frame;
+	iov[0].iov_len = sizeof(frame);
+	iov[1].iov_base = buf;
+	iov[1].iov_len = buflen;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+	if (addr) {
+		msg.msg_name = &addr->ss;
+		msg.msg_namelen = sizeof(addr->ss);
+	}
+
+	cnt = recvmsg(fd, &msg, MSG_DONTWAIT);
+	if (cnt < (ssize_t) sizeof(frame)) {
+		pr_err("simnet: recvmsg failed: %m");
+		return cnt < 0 ? -errno : -EBADMSG;
+	}
+	if (addr) {
+		addr->len = msg.msg_namelen;
+	}
+	hwts->ts = nanoseconds_to_tmv(simclock_stamp(s->clkid, frame.rx_mono));
+
+	return cnt - sizeof(frame);
+}
+
+static int simnet_deliver(struct simnet *s, int64_t now, void *buf, int len,
+			  struct address *addr)
+{
+	struct simnet_frame frame;
+	struct msghdr msg;
+	struct iovec iov[2];
+
+	frame.rx_mono = now + s->delay;
+	if (s->jitter) {
+		frame.rx_mono += rand_r(&s->seed) % (s->jitter + 1);
+	}
+
+	iov[0].iov_base = &frame;
+	iov[0].iov_len = sizeof(frame);
+	iov[1].iov_base = buf;
+	iov[1].iov_len = len;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &addr->sa;
+	msg.msg_namelen = addr->len;
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+
+	/* Never block, a full receiver queue drops the message. */
+	if (sendmsg(s->fd, &msg, MSG_DONTWAIT) < 0) {
+		if (errno == EAGAIN) {
+			dropped++;
+			return 0;
+		}
+		return -errno;
+	}
+	return 0;
+}
+
+static int simnet_send(struct transport *t, struct fdarray *fda,
+		       enum transport_event event, int peer, void *buf, int len,
+		       struct address *addr, struct hw_timestamp *hwts)
+{
+	struct simnet *s = container_of(t, struct simnet, t), *dst;
+	int64_t now = simclock_mono();
+	int err;
+
+	if (event != TRANS_GENERAL) {
+		hwts->ts = nanoseconds_to_tmv(simclock_stamp(s->clkid, now));
+	}
+
+	if (addr) {
+		err = simnet_deliver(s, now, buf, len, addr);
+		if (err) {
+			pr_err("simnet: sendmsg failed: %s", strerror(-err));
+			return err;
+		}
+		return len;
+	}
+
+	/* Multicast to the other ports of the network. */
+	LIST_FOREACH(dst, &simnets, list) {
+		if (dst == s || strcmp(dst->network, s->network)) {
+			continue;
+		}
+		simnet_deliver(s, now, buf, len, &dst->address);
+	}
+	return len;
+}
+
+static void simnet_release(struct transport *t)
+{
+	struct simnet *s = container_of(t, struct simnet, t);
+
+	free(s);
+}
+
+struct transport *simnet_transport_create(void)
+{
+	struct simnet *s;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return NULL;
+	s->fd = -1;
+	s->t.close   = simnet_close;
+	s->t.open    = simnet_open;
+	s->t.recv    = simnet_recv;
+	s->t.send    = simnet_send;
+	s->t.release = simnet_release;
+	return &s->t;
+}
+
+unsigned long simnet_dropped(void)
+{
+	return dropped;
+}
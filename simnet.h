@@ -0,0 +1,55 @@
+/**
+ * @file simnet.h
+ * @brief Implements a simulated network transport.
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#ifndef HAVE_SIMNET_H
+#define HAVE_SIMNET_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "address.h"
+#include "fd.h"
+#include "transport.h"
+
+/*
+ * Each simulated port has an abstract UNIX socket named by this prefix
+ * and the interface name. Unicast addresses are interface names.
+ */
+#define SIMNET_PREFIX "linuxptp-sim/"
+
+/**
+ * Fill in the address of a simulated port.
+ * @param name  The interface name of the port.
+ * @param addr  Returns the address.
+ */
+static inline void simnet_address(const char *name, struct address *addr)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sun.sun_family = AF_UNIX;
+	snprintf(addr->sun.sun_path + 1, sizeof(addr->sun.sun_path) - 1,
+		 "%s%s", SIMNET_PREFIX, name);
+	addr->len = offsetof(struct sockaddr_un, sun_path) + 1 +
+		strlen(addr->sun.sun_path + 1);
+}
+
+/**
+ * Allocate an instance of a simulated network transport. The ports
+ * using it reach the other simulated ports of the same process which
+ * have the same sim_network setting. The time stamps are taken from
+ * the simulated clock named by the sim_clock option.
+ * @return Pointer to a new transport instance on success, NULL otherwise.
+ */
+struct transport *simnet_transport_create(void);
+
+/**
+ * Obtain the number of messages which were dropped because the
+ * receiving socket was full.
+ * @return The number of dropped messages.
+ */
+unsigned long simnet_dropped(void);
+
+#endif
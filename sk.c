@@ -19,6 +19,7 @@
  */
 #include <errno.h>
 #include <time.h>
+#include <linux/filter.h>
 #include <linux/net_tstamp.h>
 #include <linux/sockios.h>
 #include <linux/ethtool.h>
@@ -34,6 +35,7 @@
 #include "address.h"
 #include "ether.h"
 #include "missing.h"
+#include "msg.h"
 #include "print.h"
 #include "sk.h"
 
@@ -325,15 +327,60 @@ int sk_interface_addr(const char *name, int family, struct address *addr)
 static short sk_events = POLLPRI;
 static short sk_revents = POLLPRI;
 
+int sk_cmsg_timestamps(struct msghdr *msg, struct hw_timestamp *hwts)
+{
+	struct timespec *sw, *ts = NULL;
+	int level, type;
+	struct cmsghdr *cm;
+
+	for (cm = CMSG_FIRSTHDR(msg); cm != NULL; cm = CMSG_NXTHDR(msg, cm)) {
+		level = cm->cmsg_level;
+		type  = cm->cmsg_type;
+		if (SOL_SOCKET == level && SO_TIMESTAMPING == type) {
+			if (cm->cmsg_len < sizeof(*ts) * 3) {
+				pr_warning("short SO_TIMESTAMPING message");
+				return -EMSGSIZE;
+			}
+			ts = (struct timespec *) CMSG_DATA(cm);
+		}
+		if (SOL_SOCKET == level && SO_TIMESTAMPNS == type) {
+			if (cm->cmsg_len < sizeof(*sw)) {
+				pr_warning("short SO_TIMESTAMPNS message");
+				return -EMSGSIZE;
+			}
+			sw = (struct timespec *) CMSG_DATA(cm);
+			hwts->sw = timespec_to_tmv(*sw);
+		}
+	}
+
+	if (!ts) {
+		memset(&hwts->ts, 0, sizeof(hwts->ts));
+		return 0;
+	}
+
+	switch (hwts->type) {
+	case TS_SOFTWARE:
+		hwts->ts = timespec_to_tmv(ts[0]);
+		break;
+	case TS_HARDWARE:
+	case TS_ONESTEP:
+	case TS_P2P1STEP:
+		hwts->ts = timespec_to_tmv(ts[2]);
+		break;
+	case TS_LEGACY_HW:
+		hwts->ts = timespec_to_tmv(ts[1]);
+		break;
+	}
+	return 0;
+}
+
 int sk_receive(int fd, void *buf, int buflen,
 	       struct address *addr, struct hw_timestamp *hwts, int flags)
 {
 	char control[256];
-	int cnt = 0, res = 0, level, type;
-	struct cmsghdr *cm;
+	int cnt = 0, err, res = 0;
 	struct iovec iov = { buf, buflen };
 	struct msghdr msg;
-	struct timespec *sw, *ts = NULL;
 
 	memset(control, 0, sizeof(control));
 	memset(&msg, 0, sizeof(msg));
@@ -366,48 +413,51 @@ int sk_receive(int fd, void *buf, int buflen,
 		pr_err("recvmsg%sfailed: %m",
 		       flags == MSG_ERRQUEUE ? " tx timestamp " : " ");
 	}
-	for (cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
-		level = cm->cmsg_level;
-		type  = cm->cmsg_type;
-		if (SOL_SOCKET == level && SO_TIMESTAMPING == type) {
-			if (cm->cmsg_len < sizeof(*ts) * 3) {
-				pr_warning("short SO_TIMESTAMPING message");
-				return -EMSGSIZE;
-			}
-			ts = (struct timespec *) CMSG_DATA(cm);
-		}
-		if (SOL_SOCKET == level && SO_TIMESTAMPNS == type) {
-			if (cm->cmsg_len < sizeof(*sw)) {
-				pr_warning("short SO_TIMESTAMPNS message");
-				return -EMSGSIZE;
-			}
-			sw = (struct timespec *) CMSG_DATA(cm);
-			hwts->sw = timespec_to_tmv(*sw);
-		}
+	err = sk_cmsg_timestamps(&msg, hwts);
+	if (err) {
+		return err;
 	}
 
 	if (addr)
 		addr->len = msg.msg_namelen;
 
-	if (!ts) {
-		memset(&hwts->ts, 0, sizeof(hwts->ts));
-		return cnt < 1 ? -errno : cnt;
-	}
+	return cnt < 1 ? -errno : cnt;
+}
 
-	switch (hwts->type) {
-	case TS_SOFTWARE:
-		hwts->ts = timespec_to_tmv(ts[0]);
-		break;
-	case TS_HARDWARE:
-	case TS_ONESTEP:
-	case TS_P2P1STEP:
-		hwts->ts = timespec_to_tmv(ts[2]);
-		break;
-	case TS_LEGACY_HW:
-		hwts->ts = timespec_to_tmv(ts[1]);
-		break;
+int sk_reuseport_steer(int fd, int offset, int shards)
+{
+	/*
+	 * The program sees the UDP payload at offset zero, and the IP
+	 * header through SKF_NET_OFF. Its result indexes the group.
+	 */
+	struct sock_filter code[] = {
+		BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, 0),
+		BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0x0f),
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, DELAY_REQ, 2, 0),
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SIGNALING, 1, 0),
+		BPF_STMT(BPF_RET | BPF_K, 0),
+		BPF_STMT(BPF_LD  | BPF_W   | BPF_ABS, SKF_NET_OFF + offset),
+		BPF_STMT(BPF_MISC | BPF_TAX, 0),
+		BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16),
+		BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+		BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, shards),
+		BPF_STMT(BPF_ALU | BPF_ADD | BPF_K, 1),
+		BPF_STMT(BPF_RET | BPF_A, 0),
+	};
+	struct sock_fprog prog = {
+		.len = sizeof(code) / sizeof(code[0]),
+		.filter = code,
+	};
+
+	if (shards < 1) {
+		return -1;
 	}
-	return cnt < 1 ? -errno : cnt;
+	if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+		       &prog, sizeof(prog))) {
+		pr_err("setsockopt SO_ATTACH_REUSEPORT_CBPF failed: %m");
+		return -1;
+	}
+	return 0;
 }
 
 int sk_set_priority(int fd, int family, uint8_t dscp)
@@ -502,6 +552,7 @@ int sk_timestamping_init(int fd, const char *device, enum timestamp_type type,
 		case TRANS_CONTROLNET:
 		case TRANS_PROFINET:
 		case TRANS_UDS:
+		case TRANS_SIM:
 			return -1;
 		}
 		err = hwts_init(fd, device, filter1, filter2, tx_type);
@@ -109,6 +109,28 @@ int sk_interface_addr(const char *name, int family, struct address *addr);
 int sk_receive(int fd, void *buf, int buflen,
 	       struct address *addr, struct hw_timestamp *hwts, int flags);
 
+/**
+ * Extract the time stamps from the control messages of a received
+ * message. The time stamp is cleared when the message has none.
+ * @param msg   The message header as filled by recvmsg(2).
+ * @param hwts  Pointer to a buffer to receive the message's time stamp.
+ * @return      Zero on success, negative error code otherwise.
+ */
+int sk_cmsg_timestamps(struct msghdr *msg, struct hw_timestamp *hwts);
+
+/**
+ * Steer the unicast Delay_Req and Signaling messages arriving on a
+ * group of sockets sharing a port with SO_REUSEPORT. Each source address
+ * goes to one of the sockets 1 to 'shards', in the order they joined the
+ * group. All other messages go to socket 0, the one which bound first.
+ * @param fd      Any socket of the group.
+ * @param offset  Offset of the last 32 bits of the source address from
+ *                the start of the IP header.
+ * @param shards  The number of sockets after the first one.
+ * @return        Zero on success, non-zero otherwise.
+ */
+int sk_reuseport_steer(int fd, int offset, int shards);
+
 /**
  * Set DSCP value for socket.
  * @param fd     An open socket.
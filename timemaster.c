@@ -31,11 +31,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
 #include <sys/stat.h>
+#include <sys/timerfd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "missing.h"
 #include "print.h"
 #include "rtnl.h"
 #include "sk.h"
@@ -47,6 +51,9 @@
 #define DEFAULT_FIRST_SHM_SEGMENT 0
 #define DEFAULT_RESTART_PROCESSES 1
 
+#define RESTART_DELAY_MIN 1
+#define RESTART_DELAY_MAX 64
+
 #define DEFAULT_NTP_PROGRAM CHRONYD
 #define DEFAULT_NTP_MINPOLL 6
 #define DEFAULT_NTP_MAXPOLL 10
@@ -111,6 +118,7 @@ struct timemaster_config {
 	char *rundir;
 	int first_shm_segment;
 	int restart_processes;
+	int sock_refclock;
 	struct program_config chronyd;
 	struct program_config ntpd;
 	struct program_config phc2sys;
@@ -393,6 +401,15 @@ static int parse_timemaster_settings(char **settings,
 			r = parse_int(value, &config->first_shm_segment);
 		} else if (!strcasecmp(name, "restart_processes")) {
 			r = parse_int(value, &config->restart_processes);
+		} else if (!strcasecmp(name, "ntp_refclock")) {
+			if (!strcasecmp(value, "shm")) {
+				config->sock_refclock = 0;
+			} else if (!strcasecmp(value, "sock")) {
+				config->sock_refclock = 1;
+			} else {
+				pr_err("unknown ntp refclock %s", value);
+				return 1;
+			}
 		} else {
 			pr_err("unknown timemaster setting %s", name);
 			return 1;
@@ -598,6 +615,11 @@ static struct timemaster_config *config_parse(char *path)
 	if (section_lines)
 		free_parray((void **)section_lines);
 
+	if (!ret && config->sock_refclock && config->ntp_program != CHRONYD) {
+		pr_err("SOCK refclock is supported only with chronyd");
+		ret = 1;
+	}
+
 	if (ret) {
 		config_destroy(config);
 		return NULL;
@@ -626,8 +648,8 @@ static char **get_ptp4l_command(struct program_config *config,
 }
 
 static char **get_phc2sys_command(struct program_config *config, int domain,
-				  int poll, int shm_segment, char *uds_path,
-				  char *message_tag)
+				  int poll, int shm_segment, char *sock_path,
+				  char *uds_path, char *message_tag)
 {
 	char **command = (char **)parray_new();
 
@@ -640,8 +662,15 @@ static char **get_phc2sys_command(struct program_config *config, int domain,
 		      xstrdup("-z"), xstrdup(uds_path),
 		      xstrdup("-t"), xstrdup(message_tag),
 		      xstrdup("-n"), string_newf("%d", domain),
-		      xstrdup("-E"), xstrdup("ntpshm"),
-		      xstrdup("-M"), string_newf("%d", shm_segment), NULL);
+		      xstrdup("-E"), xstrdup("ntpshm"), NULL);
+	if (sock_path)
+		parray_extend((void ***)&command,
+			      xstrdup("--ntpshm_socket"), xstrdup(sock_path),
+			      NULL);
+	else
+		parray_extend((void ***)&command,
+			      xstrdup("-M"), string_newf("%d", shm_segment),
+			      NULL);
 
 	return command;
 }
@@ -669,14 +698,23 @@ static void add_command(char **command, int command_group,
 	parray_append((void ***)&script->command_groups, group);
 }
 
-static void add_shm_source(int shm_segment, int poll, int dpoll, double delay,
-			   char *ntp_options, char *prefix,
-			   struct timemaster_config *config, char **ntp_config)
+static void add_shm_source(int shm_segment, char *sock_path, int poll,
+			   int dpoll, double delay, char *ntp_options,
+			   char *prefix, struct timemaster_config *config,
+			   char **ntp_config)
 {
 	char *refid = get_refid(prefix, shm_segment);
 
 	switch (config->ntp_program) {
 	case CHRONYD:
+		if (sock_path) {
+			string_appendf(ntp_config,
+				       "refclock SOCK %s poll %d refid %s "
+				       "precision 1.0e-9 delay %.1e %s\n",
+				       sock_path, poll, refid, delay,
+				       ntp_options);
+			break;
+		}
 		string_appendf(ntp_config,
 			       "refclock SHM %d poll %d dpoll %d "
 			       "refid %s precision 1.0e-9 delay %.1e %s\n",
@@ -712,7 +750,7 @@ static int add_ptp_source(struct ptp_domain *source,
 			  char **ntp_config, struct script *script)
 {
 	struct config_file *config_file;
-	char **command, *uds_path, **interfaces, *message_tag;
+	char **command, *uds_path, *sock_path, **interfaces, *message_tag;
 	char ts_interface[IF_NAMESIZE];
 	int i, j, num_interfaces, *phc, *phcs, hw_ts, sw_ts;
 	struct sk_ts_info ts_info;
@@ -809,6 +847,10 @@ static int add_ptp_source(struct ptp_domain *source,
 
 		uds_path = string_newf("%s/ptp4l.%d.socket",
 				       config->rundir, *shm_segment);
+		sock_path = NULL;
+		if (config->sock_refclock)
+			sock_path = string_newf("%s/refclock.%d.sock",
+						config->rundir, *shm_segment);
 
 		message_tag = string_newf("[%d", source->domain);
 		for (j = 0; interfaces[j]; j++)
@@ -844,8 +886,8 @@ static int add_ptp_source(struct ptp_domain *source,
 			command = get_phc2sys_command(&config->phc2sys,
 						      source->domain,
 						      source->phc2sys_poll,
-						      *shm_segment, uds_path,
-						      message_tag);
+						      *shm_segment, sock_path,
+						      uds_path, message_tag);
 			add_command(command, (*command_group)++, script);
 		} else {
 			/* SW time stamping */
@@ -854,19 +896,26 @@ static int add_ptp_source(struct ptp_domain *source,
 			add_command(command, (*command_group)++, script);
 
 			string_appendf(&config_file->content,
-				       "clock_servo ntpshm\n"
-				       "ntpshm_segment %d\n", *shm_segment);
+				       "clock_servo ntpshm\n");
+			if (sock_path)
+				string_appendf(&config_file->content,
+					       "ntpshm_socket %s\n", sock_path);
+			else
+				string_appendf(&config_file->content,
+					       "ntpshm_segment %d\n",
+					       *shm_segment);
 		}
 
 		parray_append((void ***)&script->configs, config_file);
 
-		add_shm_source(*shm_segment, source->ntp_poll,
+		add_shm_source(*shm_segment, sock_path, source->ntp_poll,
 			       source->phc2sys_poll, source->delay,
 			       source->ntp_options, "PTP", config, ntp_config);
 
 		(*shm_segment)++;
 
 		free(message_tag);
+		free(sock_path);
 		free(uds_path);
 		free(interfaces);
 	}
@@ -1111,13 +1160,125 @@ static int remove_config_files(struct config_file **configs)
 	return 0;
 }
 
+struct child {
+	pid_t pid;
+	int pidfd;
+	int group;
+	/* 1 if a restart is scheduled, -1 if it is yet to be scheduled */
+	int pending;
+	unsigned int restarts;
+	/* number of terminations shortly after the start in a row */
+	unsigned int failures;
+	struct timespec started;
+	struct timespec restart_at;
+};
+
+static int child_start(struct child *child, char **command, sigset_t *mask,
+		       int efd)
+{
+	struct epoll_event event;
+
+	child->pid = start_program(command, mask);
+	if (!child->pid)
+		return 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &child->started);
+	child->pending = 0;
+
+	/* Without pidfds the child is reaped on SIGCHLD. */
+	child->pidfd = syscall(__NR_pidfd_open, child->pid, 0);
+	if (child->pidfd < 0) {
+		pr_debug("pidfd_open() failed: %m");
+		return 0;
+	}
+
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = child->pidfd;
+	if (epoll_ctl(efd, EPOLL_CTL_ADD, child->pidfd, &event) < 0) {
+		pr_debug("epoll_ctl() failed: %m");
+		close(child->pidfd);
+		child->pidfd = -1;
+	}
+
+	return 0;
+}
+
+static int child_reap(struct child *child, int *status)
+{
+	pid_t pid;
+
+	pid = waitpid(child->pid, status, WNOHANG);
+	if (pid <= 0)
+		return 0;
+
+	if (!WIFEXITED(*status)) {
+		pr_info("process %d terminated abnormally", pid);
+	} else {
+		pr_info("process %d terminated with status %d",
+			pid, WEXITSTATUS(*status));
+	}
+
+	if (child->pidfd >= 0) {
+		close(child->pidfd);
+		child->pidfd = -1;
+	}
+	child->pid = 0;
+
+	return 1;
+}
+
+static void children_status(struct child *children, char ***commands,
+			    int num_commands, struct timespec *now)
+{
+	int i;
+
+	for (i = 0; i < num_commands; i++) {
+		if (children[i].pid) {
+			pr_info("process %d (%s): restarts %u uptime %ld s",
+				children[i].pid, commands[i][0],
+				children[i].restarts,
+				(long)(now->tv_sec - children[i].started.tv_sec));
+		} else {
+			pr_info("%s: restarts %u, not running",
+				commands[i][0], children[i].restarts);
+		}
+	}
+}
+
+static void arm_restart_timer(int tfd, struct child *children,
+			      int num_commands)
+{
+	struct itimerspec its;
+	struct timespec *next = NULL;
+	int i;
+
+	for (i = 0; i < num_commands; i++) {
+		if (!children[i].pending)
+			continue;
+		if (!next || children[i].restart_at.tv_sec < next->tv_sec)
+			next = &children[i].restart_at;
+	}
+
+	memset(&its, 0, sizeof(its));
+	if (next)
+		its.it_value = *next;
+
+	if (timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL) < 0)
+		pr_err("timerfd_settime() failed: %m");
+}
+
 static int script_run(struct script *script)
 {
 	struct timespec ts_start, ts_now;
+	struct epoll_event event, events[16];
+	struct signalfd_siginfo info;
 	sigset_t mask, old_mask;
-	siginfo_t info;
-	pid_t pid, *pids;
-	int i, group, num_commands, status, quit = 0, ret = 0;
+	struct child *children;
+	unsigned int delay;
+	uint64_t expirations;
+	int i, j, n, num_commands, status, running, quit = 0, ret = 0;
+	int efd, sfd, tfd;
 
 	for (num_commands = 0; script->commands[num_commands]; num_commands++)
 		;
@@ -1135,6 +1296,7 @@ static int script_run(struct script *script)
 	sigaddset(&mask, SIGTERM);
 	sigaddset(&mask, SIGQUIT);
 	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGUSR1);
 
 	/* block the signals */
 	if (sigprocmask(SIG_BLOCK, &mask, &old_mask) < 0) {
@@ -1142,11 +1304,41 @@ static int script_run(struct script *script)
 		return 1;
 	}
 
-	pids = xcalloc(num_commands, sizeof(*pids));
+	sfd = signalfd(-1, &mask, SFD_CLOEXEC);
+	if (sfd < 0) {
+		pr_err("signalfd() failed: %m");
+		return 1;
+	}
+	tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	if (tfd < 0) {
+		pr_err("timerfd_create() failed: %m");
+		close(sfd);
+		return 1;
+	}
+	efd = epoll_create1(EPOLL_CLOEXEC);
+	if (efd < 0) {
+		pr_err("epoll_create1() failed: %m");
+		close(tfd);
+		close(sfd);
+		return 1;
+	}
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = sfd;
+	epoll_ctl(efd, EPOLL_CTL_ADD, sfd, &event);
+	event.data.fd = tfd;
+	epoll_ctl(efd, EPOLL_CTL_ADD, tfd, &event);
+
+	children = xcalloc(num_commands, sizeof(*children));
+
+	for (i = 0; i < num_commands; i++) {
+		children[i].pidfd = -1;
+		children[i].group = *(script->command_groups[i]);
+	}
 
 	for (i = 0; i < num_commands; i++) {
-		pids[i] = start_program(script->commands[i], &old_mask);
-		if (!pids[i]) {
+		if (child_start(&children[i], script->commands[i], &old_mask,
+				efd)) {
 			kill(getpid(), SIGTERM);
 			break;
 		}
@@ -1154,124 +1346,154 @@ static int script_run(struct script *script)
 
 	clock_gettime(CLOCK_MONOTONIC, &ts_start);
 
-	/* process the blocked signals */
 	while (1) {
-		if (sigwaitinfo(&mask, &info) < 0) {
+		if (quit) {
+			for (running = 0, i = 0; i < num_commands; i++) {
+				if (children[i].pid)
+					running++;
+			}
+			if (!running)
+				break;
+		}
+
+		n = epoll_wait(efd, events, 16, -1);
+		if (n < 0) {
 			if (errno == EINTR)
 				continue;
-			pr_err("sigwaitinfo() failed: %m");
+			pr_err("epoll_wait() failed: %m");
 			break;
 		}
 
 		clock_gettime(CLOCK_MONOTONIC, &ts_now);
 
-		if (info.si_signo != SIGCHLD) {
-			if (quit)
-				continue;
-
-			quit = 1;
-			pr_debug("exiting on signal %d", info.si_signo);
+		for (j = 0; j < n; j++) {
+			if (events[j].data.fd == sfd) {
+				if (read(sfd, &info, sizeof(info)) !=
+				    sizeof(info))
+					continue;
 
-			/* terminate remaining processes */
-			for (i = 0; i < num_commands; i++) {
-				if (pids[i] > 0) {
-					pr_debug("killing process %d", pids[i]);
-					kill(pids[i], SIGTERM);
+				if (info.ssi_signo == SIGUSR1) {
+					children_status(children,
+							script->commands,
+							num_commands, &ts_now);
+					continue;
 				}
-			}
 
-			continue;
-		}
+				if (info.ssi_signo != SIGCHLD) {
+					if (quit)
+						continue;
+
+					quit = 1;
+					pr_debug("exiting on signal %d",
+						 info.ssi_signo);
+
+					/* terminate remaining processes */
+					for (i = 0; i < num_commands; i++) {
+						children[i].pending = 0;
+						if (children[i].pid > 0) {
+							pr_debug("killing process %d",
+								 children[i].pid);
+							kill(children[i].pid, SIGTERM);
+						}
+					}
+					continue;
+				}
 
-		/* wait for all terminated processes */
-		while (1) {
-			pid = waitpid(-1, &status, WNOHANG);
-			if (pid <= 0)
-				break;
+				/* reap processes which have no pidfd */
+				for (i = 0; i < num_commands; i++) {
+					if (children[i].pid &&
+					    children[i].pidfd < 0 &&
+					    child_reap(&children[i], &status))
+						children[i].pending = -1;
+				}
+			} else if (events[j].data.fd == tfd) {
+				if (read(tfd, &expirations,
+					 sizeof(expirations)) < 0)
+					continue;
 
-			if (!WIFEXITED(status)) {
-				pr_info("process %d terminated abnormally",
-					pid);
+				for (i = 0; i < num_commands; i++) {
+					if (!children[i].pending ||
+					    children[i].restart_at.tv_sec >
+					    ts_now.tv_sec)
+						continue;
+
+					children[i].restarts++;
+					if (child_start(&children[i],
+							script->commands[i],
+							&old_mask, efd)) {
+						children[i].pending = 0;
+						kill(getpid(), SIGTERM);
+					}
+				}
 			} else {
-				pr_info("process %d terminated with status %d",
-					pid, WEXITSTATUS(status));
-			}
-
-			for (i = 0; i < num_commands; i++) {
-				if (pids[i] == pid)
-					pids[i] = 0;
+				for (i = 0; i < num_commands; i++) {
+					if (children[i].pid &&
+					    children[i].pidfd ==
+					    events[j].data.fd &&
+					    child_reap(&children[i], &status))
+						children[i].pending = -1;
+				}
 			}
 		}
 
-		/* wait for all processes to terminate when exiting */
-		if (quit) {
-			for (i = 0; i < num_commands; i++) {
-				if (pids[i])
-					break;
-			}
-			if (i == num_commands)
-				break;
-
-			pr_debug("waiting for other processes to terminate");
-			continue;
-		}
-
-		/*
-		 * terminate (and then restart if allowed) all processes in
-		 * groups that have a terminated process
-		 */
-		for (group = 0; group < num_commands; group++) {
-			int terminated = 0, running = 0;
+		/* schedule a restart of the terminated processes */
+		for (i = 0; i < num_commands; i++) {
+			if (children[i].pending >= 0)
+				continue;
 
-			for (i = 0; i < num_commands; i++) {
-				if (*(script->command_groups[i]) != group)
-					continue;
-				if (pids[i])
-					running++;
-				else
-					terminated++;
-			}
+			children[i].pending = 0;
 
-			if (!terminated)
+			if (quit)
 				continue;
 
 			/*
-			 * exit with a non-zero status if the group should not
-			 * be restarted (i.e. chronyd/ntpd), timemaster is
+			 * exit with a non-zero status if the process should
+			 * not be restarted (i.e. chronyd/ntpd), timemaster is
 			 * running only for a short time (and it is likely a
 			 * configuration error), or restarting is disabled
 			 * completely
 			 */
-			if (group == script->no_restart_group ||
+			if (children[i].group == script->no_restart_group ||
 			    ts_now.tv_sec - ts_start.tv_sec <= 1 ||
 			    !script->restart_groups) {
 				kill(getpid(), SIGTERM);
 				ret = 1;
-				break;
+				continue;
 			}
 
-			for (i = 0; i < num_commands; i++) {
-				if (*(script->command_groups[i]) != group)
-					continue;
-
-				/* terminate all processes in the group first */
-				if (running && pids[i]) {
-					pr_debug("killing process %d", pids[i]);
-					kill(pids[i], SIGTERM);
-				} else if (!running && !pids[i]) {
-					pids[i] = start_program(script->commands[i],
-								&old_mask);
-					if (!pids[i])
-						kill(getpid(), SIGTERM);
-
-					/* limit restarting rate */
-					sleep(1);
-				}
-			}
+			/*
+			 * restart only the terminated process, waiting longer
+			 * each time it fails again shortly after the start
+			 */
+			if (ts_now.tv_sec - children[i].started.tv_sec >=
+			    RESTART_DELAY_MAX)
+				children[i].failures = 0;
+
+			delay = RESTART_DELAY_MIN << children[i].failures;
+			if (delay < RESTART_DELAY_MAX)
+				children[i].failures++;
+			else
+				delay = RESTART_DELAY_MAX;
+
+			pr_info("restarting %s in %u seconds",
+				script->commands[i][0], delay);
+
+			children[i].restart_at = ts_now;
+			children[i].restart_at.tv_sec += delay;
+			children[i].pending = 1;
 		}
+
+		arm_restart_timer(tfd, children, num_commands);
 	}
 
-	free(pids);
+	for (i = 0; i < num_commands; i++) {
+		if (children[i].pidfd >= 0)
+			close(children[i].pidfd);
+	}
+	free(children);
+	close(efd);
+	close(tfd);
+	close(sfd);
 
 	if (remove_config_files(script->configs))
 		return 1;
@@ -76,7 +76,7 @@ static uint16_t flip16(uint16_t *p)
 	return v;
 }
 
-static int64_t host2net64_unaligned(int64_t *p)
+static int64_t host2net64_unaligned(void *p)
 {
 	int64_t v;
 	memcpy(&v, p, sizeof(v));
@@ -85,7 +85,7 @@ static int64_t host2net64_unaligned(int64_t *p)
 	return v;
 }
 
-static int64_t net2host64_unaligned(int64_t *p)
+static int64_t net2host64_unaligned(void *p)
 {
 	int64_t v;
 	memcpy(&v, p, sizeof(v));
@@ -124,6 +124,8 @@ static int mgt_post_recv(struct management_tlv *m, uint16_t data_len,
 	struct subscribe_events_np *sen;
 	struct port_properties_np *ppn;
 	struct port_stats_np *psn;
+	struct latency_stats_np *lsn;
+	struct snapshot_np *snp;
 	struct mgmt_clock_description *cd;
 	int extra_len = 0, len;
 	uint8_t *buf;
@@ -326,6 +328,24 @@ static int mgt_post_recv(struct management_tlv *m, uint16_t data_len,
 			ntohs(psn->portIdentity.portNumber);
 		extra_len = sizeof(struct port_stats_np);
 		break;
+	case TLV_LATENCY_STATS_NP:
+		if (data_len < sizeof(struct latency_stats_np))
+			goto bad_length;
+		lsn = (struct latency_stats_np *)m->data;
+		lsn->portIdentity.portNumber =
+			ntohs(lsn->portIdentity.portNumber);
+		lsn->numberStages = ntohs(lsn->numberStages);
+		extra_len = sizeof(struct latency_stats_np);
+		extra_len += lsn->numberStages * sizeof(lsn->stage[0]);
+		break;
+	case TLV_SNAPSHOT_NP:
+		if (data_len != sizeof(struct snapshot_np))
+			goto bad_length;
+		snp = (struct snapshot_np *) m->data;
+		snp->fragment = ntohs(snp->fragment);
+		snp->lastFragment = ntohs(snp->lastFragment);
+		snp->numberPorts = ntohs(snp->numberPorts);
+		break;
 	case TLV_SAVE_IN_NON_VOLATILE_STORAGE:
 	case TLV_RESET_NON_VOLATILE_STORAGE:
 	case TLV_INITIALIZE:
@@ -360,6 +380,8 @@ static void mgt_pre_send(struct management_tlv *m, struct tlv_extra *extra)
 	struct subscribe_events_np *sen;
 	struct port_properties_np *ppn;
 	struct port_stats_np *psn;
+	struct latency_stats_np *lsn;
+	struct snapshot_np *snp;
 	struct mgmt_clock_description *cd;
 	switch (m->id) {
 	case TLV_CLOCK_DESCRIPTION:
@@ -437,6 +459,18 @@ static void mgt_pre_send(struct management_tlv *m, struct tlv_extra *extra)
 		psn->portIdentity.portNumber =
 			htons(psn->portIdentity.portNumber);
 		break;
+	case TLV_LATENCY_STATS_NP:
+		lsn = (struct latency_stats_np *)m->data;
+		lsn->portIdentity.portNumber =
+			htons(lsn->portIdentity.portNumber);
+		lsn->numberStages = htons(lsn->numberStages);
+		break;
+	case TLV_SNAPSHOT_NP:
+		snp = (struct snapshot_np *) m->data;
+		snp->fragment = htons(snp->fragment);
+		snp->lastFragment = htons(snp->lastFragment);
+		snp->numberPorts = htons(snp->numberPorts);
+		break;
 	}
 }
 
@@ -694,6 +728,55 @@ static void slave_rx_sync_timing_data_pre_send(struct tlv_extra *extra)
 	}
 }
 
+static int slave_servo_data_post_revc(struct tlv_extra *extra)
+{
+	struct slave_servo_data_tlv *slave_servo =
+		(struct slave_servo_data_tlv *) extra->tlv;
+	size_t base_size = sizeof(slave_servo->sourcePortIdentity), n_items;
+	struct slave_servo_record *record;
+
+	if (tlv_array_invalid(extra->tlv, base_size, sizeof(*record))) {
+		return -EBADMSG;
+	}
+	n_items = tlv_array_count(extra->tlv, base_size, sizeof(*record));
+	record = slave_servo->record;
+
+	NTOHS(slave_servo->sourcePortIdentity.portNumber);
+
+	while (n_items) {
+		timestamp_net2host(&record->syncEventIngressTimestamp);
+		net2host64_unaligned(&record->offsetFromMaster);
+		net2host64_unaligned(&record->meanPathDelay);
+		net2host64_unaligned(&record->scaledFrequencyAdjustment);
+		n_items--;
+		record++;
+	}
+
+	return 0;
+}
+
+static void slave_servo_data_pre_send(struct tlv_extra *extra)
+{
+	struct slave_servo_data_tlv *slave_servo =
+		(struct slave_servo_data_tlv *) extra->tlv;
+	size_t base_size = sizeof(slave_servo->sourcePortIdentity), n_items;
+	struct slave_servo_record *record;
+
+	n_items = tlv_array_count(extra->tlv, base_size, sizeof(*record));
+	record = slave_servo->record;
+
+	HTONS(slave_servo->sourcePortIdentity.portNumber);
+
+	while (n_items) {
+		timestamp_host2net(&record->syncEventIngressTimestamp);
+		host2net64_unaligned(&record->offsetFromMaster);
+		host2net64_unaligned(&record->meanPathDelay);
+		host2net64_unaligned(&record->scaledFrequencyAdjustment);
+		n_items--;
+		record++;
+	}
+}
+
 static int unicast_message_type_valid(uint8_t message_type)
 {
 	message_type >>= 4;
@@ -872,6 +955,9 @@ int tlv_post_recv(struct tlv_extra *extra)
 	case TLV_SLAVE_DELAY_TIMING_DATA_NP:
 		result = slave_delay_timing_data_post_revc(extra);
 		break;
+	case TLV_SLAVE_SERVO_DATA_NP:
+		result = slave_servo_data_post_revc(extra);
+		break;
 	case TLV_CUMULATIVE_RATE_RATIO:
 	case TLV_PAD:
 	case TLV_AUTHENTICATION:
@@ -936,6 +1022,9 @@ void tlv_pre_send(struct TLV *tlv, struct tlv_extra *extra)
 	case TLV_SLAVE_DELAY_TIMING_DATA_NP:
 		slave_delay_timing_data_pre_send(extra);
 		break;
+	case TLV_SLAVE_SERVO_DATA_NP:
+		slave_servo_data_pre_send(extra);
+		break;
 	case TLV_CUMULATIVE_RATE_RATIO:
 	case TLV_PAD:
 	case TLV_AUTHENTICATION:
@@ -51,6 +51,7 @@
 #define TLV_SLAVE_RX_SYNC_COMPUTED_DATA			0x8005
 #define TLV_SLAVE_TX_EVENT_TIMESTAMPS			0x8006
 #define TLV_SLAVE_DELAY_TIMING_DATA_NP			0x7F00
+#define TLV_SLAVE_SERVO_DATA_NP				0x7F01
 #define TLV_CUMULATIVE_RATE_RATIO			0x8007
 #define TLV_PAD						0x8008
 #define TLV_AUTHENTICATION				0x8009
@@ -100,6 +101,8 @@ enum management_action {
 #define TLV_GRANDMASTER_SETTINGS_NP			0xC001
 #define TLV_SUBSCRIBE_EVENTS_NP				0xC003
 #define TLV_SYNCHRONIZATION_UNCERTAIN_NP		0xC006
+#define TLV_SNAPSHOT_NP					0xC007
+#define TLV_RELOAD_CONFIG_NP				0xC008
 
 /* Port management ID values */
 #define TLV_NULL_MANAGEMENT				0x0000
@@ -125,6 +128,7 @@ enum management_action {
 #define TLV_PORT_DATA_SET_NP				0xC002
 #define TLV_PORT_PROPERTIES_NP				0xC004
 #define TLV_PORT_STATS_NP				0xC005
+#define TLV_LATENCY_STATS_NP				0xC009
 
 /* Management error ID values */
 #define TLV_RESPONSE_TOO_BIG				0x0001
@@ -277,6 +281,27 @@ struct slave_rx_sync_timing_data_tlv {
 	  sizeof(struct slave_rx_sync_timing_data_tlv)) /		\
 	 sizeof(struct slave_rx_sync_timing_record))
 
+struct slave_servo_record {
+	struct Timestamp    syncEventIngressTimestamp;
+	TimeInterval        offsetFromMaster;
+	TimeInterval        meanPathDelay;
+	Integer64           scaledFrequencyAdjustment; /* ppb * 2^16 */
+	UInteger8           servoState;
+	UInteger8           reserved;
+} PACKED;
+
+struct slave_servo_data_tlv {
+	Enumeration16        type;
+	UInteger16           length;
+	struct PortIdentity  sourcePortIdentity;
+	struct slave_servo_record record[0];
+} PACKED;
+
+#define SLAVE_SERVO_MAX \
+	((sizeof(struct message_data) - sizeof(struct signaling_msg) -	\
+	  sizeof(struct slave_servo_data_tlv)) /			\
+	 sizeof(struct slave_servo_record))
+
 typedef struct Integer96 {
 	uint16_t nanoseconds_msb;
 	uint64_t nanoseconds_lsb;
@@ -349,6 +374,39 @@ struct port_stats_np {
 	struct PortStats stats;
 } PACKED;
 
+/*
+ * The latencies of the hot path stages in ns, see latency.h. Like the
+ * counters of PORT_STATS_NP, the fields of a stage are in host order.
+ */
+struct latency_stage_np {
+	uint64_t count;
+	uint32_t min;
+	uint32_t mean;
+	uint32_t p50;
+	uint32_t p99;
+	uint32_t max;
+	uint32_t reserved;
+} PACKED;
+
+struct latency_stats_np {
+	struct PortIdentity portIdentity;
+	UInteger16 numberStages;
+	UInteger16 reserved;
+	struct latency_stage_np stage[0];
+} PACKED;
+
+/*
+ * A SNAPSHOT_NP response carries this TLV first, followed by the clock
+ * and port data sets as separate management TLVs. Large snapshots are
+ * split over several responses sharing the same sequenceId.
+ */
+struct snapshot_np {
+	UInteger16    fragment;    /* index of this response, from zero */
+	UInteger16    lastFragment; /* non-zero in the final response */
+	UInteger16    numberPorts;
+	UInteger16    reserved;
+} PACKED;
+
 #define PROFILE_ID_LEN 6
 
 struct mgmt_clock_description {
@@ -0,0 +1,248 @@
+/**
+ * @file tmo.c
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "missing.h"
+#include "print.h"
+#include "tmo.h"
+
+#define NS_PER_SEC 1000000000LL
+#define TMO_INITIAL_SIZE 64
+
+#define parent(x)	(((x) - 1) / 2)
+#define left(x)		(2 * (x) + 1)
+
+/*
+ * A binary min-heap of the armed timers, ordered by the expiration
+ * time and then by the order of arming. Each timer knows its position,
+ * so that it can be re-armed or cleared without a search.
+ */
+struct tmo_heap {
+	struct tmo **data;
+	int len;
+	int max;
+	int fd;
+	int64_t programmed;	/* expiration time of the timerfd, or zero */
+	uint64_t seq;
+};
+
+static int tmo_before(struct tmo *a, struct tmo *b)
+{
+	if (a->expiry != b->expiry) {
+		return a->expiry < b->expiry;
+	}
+	return a->seq < b->seq;
+}
+
+static void tmo_place(struct tmo_heap *h, struct tmo *t, int pos)
+{
+	h->data[pos] = t;
+	t->pos = pos;
+}
+
+static void tmo_sift_up(struct tmo_heap *h, int pos)
+{
+	struct tmo *t = h->data[pos];
+
+	while (pos && tmo_before(t, h->data[parent(pos)])) {
+		tmo_place(h, h->data[parent(pos)], pos);
+		pos = parent(pos);
+	}
+	tmo_place(h, t, pos);
+}
+
+static void tmo_sift_down(struct tmo_heap *h, int pos)
+{
+	struct tmo *t = h->data[pos];
+	int child;
+
+	while ((child = left(pos)) < h->len) {
+		if (child + 1 < h->len &&
+		    tmo_before(h->data[child + 1], h->data[child])) {
+			child++;
+		}
+		if (!tmo_before(h->data[child], t)) {
+			break;
+		}
+		tmo_place(h, h->data[child], pos);
+		pos = child;
+	}
+	tmo_place(h, t, pos);
+}
+
+static void tmo_remove(struct tmo_heap *h, struct tmo *t)
+{
+	int pos = t->pos;
+	struct tmo *last;
+
+	t->pos = -1;
+	last = h->data[--h->len];
+	if (last == t) {
+		return;
+	}
+	tmo_place(h, last, pos);
+	if (pos && tmo_before(last, h->data[parent(pos)])) {
+		tmo_sift_up(h, pos);
+	} else {
+		tmo_sift_down(h, pos);
+	}
+}
+
+static int tmo_insert(struct tmo_heap *h, struct tmo *t)
+{
+	struct tmo **data;
+	int max;
+
+	if (h->len == h->max) {
+		max = h->max ? 2 * h->max : TMO_INITIAL_SIZE;
+		data = realloc(h->data, max * sizeof(*data));
+		if (!data) {
+			pr_err("low memory");
+			return -1;
+		}
+		h->data = data;
+		h->max = max;
+	}
+	tmo_place(h, t, h->len++);
+	tmo_sift_up(h, t->pos);
+	return 0;
+}
+
+struct tmo_heap *tmo_heap_create(void)
+{
+	struct tmo_heap *h;
+
+	h = calloc(1, sizeof(*h));
+	if (!h) {
+		return NULL;
+	}
+	h->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (h->fd < 0) {
+		pr_err("timerfd_create: %m");
+		free(h);
+		return NULL;
+	}
+	return h;
+}
+
+void tmo_heap_destroy(struct tmo_heap *h)
+{
+	close(h->fd);
+	free(h->data);
+	free(h);
+}
+
+int tmo_heap_fd(struct tmo_heap *h)
+{
+	return h->fd;
+}
+
+int tmo_heap_update(struct tmo_heap *h)
+{
+	struct itimerspec tmo = {
+		{0, 0}, {0, 0}
+	};
+	int64_t expiry;
+
+	if (!h->len) {
+		return 0;
+	}
+	expiry = h->data[0]->expiry;
+	if (h->programmed && h->programmed <= expiry) {
+		return 0;
+	}
+	tmo.it_value.tv_sec = expiry / NS_PER_SEC;
+	tmo.it_value.tv_nsec = expiry % NS_PER_SEC;
+	if (timerfd_settime(h->fd, TFD_TIMER_ABSTIME, &tmo, NULL)) {
+		pr_err("timerfd_settime: %m");
+		return -1;
+	}
+	h->programmed = expiry;
+	return 0;
+}
+
+void tmo_heap_acknowledge(struct tmo_heap *h)
+{
+	uint64_t expirations;
+
+	if (read(h->fd, &expirations, sizeof(expirations)) < 0 &&
+	    errno != EAGAIN) {
+		pr_err("timerfd read: %m");
+	}
+	h->programmed = 0;
+}
+
+struct tmo *tmo_heap_expired(struct tmo_heap *h, int64_t now)
+{
+	struct tmo *t;
+
+	if (!h->len || h->data[0]->expiry > now) {
+		return NULL;
+	}
+	t = h->data[0];
+	tmo_remove(h, t);
+	return t;
+}
+
+int64_t tmo_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+void tmo_init(struct tmo *t, struct tmo_heap *h, void *owner, int id)
+{
+	t->heap = h;
+	t->owner = owner;
+	t->id = id;
+	t->pos = -1;
+	t->expiry = 0;
+	t->seq = 0;
+}
+
+int tmo_arm(struct tmo *t, int64_t ns)
+{
+	if (!ns) {
+		tmo_clear(t);
+		return 0;
+	}
+	return tmo_arm_abs(t, tmo_now() + ns);
+}
+
+int tmo_arm_abs(struct tmo *t, int64_t expiry)
+{
+	struct tmo_heap *h = t->heap;
+	int64_t old = t->expiry;
+
+	if (!expiry) {
+		tmo_clear(t);
+		return 0;
+	}
+	t->expiry = expiry;
+	t->seq = h->seq++;
+	if (!tmo_armed(t)) {
+		return tmo_insert(h, t);
+	}
+	if (expiry < old) {
+		tmo_sift_up(h, t->pos);
+	} else {
+		tmo_sift_down(h, t->pos);
+	}
+	return 0;
+}
+
+void tmo_clear(struct tmo *t)
+{
+	if (tmo_armed(t)) {
+		tmo_remove(t->heap, t);
+	}
+}
@@ -0,0 +1,139 @@
+/**
+ * @file tmo.h
+ * @brief Implements many timers on top of a single timerfd.
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#ifndef HAVE_TMO_H
+#define HAVE_TMO_H
+
+#include <stdint.h>
+
+struct tmo_heap;
+
+/*
+ * One timer, usually embedded in the object which it belongs to.
+ * The fields are private to tmo.c.
+ */
+struct tmo {
+	struct tmo_heap *heap;
+	void *owner;
+	int id;
+	int pos;		/* index in the heap, or -1 when not armed */
+	int64_t expiry;		/* CLOCK_MONOTONIC in ns */
+	uint64_t seq;		/* orders timers which expire at once */
+};
+
+/**
+ * Create a heap of timers and the timerfd which drives it.
+ * @return  A pointer to a new heap on success, NULL otherwise.
+ */
+struct tmo_heap *tmo_heap_create(void);
+
+/**
+ * Destroy a heap of timers. The timers must no longer be used.
+ * @param h  A heap obtained via tmo_heap_create().
+ */
+void tmo_heap_destroy(struct tmo_heap *h);
+
+/**
+ * Obtain the file descriptor to poll for the expiration of the timers.
+ * @param h  A heap obtained via tmo_heap_create().
+ * @return   The descriptor of the timerfd.
+ */
+int tmo_heap_fd(struct tmo_heap *h);
+
+/**
+ * Program the timerfd for the earliest timer, if needed. Call this
+ * before polling. The timerfd is only reprogrammed when a timer expires
+ * before the time already programmed, so that re-arming a timer does
+ * not cost a system call. A timer pushed further out causes at most
+ * one early wake up, which finds nothing to do.
+ * @param h  A heap obtained via tmo_heap_create().
+ * @return   Zero on success, non-zero otherwise.
+ */
+int tmo_heap_update(struct tmo_heap *h);
+
+/**
+ * Acknowledge the readable timerfd. Call this when the poll reports it.
+ * @param h  A heap obtained via tmo_heap_create().
+ */
+void tmo_heap_acknowledge(struct tmo_heap *h);
+
+/**
+ * Remove the timer which expires first, if it expired.
+ * @param h    A heap obtained via tmo_heap_create().
+ * @param now  The current time from tmo_now().
+ * @return     The expired timer, or NULL if none expired by 'now'.
+ */
+struct tmo *tmo_heap_expired(struct tmo_heap *h, int64_t now);
+
+/**
+ * Read the clock of the timers.
+ * @return  The CLOCK_MONOTONIC time in ns.
+ */
+int64_t tmo_now(void);
+
+/**
+ * Initialize a timer. The timer is not armed.
+ * @param t      The timer to initialize.
+ * @param h      The heap which drives the timer.
+ * @param owner  The object to which the timer belongs.
+ * @param id     Identifies the timer among those of the owner.
+ */
+void tmo_init(struct tmo *t, struct tmo_heap *h, void *owner, int id);
+
+/**
+ * Arm a timer, replacing any earlier expiration time. Like a timerfd,
+ * a zero interval disarms the timer.
+ * @param t   The timer.
+ * @param ns  The interval in ns from now.
+ * @return    Zero on success, non-zero otherwise.
+ */
+int tmo_arm(struct tmo *t, int64_t ns);
+
+/**
+ * Arm a timer at an absolute time. A zero time disarms the timer.
+ * @param t       The timer.
+ * @param expiry  The CLOCK_MONOTONIC time in ns.
+ * @return        Zero on success, non-zero otherwise.
+ */
+int tmo_arm_abs(struct tmo *t, int64_t expiry);
+
+/**
+ * Disarm a timer.
+ * @param t  The timer.
+ */
+void tmo_clear(struct tmo *t);
+
+/**
+ * Find out whether a timer is armed.
+ * @param t  The timer.
+ * @return   One if the timer is armed, zero otherwise.
+ */
+static inline int tmo_armed(struct tmo *t)
+{
+	return t->pos >= 0;
+}
+
+/**
+ * Obtain the owner of a timer.
+ * @param t  The timer.
+ * @return   The owner passed to tmo_init().
+ */
+static inline void *tmo_owner(struct tmo *t)
+{
+	return t->owner;
+}
+
+/**
+ * Obtain the identifier of a timer.
+ * @param t  The timer.
+ * @return   The id passed to tmo_init().
+ */
+static inline int tmo_id(struct tmo *t)
+{
+	return t->id;
+}
+
+#endif
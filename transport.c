@@ -18,27 +18,87 @@
  */
 
 #include <arpa/inet.h>
+#include <errno.h>
 
+#include "print.h"
+#include "sk.h"
 #include "transport.h"
 #include "transport_private.h"
 #include "raw.h"
 #include "udp.h"
 #include "udp6.h"
 #include "uds.h"
+#include "uring.h"
+
+/* Find the sockets behind the descriptors which the caller knows. */
+static struct fdarray *transport_sockets(struct transport *t,
+					 struct fdarray *fda)
+{
+	return t->uring && fda == t->uring_fda ? &t->sockets : fda;
+}
+
+static int transport_uring_owns(struct transport *t, int fd)
+{
+	return t->uring && (fd == t->sockets.fd[FD_EVENT] ||
+			    fd == t->sockets.fd[FD_GENERAL]);
+}
 
 int transport_close(struct transport *t, struct fdarray *fda)
 {
+	if (t->uring && fda == t->uring_fda) {
+		uring_destroy(t->uring);
+		t->uring = NULL;
+		t->uring_fda = NULL;
+		*fda = t->sockets;
+	}
 	return t->close(t, fda);
 }
 
 int transport_open(struct transport *t, struct interface *iface,
 		   struct fdarray *fda, enum timestamp_type tt)
 {
-	return t->open(t, iface, fda, tt);
+	int err;
+
+	err = t->open(t, iface, fda, tt);
+	if (err || !t->use_uring) {
+		return err;
+	}
+	t->uring = uring_create(fda);
+	if (!t->uring) {
+		pr_warning("io_uring unavailable, using the sockets directly");
+		return 0;
+	}
+	t->sockets = *fda;
+	t->uring_fda = fda;
+	fda->fd[FD_EVENT] = uring_fd(t->uring);
+	fda->fd[FD_GENERAL] = -1;
+	return 0;
+}
+
+int transport_open_shard(struct transport *t, struct interface *iface,
+			 struct fdarray *fda, enum timestamp_type tt)
+{
+	if (!t->open_shard) {
+		return -1;
+	}
+	return t->open_shard(t, iface, fda, tt);
+}
+
+int transport_steer_shards(struct transport *t, struct fdarray *fda,
+			   int shards)
+{
+	if (!t->steer_shards) {
+		return -1;
+	}
+	return t->steer_shards(t, transport_sockets(t, fda), shards);
 }
 
 int transport_recv(struct transport *t, int fd, struct ptp_message *msg)
 {
+	if (t->uring && fd == uring_fd(t->uring)) {
+		return uring_recv(t->uring, msg, sizeof(msg->data),
+				  &msg->address, &msg->hwts);
+	}
 	return t->recv(t, fd, msg, sizeof(msg->data), &msg->address, &msg->hwts);
 }
 
@@ -47,7 +107,8 @@ int transport_send(struct transport *t, struct fdarray *fda,
 {
 	int len = ntohs(msg->header.messageLength);
 
-	return t->send(t, fda, event, 0, msg, len, NULL, &msg->hwts);
+	return t->send(t, transport_sockets(t, fda), event, 0, msg, len,
+		       NULL, &msg->hwts);
 }
 
 int transport_peer(struct transport *t, struct fdarray *fda,
@@ -55,7 +116,8 @@ int transport_peer(struct transport *t, struct fdarray *fda,
 {
 	int len = ntohs(msg->header.messageLength);
 
-	return t->send(t, fda, event, 1, msg, len, NULL, &msg->hwts);
+	return t->send(t, transport_sockets(t, fda), event, 1, msg, len,
+		       NULL, &msg->hwts);
 }
 
 int transport_sendto(struct transport *t, struct fdarray *fda,
@@ -63,20 +125,66 @@ int transport_sendto(struct transport *t, struct fdarray *fda,
 {
 	int len = ntohs(msg->header.messageLength);
 
-	return t->send(t, fda, event, 0, msg, len, &msg->address, &msg->hwts);
+	return t->send(t, transport_sockets(t, fda), event, 0, msg, len,
+		       &msg->address, &msg->hwts);
 }
 
-int transport_txts(struct fdarray *fda,
+int transport_txts(struct transport *t, struct fdarray *fda,
 		   struct ptp_message *msg)
 {
 	int cnt, len = ntohs(msg->header.messageLength);
 	struct hw_timestamp *hwts = &msg->hwts;
 	unsigned char pkt[1600];
 
+	fda = transport_sockets(t, fda);
+	if (transport_uring_owns(t, fda->fd[FD_EVENT])) {
+		return uring_txts(t->uring, fda->fd[FD_EVENT], hwts);
+	}
 	cnt = sk_receive(fda->fd[FD_EVENT], pkt, len, NULL, hwts, MSG_ERRQUEUE);
 	return cnt > 0 ? 0 : cnt;
 }
 
+int transport_use_uring(struct transport *t)
+{
+	switch (t->type) {
+	case TRANS_UDP_IPV4:
+	case TRANS_UDP_IPV6:
+		t->use_uring = 1;
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+void transport_flush(struct transport *t)
+{
+	if (t->uring) {
+		uring_flush(t->uring);
+	}
+}
+
+int transport_sk_send(struct transport *t, int fd, void *buf, int len,
+		      struct address *addr, socklen_t alen, int txts,
+		      struct hw_timestamp *hwts)
+{
+	unsigned char junk[1600];
+	ssize_t cnt;
+
+	if (transport_uring_owns(t, fd)) {
+		return uring_send(t->uring, fd, buf, len, &addr->sa, alen,
+				  txts, hwts);
+	}
+	cnt = sendto(fd, buf, len, 0, &addr->sa, alen);
+	if (cnt < 1) {
+		pr_err("sendto failed: %m");
+		return -errno;
+	}
+	/*
+	 * Get the time stamp right away.
+	 */
+	return txts ? sk_receive(fd, junk, len, NULL, hwts, MSG_ERRQUEUE) : cnt;
+}
+
 int transport_physical_addr(struct transport *t, uint8_t *addr)
 {
 	if (t->physical_addr) {
@@ -98,6 +206,14 @@ enum transport_type transport_type(struct transport *t)
 	return t->type;
 }
 
+/* The simulated network, only present in the simulator. */
+static struct transport *(*sim_create)(void);
+
+void transport_set_sim(struct transport *(*create)(void))
+{
+	sim_create = create;
+}
+
 struct transport *transport_create(struct config *cfg,
 				   enum transport_type type)
 {
@@ -115,6 +231,10 @@ struct transport *transport_create(struct config *cfg,
 	case TRANS_IEEE_802_3:
 		t = raw_transport_create();
 		break;
+	case TRANS_SIM:
+		if (sim_create)
+			t = sim_create();
+		break;
 	case TRANS_DEVICENET:
 	case TRANS_CONTROLNET:
 	case TRANS_PROFINET:
@@ -39,6 +39,8 @@ enum transport_type {
 	TRANS_DEVICENET,
 	TRANS_CONTROLNET,
 	TRANS_PROFINET,
+	/* Simulated network, reported as an unknown protocol. */
+	TRANS_SIM = 0xFFFE,
 };
 
 /**
@@ -60,6 +62,34 @@ int transport_close(struct transport *t, struct fdarray *fda);
 int transport_open(struct transport *t, struct interface *iface,
 		   struct fdarray *fda, enum timestamp_type tt);
 
+/**
+ * Opens one more pair of sockets on the ports of an open transport, for
+ * a thread serving unicast clients. The sockets share the ports with
+ * those of transport_open() and do not join the multicast groups.
+ * @param t      The transport, opened with transport_open().
+ * @param iface  The interface passed to transport_open().
+ * @param fda    Filled in with the descriptors of the new sockets. Close
+ *               them with transport_close().
+ * @param tt     The time stamping mode passed to transport_open().
+ * @return       Zero on success, non-zero otherwise or when the transport
+ *               cannot share its ports.
+ */
+int transport_open_shard(struct transport *t, struct interface *iface,
+			 struct fdarray *fda, enum timestamp_type tt);
+
+/**
+ * Steers the unicast Delay_Req and Signaling messages to the sockets of
+ * transport_open_shard(), so that all of the messages from one address
+ * reach the same shard. All other messages still arrive on the sockets
+ * of transport_open(). Call this after opening all of the shards.
+ * @param t       The transport.
+ * @param fda     The array of descriptors filled in by transport_open.
+ * @param shards  The number of shards opened.
+ * @return        Zero on success, non-zero otherwise.
+ */
+int transport_steer_shards(struct transport *t, struct fdarray *fda,
+			   int shards);
+
 int transport_recv(struct transport *t, int fd, struct ptp_message *msg);
 
 /**
@@ -105,14 +135,33 @@ int transport_sendto(struct transport *t, struct fdarray *fda,
  * Fetches the transmit time stamp for a PTP message that was sent
  * with the TRANS_DEFER_EVENT flag.
  *
+ * @param t	The transport.
  * @param fda	The array of descriptors filled in by transport_open.
  * @param msg	The message previously sent using transport_send(),
  *              transport_peer(), or transport_sendto().
  * @return	Zero on success, or negative value in case of an error.
  */
-int transport_txts(struct fdarray *fda,
+int transport_txts(struct transport *t, struct fdarray *fda,
 		   struct ptp_message *msg);
 
+/**
+ * Moves the sockets onto io_uring from the next time the transport is
+ * opened. The descriptor array then holds the descriptor of the
+ * receive ring in place of the sockets, general messages are queued
+ * until transport_flush(), and transport_recv() may return zero when
+ * the ring held no message. Only the UDP transports support this.
+ * @param t	The transport.
+ * @return	Zero on success, non-zero otherwise.
+ */
+int transport_use_uring(struct transport *t);
+
+/**
+ * Sends the general messages queued by the transport. Call this before
+ * polling the descriptors.
+ * @param t	The transport.
+ */
+void transport_flush(struct transport *t);
+
 /**
  * Returns the transport's type.
  */
@@ -147,6 +196,13 @@ int transport_protocol_addr(struct transport *t, uint8_t *addr);
 struct transport *transport_create(struct config *cfg,
 				   enum transport_type type);
 
+/**
+ * Provide the transport of the simulated network, TRANS_SIM. Without
+ * this, transport_create() fails for that type.
+ * @param create  Allocates an instance of the simulated transport.
+ */
+void transport_set_sim(struct transport *(*create)(void));
+
 /**
  * Free an instance of a transport.
  * @param t Pointer obtained by calling transport_create().
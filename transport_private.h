@@ -26,9 +26,15 @@
 #include "fd.h"
 #include "transport.h"
 
+struct uring;
+
 struct transport {
 	enum transport_type type;
 	struct config *cfg;
+	int use_uring;
+	struct uring *uring;
+	struct fdarray *uring_fda;	/* polls the ring instead */
+	struct fdarray sockets;		/* the sockets behind uring_fda */
 
 	int (*close)(struct transport *t, struct fdarray *fda);
 
@@ -47,6 +53,29 @@ struct transport {
 	int (*physical_addr)(struct transport *t, uint8_t *addr);
 
 	int (*protocol_addr)(struct transport *t, uint8_t *addr);
+
+	int (*open_shard)(struct transport *t, struct interface *iface,
+			  struct fdarray *fda, enum timestamp_type tt);
+
+	int (*steer_shards)(struct transport *t, struct fdarray *fda,
+			    int shards);
 };
 
+/**
+ * Sends a message on one of the sockets of a transport, through the
+ * io_uring when the sockets were moved onto one.
+ * @param t      The transport.
+ * @param fd     The socket.
+ * @param buf    The message.
+ * @param len    Length of the message in bytes.
+ * @param addr   The destination address.
+ * @param alen   Length of the destination address.
+ * @param txts   Non-zero to fetch the transmit time stamp.
+ * @param hwts   Receives the transmit time stamp.
+ * @return       The number of bytes sent, or a negative error code.
+ */
+int transport_sk_send(struct transport *t, int fd, void *buf, int len,
+		      struct address *addr, socklen_t alen, int txts,
+		      struct hw_timestamp *hwts);
+
 #endif
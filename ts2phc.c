@@ -17,7 +17,9 @@
 #include "interface.h"
 #include "phc.h"
 #include "print.h"
+#include "rtprof.h"
 #include "ts2phc.h"
+#include "tsrec.h"
 #include "version.h"
 
 #define NS_PER_SEC		1000000000LL
@@ -32,6 +34,7 @@ static void ts2phc_cleanup(struct ts2phc_private *priv)
 	struct port *p, *tmp;
 
 	ts2phc_slave_cleanup(priv);
+	tsrec_close();
 	if (priv->master)
 		ts2phc_master_destroy(priv->master);
 	if (priv->cfg)
@@ -151,7 +154,9 @@ struct servo *servo_add(struct ts2phc_private *priv, struct clock *clock)
 	if (!servo)
 		return NULL;
 
+	tsrec_write(TSREC_SERVO, clock->clkid, max_adj, 0, 0, fadj);
 	servo_sync_interval(servo, SERVO_SYNC_INTERVAL);
+	tsrec_write(TSREC_INTERVAL, clock->clkid, 0, 0, 0, SERVO_SYNC_INTERVAL);
 
 	return servo;
 }
@@ -223,6 +228,11 @@ struct clock *clock_add(struct ts2phc_private *priv, const char *device)
 
 void clock_destroy(struct clock *c)
 {
+	unsigned long issued, skipped;
+
+	clockadj_get_counts(c->clkid, &issued, &skipped);
+	pr_info("%s: clock adjustments: %lu issued, %lu skipped",
+		c->name, issued, skipped);
 	servo_destroy(c->servo);
 	posix_clock_close(c->clkid);
 	free(c->name);
@@ -481,12 +491,16 @@ static void ts2phc_synchronize_clocks(struct ts2phc_private *priv, int autocfg)
 			continue;
 		}
 
+		tsrec_write(TSREC_OFFSET, c->clkid, offset,
+			    tmv_to_nanoseconds(ts), -1, 0.0);
+
 		adj = servo_sample(c->servo, offset, tmv_to_nanoseconds(ts),
 				   SAMPLE_WEIGHT, &c->servo_state);
 
 		pr_info("%s offset %10" PRId64 " s%d freq %+7.0f",
 			c->name, offset, c->servo_state, adj);
 
+		clockadj_begin(c->clkid);
 		switch (c->servo_state) {
 		case SERVO_UNLOCKED:
 			break;
@@ -499,6 +513,7 @@ static void ts2phc_synchronize_clocks(struct ts2phc_private *priv, int autocfg)
 			clockadj_set_freq(c->clkid, -adj);
 			break;
 		}
+		clockadj_commit(c->clkid);
 	}
 }
 
@@ -653,6 +668,17 @@ int main(int argc, char *argv[])
 	STAILQ_INIT(&priv.slaves);
 	priv.cfg = cfg;
 
+	if (tsrec_open(config_get_string(cfg, NULL, "timestamp_record"))) {
+		ts2phc_cleanup(&priv);
+		return -1;
+	}
+	clockadj_set_record(tsrec_write);
+
+	if (rtprof_apply(cfg)) {
+		ts2phc_cleanup(&priv);
+		return -1;
+	}
+
 	snprintf(uds_local, sizeof(uds_local), "/var/run/ts2phc.%d",
 		 getpid());
 
@@ -735,6 +761,8 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
+	rtprof_check(cfg);
+
 	while (is_running()) {
 		struct clock *c;
 
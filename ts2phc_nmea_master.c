@@ -5,6 +5,7 @@
  */
 #include <poll.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -20,26 +21,62 @@
 #include "ts2phc_nmea_master.h"
 #include "util.h"
 
-#define BAUD		9600
 #define NMEA_TMO	2000 /*milliseconds*/
+#define BITS_PER_CHAR	10 /*start bit, 8 data bits, stop bit*/
+
+struct nmea_sample {
+	struct timespec local_monotime;
+	struct timespec local_utctime;
+	struct timespec rmc_utctime;
+	bool rmc_fix_valid;
+};
 
 struct ts2phc_nmea_master {
 	struct ts2phc_master master;
 	struct config *config;
 	struct lstab *lstab;
 	pthread_t worker;
-	/* Protects anonymous struct fields, below, from concurrent access. */
-	pthread_mutex_t mutex;
-	struct {
-		struct timespec local_monotime;
-		struct timespec local_utctime;
-		struct timespec rmc_utctime;
-		bool rmc_fix_valid;
-	};
+	/*
+	 * Single slot handed over from the worker to the main thread.
+	 * The sequence counter is odd while the worker updates the slot,
+	 * and the reader retries until it sees a stable, even value.
+	 */
+	atomic_uint seq;
+	struct nmea_sample slot;
 };
 
+static void nmea_publish(struct ts2phc_nmea_master *m,
+			 const struct nmea_sample *sample)
+{
+	unsigned int seq = atomic_load_explicit(&m->seq, memory_order_relaxed);
+
+	atomic_store_explicit(&m->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	m->slot = *sample;
+	atomic_store_explicit(&m->seq, seq + 2, memory_order_release);
+}
+
+static void nmea_fetch(struct ts2phc_nmea_master *m,
+		       struct nmea_sample *sample)
+{
+	unsigned int seq;
+
+	do {
+		seq = atomic_load_explicit(&m->seq, memory_order_acquire);
+		*sample = m->slot;
+		atomic_thread_fence(memory_order_acquire);
+	} while ((seq & 1) ||
+		 seq != atomic_load_explicit(&m->seq, memory_order_relaxed));
+}
+
+static struct timespec nmea_backdate(struct timespec ts, int64_t ns)
+{
+	return tmv_to_timespec(tmv_sub(timespec_to_tmv(ts),
+				       nanoseconds_to_tmv(ns)));
+}
+
 static int open_nmea_connection(const char *host, const char *port,
-				const char *serialport)
+				const char *serialport, int baud)
 {
 	int fd;
 
@@ -50,7 +87,7 @@ static int open_nmea_connection(const char *host, const char *port,
 		}
 		return fd;
 	}
-	fd = serial_open(serialport, BAUD, 0, 0);
+	fd = serial_open(serialport, baud, 0, 0);
 	if (fd == -1) {
 		pr_err("failed to open nmea source %s", serialport);
 	}
@@ -64,7 +101,10 @@ static void *monitor_nmea_status(void *arg)
 	char *host, input[256], *port, *ptr, *uart;
 	struct ts2phc_nmea_master *master = arg;
 	struct timespec rxtime, tmo = { 2, 0 };
-	int cnt, num, parsed;
+	int baud, cnt, len, num, parsed;
+	struct nmea_sample sample;
+	struct timespec utctime;
+	int64_t char_ns, delay;
 	struct nmea_rmc rmc;
 	struct timex ntx;
 
@@ -75,20 +115,26 @@ static void *monitor_nmea_status(void *arg)
 	host = config_get_string(master->config, NULL, "ts2phc.nmea_remote_host");
 	port = config_get_string(master->config, NULL, "ts2phc.nmea_remote_port");
 	uart = config_get_string(master->config, NULL, "ts2phc.nmea_serialport");
+	baud = config_get_int(master->config, NULL, "ts2phc.nmea_baudrate");
+	/*
+	 * The arrival of each sentence is estimated by backing off from
+	 * the read time by the transmission time of the bytes that
+	 * followed its leading '$'. Remote connections carry no such
+	 * timing information.
+	 */
+	char_ns = host[0] && port[0] ? 0 : BITS_PER_CHAR * NS_PER_SEC / baud;
 	memset(&ntx, 0, sizeof(ntx));
 	ntx.modes = ADJ_NANO;
 
 	while (is_running()) {
 		if (pfd.fd == -1) {
-			pfd.fd = open_nmea_connection(host, port, uart);
+			pfd.fd = open_nmea_connection(host, port, uart, baud);
 			if (pfd.fd == -1) {
 				clock_nanosleep(CLOCK_MONOTONIC, 0, &tmo, NULL);
 				continue;
 			}
 		}
 		num = poll(&pfd, 1, NMEA_TMO);
-		clock_gettime(CLOCK_MONOTONIC, &rxtime);
-		adjtimex(&ntx);
 		if (num < 0) {
 			pr_err("poll failed");
 			break;
@@ -109,22 +155,27 @@ static void *monitor_nmea_status(void *arg)
 			continue;
 		}
 		cnt = read(pfd.fd, input, sizeof(input));
+		/* The last byte read arrived no later than this. */
+		clock_gettime(CLOCK_MONOTONIC, &rxtime);
+		adjtimex(&ntx);
 		if (cnt < 0) {
 			pr_err("failed to read from nmea source");
 			close(pfd.fd);
 			pfd.fd = -1;
 			continue;
 		}
+		utctime.tv_sec = ntx.time.tv_sec;
+		utctime.tv_nsec = ntx.time.tv_usec;
+		len = cnt;
 		ptr = input;
 		do {
 			if (!nmea_parse(np, ptr, cnt, &rmc, &parsed)) {
-				pthread_mutex_lock(&master->mutex);
-				master->local_monotime = rxtime;
-				master->local_utctime.tv_sec = ntx.time.tv_sec;
-				master->local_utctime.tv_nsec = ntx.time.tv_usec;
-				master->rmc_utctime = rmc.ts;
-				master->rmc_fix_valid = rmc.fix_valid;
-				pthread_mutex_unlock(&master->mutex);
+				delay = (len - (ptr - input) - rmc.start) * char_ns;
+				sample.local_monotime = nmea_backdate(rxtime, delay);
+				sample.local_utctime = nmea_backdate(utctime, delay);
+				sample.rmc_utctime = rmc.ts;
+				sample.rmc_fix_valid = rmc.fix_valid;
+				nmea_publish(master, &sample);
 			}
 			cnt -= parsed;
 			ptr += parsed;
@@ -143,7 +194,6 @@ static void ts2phc_nmea_master_destroy(struct ts2phc_master *master)
 	struct ts2phc_nmea_master *m =
 		container_of(master, struct ts2phc_nmea_master, master);
 	pthread_join(m->worker, NULL);
-	pthread_mutex_destroy(&m->mutex);
 	lstab_destroy(m->lstab);
 	free(m);
 }
@@ -155,6 +205,7 @@ static int ts2phc_nmea_master_getppstime(struct ts2phc_master *master,
 		container_of(master, struct ts2phc_nmea_master, master);
 	tmv_t delay_t1, delay_t2, local_t1, local_t2, rmc;
 	int lstab_error = 0, tai_offset = 0;
+	struct nmea_sample sample;
 	enum lstab_result result;
 	struct timespec now;
 	int64_t utc_time;
@@ -163,14 +214,12 @@ static int ts2phc_nmea_master_getppstime(struct ts2phc_master *master,
 	clock_gettime(CLOCK_MONOTONIC, &now);
 	local_t2 = timespec_to_tmv(now);
 
-	pthread_mutex_lock(&m->mutex);
-
-	local_t1 = timespec_to_tmv(m->local_monotime);
-	delay_t2 = timespec_to_tmv(m->local_utctime);
-	rmc = timespec_to_tmv(m->rmc_utctime);
-	fix_valid = m->rmc_fix_valid;
+	nmea_fetch(m, &sample);
 
-	pthread_mutex_unlock(&m->mutex);
+	local_t1 = timespec_to_tmv(sample.local_monotime);
+	delay_t2 = timespec_to_tmv(sample.local_utctime);
+	rmc = timespec_to_tmv(sample.rmc_utctime);
+	fix_valid = sample.rmc_fix_valid;
 
 	delay_t1 = rmc;
 	pr_debug("nmea delay: %" PRId64 " ns",
@@ -216,7 +265,7 @@ struct ts2phc_master *ts2phc_nmea_master_create(struct ts2phc_private *priv,
 	master->master.destroy = ts2phc_nmea_master_destroy;
 	master->master.getppstime = ts2phc_nmea_master_getppstime;
 	master->config = priv->cfg;
-	pthread_mutex_init(&master->mutex, NULL);
+	atomic_init(&master->seq, 0);
 	err = pthread_create(&master->worker, NULL, monitor_nmea_status, master);
 	if (err) {
 		pr_err("failed to create worker thread: %s", strerror(err));
@@ -121,6 +121,24 @@ void tsproc_set_delay(struct tsproc *tsp, tmv_t delay)
 	tsp->filtered_delay_valid = 1;
 }
 
+int tsproc_get_delay_samples(struct tsproc *tsp, tmv_t *buf, int len)
+{
+	return filter_samples(tsp->delay_filter, buf, len);
+}
+
+void tsproc_seed_delay(struct tsproc *tsp, const tmv_t *buf, int len)
+{
+	int i;
+
+	if (len < 1)
+		return;
+
+	filter_reset(tsp->delay_filter);
+	for (i = 0; i < len; i++)
+		tsp->filtered_delay = filter_sample(tsp->delay_filter, buf[i]);
+	tsp->filtered_delay_valid = 1;
+}
+
 tmv_t get_raw_delay(struct tsproc *tsp)
 {
 	tmv_t t23, t41, delay;
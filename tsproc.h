@@ -82,6 +82,24 @@ void tsproc_set_clock_rate_ratio(struct tsproc *tsp, double clock_rate_ratio);
  */
 void tsproc_set_delay(struct tsproc *tsp, tmv_t delay);
 
+/**
+ * Copy out the samples held by the delay filter, oldest first.
+ * @param tsp    Pointer obtained via @ref tsproc_create().
+ * @param buf    Buffer to receive the samples.
+ * @param len    The number of samples which fit into 'buf'.
+ * @return       The number of samples copied.
+ */
+int tsproc_get_delay_samples(struct tsproc *tsp, tmv_t *buf, int len);
+
+/**
+ * Refill the delay filter with samples saved earlier, and take its
+ * output as the current delay.
+ * @param tsp    Pointer obtained via @ref tsproc_create().
+ * @param buf    The samples, oldest first.
+ * @param len    The number of samples.
+ */
+void tsproc_seed_delay(struct tsproc *tsp, const tmv_t *buf, int len);
+
 /**
  * Update delay in a time stamp processor using new measurements.
  * @param tsp    Pointer obtained via @ref tsproc_create().
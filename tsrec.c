@@ -0,0 +1,98 @@
+/**
+ * @file tsrec.c
+ * @note Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <string.h>
+
+#include "print.h"
+#include "tsrec.h"
+
+static FILE *tsrec_fp;
+
+int tsrec_open(const char *path)
+{
+	struct tsrec_header hdr = {
+		.magic = TSREC_MAGIC,
+		.version = TSREC_VERSION,
+		.record_size = sizeof(struct tsrec_record),
+	};
+
+	if (!path || !path[0]) {
+		return 0;
+	}
+	tsrec_close();
+	tsrec_fp = fopen(path, "w");
+	if (!tsrec_fp) {
+		pr_err("failed to open %s: %m", path);
+		return -1;
+	}
+	if (fwrite(&hdr, sizeof(hdr), 1, tsrec_fp) != 1) {
+		pr_err("failed to write %s: %m", path);
+		tsrec_close();
+		return -1;
+	}
+	return 0;
+}
+
+void tsrec_close(void)
+{
+	if (tsrec_fp) {
+		fclose(tsrec_fp);
+		tsrec_fp = NULL;
+	}
+}
+
+void tsrec_write(int type, clockid_t clkid, int64_t ts0, int64_t ts1,
+		 int64_t ts2, double value)
+{
+	struct tsrec_record rec;
+
+	if (!tsrec_fp) {
+		return;
+	}
+	memset(&rec, 0, sizeof(rec));
+	rec.type = type;
+	rec.clkid = clkid;
+	rec.ts[0] = ts0;
+	rec.ts[1] = ts1;
+	rec.ts[2] = ts2;
+	rec.value = value;
+
+	if (fwrite(&rec, sizeof(rec), 1, tsrec_fp) != 1) {
+		pr_err("failed to record time stamps: %m");
+		tsrec_close();
+	}
+}
+
+int tsrec_read_header(FILE *fp)
+{
+	struct tsrec_header hdr;
+
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1) {
+		return -1;
+	}
+	if (hdr.magic != TSREC_MAGIC || hdr.version != TSREC_VERSION ||
+	    hdr.record_size != sizeof(struct tsrec_record)) {
+		return -1;
+	}
+	return 0;
+}
+
+int tsrec_read(FILE *fp, struct tsrec_record *rec)
+{
+	return fread(rec, sizeof(*rec), 1, fp) == 1;
+}
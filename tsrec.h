@@ -0,0 +1,114 @@
+/**
+ * @file tsrec.h
+ * @brief Records the time stamps and clock adjustments of a servo loop.
+ * @note Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef HAVE_TSREC_H
+#define HAVE_TSREC_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define TSREC_MAGIC	0x43525354 /* "TSRC" */
+#define TSREC_VERSION	1
+
+/**
+ * The file starts with a header and is followed by fixed size
+ * records, all in host byte order. Every record carries the ID of the
+ * clock being disciplined, so that the samples of programs which
+ * synchronize several clocks may be told apart.
+ */
+struct tsrec_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t record_size;
+};
+
+enum tsrec_type {
+	/* A servo was created: ts[0] max_adj, ts[1] sw_ts, value freq. */
+	TSREC_SERVO = 1,
+	/* A sync event: ts[0] t1, ts[1] t2, ts[2] correction. */
+	TSREC_SYNC,
+	/* A delay measurement: ts[0] t3, ts[1] t4, ts[2] correction. */
+	TSREC_DELAY,
+	/* A peer delay: ts[0] delay, ts[1] t1, ts[2] t2, value nrr. */
+	TSREC_PEER_DELAY,
+	/* A direct offset: ts[0] offset, ts[1] local time, ts[2] delay. */
+	TSREC_OFFSET,
+	/* Frequency adjustment: value ppb. */
+	TSREC_FREQ,
+	/* Clock step: ts[0] nanoseconds. */
+	TSREC_STEP,
+	/* Phase adjustment: ts[0] nanoseconds. */
+	TSREC_PHASE,
+	/* Sync interval change: value seconds. */
+	TSREC_INTERVAL,
+	/* The time stamp processor was reset: ts[0] full. */
+	TSREC_RESET,
+};
+
+struct tsrec_record {
+	uint16_t type;
+	uint16_t reserved;
+	int32_t  clkid;
+	int64_t  ts[3];
+	double   value;
+};
+
+/**
+ * Opens the process wide time stamp record file. When no file is
+ * open, all of the tsrec_xxx() recording functions do nothing.
+ * @param path  The name of the file to create, or the empty string.
+ * @return      Zero on success, non-zero otherwise.
+ */
+int tsrec_open(const char *path);
+
+/**
+ * Flushes and closes the time stamp record file, if any.
+ */
+void tsrec_close(void);
+
+/**
+ * Records a single event.
+ * @param type   One of the @ref tsrec_type values.
+ * @param clkid  The clock disciplined by the servo.
+ * @param ts0    First integer field.
+ * @param ts1    Second integer field.
+ * @param ts2    Third integer field.
+ * @param value  Floating point field.
+ */
+void tsrec_write(int type, clockid_t clkid, int64_t ts0, int64_t ts1,
+		 int64_t ts2, double value);
+
+/**
+ * Reads the header of a time stamp record file.
+ * @param fp  A file opened for reading.
+ * @return    Zero on success, non-zero if the file is not a
+ *            compatible record file.
+ */
+int tsrec_read_header(FILE *fp);
+
+/**
+ * Reads the next record from a time stamp record file.
+ * @param fp   A file positioned after the header.
+ * @param rec  Buffer to hold the record.
+ * @return     One if a record was read, zero at the end of the file.
+ */
+int tsrec_read(FILE *fp, struct tsrec_record *rec);
+
+#endif
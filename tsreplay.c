@@ -0,0 +1,499 @@
+/**
+ * @file tsreplay.c
+ * @brief Replays recorded time stamps through the servo loop.
+ * @note Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config.h"
+#include "print.h"
+#include "servo.h"
+#include "stats.h"
+#include "tmv.h"
+#include "tsproc.h"
+#include "tsrec.h"
+#include "util.h"
+#include "version.h"
+
+#define DEFAULT_MAX_ADJ 500000
+#define MAX_CLOCKS 16
+#define NS_PER_SEC 1000000000LL
+
+/*
+ * The local clock as seen through its adjustments. Only the deviation
+ * from the free running oscillator is tracked, since the recorded time
+ * stamps already include the behavior of the oscillator itself.
+ */
+struct simclock {
+	double freq;
+	double phase;
+};
+
+struct replay {
+	struct config *cfg;
+	enum servo_type servo_type;
+	int write_phase_mode;
+
+	clockid_t clkids[MAX_CLOCKS];
+	int num_clkids;
+	int selected;
+	clockid_t clkid;
+	int active;
+
+	struct servo *servo;
+	enum servo_state state;
+	struct tsproc *tsproc;
+	struct tsproc *rec_tsproc;
+	struct simclock real;
+	struct simclock sim;
+	int64_t last_ts;
+
+	struct stats *rec_offset;
+	struct stats *offset;
+	struct stats *freq;
+	struct stats *delay;
+	struct stats *cpu;
+};
+
+static void simclock_advance(struct simclock *c, int64_t dt)
+{
+	c->phase += c->freq * dt / NS_PER_SEC;
+}
+
+/*
+ * Advances both clocks to the local time 'ts' of the recording and
+ * returns the difference between the simulated and the real clock.
+ */
+static int64_t replay_advance(struct replay *r, int64_t ts)
+{
+	int64_t dt = r->last_ts ? ts - r->last_ts : 0;
+
+	simclock_advance(&r->real, dt);
+	simclock_advance(&r->sim, dt);
+	r->last_ts = ts;
+
+	return (int64_t) (r->sim.phase - r->real.phase);
+}
+
+/* Like replay_advance(), but for time stamps out of sequence. */
+static int64_t replay_delta(struct replay *r, int64_t ts)
+{
+	struct simclock real = r->real, sim = r->sim;
+	int64_t dt = r->last_ts ? ts - r->last_ts : 0;
+
+	simclock_advance(&real, dt);
+	simclock_advance(&sim, dt);
+
+	return (int64_t) (sim.phase - real.phase);
+}
+
+static int64_t cpu_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static int replay_servo(struct replay *r, struct tsrec_record *rec)
+{
+	int i, max_adj;
+
+	for (i = 0; i < r->num_clkids; i++) {
+		if (r->clkids[i] == rec->clkid) {
+			break;
+		}
+	}
+	if (i == r->num_clkids) {
+		if (r->num_clkids == MAX_CLOCKS) {
+			pr_err("too many clocks in the recording");
+			return -1;
+		}
+		r->clkids[r->num_clkids++] = rec->clkid;
+	}
+	if (i != r->selected) {
+		return 0;
+	}
+
+	if (r->servo) {
+		servo_destroy(r->servo);
+	}
+	/* A free running clock is recorded without a frequency range. */
+	max_adj = rec->ts[0] ? rec->ts[0] : DEFAULT_MAX_ADJ;
+
+	r->servo = servo_create(r->cfg, r->servo_type, -rec->value,
+				max_adj, rec->ts[1]);
+	if (!r->servo) {
+		pr_err("failed to create servo");
+		return -1;
+	}
+	r->clkid = rec->clkid;
+	r->active = 1;
+	r->state = SERVO_UNLOCKED;
+	r->real.freq = rec->value;
+	r->real.phase = 0.0;
+	r->sim = r->real;
+	r->last_ts = 0;
+	tsproc_reset(r->tsproc, 1);
+	tsproc_reset(r->rec_tsproc, 1);
+	return 0;
+}
+
+static void replay_sample(struct replay *r, int64_t offset, int64_t ts,
+			  double weight)
+{
+	double adj;
+
+	adj = servo_sample(r->servo, offset, ts, weight, &r->state);
+	tsproc_set_clock_rate_ratio(r->tsproc, servo_rate_ratio(r->servo));
+
+	switch (r->state) {
+	case SERVO_UNLOCKED:
+		break;
+	case SERVO_JUMP:
+		r->sim.freq = -adj;
+		r->sim.phase -= offset;
+		tsproc_reset(r->tsproc, 0);
+		break;
+	case SERVO_LOCKED:
+		r->sim.freq = -adj;
+		break;
+	case SERVO_LOCKED_STABLE:
+		if (r->write_phase_mode) {
+			r->sim.phase -= offset;
+			adj = 0;
+		} else {
+			r->sim.freq = -adj;
+		}
+		break;
+	}
+
+	stats_add_value(r->offset, offset);
+	stats_add_value(r->freq, adj);
+
+	pr_debug("offset %10" PRId64 " s%d freq %+7.0f", offset, r->state, adj);
+}
+
+static void replay_sync(struct replay *r, struct tsrec_record *rec)
+{
+	tmv_t origin, ingress, offset;
+	int64_t delta, start;
+	double weight;
+
+	origin = nanoseconds_to_tmv(rec->ts[0] + rec->ts[2]);
+	ingress = nanoseconds_to_tmv(rec->ts[1]);
+	delta = replay_advance(r, rec->ts[1]);
+
+	tsproc_down_ts(r->rec_tsproc, origin, ingress);
+	if (!tsproc_update_offset(r->rec_tsproc, &offset, &weight)) {
+		stats_add_value(r->rec_offset, tmv_dbl(offset));
+	}
+
+	start = cpu_time();
+
+	ingress = tmv_add(ingress, nanoseconds_to_tmv(delta));
+	tsproc_down_ts(r->tsproc, origin, ingress);
+	if (!tsproc_update_offset(r->tsproc, &offset, &weight)) {
+		replay_sample(r, tmv_to_nanoseconds(offset),
+			      tmv_to_nanoseconds(ingress), weight);
+	}
+
+	stats_add_value(r->cpu, cpu_time() - start);
+}
+
+static void replay_delay(struct replay *r, struct tsrec_record *rec)
+{
+	tmv_t req, rx, delay;
+
+	req = nanoseconds_to_tmv(rec->ts[0]);
+	rx = nanoseconds_to_tmv(rec->ts[1] - rec->ts[2]);
+
+	tsproc_up_ts(r->rec_tsproc, req, rx);
+	tsproc_update_delay(r->rec_tsproc, &delay);
+
+	req = tmv_add(req, nanoseconds_to_tmv(replay_delta(r, rec->ts[0])));
+	tsproc_up_ts(r->tsproc, req, rx);
+	if (!tsproc_update_delay(r->tsproc, &delay)) {
+		stats_add_value(r->delay, tmv_dbl(delay));
+	}
+}
+
+static void replay_peer_delay(struct replay *r, struct tsrec_record *rec)
+{
+	tmv_t ppd, req, rx;
+
+	ppd = nanoseconds_to_tmv(rec->ts[0]);
+	req = nanoseconds_to_tmv(rec->ts[1]);
+	rx = nanoseconds_to_tmv(rec->ts[2]);
+
+	tsproc_set_delay(r->rec_tsproc, ppd);
+	tsproc_up_ts(r->rec_tsproc, req, rx);
+
+	req = tmv_add(req, nanoseconds_to_tmv(replay_delta(r, rec->ts[1])));
+	tsproc_set_delay(r->tsproc, ppd);
+	tsproc_up_ts(r->tsproc, req, rx);
+
+	stats_add_value(r->delay, tmv_dbl(ppd));
+}
+
+static void replay_offset(struct replay *r, struct tsrec_record *rec)
+{
+	int64_t delta, start;
+
+	delta = replay_advance(r, rec->ts[1]);
+	stats_add_value(r->rec_offset, rec->ts[0]);
+	if (rec->ts[2] >= 0) {
+		stats_add_value(r->delay, rec->ts[2]);
+	}
+
+	start = cpu_time();
+	replay_sample(r, rec->ts[0] + delta, rec->ts[1] + delta, 1.0);
+	stats_add_value(r->cpu, cpu_time() - start);
+}
+
+static int replay_record(struct replay *r, struct tsrec_record *rec)
+{
+	if (rec->type == TSREC_SERVO) {
+		return replay_servo(r, rec);
+	}
+	if (!r->active || rec->clkid != r->clkid) {
+		return 0;
+	}
+
+	switch (rec->type) {
+	case TSREC_SYNC:
+		replay_sync(r, rec);
+		break;
+	case TSREC_DELAY:
+		replay_delay(r, rec);
+		break;
+	case TSREC_PEER_DELAY:
+		replay_peer_delay(r, rec);
+		break;
+	case TSREC_OFFSET:
+		replay_offset(r, rec);
+		break;
+	case TSREC_FREQ:
+		r->real.freq = rec->value;
+		break;
+	case TSREC_STEP:
+		r->real.phase += rec->ts[0];
+		tsproc_reset(r->rec_tsproc, 0);
+		break;
+	case TSREC_PHASE:
+		r->real.phase += rec->ts[0];
+		break;
+	case TSREC_INTERVAL:
+		servo_sync_interval(r->servo, rec->value);
+		break;
+	case TSREC_RESET:
+		tsproc_reset(r->tsproc, rec->ts[0]);
+		tsproc_reset(r->rec_tsproc, rec->ts[0]);
+		break;
+	default:
+		pr_debug("skipping record of unknown type %hu", rec->type);
+		break;
+	}
+	return 0;
+}
+
+static void replay_report(struct replay *r)
+{
+	struct stats_result rec_offset, offset, freq, delay, cpu;
+
+	if (stats_get_result(r->offset, &offset) ||
+	    stats_get_result(r->cpu, &cpu)) {
+		fprintf(stderr, "no samples were replayed\n");
+		return;
+	}
+	if (stats_get_result(r->rec_offset, &rec_offset)) {
+		memset(&rec_offset, 0, sizeof(rec_offset));
+	}
+	stats_get_result(r->freq, &freq);
+	if (stats_get_result(r->delay, &delay)) {
+		memset(&delay, 0, sizeof(delay));
+	}
+
+	printf("clock      %d of %d\n", r->selected + 1, r->num_clkids);
+	printf("samples    %u\n", stats_get_num_values(r->offset));
+	printf("recorded   rms %9.0f max %9.0f\n",
+	       rec_offset.rms, rec_offset.max_abs);
+	printf("replayed   rms %9.0f max %9.0f freq %+7.0f +/- %5.0f "
+	       "delay %7.0f +/- %3.0f\n",
+	       offset.rms, offset.max_abs, freq.mean, freq.stddev,
+	       delay.mean, delay.stddev);
+	printf("cpu        mean %7.0f ns max %7.0f ns per sample\n",
+	       cpu.mean, cpu.max);
+}
+
+static void replay_destroy(struct replay *r)
+{
+	if (r->servo)
+		servo_destroy(r->servo);
+	if (r->tsproc)
+		tsproc_destroy(r->tsproc);
+	if (r->rec_tsproc)
+		tsproc_destroy(r->rec_tsproc);
+	if (r->rec_offset)
+		stats_destroy(r->rec_offset);
+	if (r->offset)
+		stats_destroy(r->offset);
+	if (r->freq)
+		stats_destroy(r->freq);
+	if (r->delay)
+		stats_destroy(r->delay);
+	if (r->cpu)
+		stats_destroy(r->cpu);
+}
+
+static int replay_init(struct replay *r, struct config *cfg)
+{
+	int mode, filter, length;
+
+	r->cfg = cfg;
+	r->servo_type = config_get_int(cfg, NULL, "clock_servo");
+	r->write_phase_mode = config_get_int(cfg, NULL, "write_phase_mode");
+
+	mode = config_get_int(cfg, NULL, "tsproc_mode");
+	filter = config_get_int(cfg, NULL, "delay_filter");
+	length = config_get_int(cfg, NULL, "delay_filter_length");
+	r->tsproc = tsproc_create(mode, filter, length);
+	r->rec_tsproc = tsproc_create(mode, filter, length);
+
+	r->rec_offset = stats_create();
+	r->offset = stats_create();
+	r->freq = stats_create();
+	r->delay = stats_create();
+	r->cpu = stats_create();
+
+	if (!r->tsproc || !r->rec_tsproc || !r->rec_offset || !r->offset ||
+	    !r->freq || !r->delay || !r->cpu) {
+		return -1;
+	}
+	return 0;
+}
+
+static void usage(char *progname)
+{
+	fprintf(stderr,
+		"\n"
+		"usage: %s [options] file\n\n"
+		" -c [num]  replay the num-th clock of the recording (1)\n"
+		" -f [file] read the servo configuration from 'file'\n"
+		" -l [num]  set the logging level to 'num' (6)\n"
+		" -h        prints this message and exits\n"
+		" -v        prints the software version and exits\n"
+		"\n",
+		progname);
+}
+
+int main(int argc, char *argv[])
+{
+	char *config = NULL, *progname;
+	struct tsrec_record rec;
+	struct replay r;
+	struct option *opts;
+	struct config *cfg;
+	int c, err = -1, index, level = LOG_INFO;
+	FILE *fp = NULL;
+
+	memset(&r, 0, sizeof(r));
+
+	cfg = config_create();
+	if (!cfg) {
+		return -1;
+	}
+	opts = config_long_options(cfg);
+	print_set_verbose(1);
+	print_set_syslog(0);
+
+	progname = strrchr(argv[0], '/');
+	progname = progname ? 1+progname : argv[0];
+	while (EOF != (c = getopt_long(argc, argv, "c:f:l:hv", opts, &index))) {
+		switch (c) {
+		case 0:
+			if (config_parse_option(cfg, opts[index].name, optarg))
+				goto out;
+			break;
+		case 'c':
+			if (get_arg_val_i(c, optarg, &r.selected, 1, MAX_CLOCKS))
+				goto out;
+			r.selected--;
+			break;
+		case 'f':
+			config = optarg;
+			break;
+		case 'l':
+			if (get_arg_val_i(c, optarg, &level,
+					  PRINT_LEVEL_MIN, PRINT_LEVEL_MAX))
+				goto out;
+			break;
+		case 'v':
+			version_show(stdout);
+			err = 0;
+			goto out;
+		case 'h':
+			usage(progname);
+			err = 0;
+			goto out;
+		case '?':
+		default:
+			usage(progname);
+			goto out;
+		}
+	}
+	if (optind != argc - 1) {
+		usage(progname);
+		goto out;
+	}
+	if (config && config_read(config, cfg)) {
+		fprintf(stderr, "failed to read config\n");
+		goto out;
+	}
+	print_set_progname(progname);
+	print_set_level(level);
+
+	fp = fopen(argv[optind], "r");
+	if (!fp) {
+		fprintf(stderr, "failed to open %s: %m\n", argv[optind]);
+		goto out;
+	}
+	if (tsrec_read_header(fp)) {
+		fprintf(stderr, "%s is not a time stamp recording\n",
+			argv[optind]);
+		goto out;
+	}
+	if (replay_init(&r, cfg)) {
+		goto out;
+	}
+	while (tsrec_read(fp, &rec)) {
+		if (replay_record(&r, &rec))
+			goto out;
+	}
+	replay_report(&r);
+	err = 0;
+out:
+	if (fp)
+		fclose(fp);
+	replay_destroy(&r);
+	config_destroy(cfg);
+	return err;
+}
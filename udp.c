@@ -34,6 +34,7 @@
 #include "print.h"
 #include "sk.h"
 #include "ether.h"
+#include "missing.h"
 #include "transport_private.h"
 #include "udp.h"
 
@@ -90,11 +91,16 @@ static int udp_close(struct transport *t, struct fdarray *fda)
 	return 0;
 }
 
+/*
+ * Opens a socket on one of the PTP ports. A socket without multicast
+ * addresses is a shard, which only serves unicast clients and shares
+ * the port with SO_REUSEPORT.
+ */
 static int open_socket(const char *name, struct in_addr mc_addr[2], short port,
-		       int ttl)
+		       int ttl, int reuseport)
 {
 	struct sockaddr_in addr;
-	int fd, index, on = 1;
+	int fd, index, on = 1, off = 0;
 
 	memset(&addr, 0, sizeof(addr));
 	addr.sin_family = AF_INET;
@@ -114,14 +120,31 @@ static int open_socket(const char *name, struct in_addr mc_addr[2], short port,
 		pr_err("setsockopt SO_REUSEADDR failed: %m");
 		goto no_option;
 	}
-	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr))) {
-		pr_err("bind failed: %m");
+	if (reuseport &&
+	    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on))) {
+		pr_err("setsockopt SO_REUSEPORT failed: %m");
 		goto no_option;
 	}
+	/*
+	 * Bind to the device first, so that the sockets sharing the
+	 * port with SO_REUSEPORT join one group.
+	 */
 	if (setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, name, strlen(name))) {
 		pr_err("setsockopt SO_BINDTODEVICE failed: %m");
 		goto no_option;
 	}
+	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr))) {
+		pr_err("bind failed: %m");
+		goto no_option;
+	}
+	if (!mc_addr) {
+		if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_ALL,
+			       &off, sizeof(off))) {
+			pr_err("setsockopt IP_MULTICAST_ALL failed: %m");
+			goto no_option;
+		}
+		return fd;
+	}
 	if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl))) {
 		pr_err("setsockopt IP_MULTICAST_TTL failed: %m");
 		goto no_option;
@@ -150,32 +173,21 @@ enum { MC_PRIMARY, MC_PDELAY };
 
 static struct in_addr mcast_addr[2];
 
-static int udp_open(struct transport *t, struct interface *iface,
-		    struct fdarray *fda, enum timestamp_type ts_type)
+static int open_sockets(struct transport *t, struct interface *iface,
+			struct fdarray *fda, enum timestamp_type ts_type,
+			struct in_addr mc_addr[2], int reuseport)
 {
-	struct udp *udp = container_of(t, struct udp, t);
 	const char *name = interface_name(iface);
 	uint8_t event_dscp, general_dscp;
 	int efd, gfd, ttl;
 
 	ttl = config_get_int(t->cfg, name, "udp_ttl");
-	udp->mac.len = 0;
-	sk_interface_macaddr(name, &udp->mac);
 
-	udp->ip.len = 0;
-	sk_interface_addr(name, AF_INET, &udp->ip);
-
-	if (!inet_aton(PTP_PRIMARY_MCAST_IPADDR, &mcast_addr[MC_PRIMARY]))
-		return -1;
-
-	if (!inet_aton(PTP_PDELAY_MCAST_IPADDR, &mcast_addr[MC_PDELAY]))
-		return -1;
-
-	efd = open_socket(name, mcast_addr, EVENT_PORT, ttl);
+	efd = open_socket(name, mc_addr, EVENT_PORT, ttl, reuseport);
 	if (efd < 0)
 		goto no_event;
 
-	gfd = open_socket(name, mcast_addr, GENERAL_PORT, ttl);
+	gfd = open_socket(name, mc_addr, GENERAL_PORT, ttl, reuseport);
 	if (gfd < 0)
 		goto no_general;
 
@@ -207,6 +219,47 @@ no_event:
 	return -1;
 }
 
+static int udp_open(struct transport *t, struct interface *iface,
+		    struct fdarray *fda, enum timestamp_type ts_type)
+{
+	struct udp *udp = container_of(t, struct udp, t);
+	const char *name = interface_name(iface);
+	int reuseport;
+
+	udp->mac.len = 0;
+	sk_interface_macaddr(name, &udp->mac);
+
+	udp->ip.len = 0;
+	sk_interface_addr(name, AF_INET, &udp->ip);
+
+	if (!inet_aton(PTP_PRIMARY_MCAST_IPADDR, &mcast_addr[MC_PRIMARY]))
+		return -1;
+
+	if (!inet_aton(PTP_PDELAY_MCAST_IPADDR, &mcast_addr[MC_PDELAY]))
+		return -1;
+
+	reuseport = config_get_int(t->cfg, name, "unicast_workers") > 0;
+
+	return open_sockets(t, iface, fda, ts_type, mcast_addr, reuseport);
+}
+
+static int udp_open_shard(struct transport *t, struct interface *iface,
+			  struct fdarray *fda, enum timestamp_type ts_type)
+{
+	return open_sockets(t, iface, fda, ts_type, NULL, 1);
+}
+
+static int udp_steer_shards(struct transport *t, struct fdarray *fda,
+			    int shards)
+{
+	/* The source address is at offset 12 of the IPv4 header. */
+	if (sk_reuseport_steer(fda->fd[FD_EVENT], 12, shards) ||
+	    sk_reuseport_steer(fda->fd[FD_GENERAL], 12, shards)) {
+		return -1;
+	}
+	return 0;
+}
+
 static int udp_recv(struct transport *t, int fd, void *buf, int buflen,
 		    struct address *addr, struct hw_timestamp *hwts)
 {
@@ -218,8 +271,6 @@ static int udp_send(struct transport *t, struct fdarray *fda,
 		    struct address *addr, struct hw_timestamp *hwts)
 {
 	struct address addr_buf;
-	unsigned char junk[1600];
-	ssize_t cnt;
 	int fd = -1;
 
 	switch (event) {
@@ -253,15 +304,8 @@ static int udp_send(struct transport *t, struct fdarray *fda,
 	if (event == TRANS_ONESTEP)
 		len += 2;
 
-	cnt = sendto(fd, buf, len, 0, &addr->sa, sizeof(addr->sin));
-	if (cnt < 1) {
-		pr_err("sendto failed: %m");
-		return -errno;
-	}
-	/*
-	 * Get the time stamp right away.
-	 */
-	return event == TRANS_EVENT ? sk_receive(fd, junk, len, NULL, hwts, MSG_ERRQUEUE) : cnt;
+	return transport_sk_send(t, fd, buf, len, addr, sizeof(addr->sin),
+				 event == TRANS_EVENT, hwts);
 }
 
 static void udp_release(struct transport *t)
@@ -306,5 +350,7 @@ struct transport *udp_transport_create(void)
 	udp->t.release = udp_release;
 	udp->t.physical_addr = udp_physical_addr;
 	udp->t.protocol_addr = udp_protocol_addr;
+	udp->t.open_shard = udp_open_shard;
+	udp->t.steer_shards = udp_steer_shards;
 	return &udp->t;
 }
@@ -34,6 +34,7 @@
 #include "print.h"
 #include "sk.h"
 #include "ether.h"
+#include "missing.h"
 #include "transport_private.h"
 #include "udp6.h"
 
@@ -101,11 +102,16 @@ static int udp6_close(struct transport *t, struct fdarray *fda)
 	return 0;
 }
 
+/*
+ * Opens a socket on one of the PTP ports. A socket without multicast
+ * addresses is a shard, which only serves unicast clients and shares
+ * the port with SO_REUSEPORT.
+ */
 static int open_socket_ipv6(const char *name, struct in6_addr mc_addr[2], short port,
-			    int *interface_index, int hop_limit)
+			    int *interface_index, int hop_limit, int reuseport)
 {
 	struct sockaddr_in6 addr;
-	int fd, index, on = 1;
+	int fd, index, on = 1, off = 0;
 
 	memset(&addr, 0, sizeof(addr));
 	addr.sin6_family = AF_INET6;
@@ -127,14 +133,31 @@ static int open_socket_ipv6(const char *name, struct in6_addr mc_addr[2], short
 		pr_err("setsockopt SO_REUSEADDR failed: %m");
 		goto no_option;
 	}
-	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr))) {
-		pr_err("bind failed: %m");
+	if (reuseport &&
+	    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on))) {
+		pr_err("setsockopt SO_REUSEPORT failed: %m");
 		goto no_option;
 	}
+	/*
+	 * Bind to the device first, so that the sockets sharing the
+	 * port with SO_REUSEPORT join one group.
+	 */
 	if (setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, name, strlen(name))) {
 		pr_err("setsockopt SO_BINDTODEVICE failed: %m");
 		goto no_option;
 	}
+	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr))) {
+		pr_err("bind failed: %m");
+		goto no_option;
+	}
+	if (!mc_addr) {
+		if (setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_ALL,
+			       &off, sizeof(off))) {
+			pr_err("setsockopt IPV6_MULTICAST_ALL failed: %m");
+			goto no_option;
+		}
+		return fd;
+	}
 	if (setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &hop_limit,
 		       sizeof(hop_limit))) {
 		pr_err("setsockopt IPV6_MULTICAST_HOPS failed: %m");
@@ -160,39 +183,24 @@ no_socket:
 	return -1;
 }
 
-static int udp6_open(struct transport *t, struct interface *iface,
-		     struct fdarray *fda, enum timestamp_type ts_type)
+static int open_sockets(struct transport *t, struct interface *iface,
+			struct fdarray *fda, enum timestamp_type ts_type,
+			struct in6_addr mc_addr[2], int *interface_index,
+			int reuseport)
 {
-	struct udp6 *udp6 = container_of(t, struct udp6, t);
 	const char *name = interface_name(iface);
 	uint8_t event_dscp, general_dscp;
 	int efd, gfd, hop_limit;
 
 	hop_limit = config_get_int(t->cfg, name, "udp_ttl");
-	udp6->mac.len = 0;
-	sk_interface_macaddr(name, &udp6->mac);
-
-	udp6->ip.len = 0;
-	sk_interface_addr(name, AF_INET6, &udp6->ip);
 
-	if (1 != inet_pton(AF_INET6, PTP_PRIMARY_MCAST_IP6ADDR,
-			   &udp6->mc6_addr[MC_PRIMARY]))
-		return -1;
-
-	udp6->mc6_addr[MC_PRIMARY].s6_addr[1] = config_get_int(t->cfg, name,
-							       "udp6_scope");
-
-	if (1 != inet_pton(AF_INET6, PTP_PDELAY_MCAST_IP6ADDR,
-			   &udp6->mc6_addr[MC_PDELAY]))
-		return -1;
-
-	efd = open_socket_ipv6(name, udp6->mc6_addr, EVENT_PORT, &udp6->index,
-			       hop_limit);
+	efd = open_socket_ipv6(name, mc_addr, EVENT_PORT, interface_index,
+			       hop_limit, reuseport);
 	if (efd < 0)
 		goto no_event;
 
-	gfd = open_socket_ipv6(name, udp6->mc6_addr, GENERAL_PORT, &udp6->index,
-			       hop_limit);
+	gfd = open_socket_ipv6(name, mc_addr, GENERAL_PORT, interface_index,
+			       hop_limit, reuseport);
 	if (gfd < 0)
 		goto no_general;
 
@@ -224,6 +232,55 @@ no_event:
 	return -1;
 }
 
+static int udp6_open(struct transport *t, struct interface *iface,
+		     struct fdarray *fda, enum timestamp_type ts_type)
+{
+	struct udp6 *udp6 = container_of(t, struct udp6, t);
+	const char *name = interface_name(iface);
+	int reuseport;
+
+	udp6->mac.len = 0;
+	sk_interface_macaddr(name, &udp6->mac);
+
+	udp6->ip.len = 0;
+	sk_interface_addr(name, AF_INET6, &udp6->ip);
+
+	if (1 != inet_pton(AF_INET6, PTP_PRIMARY_MCAST_IP6ADDR,
+			   &udp6->mc6_addr[MC_PRIMARY]))
+		return -1;
+
+	udp6->mc6_addr[MC_PRIMARY].s6_addr[1] = config_get_int(t->cfg, name,
+							       "udp6_scope");
+
+	if (1 != inet_pton(AF_INET6, PTP_PDELAY_MCAST_IP6ADDR,
+			   &udp6->mc6_addr[MC_PDELAY]))
+		return -1;
+
+	reuseport = config_get_int(t->cfg, name, "unicast_workers") > 0;
+
+	return open_sockets(t, iface, fda, ts_type, udp6->mc6_addr,
+			    &udp6->index, reuseport);
+}
+
+static int udp6_open_shard(struct transport *t, struct interface *iface,
+			   struct fdarray *fda, enum timestamp_type ts_type)
+{
+	int index;
+
+	return open_sockets(t, iface, fda, ts_type, NULL, &index, 1);
+}
+
+static int udp6_steer_shards(struct transport *t, struct fdarray *fda,
+			     int shards)
+{
+	/* The last word of the source address is at offset 20. */
+	if (sk_reuseport_steer(fda->fd[FD_EVENT], 20, shards) ||
+	    sk_reuseport_steer(fda->fd[FD_GENERAL], 20, shards)) {
+		return -1;
+	}
+	return 0;
+}
+
 static int udp6_recv(struct transport *t, int fd, void *buf, int buflen,
 		     struct address *addr, struct hw_timestamp *hwts)
 {
@@ -236,8 +293,6 @@ static int udp6_send(struct transport *t, struct fdarray *fda,
 {
 	struct udp6 *udp6 = container_of(t, struct udp6, t);
 	struct address addr_buf;
-	unsigned char junk[1600];
-	ssize_t cnt;
 	int fd = -1;
 
 	switch (event) {
@@ -268,15 +323,8 @@ static int udp6_send(struct transport *t, struct fdarray *fda,
 
 	len += 2; /* Extend the payload by two, for UDP checksum corrections. */
 
-	cnt = sendto(fd, buf, len, 0, &addr->sa, sizeof(addr->sin6));
-	if (cnt < 1) {
-		pr_err("sendto failed: %m");
-		return -errno;
-	}
-	/*
-	 * Get the time stamp right away.
-	 */
-	return event == TRANS_EVENT ? sk_receive(fd, junk, len, NULL, hwts, MSG_ERRQUEUE) : cnt;
+	return transport_sk_send(t, fd, buf, len, addr, sizeof(addr->sin6),
+				 event == TRANS_EVENT, hwts);
 }
 
 static void udp6_release(struct transport *t)
@@ -322,5 +370,7 @@ struct transport *udp6_transport_create(void)
 	udp6->t.release = udp6_release;
 	udp6->t.physical_addr = udp6_physical_addr;
 	udp6->t.protocol_addr = udp6_protocol_addr;
+	udp6->t.open_shard = udp6_open_shard;
+	udp6->t.steer_shards = udp6_steer_shards;
 	return &udp6->t;
 }
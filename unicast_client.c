@@ -350,7 +350,7 @@ int unicast_client_initialize(struct port *p)
 	struct unicast_master_table *table;
 	int table_id;
 
-	table_id = config_get_int(cfg, p->name, "unicast_master_table");
+	table_id = p->settings.unicast_master_table;
 	if (!table_id) {
 		return 0;
 	}
@@ -390,7 +390,7 @@ int unicast_client_initialize(struct port *p)
 	table->port = portnum(p);
 	p->unicast_master_table = table;
 	p->unicast_req_duration =
-		config_get_int(cfg, p->name, "unicast_req_duration");
+		p->settings.unicast_req_duration;
 	return 0;
 }
 
@@ -475,25 +475,57 @@ void unicast_client_grant(struct port *p, struct ptp_message *m,
 							  UC_EV_GRANT_SYDY);
 			}
 			unicast_client_set_renewal(p, ucma, g->durationField);
-			clock_sync_interval(p->clock, g->logInterMessagePeriod);
+			p->log_sync_interval = g->logInterMessagePeriod;
+			clock_sync_interval(p->clock, p->log_sync_interval);
 			break;
 		}
 		break;
 	case UC_HAVE_SYDY:
 		switch (mtype) {
 		case ANNOUNCE:
+			unicast_client_set_renewal(p, ucma, g->durationField);
+			break;
 		case DELAY_RESP:
+			unicast_client_set_renewal(p, ucma, g->durationField);
+			p->logMinDelayReqInterval = g->logInterMessagePeriod;
+			break;
 		case SYNC:
 			unicast_client_set_renewal(p, ucma, g->durationField);
+			/* The rate changes when the grant is renegotiated. */
+			if (p->log_sync_interval != g->logInterMessagePeriod) {
+				p->log_sync_interval = g->logInterMessagePeriod;
+				clock_sync_interval(p->clock,
+						    p->log_sync_interval);
+			}
 			break;
 		}
 		break;
 	}
 }
 
+int unicast_client_renegotiate(struct port *p)
+{
+	struct unicast_master_address *master;
+	int err = 0;
+
+	if (!unicast_client_enabled(p)) {
+		return 0;
+	}
+	STAILQ_FOREACH(master, &p->unicast_master_table->addrs, list) {
+		if (master->type != transport_type(p->trp) ||
+		    master->state != UC_HAVE_SYDY) {
+			continue;
+		}
+		if (unicast_client_sydy(p, master)) {
+			err = -1;
+		}
+	}
+	return err;
+}
+
 int unicast_client_set_tmo(struct port *p)
 {
-	return set_tmo_log(p->fda.fd[FD_UNICAST_REQ_TIMER], 1,
+	return set_tmo_log(port_timer(p, FD_UNICAST_REQ_TIMER), 1,
 			   p->unicast_master_table->logQueryInterval);
 }
 
@@ -508,7 +540,8 @@ void unicast_client_state_changed(struct port *p)
 	pid = clock_parent_identity(p->clock);
 
 	STAILQ_FOREACH(ucma, &p->unicast_master_table->addrs, list) {
-		if (pid_eq(&ucma->portIdentity, &pid)) {
+		if (pid_eq(&ucma->portIdentity, &pid) ||
+		    port_standby_selected(p, &ucma->portIdentity)) {
 			ucma->state = unicast_fsm(ucma->state, UC_EV_SELECTED);
 		} else {
 			ucma->state = unicast_fsm(ucma->state, UC_EV_UNSELECTED);
@@ -62,6 +62,14 @@ int unicast_client_enabled(struct port *p);
 void unicast_client_grant(struct port *p, struct ptp_message *m,
 			  struct tlv_extra *extra);
 
+/**
+ * Requests Sync and Delay_Resp from the selected master again, using the
+ * current message intervals of the port.
+ * @param p      The port in question.
+ * @return       Zero on success, non-zero otherwise.
+ */
+int unicast_client_renegotiate(struct port *p);
+
 /**
  * Programs the unicast request timer.
  * @param p      The port in question.
@@ -157,10 +157,11 @@ static void timespec_normalize(struct timespec *ts)
 	}
 }
 
-static int unicast_service_clients(struct port *p,
-				   struct unicast_service_interval *interval)
+static int unicast_service_clients(struct unicast_service_interval *interval,
+				   unicast_service_callback send, void *ctx)
 {
 	struct unicast_client_address *client, *next;
+	char buf[64];
 	struct timespec now;
 	int err = 0;
 
@@ -170,25 +171,16 @@ static int unicast_service_clients(struct port *p,
 		return err;
 	}
 	LIST_FOREACH_SAFE(client, &interval->clients, list, next) {
-		pr_debug("%s wants 0x%x", pid2str(&client->portIdentity),
-			 client->message_types);
 		if (now.tv_sec > client->grant_tmo) {
 			pr_debug("%s service of 0x%x expired",
-				 pid2str(&client->portIdentity),
+				 pid2str_r(&client->portIdentity, buf, sizeof(buf)),
 				 client->message_types);
 			LIST_REMOVE(client, list);
 			free(client);
 			continue;
 		}
-		if (client->message_types & (1 << ANNOUNCE)) {
-			if (port_tx_announce(p, &client->addr)) {
-				err = -1;
-			}
-		}
-		if (client->message_types & (1 << SYNC)) {
-			if (port_tx_sync(p, &client->addr)) {
-				err = -1;
-			}
+		if (send && send(ctx, &client->addr, client->message_types)) {
+			err = -1;
 		}
 	}
 	return err;
@@ -198,6 +190,7 @@ static void unicast_service_extend(struct unicast_client_address *client,
 				   struct request_unicast_xmit_tlv *req)
 {
 	struct timespec now;
+	char buf[64];
 	time_t tmo;
 	int err;
 
@@ -210,28 +203,26 @@ static void unicast_service_extend(struct unicast_client_address *client,
 	if (tmo > client->grant_tmo) {
 		client->grant_tmo = tmo;
 		pr_debug("%s grant of 0x%x extended to %lld",
-			 pid2str(&client->portIdentity),
+			 pid2str_r(&client->portIdentity, buf, sizeof(buf)),
 			 client->message_types, (long long)tmo);
 	}
 }
 
 static int unicast_service_rearm_timer(struct port *p)
 {
-	struct unicast_service_interval *interval;
-	struct itimerspec tmo;
-	int fd;
-
-	fd = p->fda.fd[FD_UNICAST_SRV_TIMER];
-	memset(&tmo, 0, sizeof(tmo));
-	interval = pqueue_peek(p->unicast_service->queue);
-	if (interval) {
-		tmo.it_value = interval->tmo;
+	struct tmo *t;
+	int64_t tmo;
+
+	t = port_timer(p, FD_UNICAST_SRV_TIMER);
+	tmo = unicast_service_deadline(p->unicast_service);
+	if (tmo) {
 		pr_debug("arming timer tmo={%lld,%ld}",
-			 (long long)interval->tmo.tv_sec, interval->tmo.tv_nsec);
-	} else {
-		pr_debug("stopping unicast service timer");
+			 (long long)(tmo / NS_PER_SEC), (long)(tmo % NS_PER_SEC));
+		return tmo_arm_abs(t, tmo);
 	}
-	return timerfd_settime(fd, TFD_TIMER_ABSTIME, &tmo, NULL);
+	pr_debug("stopping unicast service timer");
+	tmo_clear(t);
+	return 0;
 }
 
 static int unicast_service_reply(struct port *p, struct ptp_message *dst,
@@ -259,22 +250,71 @@ out:
 	return err;
 }
 
+static int unicast_service_send(void *ctx, struct address *addr,
+				unsigned int message_types)
+{
+	struct port *p = ctx;
+	int err = 0;
+
+	if (message_types & (1 << ANNOUNCE)) {
+		if (port_tx_announce(p, addr)) {
+			err = -1;
+		}
+	}
+	if (message_types & (1 << SYNC)) {
+		if (port_tx_sync(p, addr)) {
+			err = -1;
+		}
+	}
+	return err;
+}
+
 /* public methods */
 
-int unicast_service_add(struct port *p, struct ptp_message *m,
-			struct tlv_extra *extra)
+struct unicast_service *unicast_service_create(void)
+{
+	struct unicast_service *s;
+
+	s = calloc(1, sizeof(*s));
+	if (!s) {
+		return NULL;
+	}
+	LIST_INIT(&s->intervals);
+
+	s->queue = pqueue_create(QUEUE_LEN, compare_timeout);
+	if (!s->queue) {
+		free(s);
+		return NULL;
+	}
+	return s;
+}
+
+void unicast_service_destroy(struct unicast_service *s)
+{
+	struct unicast_service_interval *itmp, *inext;
+	struct unicast_client_address *ctmp, *cnext;
+
+	LIST_FOREACH_SAFE(itmp, &s->intervals, list, inext) {
+		LIST_FOREACH_SAFE(ctmp, &itmp->clients, list, cnext) {
+			LIST_REMOVE(ctmp, list);
+			free(ctmp);
+		}
+		LIST_REMOVE(itmp, list);
+		free(itmp);
+	}
+	pqueue_destroy(s->queue);
+	free(s);
+}
+
+int unicast_service_insert(struct unicast_service *s, enum transport_type type,
+			   struct PortIdentity *pid, struct address *addr,
+			   struct request_unicast_xmit_tlv *req)
 {
 	struct unicast_client_address *client = NULL, *ctmp, *next;
 	struct unicast_service_interval *interval = NULL, *itmp;
-	struct request_unicast_xmit_tlv *req;
 	unsigned int mask;
 	uint8_t mtype;
 
-	if (!p->unicast_service) {
-		return SERVICE_DISABLED;
-	}
-
-	req = (struct request_unicast_xmit_tlv *) extra->tlv;
 	mtype = req->message_type >> 4;
 	mask = 1 << mtype;
 
@@ -289,7 +329,7 @@ int unicast_service_add(struct port *p, struct ptp_message *m,
 		return SERVICE_DENIED;
 	}
 
-	LIST_FOREACH(itmp, &p->unicast_service->intervals, list) {
+	LIST_FOREACH(itmp, &s->intervals, list) {
 		/*
 		 * Remember the interval of interest.
 		 */
@@ -300,8 +340,7 @@ int unicast_service_add(struct port *p, struct ptp_message *m,
 		 * Find any client records, and remove any stale contract.
 		 */
 		LIST_FOREACH_SAFE(ctmp, &itmp->clients, list, next) {
-			if (!addreq(transport_type(p->trp),
-				    &ctmp->addr, &m->address)) {
+			if (!addreq(type, &ctmp->addr, addr)) {
 				continue;
 			}
 			if (interval == itmp) {
@@ -333,9 +372,9 @@ int unicast_service_add(struct port *p, struct ptp_message *m,
 	if (!client) {
 		return SERVICE_DENIED;
 	}
-	client->portIdentity = m->header.sourcePortIdentity;
+	client->portIdentity = *pid;
 	client->message_types = mask;
-	client->addr = m->address;
+	client->addr = *addr;
 	unicast_service_extend(client, req);
 
 	if (!interval) {
@@ -345,37 +384,136 @@ int unicast_service_add(struct port *p, struct ptp_message *m,
 			return SERVICE_DENIED;
 		}
 		initialize_interval(interval, req->logInterMessagePeriod);
-		LIST_INSERT_HEAD(&p->unicast_service->intervals, interval, list);
-		if (pqueue_insert(p->unicast_service->queue, interval)) {
+		LIST_INSERT_HEAD(&s->intervals, interval, list);
+		if (pqueue_insert(s->queue, interval)) {
 			LIST_REMOVE(interval, list);
 			free(interval);
 			free(client);
 			return SERVICE_DENIED;
 		}
-		unicast_service_rearm_timer(p);
 	}
 	LIST_INSERT_HEAD(&interval->clients, client, list);
 	return SERVICE_GRANTED;
 }
 
-void unicast_service_cleanup(struct port *p)
+void unicast_service_cancel(struct unicast_service *s, enum transport_type type,
+			    struct address *addr,
+			    struct cancel_unicast_xmit_tlv *cancel)
 {
-	struct unicast_service_interval *itmp, *inext;
-	struct unicast_client_address *ctmp, *cnext;
+	struct unicast_client_address *ctmp, *next;
+	struct unicast_service_interval *itmp;
+	unsigned int mask;
+	uint8_t mtype;
 
-	if (!p->unicast_service) {
+	if (cancel->message_type_flags & CANCEL_UNICAST_MAINTAIN_REQUEST) {
 		return;
 	}
-	LIST_FOREACH_SAFE(itmp, &p->unicast_service->intervals, list, inext) {
-		LIST_FOREACH_SAFE(ctmp, &itmp->clients, list, cnext) {
-			LIST_REMOVE(ctmp, list);
-			free(ctmp);
+	mtype = cancel->message_type_flags >> 4;
+	mask = 1 << mtype;
+
+	switch (mtype) {
+	case ANNOUNCE:
+	case SYNC:
+		break;
+	case DELAY_RESP:
+	case PDELAY_RESP:
+	default:
+		return;
+	}
+
+	LIST_FOREACH(itmp, &s->intervals, list) {
+		LIST_FOREACH_SAFE(ctmp, &itmp->clients, list, next) {
+			if (!addreq(type, &ctmp->addr, addr)) {
+				continue;
+			}
+			if (ctmp->message_types & mask) {
+				ctmp->message_types &= ~mask;
+				if (!ctmp->message_types) {
+					LIST_REMOVE(ctmp, list);
+					free(ctmp);
+				}
+				return;
+			}
 		}
-		LIST_REMOVE(itmp, list);
-		free(itmp);
 	}
-	pqueue_destroy(p->unicast_service->queue);
-	free(p->unicast_service);
+}
+
+int64_t unicast_service_deadline(struct unicast_service *s)
+{
+	struct unicast_service_interval *interval;
+
+	interval = pqueue_peek(s->queue);
+	if (!interval) {
+		return 0;
+	}
+	return interval->tmo.tv_sec * NS_PER_SEC + interval->tmo.tv_nsec;
+}
+
+int unicast_service_expire(struct unicast_service *s,
+			   unicast_service_callback send, void *ctx)
+{
+	struct unicast_service_interval *interval;
+	struct timespec now;
+	int err = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	while ((interval = pqueue_peek(s->queue)) != NULL) {
+
+		pr_debug("peek i={2^%d} tmo={%lld,%ld}", interval->log_period,
+			 (long long)interval->tmo.tv_sec, interval->tmo.tv_nsec);
+
+		if (timespec_compare(&now, &interval->tmo) > 0) {
+			break;
+		}
+		interval = pqueue_extract(s->queue);
+
+		if (unicast_service_clients(interval, send, ctx)) {
+			err = -1;
+		}
+
+		if (LIST_EMPTY(&interval->clients)) {
+			pr_debug("retire interval 2^%d", interval->log_period);
+			LIST_REMOVE(interval, list);
+			free(interval);
+			continue;
+		}
+
+		interval_increment(interval);
+		pr_debug("next i={2^%d} tmo={%lld,%ld}", interval->log_period,
+			 (long long)interval->tmo.tv_sec, interval->tmo.tv_nsec);
+		pqueue_insert(s->queue, interval);
+	}
+	return err;
+}
+
+int unicast_service_add(struct port *p, struct ptp_message *m,
+			struct tlv_extra *extra)
+{
+	struct request_unicast_xmit_tlv *req;
+	int result;
+
+	if (!p->unicast_service) {
+		return SERVICE_DISABLED;
+	}
+	req = (struct request_unicast_xmit_tlv *) extra->tlv;
+
+	result = unicast_service_insert(p->unicast_service,
+					transport_type(p->trp),
+					&m->header.sourcePortIdentity,
+					&m->address, req);
+	if (result == SERVICE_GRANTED) {
+		unicast_service_rearm_timer(p);
+	}
+	return result;
+}
+
+void unicast_service_cleanup(struct port *p)
+{
+	if (!p->unicast_service) {
+		return;
+	}
+	unicast_service_destroy(p->unicast_service);
 }
 
 int unicast_service_deny(struct port *p, struct ptp_message *m,
@@ -400,25 +538,19 @@ int unicast_service_initialize(struct port *p)
 {
 	struct config *cfg = clock_config(p->clock);
 
-	if (!config_get_int(cfg, p->name, "unicast_listen")) {
+	if (!p->settings.unicast_listen) {
 		return 0;
 	}
 	if (config_set_section_int(cfg, p->name, "hybrid_e2e", 1)) {
 		return -1;
 	}
-	p->unicast_service = calloc(1, sizeof(*p->unicast_service));
+	p->settings.hybrid_e2e = 1;
+	p->unicast_service = unicast_service_create();
 	if (!p->unicast_service) {
 		return -1;
 	}
-	LIST_INIT(&p->unicast_service->intervals);
-
-	p->unicast_service->queue = pqueue_create(QUEUE_LEN, compare_timeout);
-	if (!p->unicast_service->queue) {
-		free(p->unicast_service);
-		return -1;
-	}
 	p->inhibit_multicast_service =
-		config_get_int(cfg, p->name, "inhibit_multicast_service");
+		p->settings.inhibit_multicast_service;
 
 	return 0;
 }
@@ -426,60 +558,24 @@ int unicast_service_initialize(struct port *p)
 void unicast_service_remove(struct port *p, struct ptp_message *m,
 			    struct tlv_extra *extra)
 {
-	struct unicast_client_address *ctmp, *next;
 	struct cancel_unicast_xmit_tlv *cancel;
-	struct unicast_service_interval *itmp;
-	unsigned int mask;
-	uint8_t mtype;
 
 	if (!p->unicast_service) {
 		return;
 	}
 	cancel = (struct cancel_unicast_xmit_tlv *) extra->tlv;
-	if (cancel->message_type_flags & CANCEL_UNICAST_MAINTAIN_REQUEST) {
-		return;
-	}
-	mtype = cancel->message_type_flags >> 4;
-	mask = 1 << mtype;
-
-	switch (mtype) {
-	case ANNOUNCE:
-	case SYNC:
-		break;
-	case DELAY_RESP:
-	case PDELAY_RESP:
-	default:
-		return;
-	}
 
-	LIST_FOREACH(itmp, &p->unicast_service->intervals, list) {
-		LIST_FOREACH_SAFE(ctmp, &itmp->clients, list, next) {
-			if (!addreq(transport_type(p->trp),
-				    &ctmp->addr, &m->address)) {
-				continue;
-			}
-			if (ctmp->message_types & mask) {
-				ctmp->message_types &= ~mask;
-				if (!ctmp->message_types) {
-					LIST_REMOVE(ctmp, list);
-					free(ctmp);
-				}
-				return;
-			}
-		}
-	}
+	unicast_service_cancel(p->unicast_service, transport_type(p->trp),
+			       &m->address, cancel);
 }
 
 int unicast_service_timer(struct port *p)
 {
-	struct unicast_service_interval *interval;
 	int err = 0, master = 0;
-	struct timespec now;
 
 	if (!p->unicast_service) {
 		return 0;
 	}
-	clock_gettime(CLOCK_MONOTONIC, &now);
 
 	switch (p->state) {
 	case PS_INITIALIZING:
@@ -497,32 +593,8 @@ int unicast_service_timer(struct port *p)
 		break;
 	}
 
-	while ((interval = pqueue_peek(p->unicast_service->queue)) != NULL) {
-
-		pr_debug("peek i={2^%d} tmo={%lld,%ld}", interval->log_period,
-			 (long long)interval->tmo.tv_sec, interval->tmo.tv_nsec);
-
-		if (timespec_compare(&now, &interval->tmo) > 0) {
-			break;
-		}
-		interval = pqueue_extract(p->unicast_service->queue);
-
-		if (master && unicast_service_clients(p, interval)) {
-			err = -1;
-		}
-
-		if (LIST_EMPTY(&interval->clients)) {
-			pr_debug("retire interval 2^%d", interval->log_period);
-			LIST_REMOVE(interval, list);
-			free(interval);
-			continue;
-		}
-
-		interval_increment(interval);
-		pr_debug("next i={2^%d} tmo={%lld,%ld}", interval->log_period,
-			 (long long)interval->tmo.tv_sec, interval->tmo.tv_nsec);
-		pqueue_insert(p->unicast_service->queue, interval);
-	}
+	err = unicast_service_expire(p->unicast_service,
+				     master ? unicast_service_send : NULL, p);
 
 	if (unicast_service_rearm_timer(p)) {
 		err = -1;
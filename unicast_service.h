@@ -20,14 +20,92 @@
 #ifndef HAVE_UNICAST_SERVICE_H
 #define HAVE_UNICAST_SERVICE_H
 
+#include <stdint.h>
+
+#include "transport.h"
+
+struct address;
+struct cancel_unicast_xmit_tlv;
 struct port;
+struct PortIdentity;
 struct ptp_message;
+struct request_unicast_xmit_tlv;
 struct tlv_extra;
+struct unicast_service;
 
 #define SERVICE_GRANTED   0
 #define SERVICE_DENIED    1
 #define SERVICE_DISABLED  2
 
+/**
+ * Sends the granted messages to one client.
+ * @param ctx            The context passed to unicast_service_expire().
+ * @param addr           The address of the client.
+ * @param message_types  Bit mask of the granted message types.
+ * @return               Zero on success, non-zero otherwise.
+ */
+typedef int (*unicast_service_callback)(void *ctx, struct address *addr,
+					unsigned int message_types);
+
+/*
+ * The grants and the transmit schedule of a unicast service. A port
+ * has one, and each unicast worker thread has its own. These methods
+ * do not touch the port, so that a worker may call them.
+ */
+
+/**
+ * Create an empty set of grants.
+ * @return  A pointer to the new service on success, NULL otherwise.
+ */
+struct unicast_service *unicast_service_create(void);
+
+/**
+ * Destroy a set of grants.
+ * @param s  A service obtained via unicast_service_create().
+ */
+void unicast_service_destroy(struct unicast_service *s);
+
+/**
+ * Enter or extend a grant.
+ * @param s     The service in question.
+ * @param type  The transport type of the client's address.
+ * @param pid   The identity of the requesting port.
+ * @param addr  The address of the requesting port.
+ * @param req   The request TLV, in host byte order.
+ * @return      SERVICE_GRANTED or SERVICE_DENIED.
+ */
+int unicast_service_insert(struct unicast_service *s, enum transport_type type,
+			   struct PortIdentity *pid, struct address *addr,
+			   struct request_unicast_xmit_tlv *req);
+
+/**
+ * Cancel a grant.
+ * @param s       The service in question.
+ * @param type    The transport type of the client's address.
+ * @param addr    The address of the canceling port.
+ * @param cancel  The cancel TLV.
+ */
+void unicast_service_cancel(struct unicast_service *s, enum transport_type type,
+			    struct address *addr,
+			    struct cancel_unicast_xmit_tlv *cancel);
+
+/**
+ * Find out when the next messages are due.
+ * @param s  The service in question.
+ * @return   The CLOCK_MONOTONIC time in ns, or zero if nothing is granted.
+ */
+int64_t unicast_service_deadline(struct unicast_service *s);
+
+/**
+ * Serve the clients whose messages are due, and drop expired grants.
+ * @param s     The service in question.
+ * @param send  Called for each client, or NULL to send nothing.
+ * @param ctx   Passed to 'send'.
+ * @return      Zero on success, non-zero if sending failed.
+ */
+int unicast_service_expire(struct unicast_service *s,
+			   unicast_service_callback send, void *ctx);
+
 /**
  * Handle a request for unicast service.
  * @param p      The port on which the signaling message was received.
@@ -0,0 +1,706 @@
+/**
+ * @file unicast_worker.c
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "clock.h"
+#include "port.h"
+#include "port_private.h"
+#include "print.h"
+#include "tlv.h"
+#include "tmo.h"
+#include "transport.h"
+#include "unicast_client.h"
+#include "unicast_service.h"
+#include "unicast_worker.h"
+#include "util.h"
+
+enum { WORKER_EVENT, WORKER_GENERAL, WORKER_TIMER, WORKER_STOP, N_WORKER_PFD };
+
+/*
+ * What the workers know of the port and the clock. The messages are
+ * kept in network byte order, ready to be copied into a reply.
+ */
+struct unicast_view {
+	int enabled;			/* the port may grant service */
+	int master;			/* the port may serve its clients */
+	int match_transport_specific;
+	Integer8 logSyncInterval;
+	Integer64 rx_timestamp_offset;
+	Integer64 tx_timestamp_offset;
+	struct ptp_header header;	/* the fields common to all messages */
+	struct announce_msg announce;
+};
+
+struct unicast_worker {
+	struct unicast_workers *pool;
+	pthread_t thread;
+	int running;
+	struct fdarray fda;
+	struct tmo_heap *timers;
+	struct tmo tx_timer;
+	struct unicast_service *service;
+	struct unicast_view view;
+	unsigned int generation;
+	UInteger16 seq_announce;
+	UInteger16 seq_signaling;
+	UInteger16 seq_sync;
+	struct PortStats stats;		/* written by the worker only */
+	struct ptp_message rx;
+	struct ptp_message tx;
+};
+
+struct unicast_workers {
+	struct transport *trp;
+	enum transport_type type;
+	enum timestamp_type timestamping;
+	UInteger16 number;
+	int started;
+	int stop_fd;
+	pthread_mutex_t mutex;
+	unsigned int generation;
+	struct unicast_view view;	/* written under the mutex */
+	int count;
+	struct unicast_worker *worker;
+};
+
+static void stats_inc(uint64_t *counter)
+{
+	/* Only the worker writes, so no locked instruction is needed. */
+	__atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + 1,
+			 __ATOMIC_RELAXED);
+}
+
+static void view_build(struct port *p, struct unicast_view *v)
+{
+	struct timePropertiesDS tp = clock_time_properties(p->clock);
+	struct parent_ds *dad = clock_parent_ds(p->clock);
+	struct announce_msg *a = &v->announce;
+	struct ptp_header *h = &v->header;
+
+	memset(v, 0, sizeof(*v));
+	v->enabled = port_is_enabled(p);
+	v->master = (p->state == PS_MASTER || p->state == PS_GRAND_MASTER) &&
+		    port_capable(p);
+	v->match_transport_specific = p->match_transport_specific;
+	v->logSyncInterval = p->logSyncInterval;
+	v->rx_timestamp_offset = p->rx_timestamp_offset;
+	v->tx_timestamp_offset = p->tx_timestamp_offset;
+
+	h->tsmt = p->transportSpecific;
+	h->ver = PTP_VERSION;
+	h->domainNumber = clock_domain_number(p->clock);
+	h->flagField[0] = UNICAST;
+	h->sourcePortIdentity.clockIdentity = p->portIdentity.clockIdentity;
+	h->sourcePortIdentity.portNumber = htons(p->portIdentity.portNumber);
+
+	a->hdr = *h;
+	a->hdr.tsmt = ANNOUNCE | p->transportSpecific;
+	a->hdr.messageLength = htons(sizeof(*a));
+	a->hdr.control = CTL_OTHER;
+	a->hdr.logMessageInterval = p->logAnnounceInterval;
+	a->hdr.flagField[1] = tp.flags;
+	a->currentUtcOffset = htons(tp.currentUtcOffset);
+	a->grandmasterPriority1 = dad->pds.grandmasterPriority1;
+	a->grandmasterClockQuality = dad->pds.grandmasterClockQuality;
+	a->grandmasterClockQuality.offsetScaledLogVariance =
+		htons(dad->pds.grandmasterClockQuality.offsetScaledLogVariance);
+	a->grandmasterPriority2 = dad->pds.grandmasterPriority2;
+	a->grandmasterIdentity = dad->pds.grandmasterIdentity;
+	a->stepsRemoved = htons(clock_steps_removed(p->clock));
+	a->timeSource = tp.timeSource;
+}
+
+static void worker_refresh(struct unicast_worker *w)
+{
+	struct unicast_workers *pool = w->pool;
+
+	if (__atomic_load_n(&pool->generation, __ATOMIC_ACQUIRE) ==
+	    w->generation) {
+		return;
+	}
+	pthread_mutex_lock(&pool->mutex);
+	w->view = pool->view;
+	w->generation = pool->generation;
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+static int worker_sendto(struct unicast_worker *w, enum transport_event event,
+			 struct ptp_message *msg)
+{
+	int cnt;
+
+	cnt = transport_sendto(w->pool->trp, &w->fda, event, msg);
+	if (cnt <= 0) {
+		return -1;
+	}
+	stats_inc(&w->stats.txMsgType[msg_type(msg)]);
+	return 0;
+}
+
+static void timestamp_hton(struct Timestamp *dst, tmv_t t)
+{
+	struct Timestamp ts = tmv_to_Timestamp(t);
+
+	dst->seconds_msb = htons(ts.seconds_msb);
+	dst->seconds_lsb = htonl(ts.seconds_lsb);
+	dst->nanoseconds = htonl(ts.nanoseconds);
+}
+
+static int worker_tx_announce(struct unicast_worker *w, struct address *addr)
+{
+	struct ptp_message *msg = &w->tx;
+
+	msg->announce = w->view.announce;
+	msg->header.sequenceId = htons(w->seq_announce++);
+	msg->address = *addr;
+
+	if (worker_sendto(w, TRANS_GENERAL, msg)) {
+		pr_err("port %hu: send announce failed", w->pool->number);
+		return -1;
+	}
+	return 0;
+}
+
+static int worker_tx_sync(struct unicast_worker *w, struct address *addr)
+{
+	struct ptp_message *msg = &w->tx;
+
+	msg->hwts.type = w->pool->timestamping;
+	msg->header = w->view.header;
+	msg->header.tsmt = SYNC | w->view.header.tsmt;
+	msg->header.messageLength = htons(sizeof(struct sync_msg));
+	msg->header.flagField[0] |= TWO_STEP;
+	msg->header.sequenceId = htons(w->seq_sync++);
+	msg->header.control = CTL_SYNC;
+	msg->header.logMessageInterval = 0x7f;
+	memset(&msg->sync.originTimestamp, 0, sizeof(struct Timestamp));
+	msg->address = *addr;
+
+	if (worker_sendto(w, TRANS_EVENT, msg)) {
+		pr_err("port %hu: send sync failed", w->pool->number);
+		return -1;
+	}
+	if (!msg_sots_valid(msg)) {
+		pr_err("missing timestamp on transmitted sync");
+		return -1;
+	}
+	ts_add(&msg->hwts.ts, w->view.tx_timestamp_offset);
+
+	/*
+	 * Send the follow up message right away.
+	 */
+	msg->header.tsmt = FOLLOW_UP | w->view.header.tsmt;
+	msg->header.messageLength = htons(sizeof(struct follow_up_msg));
+	msg->header.flagField[0] &= ~TWO_STEP;
+	msg->header.control = CTL_FOLLOW_UP;
+	msg->header.logMessageInterval = w->view.logSyncInterval;
+	timestamp_hton(&msg->follow_up.preciseOriginTimestamp, msg->hwts.ts);
+	msg->address = *addr;
+
+	if (worker_sendto(w, TRANS_GENERAL, msg)) {
+		pr_err("port %hu: send follow up failed", w->pool->number);
+		return -1;
+	}
+	return 0;
+}
+
+static int worker_serve_client(void *ctx, struct address *addr,
+			       unsigned int message_types)
+{
+	struct unicast_worker *w = ctx;
+	int err = 0;
+
+	if (message_types & (1 << ANNOUNCE)) {
+		if (worker_tx_announce(w, addr)) {
+			err = -1;
+		}
+	}
+	if (message_types & (1 << SYNC)) {
+		if (worker_tx_sync(w, addr)) {
+			err = -1;
+		}
+	}
+	return err;
+}
+
+static void worker_rearm(struct unicast_worker *w)
+{
+	tmo_arm_abs(&w->tx_timer, unicast_service_deadline(w->service));
+}
+
+static void worker_serve(struct unicast_worker *w)
+{
+	if (!tmo_heap_expired(w->timers, tmo_now())) {
+		return;
+	}
+	unicast_service_expire(w->service,
+			       w->view.master ? worker_serve_client : NULL, w);
+	worker_rearm(w);
+}
+
+static void worker_delay_req(struct unicast_worker *w, struct ptp_message *m,
+			     int cnt)
+{
+	struct ptp_message *rsp = &w->tx;
+
+	if (!w->view.master || cnt < (int) sizeof(struct delay_req_msg)) {
+		return;
+	}
+	if (!msg_sots_valid(m)) {
+		pr_err("port %hu: delay request without time stamp",
+		       w->pool->number);
+		return;
+	}
+	ts_add(&m->hwts.ts, -w->view.rx_timestamp_offset);
+
+	rsp->header = w->view.header;
+	rsp->header.tsmt = DELAY_RESP | w->view.header.tsmt;
+	rsp->header.messageLength = htons(sizeof(struct delay_resp_msg));
+	rsp->header.correction = m->header.correction;
+	rsp->header.sequenceId = m->header.sequenceId;
+	rsp->header.control = CTL_DELAY_RESP;
+	rsp->header.logMessageInterval = 0x7f;
+	timestamp_hton(&rsp->delay_resp.receiveTimestamp, m->hwts.ts);
+	rsp->delay_resp.requestingPortIdentity = m->header.sourcePortIdentity;
+	rsp->address = m->address;
+
+	if (worker_sendto(w, TRANS_GENERAL, rsp)) {
+		pr_err("port %hu: send delay response failed",
+		       w->pool->number);
+	}
+}
+
+static void worker_reply(struct unicast_worker *w, struct ptp_message *m,
+			 struct request_unicast_xmit_tlv *req,
+			 uint32_t duration)
+{
+	struct ptp_message *msg = &w->tx;
+	struct grant_unicast_xmit_tlv *g;
+
+	msg->header = w->view.header;
+	msg->header.tsmt = SIGNALING | w->view.header.tsmt;
+	msg->header.messageLength =
+		htons(sizeof(struct signaling_msg) + sizeof(*g));
+	msg->header.sequenceId = htons(w->seq_signaling++);
+	msg->header.control = CTL_OTHER;
+	msg->header.logMessageInterval = 0x7f;
+	msg->signaling.targetPortIdentity = m->header.sourcePortIdentity;
+
+	g = (struct grant_unicast_xmit_tlv *) msg->signaling.suffix;
+	g->type = htons(TLV_GRANT_UNICAST_TRANSMISSION);
+	g->length = htons(sizeof(*g) - sizeof(struct TLV));
+	g->message_type = req->message_type;
+	g->logInterMessagePeriod = req->logInterMessagePeriod;
+	g->durationField = htonl(duration);
+	g->reserved = 0;
+	g->flags = GRANT_UNICAST_RENEWAL_INVITED;
+	msg->address = m->address;
+
+	if (worker_sendto(w, TRANS_GENERAL, msg)) {
+		pr_err("port %hu: signaling message failed", w->pool->number);
+	}
+}
+
+/*
+ * Handles the unicast negotiation TLVs of a signaling message in place.
+ * Other TLVs are of no concern to the workers.
+ */
+static void worker_signaling(struct unicast_worker *w, struct ptp_message *m,
+			     int cnt)
+{
+	struct PortIdentity *tpid = &m->signaling.targetPortIdentity;
+	struct cancel_unicast_xmit_tlv cancel;
+	struct request_unicast_xmit_tlv req;
+	struct PortIdentity pid;
+	int len, length, result;
+	struct TLV *tlv;
+	uint8_t *ptr;
+
+	if (!w->view.enabled || cnt < (int) sizeof(struct signaling_msg)) {
+		return;
+	}
+	if (!pid_eq(tpid, &w->view.header.sourcePortIdentity) &&
+	    !pid_eq(tpid, &wildcard_pid)) {
+		return;
+	}
+	pid = m->header.sourcePortIdentity;
+	pid.portNumber = ntohs(pid.portNumber);
+
+	ptr = m->signaling.suffix;
+	len = cnt - sizeof(struct signaling_msg);
+
+	while (len >= (int) sizeof(struct TLV)) {
+		tlv = (struct TLV *) ptr;
+		length = sizeof(struct TLV) + ntohs(tlv->length);
+		if (length > len) {
+			break;
+		}
+		switch (ntohs(tlv->type)) {
+		case TLV_REQUEST_UNICAST_TRANSMISSION:
+			if (length < (int) sizeof(req)) {
+				break;
+			}
+			memcpy(&req, tlv, sizeof(req));
+			req.durationField = ntohl(req.durationField);
+			result = unicast_service_insert(w->service,
+							w->pool->type, &pid,
+							&m->address, &req);
+			worker_reply(w, m, &req, result == SERVICE_GRANTED ?
+				     req.durationField : 0);
+			break;
+		case TLV_CANCEL_UNICAST_TRANSMISSION:
+			if (length < (int) sizeof(cancel)) {
+				break;
+			}
+			memcpy(&cancel, tlv, sizeof(cancel));
+			unicast_service_cancel(w->service, w->pool->type,
+					       &m->address, &cancel);
+			break;
+		}
+		ptr += length;
+		len -= length;
+	}
+	worker_rearm(w);
+}
+
+static void worker_recv(struct unicast_worker *w, int fd_index)
+{
+	struct ptp_message *m = &w->rx;
+	struct ptp_header *h = &m->header;
+	int cnt, type;
+
+	m->hwts.type = w->pool->timestamping;
+
+	cnt = transport_recv(w->pool->trp, w->fda.fd[fd_index], m);
+	if (cnt < (int) sizeof(*h) || cnt < ntohs(h->messageLength)) {
+		return;
+	}
+	cnt = ntohs(h->messageLength);
+
+	if ((h->ver & 0x0f) != PTP_VERSION ||
+	    h->domainNumber != w->view.header.domainNumber) {
+		return;
+	}
+	if (w->view.match_transport_specific &&
+	    (h->tsmt & 0xf0) != w->view.header.tsmt) {
+		return;
+	}
+	if (cid_eq(&h->sourcePortIdentity.clockIdentity,
+		   &w->view.header.sourcePortIdentity.clockIdentity)) {
+		return;
+	}
+	type = msg_type(m);
+
+	switch (type) {
+	case DELAY_REQ:
+		stats_inc(&w->stats.rxMsgType[type]);
+		worker_delay_req(w, m, cnt);
+		break;
+	case SIGNALING:
+		stats_inc(&w->stats.rxMsgType[type]);
+		worker_signaling(w, m, cnt);
+		break;
+	default:
+		break;
+	}
+}
+
+static void *worker_run(void *arg)
+{
+	struct unicast_worker *w = arg;
+	struct pollfd pfd[N_WORKER_PFD];
+	int i, cnt;
+
+	pfd[WORKER_EVENT].fd = w->fda.fd[FD_EVENT];
+	pfd[WORKER_GENERAL].fd = w->fda.fd[FD_GENERAL];
+	pfd[WORKER_TIMER].fd = tmo_heap_fd(w->timers);
+	pfd[WORKER_STOP].fd = w->pool->stop_fd;
+	for (i = 0; i < N_WORKER_PFD; i++) {
+		pfd[i].events = POLLIN | POLLPRI;
+	}
+
+	while (1) {
+		tmo_heap_update(w->timers);
+
+		cnt = poll(pfd, N_WORKER_PFD, -1);
+		if (cnt < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			pr_err("port %hu: worker poll failed: %m",
+			       w->pool->number);
+			break;
+		}
+		if (pfd[WORKER_STOP].revents) {
+			break;
+		}
+		worker_refresh(w);
+
+		if (pfd[WORKER_EVENT].revents & (POLLIN | POLLPRI)) {
+			worker_recv(w, FD_EVENT);
+		}
+		if (pfd[WORKER_GENERAL].revents & (POLLIN | POLLPRI)) {
+			worker_recv(w, FD_GENERAL);
+		}
+		if (pfd[WORKER_TIMER].revents & (POLLIN | POLLPRI)) {
+			tmo_heap_acknowledge(w->timers);
+			worker_serve(w);
+		}
+	}
+	return NULL;
+}
+
+/* public methods */
+
+int unicast_worker_initialize(struct port *p)
+{
+	struct config *cfg = clock_config(p->clock);
+	struct unicast_workers *pool;
+	struct unicast_worker *w;
+	int i, count;
+
+	count = config_get_int(cfg, p->name, "unicast_workers");
+	if (!count) {
+		return 0;
+	}
+	if (!p->unicast_service) {
+		pr_warning("port %hu: unicast_workers needs unicast_listen",
+			   portnum(p));
+		return 0;
+	}
+	switch (transport_type(p->trp)) {
+	case TRANS_UDP_IPV4:
+	case TRANS_UDP_IPV6:
+		break;
+	default:
+		pr_warning("port %hu: unicast_workers needs UDP", portnum(p));
+		return 0;
+	}
+	switch (p->timestamping) {
+	case TS_SOFTWARE:
+	case TS_HARDWARE:
+	case TS_LEGACY_HW:
+		break;
+	default:
+		pr_warning("port %hu: unicast_workers needs two step "
+			   "time stamping", portnum(p));
+		return 0;
+	}
+	if (unicast_client_enabled(p)) {
+		pr_warning("port %hu: unicast_workers conflicts with "
+			   "unicast_master_table", portnum(p));
+		return 0;
+	}
+	if (p->follow_up_info || p->path_trace_enabled) {
+		pr_warning("port %hu: unicast_workers conflicts with "
+			   "follow_up_info and path_trace_enabled", portnum(p));
+		return 0;
+	}
+
+	pool = calloc(1, sizeof(*pool));
+	if (!pool) {
+		return -1;
+	}
+	pool->worker = calloc(count, sizeof(*pool->worker));
+	if (!pool->worker) {
+		free(pool);
+		return -1;
+	}
+	pool->trp = p->trp;
+	pool->type = transport_type(p->trp);
+	pool->timestamping = p->timestamping;
+	pool->number = portnum(p);
+	pool->count = count;
+	pthread_mutex_init(&pool->mutex, NULL);
+	p->unicast_workers = pool;
+
+	pool->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (pool->stop_fd < 0) {
+		pr_err("eventfd failed: %m");
+		goto failed;
+	}
+	for (i = 0; i < count; i++) {
+		w = &pool->worker[i];
+		w->pool = pool;
+		w->fda.fd[FD_EVENT] = -1;
+		w->fda.fd[FD_GENERAL] = -1;
+		w->service = unicast_service_create();
+		w->timers = tmo_heap_create();
+		if (!w->service || !w->timers) {
+			goto failed;
+		}
+		tmo_init(&w->tx_timer, w->timers, w, 0);
+	}
+	return 0;
+failed:
+	unicast_worker_cleanup(p);
+	return -1;
+}
+
+void unicast_worker_cleanup(struct port *p)
+{
+	struct unicast_workers *pool = p->unicast_workers;
+	struct unicast_worker *w;
+	int i;
+
+	if (!pool) {
+		return;
+	}
+	for (i = 0; i < pool->count; i++) {
+		w = &pool->worker[i];
+		if (w->service) {
+			unicast_service_destroy(w->service);
+		}
+		if (w->timers) {
+			tmo_heap_destroy(w->timers);
+		}
+	}
+	if (pool->stop_fd >= 0) {
+		close(pool->stop_fd);
+	}
+	pthread_mutex_destroy(&pool->mutex);
+	free(pool->worker);
+	free(pool);
+	p->unicast_workers = NULL;
+}
+
+void unicast_worker_start(struct port *p)
+{
+	struct unicast_workers *pool = p->unicast_workers;
+	struct unicast_worker *w;
+	sigset_t mask, old;
+	int i, err;
+
+	if (!pool) {
+		return;
+	}
+	pool->started = 1;
+
+	for (i = 0; i < pool->count; i++) {
+		w = &pool->worker[i];
+		if (transport_open_shard(p->trp, p->iface, &w->fda,
+					 p->timestamping)) {
+			goto failed;
+		}
+	}
+	if (transport_steer_shards(p->trp, &p->fda, pool->count)) {
+		goto failed;
+	}
+	unicast_worker_publish(p);
+
+	/* The signals are for the main thread. */
+	sigfillset(&mask);
+	pthread_sigmask(SIG_BLOCK, &mask, &old);
+	for (i = 0; i < pool->count; i++) {
+		w = &pool->worker[i];
+		err = pthread_create(&w->thread, NULL, worker_run, w);
+		if (err) {
+			pr_err("pthread_create failed: %s", strerror(err));
+			break;
+		}
+		w->running = 1;
+	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if (i == pool->count) {
+		pr_info("port %hu: %d unicast worker threads", portnum(p),
+			pool->count);
+		return;
+	}
+failed:
+	unicast_worker_stop(p);
+	pr_err("port %hu: serving the unicast clients without workers",
+	       portnum(p));
+}
+
+void unicast_worker_stop(struct port *p)
+{
+	struct unicast_workers *pool = p->unicast_workers;
+	struct unicast_worker *w;
+	uint64_t val = 1;
+	int i;
+
+	if (!pool || !pool->started) {
+		return;
+	}
+	if (write(pool->stop_fd, &val, sizeof(val)) != sizeof(val)) {
+		pr_err("eventfd write failed: %m");
+	}
+	for (i = 0; i < pool->count; i++) {
+		w = &pool->worker[i];
+		if (w->running) {
+			pthread_join(w->thread, NULL);
+			w->running = 0;
+		}
+	}
+	if (read(pool->stop_fd, &val, sizeof(val)) < 0 && errno != EAGAIN) {
+		pr_err("eventfd read failed: %m");
+	}
+	/*
+	 * Closing the shards leaves the port alone in the group, and the
+	 * kernel ignores a steering result beyond the end of the group.
+	 */
+	for (i = 0; i < pool->count; i++) {
+		w = &pool->worker[i];
+		if (w->fda.fd[FD_EVENT] >= 0) {
+			transport_close(p->trp, &w->fda);
+			w->fda.fd[FD_EVENT] = -1;
+			w->fda.fd[FD_GENERAL] = -1;
+		}
+	}
+	pool->started = 0;
+}
+
+void unicast_worker_publish(struct port *p)
+{
+	struct unicast_workers *pool = p->unicast_workers;
+	struct unicast_view v;
+
+	if (!pool) {
+		return;
+	}
+	view_build(p, &v);
+
+	/* Only this thread writes the view, so it may read without lock. */
+	if (!memcmp(&v, &pool->view, sizeof(v))) {
+		return;
+	}
+	pthread_mutex_lock(&pool->mutex);
+	pool->view = v;
+	__atomic_store_n(&pool->generation, pool->generation + 1,
+			 __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void unicast_worker_stats(struct port *p, struct PortStats *stats)
+{
+	struct unicast_workers *pool = p->unicast_workers;
+	struct unicast_worker *w;
+	int i, j;
+
+	if (!pool) {
+		return;
+	}
+	for (i = 0; i < pool->count; i++) {
+		w = &pool->worker[i];
+		for (j = 0; j < MAX_MESSAGE_TYPES; j++) {
+			stats->rxMsgType[j] +=
+				__atomic_load_n(&w->stats.rxMsgType[j],
+						__ATOMIC_RELAXED);
+			stats->txMsgType[j] +=
+				__atomic_load_n(&w->stats.txMsgType[j],
+						__ATOMIC_RELAXED);
+		}
+	}
+}
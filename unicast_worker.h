@@ -0,0 +1,66 @@
+/**
+ * @file unicast_worker.h
+ * @brief Serves the unicast clients of a port from worker threads.
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#ifndef HAVE_UNICAST_WORKER_H
+#define HAVE_UNICAST_WORKER_H
+
+#include "ddt.h"
+
+struct port;
+
+/*
+ * Each worker thread owns a pair of sockets sharing the PTP ports with
+ * SO_REUSEPORT. The kernel steers the unicast Delay_Req and Signaling
+ * messages to the workers by the source address, so that every client
+ * belongs to one worker, which keeps the grants and sends the Announce,
+ * Sync and Follow_Up messages of its clients. All other messages still
+ * reach the port. The workers never touch the port or the clock; the
+ * port publishes the data sets which they need.
+ */
+
+/**
+ * Set up the worker threads of a port, if configured.
+ * @param p  The port in question.
+ * @return   Zero on success, non-zero otherwise.
+ */
+int unicast_worker_initialize(struct port *p);
+
+/**
+ * Free the resources of the worker threads of a port.
+ * @param p  The port in question, with the workers stopped.
+ */
+void unicast_worker_cleanup(struct port *p);
+
+/**
+ * Open the sockets of the workers and start the threads. Call this
+ * after opening the transport of the port. If the workers cannot be
+ * started, the port serves its clients on its own.
+ * @param p  The port in question.
+ */
+void unicast_worker_start(struct port *p);
+
+/**
+ * Stop the threads and close their sockets. Call this before closing
+ * the transport of the port. The grants are kept.
+ * @param p  The port in question.
+ */
+void unicast_worker_stop(struct port *p);
+
+/**
+ * Publish the data sets of the port and the clock to the workers. Cheap
+ * when nothing changed, so call it whenever something might have.
+ * @param p  The port in question.
+ */
+void unicast_worker_publish(struct port *p);
+
+/**
+ * Add the messages counted by the workers to the statistics of a port.
+ * @param p      The port in question.
+ * @param stats  The statistics of the port.
+ */
+void unicast_worker_stats(struct port *p, struct PortStats *stats);
+
+#endif
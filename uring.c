@@ -0,0 +1,727 @@
+/**
+ * @file uring.c
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "print.h"
+#include "uring.h"
+
+#ifdef HAVE_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "sk.h"
+
+#define URING_RX_ENTRIES	8
+#define URING_TX_ENTRIES	64
+#define URING_BUFS		64	/* must be a power of two */
+#define URING_SLOTS		32
+#define URING_NAMELEN		sizeof(struct sockaddr_storage)
+#define URING_CONTROLLEN	256
+#define URING_PAYLOAD		2048
+#define URING_BUFLEN		(sizeof(struct io_uring_recvmsg_out) + \
+				 URING_NAMELEN + URING_CONTROLLEN + \
+				 URING_PAYLOAD)
+
+enum {
+	URING_RECV,
+	URING_SEND,
+	URING_EVENT,
+	URING_TXTS,
+	URING_TIMEOUT,
+};
+
+#define TAG(kind, index)	((uint64_t) (kind) << 32 | (index))
+#define TAG_KIND(tag)		((tag) >> 32)
+#define TAG_INDEX(tag)		((tag) & 0xffffffff)
+
+/*
+ * One io_uring instance, with the shared rings mapped. The submission
+ * queue entries are used in order, so that the index array maps each
+ * slot to itself.
+ */
+struct ring {
+	int fd;
+	unsigned int entries;
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int sq_mask;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_map;
+	void *cq_map;
+	size_t sq_len;
+	size_t cq_len;
+	size_t sqes_len;
+	unsigned int tail;	/* entries prepared */
+	unsigned int submitted;	/* entries passed to the kernel */
+};
+
+/* A queued general message, copied so that the caller may free it. */
+struct slot {
+	struct msghdr hdr;
+	struct iovec iov;
+	struct sockaddr_storage ss;
+	int busy;
+	unsigned char buf[URING_PAYLOAD];
+};
+
+struct uring {
+	struct ring rx;
+	struct ring tx;
+	struct fdarray fda;
+	int armed[N_POLLFD];
+	struct msghdr rx_hdr;
+	struct io_uring_buf_ring *br;
+	size_t br_len;
+	unsigned short br_tail;
+	unsigned char *bufs;
+	struct slot slots[URING_SLOTS];
+	/* The event message in flight and its time stamp. */
+	struct msghdr ev_hdr;
+	struct iovec ev_iov;
+	int ev_res;
+	int ev_done;
+	struct msghdr ts_hdr;
+	struct iovec ts_iov;
+	unsigned char ts_buf[1600];
+	char ts_control[URING_CONTROLLEN];
+	struct __kernel_timespec ts_timeout;
+	int ts_res;
+	int ts_done;
+};
+
+static int sys_io_uring_setup(unsigned int entries, struct io_uring_params *p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned int to_submit,
+			      unsigned int min_complete, unsigned int flags)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+		       flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned int opcode, void *arg,
+				 unsigned int nr_args)
+{
+	return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void *ring_field(void *map, unsigned int offset)
+{
+	return (char *) map + offset;
+}
+
+static void ring_close(struct ring *r)
+{
+	munmap(r->sqes, r->sqes_len);
+	if (r->cq_map != r->sq_map) {
+		munmap(r->cq_map, r->cq_len);
+	}
+	munmap(r->sq_map, r->sq_len);
+	close(r->fd);
+}
+
+static int ring_init(struct ring *r, unsigned int entries,
+		     unsigned int cq_entries)
+{
+	struct io_uring_params p;
+	unsigned int i, *array;
+
+	memset(&p, 0, sizeof(p));
+	if (cq_entries) {
+		p.flags = IORING_SETUP_CQSIZE;
+		p.cq_entries = cq_entries;
+	}
+	r->fd = sys_io_uring_setup(entries, &p);
+	if (r->fd < 0) {
+		pr_err("io_uring_setup failed: %m");
+		return -1;
+	}
+	r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (r->cq_len > r->sq_len) {
+			r->sq_len = r->cq_len;
+		}
+		r->cq_len = r->sq_len;
+	}
+	r->sq_map = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (r->sq_map == MAP_FAILED) {
+		goto no_sq;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		r->cq_map = r->sq_map;
+	} else {
+		r->cq_map = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE,
+				 MAP_SHARED | MAP_POPULATE, r->fd,
+				 IORING_OFF_CQ_RING);
+		if (r->cq_map == MAP_FAILED) {
+			goto no_cq;
+		}
+	}
+	r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE,
+		       MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED) {
+		goto no_sqes;
+	}
+
+	r->entries = p.sq_entries;
+	r->sq_head = ring_field(r->sq_map, p.sq_off.head);
+	r->sq_tail = ring_field(r->sq_map, p.sq_off.tail);
+	r->sq_mask = *(unsigned int *) ring_field(r->sq_map, p.sq_off.ring_mask);
+	array = ring_field(r->sq_map, p.sq_off.array);
+	for (i = 0; i < r->entries; i++) {
+		array[i] = i;
+	}
+	r->cq_head = ring_field(r->cq_map, p.cq_off.head);
+	r->cq_tail = ring_field(r->cq_map, p.cq_off.tail);
+	r->cq_mask = *(unsigned int *) ring_field(r->cq_map, p.cq_off.ring_mask);
+	r->cqes = ring_field(r->cq_map, p.cq_off.cqes);
+	r->tail = *r->sq_tail;
+	r->submitted = r->tail;
+	return 0;
+
+no_sqes:
+	if (r->cq_map != r->sq_map) {
+		munmap(r->cq_map, r->cq_len);
+	}
+no_cq:
+	munmap(r->sq_map, r->sq_len);
+no_sq:
+	pr_err("io_uring mmap failed: %m");
+	close(r->fd);
+	return -1;
+}
+
+/* Submit the prepared entries and wait for some completions. */
+static int ring_enter(struct ring *r, unsigned int min_complete)
+{
+	unsigned int flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+	int cnt;
+
+	__atomic_store_n(r->sq_tail, r->tail, __ATOMIC_RELEASE);
+	do {
+		cnt = sys_io_uring_enter(r->fd, r->tail - r->submitted,
+					 min_complete, flags);
+	} while (cnt < 0 && errno == EINTR);
+	if (cnt < 0) {
+		pr_err("io_uring_enter failed: %m");
+		return -1;
+	}
+	r->submitted += cnt;
+	return 0;
+}
+
+/* Make room for 'n' entries, which the caller prepares in one go. */
+static int ring_reserve(struct ring *r, unsigned int n)
+{
+	unsigned int head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+
+	if (r->entries - (r->tail - head) >= n) {
+		return 0;
+	}
+	if (ring_enter(r, 0)) {
+		return -1;
+	}
+	head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+	return r->entries - (r->tail - head) >= n ? 0 : -1;
+}
+
+static struct io_uring_sqe *ring_sqe(struct ring *r)
+{
+	struct io_uring_sqe *sqe = &r->sqes[r->tail & r->sq_mask];
+
+	memset(sqe, 0, sizeof(*sqe));
+	r->tail++;
+	return sqe;
+}
+
+static struct io_uring_cqe *ring_cqe(struct ring *r)
+{
+	unsigned int head = *r->cq_head;
+
+	if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) {
+		return NULL;
+	}
+	return &r->cqes[head & r->cq_mask];
+}
+
+static void ring_cqe_seen(struct ring *r)
+{
+	__atomic_store_n(r->cq_head, *r->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+static void uring_prep_msg(struct io_uring_sqe *sqe, int opcode, int fd,
+			   struct msghdr *hdr, uint64_t tag)
+{
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t) hdr;
+	sqe->len = 1;
+	sqe->user_data = tag;
+}
+
+static void uring_recycle(struct uring *u, unsigned int bid)
+{
+	struct io_uring_buf *b = &u->br->bufs[u->br_tail & (URING_BUFS - 1)];
+
+	/* Leave b->resv alone, as it overlays the tail of the ring. */
+	b->addr = (uintptr_t) (u->bufs + bid * URING_BUFLEN);
+	b->len = URING_BUFLEN;
+	b->bid = bid;
+	u->br_tail++;
+	__atomic_store_n(&u->br->tail, u->br_tail, __ATOMIC_RELEASE);
+}
+
+static int uring_provide(struct uring *u)
+{
+	struct io_uring_buf_reg reg;
+	unsigned int i;
+
+	u->bufs = calloc(URING_BUFS, URING_BUFLEN);
+	if (!u->bufs) {
+		pr_err("low memory");
+		return -1;
+	}
+	u->br_len = URING_BUFS * sizeof(struct io_uring_buf);
+	u->br = mmap(NULL, u->br_len, PROT_READ | PROT_WRITE,
+		     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (u->br == MAP_FAILED) {
+		pr_err("io_uring buffer ring mmap failed: %m");
+		goto no_map;
+	}
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uintptr_t) u->br;
+	reg.ring_entries = URING_BUFS;
+	reg.bgid = 0;
+	if (sys_io_uring_register(u->rx.fd, IORING_REGISTER_PBUF_RING,
+				  &reg, 1)) {
+		pr_err("io_uring buffer ring registration failed: %m");
+		goto no_reg;
+	}
+	for (i = 0; i < URING_BUFS; i++) {
+		uring_recycle(u, i);
+	}
+	return 0;
+no_reg:
+	munmap(u->br, u->br_len);
+no_map:
+	free(u->bufs);
+	return -1;
+}
+
+/* Arm a multishot recvmsg on each socket which lost its own. */
+static int uring_arm(struct uring *u)
+{
+	struct io_uring_sqe *sqe;
+	int i, armed = 0;
+
+	for (i = 0; i < N_POLLFD; i++) {
+		if (u->fda.fd[i] < 0 || u->armed[i]) {
+			continue;
+		}
+		if (ring_reserve(&u->rx, 1)) {
+			return -1;
+		}
+		sqe = ring_sqe(&u->rx);
+		uring_prep_msg(sqe, IORING_OP_RECVMSG, u->fda.fd[i],
+			       &u->rx_hdr, TAG(URING_RECV, i));
+		sqe->ioprio = IORING_RECV_MULTISHOT;
+		sqe->flags = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = 0;
+		u->armed[i] = 1;
+		armed = 1;
+	}
+	return armed ? ring_enter(&u->rx, 0) : 0;
+}
+
+/* Collect the completions of the transmissions. */
+static void uring_reap(struct uring *u)
+{
+	struct io_uring_cqe *cqe;
+	uint64_t tag;
+	int res;
+
+	while ((cqe = ring_cqe(&u->tx))) {
+		tag = cqe->user_data;
+		res = cqe->res;
+		ring_cqe_seen(&u->tx);
+
+		switch (TAG_KIND(tag)) {
+		case URING_SEND:
+			u->slots[TAG_INDEX(tag)].busy = 0;
+			if (res < 0) {
+				pr_err("sendmsg failed: %s", strerror(-res));
+			}
+			break;
+		case URING_EVENT:
+			u->ev_res = res;
+			u->ev_done = 1;
+			break;
+		case URING_TXTS:
+			u->ts_res = res;
+			u->ts_done = 1;
+			break;
+		case URING_TIMEOUT:
+			break;
+		}
+	}
+}
+
+static int uring_busy(struct uring *u)
+{
+	int i;
+
+	for (i = 0; i < URING_SLOTS; i++) {
+		if (u->slots[i].busy) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int uring_slot(struct uring *u)
+{
+	int i;
+
+	for (;;) {
+		for (i = 0; i < URING_SLOTS; i++) {
+			if (!u->slots[i].busy) {
+				return i;
+			}
+		}
+		if (ring_enter(&u->tx, 1)) {
+			return -1;
+		}
+		uring_reap(u);
+	}
+}
+
+/*
+ * Append the recvmsg of a time stamp from the error queue, bounded by
+ * the tx_timestamp_timeout, submit everything queued so far and wait.
+ */
+static int uring_wait_txts(struct uring *u, int fd, int event,
+			   struct hw_timestamp *hwts)
+{
+	struct io_uring_sqe *sqe;
+
+	memset(u->ts_control, 0, sizeof(u->ts_control));
+	u->ts_iov.iov_base = u->ts_buf;
+	u->ts_iov.iov_len = sizeof(u->ts_buf);
+	memset(&u->ts_hdr, 0, sizeof(u->ts_hdr));
+	u->ts_hdr.msg_iov = &u->ts_iov;
+	u->ts_hdr.msg_iovlen = 1;
+	u->ts_hdr.msg_control = u->ts_control;
+	u->ts_hdr.msg_controllen = sizeof(u->ts_control);
+
+	sqe = ring_sqe(&u->tx);
+	uring_prep_msg(sqe, IORING_OP_RECVMSG, fd, &u->ts_hdr,
+		       TAG(URING_TXTS, 0));
+	sqe->msg_flags = MSG_ERRQUEUE;
+	sqe->flags = IOSQE_IO_LINK;
+
+	u->ts_timeout.tv_sec = sk_tx_timeout / 1000;
+	u->ts_timeout.tv_nsec = (sk_tx_timeout % 1000) * 1000000;
+	sqe = ring_sqe(&u->tx);
+	sqe->opcode = IORING_OP_LINK_TIMEOUT;
+	sqe->fd = -1;
+	sqe->addr = (uintptr_t) &u->ts_timeout;
+	sqe->len = 1;
+	sqe->user_data = TAG(URING_TIMEOUT, 0);
+
+	u->ts_done = 0;
+	u->ev_done = !event;
+	while (!u->ts_done || !u->ev_done) {
+		if (ring_enter(&u->tx, 1)) {
+			return -EIO;
+		}
+		uring_reap(u);
+	}
+
+	if (event && u->ev_res < 0) {
+		pr_err("sendmsg failed: %s", strerror(-u->ev_res));
+		return u->ev_res;
+	}
+	if (u->ts_res == -ECANCELED) {
+		pr_err("timed out while polling for tx timestamp");
+		pr_err("increasing tx_timestamp_timeout may correct "
+		       "this issue, but it is likely caused by a driver bug");
+		return -ETIME;
+	} else if (u->ts_res < 0) {
+		pr_err("recvmsg tx timestamp failed: %s", strerror(-u->ts_res));
+		return u->ts_res;
+	}
+	return sk_cmsg_timestamps(&u->ts_hdr, hwts);
+}
+
+struct uring *uring_create(struct fdarray *fda)
+{
+	struct io_uring_cqe *cqe;
+	struct uring *u;
+
+	u = calloc(1, sizeof(*u));
+	if (!u) {
+		pr_err("low memory");
+		return NULL;
+	}
+	u->fda = *fda;
+	u->rx_hdr.msg_namelen = URING_NAMELEN;
+	u->rx_hdr.msg_controllen = URING_CONTROLLEN;
+
+	if (ring_init(&u->rx, URING_RX_ENTRIES, 2 * URING_BUFS)) {
+		goto no_rx;
+	}
+	if (ring_init(&u->tx, URING_TX_ENTRIES, 0)) {
+		goto no_tx;
+	}
+	if (uring_provide(u)) {
+		goto no_bufs;
+	}
+	if (uring_arm(u)) {
+		goto no_arm;
+	}
+	/* A kernel without multishot recvmsg fails the request at once. */
+	cqe = ring_cqe(&u->rx);
+	if (cqe && cqe->res < 0 && cqe->res != -ENOBUFS) {
+		pr_err("io_uring recvmsg failed: %s", strerror(-cqe->res));
+		goto no_arm;
+	}
+	return u;
+
+no_arm:
+	ring_close(&u->rx);
+	munmap(u->br, u->br_len);
+	free(u->bufs);
+	ring_close(&u->tx);
+	free(u);
+	return NULL;
+no_bufs:
+	ring_close(&u->tx);
+no_tx:
+	ring_close(&u->rx);
+no_rx:
+	free(u);
+	return NULL;
+}
+
+void uring_destroy(struct uring *u)
+{
+	struct io_uring_sync_cancel_reg reg;
+	int err;
+
+	uring_flush(u);
+	while (uring_busy(u)) {
+		if (ring_enter(&u->tx, 1)) {
+			break;
+		}
+		uring_reap(u);
+	}
+	/*
+	 * The kernel writes into the buffers until the receptions are
+	 * gone, so cancel them before freeing anything.
+	 */
+	memset(&reg, 0, sizeof(reg));
+	reg.fd = -1;
+	reg.flags = IORING_ASYNC_CANCEL_ANY;
+	reg.timeout.tv_sec = -1;
+	reg.timeout.tv_nsec = -1;
+	do {
+		err = sys_io_uring_register(u->rx.fd,
+					    IORING_REGISTER_SYNC_CANCEL,
+					    &reg, 1);
+	} while (err < 0 && errno == EINTR);
+	if (err < 0 && errno != ENOENT) {
+		pr_err("io_uring cancel failed: %m");
+	}
+	ring_close(&u->rx);
+	munmap(u->br, u->br_len);
+	free(u->bufs);
+	ring_close(&u->tx);
+	free(u);
+}
+
+int uring_fd(struct uring *u)
+{
+	return u->rx.fd;
+}
+
+int uring_recv(struct uring *u, void *buf, int buflen,
+	       struct address *addr, struct hw_timestamp *hwts)
+{
+	struct io_uring_recvmsg_out *out;
+	struct io_uring_cqe *cqe;
+	unsigned int bid, flags;
+	int cnt, err, index, res;
+	unsigned char *name;
+	struct msghdr hdr;
+
+	while ((cqe = ring_cqe(&u->rx))) {
+		res = cqe->res;
+		flags = cqe->flags;
+		index = TAG_INDEX(cqe->user_data);
+		ring_cqe_seen(&u->rx);
+
+		if (!(flags & IORING_CQE_F_MORE)) {
+			u->armed[index] = 0;
+		}
+		if (res < 0 && res != -ENOBUFS) {
+			pr_err("io_uring recvmsg failed: %s", strerror(-res));
+			return res;
+		}
+		if (res < 0 || !(flags & IORING_CQE_F_BUFFER)) {
+			continue;
+		}
+		bid = flags >> IORING_CQE_BUFFER_SHIFT;
+		out = (struct io_uring_recvmsg_out *) (u->bufs + bid * URING_BUFLEN);
+		name = (unsigned char *) (out + 1);
+
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.msg_control = name + URING_NAMELEN;
+		hdr.msg_controllen = out->controllen;
+		err = sk_cmsg_timestamps(&hdr, hwts);
+
+		addr->len = out->namelen < URING_NAMELEN ?
+			out->namelen : URING_NAMELEN;
+		memcpy(&addr->ss, name, addr->len);
+
+		cnt = out->payloadlen < URING_PAYLOAD ?
+			out->payloadlen : URING_PAYLOAD;
+		if (cnt > buflen) {
+			cnt = buflen;
+		}
+		memcpy(buf, name + URING_NAMELEN + URING_CONTROLLEN, cnt);
+
+		uring_recycle(u, bid);
+		if (uring_arm(u)) {
+			return -EIO;
+		}
+		return err ? err : cnt;
+	}
+	return uring_arm(u) ? -EIO : 0;
+}
+
+int uring_send(struct uring *u, int fd, void *buf, int len,
+	       struct sockaddr *sa, socklen_t salen, int txts,
+	       struct hw_timestamp *hwts)
+{
+	struct io_uring_sqe *sqe;
+	struct slot *s;
+	int err, i;
+
+	if (txts) {
+		if (ring_reserve(&u->tx, 3)) {
+			return -EIO;
+		}
+		u->ev_iov.iov_base = buf;
+		u->ev_iov.iov_len = len;
+		memset(&u->ev_hdr, 0, sizeof(u->ev_hdr));
+		u->ev_hdr.msg_name = sa;
+		u->ev_hdr.msg_namelen = salen;
+		u->ev_hdr.msg_iov = &u->ev_iov;
+		u->ev_hdr.msg_iovlen = 1;
+		sqe = ring_sqe(&u->tx);
+		uring_prep_msg(sqe, IORING_OP_SENDMSG, fd, &u->ev_hdr,
+			       TAG(URING_EVENT, 0));
+		sqe->flags = IOSQE_IO_LINK;
+		err = uring_wait_txts(u, fd, 1, hwts);
+		return err ? err : len;
+	}
+
+	if (len > URING_PAYLOAD || salen > sizeof(s->ss)) {
+		return -EMSGSIZE;
+	}
+	i = uring_slot(u);
+	if (i < 0 || ring_reserve(&u->tx, 1)) {
+		return -EIO;
+	}
+	s = &u->slots[i];
+	memcpy(s->buf, buf, len);
+	memcpy(&s->ss, sa, salen);
+	s->iov.iov_base = s->buf;
+	s->iov.iov_len = len;
+	memset(&s->hdr, 0, sizeof(s->hdr));
+	s->hdr.msg_name = &s->ss;
+	s->hdr.msg_namelen = salen;
+	s->hdr.msg_iov = &s->iov;
+	s->hdr.msg_iovlen = 1;
+	s->busy = 1;
+
+	sqe = ring_sqe(&u->tx);
+	uring_prep_msg(sqe, IORING_OP_SENDMSG, fd, &s->hdr,
+		       TAG(URING_SEND, i));
+	return len;
+}
+
+int uring_txts(struct uring *u, int fd, struct hw_timestamp *hwts)
+{
+	if (ring_reserve(&u->tx, 2)) {
+		return -EIO;
+	}
+	return uring_wait_txts(u, fd, 0, hwts);
+}
+
+void uring_flush(struct uring *u)
+{
+	if (u->tx.tail != u->tx.submitted) {
+		ring_enter(&u->tx, 0);
+	}
+	uring_reap(u);
+}
+
+#else
+
+struct uring *uring_create(struct fdarray *fda)
+{
+	pr_err("io_uring is not supported by this build");
+	return NULL;
+}
+
+void uring_destroy(struct uring *u)
+{
+}
+
+int uring_fd(struct uring *u)
+{
+	return -1;
+}
+
+int uring_recv(struct uring *u, void *buf, int buflen,
+	       struct address *addr, struct hw_timestamp *hwts)
+{
+	return -EOPNOTSUPP;
+}
+
+int uring_send(struct uring *u, int fd, void *buf, int len,
+	       struct sockaddr *sa, socklen_t salen, int txts,
+	       struct hw_timestamp *hwts)
+{
+	return -EOPNOTSUPP;
+}
+
+int uring_txts(struct uring *u, int fd, struct hw_timestamp *hwts)
+{
+	return -EOPNOTSUPP;
+}
+
+void uring_flush(struct uring *u)
+{
+}
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file uring.h
+ * @brief Moves the socket I/O of a port onto io_uring.
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#ifndef HAVE_URING_H
+#define HAVE_URING_H
+
+#include <sys/socket.h>
+
+#include "address.h"
+#include "fd.h"
+#include "transport.h"
+
+struct uring;
+
+/*
+ * A receive ring keeps a multishot recvmsg armed on each socket, with
+ * the messages landing in a ring of provided buffers. Its descriptor
+ * becomes readable when messages are waiting, so that the clock polls
+ * it in place of the sockets. A second ring carries the transmissions.
+ * General messages are queued there and go out together at the next
+ * flush. An event message goes out at once, linked to the recvmsg of
+ * its time stamp from the error queue, so that one system call sends
+ * the message and collects the time stamp.
+ */
+
+/**
+ * Create the rings for a set of sockets, and arm the receive ring.
+ * @param fda  The open sockets.
+ * @return     A pointer to the rings on success, NULL otherwise.
+ */
+struct uring *uring_create(struct fdarray *fda);
+
+/**
+ * Flush the queued messages, cancel the receptions and free the rings.
+ * The sockets stay open.
+ * @param u  Rings obtained via uring_create().
+ */
+void uring_destroy(struct uring *u);
+
+/**
+ * Obtain the descriptor to poll for the received messages.
+ * @param u  Rings obtained via uring_create().
+ * @return   The descriptor of the receive ring.
+ */
+int uring_fd(struct uring *u);
+
+/**
+ * Take the next received message from the receive ring.
+ * @param u       Rings obtained via uring_create().
+ * @param buf     Buffer to receive the message.
+ * @param buflen  Size of 'buf' in bytes.
+ * @param addr    Receives the source address of the message.
+ * @param hwts    Receives the time stamp of the message.
+ * @return        The length of the message, zero when no message was
+ *                waiting, or a negative error code.
+ */
+int uring_recv(struct uring *u, void *buf, int buflen,
+	       struct address *addr, struct hw_timestamp *hwts);
+
+/**
+ * Send a message on one of the sockets. Without a time stamp, the
+ * message is copied and queued until the next flush.
+ * @param u       Rings obtained via uring_create().
+ * @param fd      The socket.
+ * @param buf     The message.
+ * @param len     Length of the message in bytes.
+ * @param sa      The destination address.
+ * @param salen   Length of the destination address.
+ * @param txts    Non-zero to wait for the transmit time stamp.
+ * @param hwts    Receives the transmit time stamp.
+ * @return        The number of bytes sent or queued, or a negative
+ *                error code.
+ */
+int uring_send(struct uring *u, int fd, void *buf, int len,
+	       struct sockaddr *sa, socklen_t salen, int txts,
+	       struct hw_timestamp *hwts);
+
+/**
+ * Flush the queued messages and wait for the transmit time stamp of an
+ * event message sent earlier without one.
+ * @param u     Rings obtained via uring_create().
+ * @param fd    The socket.
+ * @param hwts  Receives the transmit time stamp.
+ * @return      Zero on success, a negative error code otherwise.
+ */
+int uring_txts(struct uring *u, int fd, struct hw_timestamp *hwts);
+
+/**
+ * Submit the queued messages.
+ * @param u  Rings obtained via uring_create().
+ */
+void uring_flush(struct uring *u);
+
+#endif
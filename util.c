@@ -27,6 +27,7 @@
 #include "address.h"
 #include "phc.h"
 #include "print.h"
+#include "simnet.h"
 #include "sk.h"
 #include "util.h"
 
@@ -35,6 +36,7 @@
 #define NS_PER_DAY (24 * NS_PER_HOUR)
 
 static int running = 1;
+static int reload;
 
 const char *ps_str[] = {
 	"NONE",
@@ -109,6 +111,11 @@ int addreq(enum transport_type type, struct address *a, struct address *b)
 		bufb = &b->sll.sll_addr;
 		len = MAC_LEN;
 		break;
+	case TRANS_SIM:
+		bufa = &a->sun.sun_path;
+		bufb = &b->sun.sun_path;
+		len = sizeof(a->sun.sun_path);
+		break;
 	case TRANS_UDS:
 	case TRANS_DEVICENET:
 	case TRANS_CONTROLNET:
@@ -163,8 +170,13 @@ int count_char(const char *str, char c)
 char *pid2str(struct PortIdentity *id)
 {
 	static char buf[64];
+	return pid2str_r(id, buf, sizeof(buf));
+}
+
+char *pid2str_r(struct PortIdentity *id, char *buf, int buf_len)
+{
 	unsigned char *ptr = id->clockIdentity.id;
-	snprintf(buf, sizeof(buf), "%02x%02x%02x.%02x%02x.%02x%02x%02x-%hu",
+	snprintf(buf, buf_len, "%02x%02x%02x.%02x%02x.%02x%02x%02x-%hu",
 		 ptr[0], ptr[1], ptr[2], ptr[3],
 		 ptr[4], ptr[5], ptr[6], ptr[7],
 		 id->portNumber);
@@ -284,6 +296,9 @@ int str2addr(enum transport_type type, const char *s, struct address *addr)
 		memcpy(&addr->sll.sll_addr, mac, MAC_LEN);
 		addr->len = sizeof(addr->sll);
 		break;
+	case TRANS_SIM:
+		simnet_address(s, addr);
+		break;
 	}
 	return 0;
 }
@@ -591,6 +606,28 @@ int is_running(void)
 	return running;
 }
 
+static void handle_hup(int s)
+{
+	reload = 1;
+}
+
+int handle_reload_signal(void)
+{
+	if (SIG_ERR == signal(SIGHUP, handle_hup)) {
+		fprintf(stderr, "cannot handle SIGHUP\n");
+		return -1;
+	}
+	return 0;
+}
+
+int reload_requested(void)
+{
+	int requested = reload;
+
+	reload = 0;
+	return requested;
+}
+
 void *xmalloc(size_t size)
 {
 	void *r;
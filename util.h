@@ -108,6 +108,17 @@ int count_char(const char *str, char c);
  */
 char *pid2str(struct PortIdentity *id);
 
+/**
+ * Convert a port identity into a human readable string, like pid2str()
+ * but into a buffer provided by the caller.
+ *
+ * @param id       Port idendtity to show.
+ * @param buf      Buffer to hold the result.
+ * @param buf_len  Size of the buffer, at least 64 bytes.
+ * @return         Pointer to the buffer.
+ */
+char *pid2str_r(struct PortIdentity *id, char *buf, int buf_len);
+
 char *portaddr2str(struct PortAddress *addr);
 
 /**
@@ -348,6 +359,22 @@ int handle_term_signals(void);
  */
 int is_running(void);
 
+/**
+ * Setup a handler for the signal requesting a reload of the
+ * configuration (SIGHUP).
+ *
+ * @return       0 on success, -1 on error.
+ */
+int handle_reload_signal(void);
+
+/**
+ * Check if a reload of the configuration was requested by a signal,
+ * and clear the request.
+ *
+ * @return       1 if a reload was requested, 0 otherwise.
+ */
+int reload_requested(void);
+
 /**
  * Allocate memory. This is a malloc() wrapper that terminates the process when
  * the allocation fails.
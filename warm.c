@@ -0,0 +1,274 @@
+/**
+ * @file warm.c
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "print.h"
+#include "warm.h"
+
+static struct {
+	char *path;
+	int max_age;
+	int interval;
+	int dirty;
+	int count;
+	struct warm_record rec[WARM_MAX_CLOCKS];
+	time_t written[WARM_MAX_CLOCKS]; /* CLOCK_MONOTONIC in seconds */
+} warm;
+
+static time_t warm_now(clockid_t clkid)
+{
+	struct timespec ts;
+
+	clock_gettime(clkid, &ts);
+	return ts.tv_sec;
+}
+
+static int warm_lookup(struct warm_record *rec, int count, const char *clock)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (!strncmp(rec[i].clock, clock, sizeof(rec[i].clock)))
+			return i;
+	}
+	return -1;
+}
+
+static int warm_index(const char *clock)
+{
+	return warm_lookup(warm.rec, warm.count, clock);
+}
+
+/*
+ * Find the slot for the record of a clock, evicting the oldest record
+ * when the table is full.
+ */
+static int warm_slot(struct warm_record *rec, int *count, const char *clock)
+{
+	int i, oldest;
+
+	i = warm_lookup(rec, *count, clock);
+	if (i >= 0) {
+		return i;
+	}
+	if (*count < WARM_MAX_CLOCKS) {
+		return (*count)++;
+	}
+	for (oldest = 0, i = 1; i < *count; i++) {
+		if (rec[i].saved < rec[oldest].saved)
+			oldest = i;
+	}
+	return oldest;
+}
+
+/* Returns the number of records read, or zero without a valid file. */
+static int warm_read(struct warm_record *rec)
+{
+	struct warm_header hdr;
+	FILE *fp;
+
+	fp = fopen(warm.path, "r");
+	if (!fp) {
+		return 0;
+	}
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	    hdr.magic != WARM_MAGIC || hdr.version != WARM_VERSION ||
+	    hdr.record_size != sizeof(struct warm_record) ||
+	    hdr.count > WARM_MAX_CLOCKS ||
+	    fread(rec, sizeof(rec[0]), hdr.count, fp) != hdr.count) {
+		pr_warning("ignoring invalid state file %s", warm.path);
+		fclose(fp);
+		return 0;
+	}
+	fclose(fp);
+	return hdr.count;
+}
+
+static int warm_write_file(const char *tmp, int fd,
+			   struct warm_record *rec, int count)
+{
+	struct warm_header hdr = {
+		.magic = WARM_MAGIC,
+		.version = WARM_VERSION,
+		.record_size = sizeof(struct warm_record),
+	};
+	FILE *fp;
+	int err;
+
+	hdr.count = count;
+
+	fp = fdopen(fd, "w");
+	if (!fp) {
+		pr_err("failed to open %s: %m", tmp);
+		close(fd);
+		return -1;
+	}
+	if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	    fwrite(rec, sizeof(rec[0]), count, fp) != count ||
+	    fflush(fp) || fsync(fd)) {
+		pr_err("failed to write %s: %m", tmp);
+		fclose(fp);
+		return -1;
+	}
+	err = fclose(fp);
+	if (err) {
+		pr_err("failed to write %s: %m", tmp);
+	}
+	return err;
+}
+
+/*
+ * Several daemons may share one state file, each keeping the records
+ * of its own clocks. Under the lock, the records in the file are read
+ * again and only those saved by this process are replaced.
+ */
+static void warm_write(void)
+{
+	struct warm_record rec[WARM_MAX_CLOCKS];
+	char lock[PATH_MAX], tmp[PATH_MAX];
+	int count, fd, i, k, lfd;
+
+	snprintf(lock, sizeof(lock), "%s.lock", warm.path);
+	snprintf(tmp, sizeof(tmp), "%s.XXXXXX", warm.path);
+
+	lfd = open(lock, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (lfd < 0) {
+		pr_err("failed to open %s: %m", lock);
+		return;
+	}
+	while (flock(lfd, LOCK_EX)) {
+		if (errno != EINTR) {
+			pr_err("failed to lock %s: %m", lock);
+			close(lfd);
+			return;
+		}
+	}
+
+	count = warm_read(rec);
+	for (i = 0; i < warm.count; i++) {
+		if (!warm.written[i]) {
+			continue;
+		}
+		k = warm_slot(rec, &count, warm.rec[i].clock);
+		rec[k] = warm.rec[i];
+	}
+
+	/* Replace the file at once, so that a crash leaves either version. */
+	fd = mkstemp(tmp);
+	if (fd < 0) {
+		pr_err("failed to create %s: %m", tmp);
+		goto out;
+	}
+	fchmod(fd, 0644);
+	if (warm_write_file(tmp, fd, rec, count)) {
+		unlink(tmp);
+		goto out;
+	}
+	if (rename(tmp, warm.path)) {
+		pr_err("failed to rename %s: %m", tmp);
+		unlink(tmp);
+	}
+out:
+	close(lfd);
+}
+
+int warm_open(const char *path, int max_age, int interval)
+{
+	if (!path || !path[0]) {
+		return 0;
+	}
+	warm_close();
+	warm.path = strdup(path);
+	if (!warm.path) {
+		pr_err("low memory");
+		return -1;
+	}
+	warm.max_age = max_age;
+	warm.interval = interval;
+	warm.count = warm_read(warm.rec);
+	return 0;
+}
+
+void warm_close(void)
+{
+	warm_flush();
+	free(warm.path);
+	memset(&warm, 0, sizeof(warm));
+}
+
+int warm_find(const char *clock, struct warm_record *rec)
+{
+	int64_t age;
+	int i;
+
+	if (!warm.path) {
+		return -1;
+	}
+	i = warm_index(clock);
+	if (i < 0) {
+		return -1;
+	}
+	age = warm_now(CLOCK_REALTIME) - warm.rec[i].saved;
+	if (age < 0 || age > warm.max_age) {
+		pr_info("state of %s is stale, %" PRId64 " seconds old",
+			clock, age);
+		return -1;
+	}
+	*rec = warm.rec[i];
+	rec->clock[sizeof(rec->clock) - 1] = '\0';
+	rec->parent[sizeof(rec->parent) - 1] = '\0';
+	if (rec->n_delay < 0 || rec->n_delay > WARM_DELAY_SAMPLES) {
+		rec->n_delay = 0;
+	}
+	return 0;
+}
+
+int warm_due(const char *clock)
+{
+	int i;
+
+	if (!warm.path) {
+		return 0;
+	}
+	i = warm_index(clock);
+	if (i < 0 || !warm.written[i]) {
+		return 1;
+	}
+	return warm_now(CLOCK_MONOTONIC) - warm.written[i] >= warm.interval;
+}
+
+void warm_save(struct warm_record *rec)
+{
+	int i;
+
+	if (!warm.path) {
+		return;
+	}
+	i = warm_slot(warm.rec, &warm.count, rec->clock);
+	rec->saved = warm_now(CLOCK_REALTIME);
+	warm.rec[i] = *rec;
+	warm.written[i] = warm_now(CLOCK_MONOTONIC);
+	warm.dirty = 1;
+}
+
+void warm_flush(void)
+{
+	/* A failed write is tried again with the next saved record. */
+	if (warm.path && warm.dirty) {
+		warm.dirty = 0;
+		warm_write();
+	}
+}
@@ -0,0 +1,90 @@
+/**
+ * @file warm.h
+ * @brief Keeps the learned state of the servo loops for a warm start.
+ * @note Copyright (C) 2026 agent <agent@local>
+ * @note SPDX-License-Identifier: GPL-2.0+
+ */
+#ifndef HAVE_WARM_H
+#define HAVE_WARM_H
+
+#include <stdint.h>
+
+#define WARM_MAGIC	0x4d524157 /* "WARM" */
+#define WARM_VERSION	1
+#define WARM_DELAY_SAMPLES 64
+
+/**
+ * The state of one disciplined clock. The file holds a header and up to
+ * WARM_MAX_CLOCKS of these records, all in host byte order.
+ */
+struct warm_record {
+	char clock[64];		/* the disciplined clock */
+	char parent[64];	/* its source, e.g. the parent port identity */
+	int64_t saved;		/* CLOCK_REALTIME in seconds */
+	double freq;		/* frequency of the clock in ppb */
+	int64_t path_delay;	/* in ns, or zero if not measured */
+	int32_t utc_offset;
+	int32_t utc_offset_valid;
+	int32_t n_delay;	/* number of delay filter samples */
+	int32_t reserved;
+	int64_t delay[WARM_DELAY_SAMPLES]; /* oldest first, in ns */
+};
+
+#define WARM_MAX_CLOCKS 16
+
+struct warm_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t record_size;
+	uint32_t count;
+	uint32_t reserved;
+};
+
+/**
+ * Read the state file, if there is one, and remember where to write it.
+ * @param path      The name of the file. The empty string disables it.
+ * @param max_age   The age in seconds beyond which a record is stale.
+ * @param interval  The minimum time in seconds between two writes of
+ *                  the record of one clock.
+ * @return          Zero on success, non-zero otherwise.
+ */
+int warm_open(const char *path, int max_age, int interval);
+
+/**
+ * Write the records saved since the last write, if any, and forget the
+ * state file. The callers save their last records with warm_save()
+ * before, e.g. when they exit.
+ */
+void warm_close(void);
+
+/**
+ * Look up the state of a clock, as read from the file.
+ * @param clock  The name of the clock.
+ * @param rec    Receives a copy of the record.
+ * @return       Zero when a fresh record was found, non-zero otherwise.
+ */
+int warm_find(const char *clock, struct warm_record *rec);
+
+/**
+ * Tell whether the record of a clock is due for an update.
+ * @param clock  The name of the clock.
+ * @return       One (1) when the state file is enabled and the record is
+ *               older than the write interval, zero otherwise.
+ */
+int warm_due(const char *clock);
+
+/**
+ * Replace the record of a clock. The state file is written later, by
+ * warm_flush() or warm_close().
+ * @param rec  The new record. Its saved time is set here.
+ */
+void warm_save(struct warm_record *rec);
+
+/**
+ * Write the state file when a record was saved since the last write.
+ * This is meant to be called outside of the servo path, e.g. at the
+ * end of an iteration of the main loop.
+ */
+void warm_flush(void);
+
+#endif